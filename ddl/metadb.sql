@@ -81,6 +81,14 @@ create table worker_has_partition
     worker_idworker         INTEGER
 );
 
+create table partition_replica
+(
+    partition_idpartition   VARCHAR,
+    partition_graph_idgraph VARCHAR,
+    worker_idworker         INTEGER,
+    created_time            TIME
+);
+
 INSERT INTO graph_status (idgraph_status, description) VALUES (1, 'LOADING');
 INSERT INTO graph_status (idgraph_status, description) VALUES (2, 'OPERATIONAL');
 INSERT INTO graph_status (idgraph_status, description) VALUES (3, 'DELETED');
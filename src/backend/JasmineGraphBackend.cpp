@@ -13,6 +13,8 @@ limitations under the License.
 
 #include "JasmineGraphBackend.h"
 
+#include "../../globals.h"
+#include "../k8s/K8sWorkerController.h"
 #include "../util/Conts.h"
 #include "../util/Utils.h"
 #include "../util/logger/Logger.h"
@@ -62,6 +64,13 @@ void *backendservicesesion(void *dummyPt) {
             worker_info.erase(std::remove(worker_info.begin(), worker_info.end(), '\r'), worker_info.end());
 
             std::vector<std::string> strArr = Utils::split(worker_info, '|');
+            if (strArr.size() < 2) {
+                backend_logger.error("Invalid worker info: " + worker_info);
+                break;
+            }
+            if (jasminegraph_profile == PROFILE_K8S) {
+                K8sWorkerController::workerReady(strArr[0]);
+            }
 
             std::string updateQuery =
                 "update worker set status='started' where ip='" + strArr[0] + "' and server_port='" + strArr[1] + "';";
@@ -127,7 +127,9 @@ bool JasmineGraphHashMapCentralStore::storeGraph() {
     return result;
 }
 
-map<long, unordered_set<long>> JasmineGraphHashMapCentralStore::getUnderlyingHashMap() { return centralSubgraphMap; }
+const map<long, unordered_set<long>> &JasmineGraphHashMapCentralStore::getUnderlyingHashMap() const {
+    return centralSubgraphMap;
+}
 
 map<long, long> JasmineGraphHashMapCentralStore::getOutDegreeDistributionHashMap() {
     map<long, long> distributionHashMap;
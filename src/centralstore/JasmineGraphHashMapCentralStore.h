@@ -64,7 +64,7 @@ class JasmineGraphHashMapCentralStore : public JasmineGraphLocalStore {
 
     bool storeGraph();
 
-    map<long, unordered_set<long>> getUnderlyingHashMap();
+    const map<long, unordered_set<long>> &getUnderlyingHashMap() const;
 
     map<long, long> getOutDegreeDistributionHashMap();
 
@@ -14,6 +14,7 @@ limitations under the License.
 #include "JasmineGraphFrontEnd.h"
 
 #include <spdlog/spdlog.h>
+#include <sys/epoll.h>
 
 #include <algorithm>
 #include <cctype>
@@ -36,18 +37,24 @@ limitations under the License.
 #include "../partitioner/stream/Partitioner.h"
 #include "../performance/metrics/PerformanceUtil.h"
 #include "../query/algorithms/linkprediction/JasminGraphLinkPredictor.h"
+#include "../query/algorithms/triangles/StreamingTriangleCounter.h"
+#include "../server/ClusterTopology.h"
 #include "../server/JasmineGraphInstanceProtocol.h"
 #include "../server/JasmineGraphServer.h"
+#include "../server/ReplicaManager.h"
 #include "../util/Conts.h"
 #include "../util/kafka/KafkaCC.h"
 #include "../util/kafka/StreamHandler.h"
 #include "../util/logger/Logger.h"
+#include "../util/scheduler/ctpl_stl.h"
 #include "JasmineGraphFrontEndProtocol.h"
 #include "core/CoreConstants.h"
 #include "core/scheduler/JobScheduler.h"
 
 #define MAX_PENDING_CONNECTIONS 10
 #define DATA_BUFFER_SIZE (FRONTEND_DATA_LENGTH + 1)
+#define DEFAULT_DEGREE_DISTRIBUTION_TOP_N 10
+#define EGONET_WRITE_BUFFER_SIZE (64 * 1024)
 
 using json = nlohmann::json;
 using namespace std;
@@ -55,7 +62,7 @@ using namespace std::chrono;
 
 std::atomic<int> highPriorityTaskCount;
 static int connFd;
-static volatile int currentFESession;
+static std::atomic<int> currentFESession(0);
 static bool canCalibrate = true;
 Logger frontend_logger;
 std::set<ProcessInfo> processData;
@@ -70,10 +77,11 @@ static void add_graph_cust_command(std::string masterIP, int connFd, SQLiteDBInt
 static void remove_graph_command(std::string masterIP, int connFd, SQLiteDBInterface *sqlite, bool *loop_exit_p);
 static void add_model_command(int connFd, SQLiteDBInterface *sqlite, bool *loop_exit_p);
 static void add_stream_kafka_command(int connFd, std::string &kafka_server_IP, cppkafka::Configuration &configs,
-                                     KafkaConnector *&kstream, thread &input_stream_handler_thread,
-                                     vector<DataPublisher *> &workerClients, int numberOfPartitions,
-                                     SQLiteDBInterface *sqlite, bool *loop_exit_p);
-static void stop_stream_kafka_command(int connFd, KafkaConnector *kstream, bool *loop_exit_p);
+                                     KafkaConnector *&kstream, StreamHandler *&stream_handler,
+                                     thread &input_stream_handler_thread, vector<DataPublisher *> &workerClients,
+                                     int numberOfPartitions, SQLiteDBInterface *sqlite, bool *loop_exit_p);
+static void stop_stream_kafka_command(int connFd, KafkaConnector *kstream, StreamHandler *stream_handler,
+                                      bool *loop_exit_p);
 static void process_dataset_command(int connFd, bool *loop_exit_p);
 static void triangles_command(std::string masterIP, int connFd, SQLiteDBInterface *sqlite,
                               PerformanceSQLiteDBInterface *perfSqlite, JobScheduler *jobScheduler, bool *loop_exit_p);
@@ -108,139 +116,190 @@ static vector<DataPublisher *> getWorkerClients(SQLiteDBInterface *sqlite) {
     return workerClients;
 }
 
-void *frontendservicesesion(void *dummyPt) {
-    frontendservicesessionargs *sessionargs = (frontendservicesessionargs *)dummyPt;
-    std::string masterIP = sessionargs->masterIP;
-    int connFd = sessionargs->connFd;
-    SQLiteDBInterface *sqlite = sessionargs->sqlite;
-    PerformanceSQLiteDBInterface *perfSqlite = sessionargs->perfSqlite;
-    JobScheduler *jobScheduler = sessionargs->jobScheduler;
-    delete sessionargs;
-    if (currentFESession++ > Conts::MAX_FE_SESSIONS) {
-        if (!Utils::send_str_wrapper(connFd, "JasmineGraph server is busy. Please try again later.")) {
-            frontend_logger.error("Error writing to socket");
-        }
-        close(connFd);
-        currentFESession--;
-        return NULL;
-    }
-
-    char data[FRONTEND_DATA_LENGTH + 1];
-    //  Initiate Thread
+/*
+ * Per-connection state of a frontend client. A session is either parked in the epoll set waiting for its next
+ * command, or running exactly one command. The connection is registered with EPOLLONESHOT, so it is never handed to
+ * two executors at once and is re-armed only after the running command returns. The reactor reads each command;
+ * control commands run on the reactor itself so that they still get through when every executor is busy.
+ * */
+struct FrontendSession {
+    int connFd;
     thread input_stream_handler;
-    //  Initiate kafka consumer parameters
-    std::string partitionCount = Utils::getJasmineGraphProperty("org.jasminegraph.server.npartitions");
-    int numberOfPartitions = std::stoi(partitionCount);
     std::string kafka_server_IP;
     cppkafka::Configuration configs;
-    KafkaConnector *kstream;
-    Partitioner graphPartitioner(numberOfPartitions, 1, spt::Algorithms::HASH);
-
+    KafkaConnector *kstream = nullptr;
+    StreamHandler *stream_handler = nullptr;  // Runs on input_stream_handler
     vector<DataPublisher *> workerClients;
     bool workerClientsInitialized = false;
+};
+
+/*
+ * Stops the Kafka stream of a session, if it has one, and waits for it. Must not run on the reactor, as the stream
+ * only notices the stop after its current poll.
+ * */
+static void endFrontendStream(FrontendSession *session) {
+    if (!session->input_stream_handler.joinable()) {
+        return;
+    }
+    session->stream_handler->stop();
+    session->input_stream_handler.join();
+    delete session->stream_handler;
+    session->stream_handler = nullptr;
+    delete session->kstream;
+    session->kstream = nullptr;
+}
+
+/*
+ * Reads the next command of a readable session. Returns false if the client went away.
+ * */
+static bool readFrontendCommand(FrontendSession *session, std::string &line) {
+    char data[FRONTEND_DATA_LENGTH + 1];
+    line = Utils::read_str_wrapper(session->connFd, data, FRONTEND_DATA_LENGTH, true);
+    if (line.empty()) {
+        // The reactor only hands over readable connections, so nothing to read means the client went away
+        return false;
+    }
+    line = Utils::trim_copy(line);
+    return true;
+}
+
+/*
+ * Runs a single command of a session. Returns true if the session should be closed.
+ * */
+static bool runFrontendCommand(FrontendSession *session, const std::string &line, const std::string &masterIP,
+                               SQLiteDBInterface *sqlite, PerformanceSQLiteDBInterface *perfSqlite,
+                               JobScheduler *jobScheduler) {
+    int connFd = session->connFd;
+    frontend_logger.info("Command received: " + line);
+    if (line.empty()) {
+        return false;
+    }
+
+    if (currentFESession > 1) {
+        canCalibrate = false;
+    } else {
+        canCalibrate = true;
+        workerResponded = false;
+    }
+
+    std::string partitionCount = Utils::getJasmineGraphProperty("org.jasminegraph.server.npartitions");
+    int numberOfPartitions = std::stoi(partitionCount);
 
     bool loop_exit = false;
-    int failCnt = 0;
-    while (!loop_exit) {
-        string line = Utils::read_str_wrapper(connFd, data, FRONTEND_DATA_LENGTH, true);
-        if (line.empty()) {
-            failCnt++;
-            if (failCnt > 4) {
-                break;
-            }
-            sleep(1);
-            continue;
-        }
-        failCnt = 0;
-        line = Utils::trim_copy(line);
-        frontend_logger.info("Command received: " + line);
-        if (line.empty()) {
-            continue;
+    if (line.compare(EXIT) == 0) {
+        loop_exit = true;
+    } else if (line.compare(LIST) == 0) {
+        list_command(connFd, sqlite, &loop_exit);
+    } else if (line.compare(SHTDN) == 0) {
+        JasmineGraphServer::shutdown_workers();
+        close(connFd);
+        exit(0);
+    } else if (line.compare(ADRDF) == 0) {
+        add_rdf_command(masterIP, connFd, sqlite, &loop_exit);
+    } else if (line.compare(ADGR) == 0) {
+        add_graph_command(masterIP, connFd, sqlite, &loop_exit);
+    } else if (line.compare(ADMDL) == 0) {
+        add_model_command(connFd, sqlite, &loop_exit);
+    } else if (line.compare(ADGR_CUST) == 0) {
+        add_graph_cust_command(masterIP, connFd, sqlite, &loop_exit);
+    } else if (line.compare(ADD_STREAM_KAFKA) == 0) {
+        if (!session->workerClientsInitialized) {
+            session->workerClients = getWorkerClients(sqlite);
+            session->workerClientsInitialized = true;
+        }
+        endFrontendStream(session);
+        add_stream_kafka_command(connFd, session->kafka_server_IP, session->configs, session->kstream,
+                                 session->stream_handler, session->input_stream_handler, session->workerClients,
+                                 numberOfPartitions, sqlite, &loop_exit);
+    } else if (line.compare(STOP_STREAM_KAFKA) == 0) {
+        stop_stream_kafka_command(connFd, session->kstream, session->stream_handler, &loop_exit);
+    } else if (line.compare(RMGR) == 0) {
+        remove_graph_command(masterIP, connFd, sqlite, &loop_exit);
+    } else if (line.compare(PROCESS_DATASET) == 0) {
+        process_dataset_command(connFd, &loop_exit);
+    } else if (line.compare(TRIANGLES) == 0) {
+        triangles_command(masterIP, connFd, sqlite, perfSqlite, jobScheduler, &loop_exit);
+    } else if (line.compare(STREAMING_TRIANGLES) == 0) {
+        streaming_triangles_command(masterIP, connFd, jobScheduler, &loop_exit, numberOfPartitions,
+                                    &JasmineGraphFrontEnd::strian_exit);
+    } else if (line.compare(STOP_STRIAN) == 0) {
+        stop_strian_command(connFd, &JasmineGraphFrontEnd::strian_exit);
+    } else if (line.compare(VCOUNT) == 0) {
+        vertex_count_command(connFd, sqlite, &loop_exit);
+    } else if (line.compare(ECOUNT) == 0) {
+        edge_count_command(connFd, sqlite, &loop_exit);
+    } else if (line.compare(MERGE) == 0) {
+        merge_command(connFd, sqlite, &loop_exit);
+    } else if (line.compare(TRAIN) == 0) {
+        train_command(connFd, sqlite, &loop_exit);
+    } else if (line.compare(IN_DEGREE) == 0) {
+        in_degree_command(connFd, &loop_exit);
+    } else if (line.compare(OUT_DEGREE) == 0) {
+        out_degree_command(connFd, &loop_exit);
+    } else if (line.compare(PAGE_RANK) == 0) {
+        page_rank_command(masterIP, connFd, sqlite, perfSqlite, jobScheduler, &loop_exit);
+    } else if (line.compare(EGONET) == 0) {
+        egonet_command(connFd, &loop_exit);
+    } else if (line.compare(DPCNTRL) == 0) {
+        duplicate_centralstore_command(connFd, &loop_exit);
+    } else if (line.compare(PREDICT) == 0) {
+        predict_command(masterIP, connFd, sqlite, &loop_exit);
+    } else if (line.compare(START_REMOTE_WORKER) == 0) {
+        start_remote_worker_command(connFd, &loop_exit);
+    } else if (line.compare(SLA) == 0) {
+        sla_command(connFd, sqlite, perfSqlite, &loop_exit);
+    } else {
+        frontend_logger.error("Message format not recognized " + line);
+        int result_wr = write(connFd, INVALID_FORMAT.c_str(), INVALID_FORMAT.size());
+        if (result_wr < 0) {
+            frontend_logger.error("Error writing to socket");
+            loop_exit = true;
         }
+    }
+    return loop_exit;
+}
 
-        if (currentFESession > 1) {
-            canCalibrate = false;
-        } else {
-            canCalibrate = true;
-            workerResponded = false;
-        }
-
-        if (line.compare(EXIT) == 0) {
-            break;
-        } else if (line.compare(LIST) == 0) {
-            list_command(connFd, sqlite, &loop_exit);
-        } else if (line.compare(SHTDN) == 0) {
-            JasmineGraphServer::shutdown_workers();
-            close(connFd);
-            exit(0);
-        } else if (line.compare(ADRDF) == 0) {
-            add_rdf_command(masterIP, connFd, sqlite, &loop_exit);
-        } else if (line.compare(ADGR) == 0) {
-            add_graph_command(masterIP, connFd, sqlite, &loop_exit);
-        } else if (line.compare(ADMDL) == 0) {
-            add_model_command(connFd, sqlite, &loop_exit);
-        } else if (line.compare(ADGR_CUST) == 0) {
-            add_graph_cust_command(masterIP, connFd, sqlite, &loop_exit);
-        } else if (line.compare(ADD_STREAM_KAFKA) == 0) {
-            if (!workerClientsInitialized) {
-                workerClients = getWorkerClients(sqlite);
-                workerClientsInitialized = true;
-            }
-            add_stream_kafka_command(connFd, kafka_server_IP, configs, kstream, input_stream_handler, workerClients,
-                                     numberOfPartitions, sqlite, &loop_exit);
-        } else if (line.compare(STOP_STREAM_KAFKA) == 0) {
-            stop_stream_kafka_command(connFd, kstream, &loop_exit);
-        } else if (line.compare(RMGR) == 0) {
-            remove_graph_command(masterIP, connFd, sqlite, &loop_exit);
-        } else if (line.compare(PROCESS_DATASET) == 0) {
-            process_dataset_command(connFd, &loop_exit);
-        } else if (line.compare(TRIANGLES) == 0) {
-            triangles_command(masterIP, connFd, sqlite, perfSqlite, jobScheduler, &loop_exit);
-        } else if (line.compare(STREAMING_TRIANGLES) == 0) {
-            streaming_triangles_command(masterIP, connFd, jobScheduler, &loop_exit,
-                                        numberOfPartitions, &JasmineGraphFrontEnd::strian_exit);
-        } else if (line.compare(STOP_STRIAN) == 0) {
-            stop_strian_command(connFd, &JasmineGraphFrontEnd::strian_exit);
-        } else if (line.compare(VCOUNT) == 0) {
-            vertex_count_command(connFd, sqlite, &loop_exit);
-        } else if (line.compare(ECOUNT) == 0) {
-            edge_count_command(connFd, sqlite, &loop_exit);
-        } else if (line.compare(MERGE) == 0) {
-            merge_command(connFd, sqlite, &loop_exit);
-        } else if (line.compare(TRAIN) == 0) {
-            train_command(connFd, sqlite, &loop_exit);
-        } else if (line.compare(IN_DEGREE) == 0) {
-            in_degree_command(connFd, &loop_exit);
-        } else if (line.compare(OUT_DEGREE) == 0) {
-            out_degree_command(connFd, &loop_exit);
-        } else if (line.compare(PAGE_RANK) == 0) {
-            page_rank_command(masterIP, connFd, sqlite, perfSqlite, jobScheduler, &loop_exit);
-        } else if (line.compare(EGONET) == 0) {
-            egonet_command(connFd, &loop_exit);
-        } else if (line.compare(DPCNTRL) == 0) {
-            duplicate_centralstore_command(connFd, &loop_exit);
-        } else if (line.compare(PREDICT) == 0) {
-            predict_command(masterIP, connFd, sqlite, &loop_exit);
-        } else if (line.compare(START_REMOTE_WORKER) == 0) {
-            start_remote_worker_command(connFd, &loop_exit);
-        } else if (line.compare(SLA) == 0) {
-            sla_command(connFd, sqlite, perfSqlite, &loop_exit);
-        } else {
-            frontend_logger.error("Message format not recognized " + line);
-            int result_wr = write(connFd, INVALID_FORMAT.c_str(), INVALID_FORMAT.size());
-            if (result_wr < 0) {
-                frontend_logger.error("Error writing to socket");
-                break;
-            }
-        }
+/*
+ * Closing a session can run on the reactor, so a Kafka stream it still reads is only told to stop there. A detached
+ * thread waits for the stream, which notices the stop after its current poll, and then frees the session.
+ * */
+static void closeFrontendSession(FrontendSession *session) {
+    frontend_logger.info("Closing connection " + to_string(session->connFd));
+    close(session->connFd);
+    currentFESession--;
+    if (!session->input_stream_handler.joinable()) {
+        delete session;
+        return;
     }
-    if (input_stream_handler.joinable()) {
-        input_stream_handler.join();
+    session->stream_handler->stop();
+    std::thread([session]() {
+        endFrontendStream(session);
+        delete session;
+    }).detach();
+}
+
+static bool armFrontendSession(int epollFd, FrontendSession *session, int operation) {
+    struct epoll_event event;
+    event.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+    event.data.ptr = session;
+    if (epoll_ctl(epollFd, operation, session->connFd, &event) < 0) {
+        frontend_logger.error("Cannot watch connection " + to_string(session->connFd) + ": " + strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+bool JasmineGraphFrontEnd::isControlCommand(const std::string &command) {
+    return command == EXIT || command == SHTDN || command == STOP_STRIAN || command == STOP_STREAM_KAFKA;
+}
+
+void JasmineGraphFrontEnd::dispatchCommand(const std::string &command, ctpl::thread_pool &executors,
+                                           const std::function<void()> &task) {
+    if (isControlCommand(command)) {
+        task();
+    } else {
+        executors.push([task](int id) { task(); });
     }
-    frontend_logger.info("Closing thread " + to_string(pthread_self()) + " and connection");
-    close(connFd);
-    currentFESession--;
-    return NULL;
 }
 
 JasmineGraphFrontEnd::JasmineGraphFrontEnd(SQLiteDBInterface *db, PerformanceSQLiteDBInterface *perfDb,
@@ -252,11 +311,9 @@ JasmineGraphFrontEnd::JasmineGraphFrontEnd(SQLiteDBInterface *db, PerformanceSQL
 }
 
 int JasmineGraphFrontEnd::run() {
-    int pId;
     int portNo = Conts::JASMINEGRAPH_FRONTEND_PORT;
     int listenFd;
     socklen_t len;
-    bool loop = false;
     struct sockaddr_in svrAdd;
     struct sockaddr_in clntAdd;
 
@@ -288,32 +345,73 @@ int JasmineGraphFrontEnd::run() {
 
     listen(listenFd, MAX_PENDING_CONNECTIONS);
 
-    std::vector<std::thread> threadVector;
-    len = sizeof(clntAdd);
+    int epollFd = epoll_create1(0);
+    if (epollFd < 0) {
+        frontend_logger.error("Cannot create epoll instance");
+        return 0;
+    }
+    struct epoll_event listenEvent;
+    listenEvent.events = EPOLLIN;
+    listenEvent.data.ptr = NULL;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &listenEvent);
 
-    int noThread = 0;
+    // Idle clients cost no thread. Only connections with a pending command occupy an executor.
+    ctpl::thread_pool executors(Conts::MAX_FE_EXECUTORS);
+    std::string masterIP = this->masterIP;
+    SQLiteDBInterface *sqlite = this->sqlite;
+    PerformanceSQLiteDBInterface *perfSqlite = this->perfSqlite;
+    JobScheduler *jobScheduler = this->jobScheduler;
 
+    frontend_logger.info("Frontend Listening");
+    struct epoll_event events[MAX_PENDING_CONNECTIONS];
     while (true) {
-        frontend_logger.info("Frontend Listening");
-
-        // this is where client connects. svr will hang in this mode until client conn
-        connFd = accept(listenFd, (struct sockaddr *)&clntAdd, &len);
-
-        if (connFd < 0) {
-            frontend_logger.error("Cannot accept connection");
+        int eventCount = epoll_wait(epollFd, events, MAX_PENDING_CONNECTIONS, -1);
+        if (eventCount < 0) {
+            if (errno != EINTR) {
+                frontend_logger.error("epoll_wait failed: " + std::string(strerror(errno)));
+            }
             continue;
         }
-        frontend_logger.info("Connection successful from " + std::string(inet_ntoa(clntAdd.sin_addr)));
+        for (int i = 0; i < eventCount; i++) {
+            FrontendSession *session = (FrontendSession *)events[i].data.ptr;
+            if (session == NULL) {
+                len = sizeof(clntAdd);
+                connFd = accept(listenFd, (struct sockaddr *)&clntAdd, &len);
+                if (connFd < 0) {
+                    frontend_logger.error("Cannot accept connection");
+                    continue;
+                }
+                frontend_logger.info("Connection successful from " + std::string(inet_ntoa(clntAdd.sin_addr)));
+
+                if (currentFESession >= Conts::MAX_FE_SESSIONS) {
+                    if (!Utils::send_str_wrapper(connFd, "JasmineGraph server is busy. Please try again later.")) {
+                        frontend_logger.error("Error writing to socket");
+                    }
+                    close(connFd);
+                    continue;
+                }
+                currentFESession++;
+                session = new FrontendSession;
+                session->connFd = connFd;
+                if (!armFrontendSession(epollFd, session, EPOLL_CTL_ADD)) {
+                    closeFrontendSession(session);
+                }
+                continue;
+            }
 
-        frontendservicesessionargs *sessionargs = new frontendservicesessionargs;
-        sessionargs->masterIP = masterIP;
-        sessionargs->connFd = connFd;
-        sessionargs->sqlite = this->sqlite;
-        sessionargs->perfSqlite = this->perfSqlite;
-        sessionargs->jobScheduler = this->jobScheduler;
-        pthread_t pt;
-        pthread_create(&pt, NULL, frontendservicesesion, sessionargs);
-        pthread_detach(pt);
+            std::string line;
+            if (!readFrontendCommand(session, line)) {
+                closeFrontendSession(session);
+                continue;
+            }
+            JasmineGraphFrontEnd::dispatchCommand(
+                line, executors, [session, line, epollFd, masterIP, sqlite, perfSqlite, jobScheduler]() {
+                    bool closeSession = runFrontendCommand(session, line, masterIP, sqlite, perfSqlite, jobScheduler);
+                    if (closeSession || !armFrontendSession(epollFd, session, EPOLL_CTL_MOD)) {
+                        closeFrontendSession(session);
+                    }
+                });
+        }
     }
 }
 
@@ -388,8 +486,10 @@ void JasmineGraphFrontEnd::removeGraph(std::string graphID, SQLiteDBInterface *s
     JasmineGraphServer::removeGraph(hostHasPartition, graphID, masterIP);
 
     sqlite->runUpdate("DELETE FROM worker_has_partition WHERE partition_graph_idgraph = " + graphID);
+    ReplicaManager::removeGraph(atoi(graphID.c_str()), sqlite);
     sqlite->runUpdate("DELETE FROM partition WHERE graph_idgraph = " + graphID);
     sqlite->runUpdate("DELETE FROM graph WHERE idgraph = " + graphID);
+    ClusterTopology::removeGraph(atoi(graphID.c_str()));
 }
 
 /**
@@ -1124,9 +1224,9 @@ static void add_model_command(int connFd, SQLiteDBInterface *sqlite, bool *loop_
 }
 
 static void add_stream_kafka_command(int connFd, std::string &kafka_server_IP, cppkafka::Configuration &configs,
-                                     KafkaConnector *&kstream, thread &input_stream_handler_thread,
-                                     vector<DataPublisher *> &workerClients, int numberOfPartitions,
-                                     SQLiteDBInterface *sqlite, bool *loop_exit_p) {
+                                     KafkaConnector *&kstream, StreamHandler *&stream_handler,
+                                     thread &input_stream_handler_thread, vector<DataPublisher *> &workerClients,
+                                     int numberOfPartitions, SQLiteDBInterface *sqlite, bool *loop_exit_p) {
     string msg_1 = "Do you want to use default KAFKA consumer(y/n) ?";
     int result_wr = write(connFd, msg_1.c_str(), msg_1.length());
     if (result_wr < 0) {
@@ -1235,7 +1335,7 @@ static void add_stream_kafka_command(int connFd, std::string &kafka_server_IP, c
     // Subscribe to the Kafka topic.
     kstream->Subscribe(topic_name_s);
     // Create the StreamHandler object.
-    StreamHandler *stream_handler = new StreamHandler(kstream, numberOfPartitions, workerClients);
+    stream_handler = new StreamHandler(kstream, numberOfPartitions, workerClients);
 
     string path = "kafka:\\" + topic_name_s + ":" + group_id;
     std::time_t time = chrono::system_clock::to_time_t(chrono::system_clock::now());
@@ -1251,10 +1351,16 @@ static void add_stream_kafka_command(int connFd, std::string &kafka_server_IP, c
     input_stream_handler_thread = thread(&StreamHandler::listen_to_kafka_topic, stream_handler);
 }
 
-static void stop_stream_kafka_command(int connFd, KafkaConnector *kstream, bool *loop_exit_p) {
+static void stop_stream_kafka_command(int connFd, KafkaConnector *kstream, StreamHandler *stream_handler,
+                                      bool *loop_exit_p) {
     frontend_logger.info("Start serving `" + STOP_STREAM_KAFKA + "` command");
     //          Unsubscribe the kafka consumer.
-    kstream->Unsubscribe();
+    if (stream_handler) {
+        stream_handler->stop();  // The session joins the stream thread when it ends or starts another stream
+    }
+    if (kstream) {
+        kstream->Unsubscribe();
+    }
     string message = "Successfully stop `" + stream_topic_name + "` input kafka stream";
     int result_wr = write(connFd, message.c_str(), message.length());
     if (result_wr < 0) {
@@ -1343,6 +1449,14 @@ static void triangles_command(std::string masterIP, int connFd, SQLiteDBInterfac
     graph_id.erase(std::remove(graph_id.begin(), graph_id.end(), '\n'), graph_id.end());
     graph_id.erase(std::remove(graph_id.begin(), graph_id.end(), '\r'), graph_id.end());
 
+    // The graph ID may be followed by the plan for triangles spanning three partitions, as in "<graphID>|shuffle"
+    std::string centralTrianglePlan = "";
+    size_t planSeparator = graph_id.find('|');
+    if (planSeparator != std::string::npos) {
+        centralTrianglePlan = Utils::trim_copy(graph_id.substr(planSeparator + 1));
+        graph_id = Utils::trim_copy(graph_id.substr(0, planSeparator));
+    }
+
     if (!JasmineGraphFrontEnd::graphExistsByID(graph_id, sqlite)) {
         string error_message = "The specified graph id does not exist";
         result_wr = write(connFd, error_message.c_str(), FRONTEND_COMMAND_LENGTH);
@@ -1436,6 +1550,9 @@ static void triangles_command(std::string masterIP, int connFd, SQLiteDBInterfac
         jobDetails.setMasterIP(masterIP);
         jobDetails.addParameter(Conts::PARAM_KEYS::GRAPH_ID, graph_id);
         jobDetails.addParameter(Conts::PARAM_KEYS::CATEGORY, Conts::SLA_CATEGORY::LATENCY);
+        if (!centralTrianglePlan.empty()) {
+            jobDetails.addParameter(Conts::PARAM_KEYS::CENTRAL_TRIANGLE_PLAN, centralTrianglePlan);
+        }
         if (canCalibrate) {
             jobDetails.addParameter(Conts::PARAM_KEYS::CAN_CALIBRATE, "true");
         } else {
@@ -1547,6 +1664,41 @@ static void streaming_triangles_command(std::string masterIP, int connFd, JobSch
     mode = Utils::trim_copy(mode, " \f\n\r\t\v");
     frontend_logger.info("Got mode " + mode);
 
+    // Mode 2 counts the triangles of a sliding window of the stream, such as 10m or 5000e. The edges of an edge window
+    // are split between the partitions, see StreamingTriangleCountExecutor::execute().
+    string window;
+    if (mode == "2") {
+        result_wr = write(connFd, SEND_WINDOW.c_str(), SEND_WINDOW.size());
+        if (result_wr < 0) {
+            frontend_logger.error("Error writing to socket");
+            *loop_exit_p = true;
+            return;
+        }
+        result_wr = write(connFd, Conts::CARRIAGE_RETURN_NEW_LINE.c_str(), Conts::CARRIAGE_RETURN_NEW_LINE.size());
+        if (result_wr < 0) {
+            frontend_logger.error("Error writing to socket");
+            *loop_exit_p = true;
+            return;
+        }
+
+        char window_data[FRONTEND_DATA_LENGTH + 1];
+        bzero(window_data, FRONTEND_DATA_LENGTH + 1);
+        read(connFd, window_data, FRONTEND_DATA_LENGTH);
+        window = Utils::trim_copy(string(window_data), " \f\n\r\t\v");
+        frontend_logger.info("Got window " + window);
+
+        TriangleWindow parsed;
+        if (!StreamingTriangleCounter::parseWindow(window, parsed)) {
+            frontend_logger.error("Invalid streaming triangle window " + window);
+            result_wr = write(connFd, INVALID_FORMAT.c_str(), INVALID_FORMAT.size());
+            if (result_wr < 0) {
+                frontend_logger.error("Error writing to socket");
+                *loop_exit_p = true;
+            }
+            return;
+        }
+    }
+
     std::priority_queue<JobRequest> jobQueue;
     JobRequest jobDetails;
     jobDetails.setJobType(STREAMING_TRIANGLES);
@@ -1554,6 +1706,7 @@ static void streaming_triangles_command(std::string masterIP, int connFd, JobSch
     jobDetails.setMasterIP(masterIP);
     jobDetails.addParameter(Conts::PARAM_KEYS::GRAPH_ID, graph_id);
     jobDetails.addParameter(Conts::PARAM_KEYS::MODE, mode);
+    jobDetails.addParameter(Conts::PARAM_KEYS::WINDOW, window);
     jobDetails.addParameter(Conts::PARAM_KEYS::PARTITION, std::to_string(numberOfPartitions));
 
     if (*strian_exit) {
@@ -1571,18 +1724,20 @@ static void streaming_triangles_command(std::string masterIP, int connFd, JobSch
 
             if (!errorMessage.empty()) {
                 *loop_exit_p = true;
+                // The scheduler thread reads the job details and the queue, so it is stopped and joined below
+                *strian_exit = true;
                 result_wr = write(connFd, errorMessage.c_str(), errorMessage.length());
 
                 if (result_wr < 0) {
                     frontend_logger.error("Error writing to socket");
-                    return;
+                    break;
                 }
                 result_wr = write(connFd, Conts::CARRIAGE_RETURN_NEW_LINE.c_str(),
                                   Conts::CARRIAGE_RETURN_NEW_LINE.size());
                 if (result_wr < 0) {
                     frontend_logger.error("Error writing to socket");
                 }
-                return;
+                break;
             }
 
             std::string triangleCount = jobResponse.getParameter(Conts::PARAM_KEYS::STREAMING_TRIANGLE_COUNT);
@@ -1599,7 +1754,8 @@ static void streaming_triangles_command(std::string masterIP, int connFd, JobSch
             if (result_wr < 0) {
                 frontend_logger.error("Error writing to socket");
                 *loop_exit_p = true;
-                return;
+                *strian_exit = true;
+                break;
             }
             result_wr = write(connFd, Conts::CARRIAGE_RETURN_NEW_LINE.c_str(), Conts::CARRIAGE_RETURN_NEW_LINE.size());
             if (result_wr < 0) {
@@ -1922,9 +2078,7 @@ static void train_command(int connFd, SQLiteDBInterface *sqlite, bool *loop_exit
     }
 }
 
-static void in_degree_command(int connFd, bool *loop_exit_p) {
-    frontend_logger.info("Calculating In Degree Distribution");
-
+static void degree_distribution_command(int connFd, bool in, bool *loop_exit_p) {
     int result_wr = write(connFd, SEND.c_str(), FRONTEND_COMMAND_LENGTH);
     if (result_wr < 0) {
         frontend_logger.error("Error writing to socket");
@@ -1943,30 +2097,29 @@ static void in_degree_command(int connFd, bool *loop_exit_p) {
 
     read(connFd, graph_id, FRONTEND_DATA_LENGTH);
 
-    string graphID(graph_id);
-
-    graphID = Utils::trim_copy(graphID);
+    // Accepts "<graph id>" or "<graph id>|<number of top vertices>"
+    std::vector<std::string> strArr = Utils::split(Utils::trim_copy(string(graph_id)), '|');
+    string graphID = strArr.empty() ? "" : Utils::trim_copy(strArr[0]);
+    int topN = DEFAULT_DEGREE_DISTRIBUTION_TOP_N;
+    if (strArr.size() > 1) {
+        topN = atoi(strArr[1].c_str());
+        if (topN < 0) {
+            topN = DEFAULT_DEGREE_DISTRIBUTION_TOP_N;
+        }
+    }
     frontend_logger.info("Graph ID received: " + graphID);
 
-    JasmineGraphServer::inDegreeDistribution(graphID);
+    string summary = in ? JasmineGraphServer::inDegreeDistribution(graphID, topN)
+                        : JasmineGraphServer::outDegreeDistribution(graphID, topN);
+    summary += "\r\n";
 
-    result_wr = write(connFd, DONE.c_str(), FRONTEND_COMMAND_LENGTH);
+    result_wr = write(connFd, summary.c_str(), summary.length());
     if (result_wr < 0) {
         frontend_logger.error("Error writing to socket");
         *loop_exit_p = true;
         return;
     }
-    result_wr = write(connFd, "\r\n", 2);
-    if (result_wr < 0) {
-        frontend_logger.error("Error writing to socket");
-        *loop_exit_p = true;
-    }
-}
-
-static void out_degree_command(int connFd, bool *loop_exit_p) {
-    frontend_logger.info("Calculating Out Degree Distribution");
-
-    int result_wr = write(connFd, SEND.c_str(), FRONTEND_COMMAND_LENGTH);
+    result_wr = write(connFd, DONE.c_str(), FRONTEND_COMMAND_LENGTH);
     if (result_wr < 0) {
         frontend_logger.error("Error writing to socket");
         *loop_exit_p = true;
@@ -1976,32 +2129,17 @@ static void out_degree_command(int connFd, bool *loop_exit_p) {
     if (result_wr < 0) {
         frontend_logger.error("Error writing to socket");
         *loop_exit_p = true;
-        return;
     }
+}
 
-    char graph_id[FRONTEND_DATA_LENGTH + 1];
-    bzero(graph_id, FRONTEND_DATA_LENGTH + 1);
-
-    read(connFd, graph_id, FRONTEND_DATA_LENGTH);
-
-    string graphID(graph_id);
-
-    graphID = Utils::trim_copy(graphID);
-    frontend_logger.info("Graph ID received: " + graphID);
-
-    JasmineGraphServer::outDegreeDistribution(graphID);
+static void in_degree_command(int connFd, bool *loop_exit_p) {
+    frontend_logger.info("Calculating In Degree Distribution");
+    degree_distribution_command(connFd, true, loop_exit_p);
+}
 
-    result_wr = write(connFd, DONE.c_str(), FRONTEND_COMMAND_LENGTH);
-    if (result_wr < 0) {
-        frontend_logger.error("Error writing to socket");
-        *loop_exit_p = true;
-        return;
-    }
-    result_wr = write(connFd, "\r\n", 2);
-    if (result_wr < 0) {
-        frontend_logger.error("Error writing to socket");
-        *loop_exit_p = true;
-    }
+static void out_degree_command(int connFd, bool *loop_exit_p) {
+    frontend_logger.info("Calculating Out Degree Distribution");
+    degree_distribution_command(connFd, false, loop_exit_p);
 }
 
 static void page_rank_command(std::string masterIP, int connFd, SQLiteDBInterface *sqlite,
@@ -2208,12 +2346,42 @@ static void egonet_command(int connFd, bool *loop_exit_p) {
 
     read(connFd, graph_id, FRONTEND_DATA_LENGTH);
 
-    string graphID(graph_id);
-
-    graphID = Utils::trim_copy(graphID);
+    // Accepts "<graph id>" to write the ego networks of all vertices on the workers, or
+    // "<graph id>|<vertex>,<vertex>,..." to stream the ego networks of the vertices back as "<ego> <from> <to>" lines
+    std::vector<std::string> strArr = Utils::split(Utils::trim_copy(string(graph_id)), '|');
+    string graphID = strArr.empty() ? "" : Utils::trim_copy(strArr[0]);
     frontend_logger.info("Graph ID received: " + graphID);
 
-    JasmineGraphServer::egoNet(graphID);
+    if (strArr.size() > 1) {
+        std::vector<long> vertices;
+        for (const auto &vertex : Utils::split(strArr[1], ',')) {
+            if (!Utils::trim_copy(vertex).empty()) {
+                vertices.push_back(atol(vertex.c_str()));
+            }
+        }
+        string lines;
+        bool failed = false;
+        auto flush = [connFd, &lines, &failed]() {
+            if (!failed && !lines.empty() && write(connFd, lines.c_str(), lines.length()) < 0) {
+                failed = true;
+            }
+            lines.clear();
+        };
+        JasmineGraphServer::egoNet(graphID, vertices, [&lines, &flush](long ego, long from, long to) {
+            lines += to_string(ego) + " " + to_string(from) + " " + to_string(to) + "\r\n";
+            if (lines.length() >= EGONET_WRITE_BUFFER_SIZE) {
+                flush();
+            }
+        });
+        flush();
+        if (failed) {
+            frontend_logger.error("Error writing to socket");
+            *loop_exit_p = true;
+            return;
+        }
+    } else {
+        JasmineGraphServer::egoNet(graphID);
+    }
 
     result_wr = write(connFd, DONE.c_str(), FRONTEND_COMMAND_LENGTH);
     if (result_wr < 0) {
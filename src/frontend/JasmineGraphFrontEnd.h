@@ -30,6 +30,7 @@ limitations under the License.
 #include <atomic>
 #include <chrono>
 #include <fstream>
+#include <functional>
 #include <iostream>
 #include <map>
 #include <string>
@@ -38,13 +39,11 @@ limitations under the License.
 #include "../metadb/SQLiteDBInterface.h"
 #include "../performancedb/PerformanceSQLiteDBInterface.h"
 #include "../query/algorithms/triangles/Triangles.h"
+#include "../util/scheduler/ctpl_stl.h"
 #include "core/scheduler/JobScheduler.h"
 
 class JasmineGraphHashMapCentralStore;
 
-void *frontendservicesesion(std::string masterIP, int connFd, SQLiteDBInterface *sqlite,
-                            PerformanceSQLiteDBInterface *perfSqlite, JobScheduler *jobScheduler);
-
 class JasmineGraphFrontEnd {
  public:
     JasmineGraphFrontEnd(SQLiteDBInterface *db, PerformanceSQLiteDBInterface *perfDb, std::string masterIP,
@@ -78,6 +77,13 @@ class JasmineGraphFrontEnd {
     static void scheduleStrianJobs(JobRequest &jobDetails, std::priority_queue<JobRequest> &jobQueue,
                                     JobScheduler *jobScheduler, bool *strian_exist);
 
+    // Control commands such as stopping a stream only flip state and must not wait behind long-running commands
+    static bool isControlCommand(const std::string &command);
+
+    // Runs a control command on the calling thread and any other command on the executor pool
+    static void dispatchCommand(const std::string &command, ctpl::thread_pool &executors,
+                                const std::function<void()> &task);
+
     static int getRunningHighPriorityTaskCount();
     static bool areRunningJobsForSameGraph();
     static bool strian_exit;
@@ -91,12 +97,4 @@ class JasmineGraphFrontEnd {
     JobScheduler *jobScheduler;
 };
 
-struct frontendservicesessionargs {
-    std::string masterIP;
-    int connFd;
-    SQLiteDBInterface *sqlite;
-    PerformanceSQLiteDBInterface *perfSqlite;
-    JobScheduler *jobScheduler;
-};
-
 #endif  // JASMINGRAPH_JASMINGRAPHFRONTEND_H
@@ -34,6 +34,7 @@ const string TRIANGLES = "trian";
 const string STREAMING_TRIANGLES = "strian";
 const string GRAPHID_SEND = "graphid-send";
 const string SEND_MODE = "mode-send";
+const string SEND_WINDOW = "window-send";
 const string VCOUNT = "vcnt";
 const string ECOUNT = "ecnt";
 const string PAGE_RANK = "pgrnk";
@@ -20,8 +20,6 @@ limitations under the License.
 #include "domain/JobRequest.h"
 #include "domain/JobResponse.h"
 
-extern std::priority_queue<JobRequest> jobQueue;
-extern std::vector<JobResponse> responseVector;
 extern std::map<std::string, JobResponse> responseMap;
 
 class CoreConstants {};
@@ -13,6 +13,8 @@ limitations under the License.
 
 #include "PageRankExecutor.h"
 
+#include "../../scheduler/JobScheduler.h"
+
 #define DATA_BUFFER_SIZE (FRONTEND_DATA_LENGTH + 1)
 using namespace std::chrono;
 
@@ -79,8 +81,9 @@ void PageRankExecutor::execute() {
 
     auto begin = chrono::high_resolution_clock::now();
 
+    ReplicaLease replicaLease;
     std::map<std::string, JasmineGraphServer::workerPartitions> graphPartitionedHosts =
-        JasmineGraphServer::getGraphPartitionedHosts(graphId);
+        JasmineGraphServer::getGraphPartitionedHosts(graphId, &replicaLease);
     string host;
     int port;
     int dataPort;
@@ -152,11 +155,7 @@ void PageRankExecutor::execute() {
     workerResponded = true;
     JobResponse jobResponse;
     jobResponse.setJobId(request.getJobId());
-    responseVector.push_back(jobResponse);
-
-    responseVectorMutex.lock();
-    responseMap[request.getJobId()] = jobResponse;
-    responseVectorMutex.unlock();
+    JobScheduler::setResult(jobResponse);
 
     auto end = chrono::high_resolution_clock::now();
     auto dur = end - begin;
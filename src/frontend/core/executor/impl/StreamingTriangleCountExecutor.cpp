@@ -13,6 +13,10 @@ limitations under the License.
 
 #include "StreamingTriangleCountExecutor.h"
 
+#include "../../../../query/algorithms/triangles/StreamingTriangleCounter.h"
+#include "../../../../server/ClusterTopology.h"
+#include "../../scheduler/JobScheduler.h"
+
 #define DATA_BUFFER_SIZE (FRONTEND_DATA_LENGTH + 1)
 
 std::map<int, int> StreamingTriangleCountExecutor::localSocketMap;
@@ -44,6 +48,7 @@ void StreamingTriangleCountExecutor::execute() {
     std::string masterIP = request.getMasterIP();
     std::string graphId = request.getParameter(Conts::PARAM_KEYS::GRAPH_ID);
     std::string mode = request.getParameter(Conts::PARAM_KEYS::MODE);
+    std::string window = request.getParameter(Conts::PARAM_KEYS::WINDOW);
     std::string partitions = request.getParameter(Conts::PARAM_KEYS::PARTITION);
 
     streamingDB.init();
@@ -59,6 +64,14 @@ void StreamingTriangleCountExecutor::execute() {
 
     streaming_triangleCount_logger.info("###STREAMING-TRIANGLE-COUNT-EXECUTOR### Completed central store counting");
 
+    // The edges of an edge window are split evenly between the partitions, which each keep their last edges of it.
+    // With the stream spread evenly over the partitions, the window holds about the last edges of the stream as a
+    // whole. A time window is the same for every partition.
+    std::string partitionWindow;
+    if (mode == "2") {
+        partitionWindow = StreamingTriangleCounter::shareWindow(window, 1, partitionCount);
+    }
+
     for (int i = 0; i < partitionCount; i++) {
         Utils::worker currentWorker = workerList.at(i);
         string host = currentWorker.hostname;
@@ -68,13 +81,16 @@ void StreamingTriangleCountExecutor::execute() {
 
         intermRes.push_back(std::async(
                 std::launch::async, StreamingTriangleCountExecutor::getTriangleCount, atoi(graphId.c_str()),
-                host, workerPort, workerDataPort, i, masterIP, mode, streamingDB));
+                host, workerPort, workerDataPort, i, masterIP, mode, partitionWindow, streamingDB));
     }
 
     if (partitionCount > 2) {
         long aggregatedTriangleCount = StreamingTriangleCountExecutor::aggregateCentralStoreTriangles(
-                sqlite, streamingDB, graphId, masterIP, mode, partitionCount);
-        if (mode == "0") {
+                sqlite, streamingDB, graphId, masterIP, mode, window, partitionCount);
+        if (mode == "2") {
+            // The workers count the whole window each time, so there is nothing to add to
+            result += aggregatedTriangleCount;
+        } else if (mode == "0") {
             saveCentralValues(streamingDB, graphId, std::to_string(aggregatedTriangleCount));
             result += aggregatedTriangleCount;
         } else {
@@ -98,14 +114,13 @@ void StreamingTriangleCountExecutor::execute() {
     jobResponse.setJobId(request.getJobId());
     jobResponse.addParameter(Conts::PARAM_KEYS::STREAMING_TRIANGLE_COUNT, std::to_string(result));
     jobResponse.setEndTime(chrono::high_resolution_clock::now());
-    responseVector.push_back(jobResponse);
-
-    responseMap[request.getJobId()] = jobResponse;
+    JobScheduler::setResult(jobResponse);
 }
 
 long StreamingTriangleCountExecutor::getTriangleCount(int graphId, std::string host, int port,
                                                       int dataPort, int partitionId, std::string masterIP,
-                                                      std::string runMode, StreamingSQLiteDBInterface streamingDB) {
+                                                      std::string runMode, std::string window,
+                                                      StreamingSQLiteDBInterface streamingDB) {
     NativeStoreTriangleResult oldResult{1, 1, 0};
 
     if (runMode == "1") {
@@ -253,6 +268,20 @@ long StreamingTriangleCountExecutor::getTriangleCount(int graphId, std::string h
     }
     streaming_triangleCount_logger.info("Sent :  mode " + runMode);
 
+    if (runMode == "2") {
+        response = Utils::read_str_trim_wrapper(sockfd, data, FRONTEND_DATA_LENGTH);
+        if (response.compare(JasmineGraphInstanceProtocol::OK) != 0) {
+            streaming_triangleCount_logger.error("Received : " + response + " instead of : " +
+                                                 JasmineGraphInstanceProtocol::OK);
+            return 0;
+        }
+        if (!Utils::send_str_wrapper(sockfd, window)) {
+            streaming_triangleCount_logger.error("Error writing to socket");
+            return 0;
+        }
+        streaming_triangleCount_logger.info("Sent : window " + window);
+    }
+
     string localRelationCount = Utils::read_str_trim_wrapper(sockfd, data, INSTANCE_DATA_LENGTH);
     streaming_triangleCount_logger.info("Received Local relation count: " + localRelationCount);
 
@@ -272,6 +301,11 @@ long StreamingTriangleCountExecutor::getTriangleCount(int graphId, std::string h
     string triangles = Utils::read_str_trim_wrapper(sockfd, data, INSTANCE_DATA_LENGTH);
     streaming_triangleCount_logger.info("Received result: " + triangles);
 
+    // A windowed count is the count of the window, and leaves the cumulative count of the partition as it is
+    if (runMode == "2") {
+        return std::stol(triangles);
+    }
+
     NativeStoreTriangleResult newResult{ std::stol(localRelationCount),
                                          std::stol(centralRelationCount),
                                          std::stol(triangles) + oldResult.result};
@@ -282,7 +316,8 @@ long StreamingTriangleCountExecutor::getTriangleCount(int graphId, std::string h
 
 long StreamingTriangleCountExecutor::aggregateCentralStoreTriangles(
         SQLiteDBInterface *sqlite, StreamingSQLiteDBInterface streamingdb, std::string graphId, std::string masterIP,
-                                                                    std::string runMode, int partitionCount) {
+                                                                    std::string runMode, std::string window,
+                                                                    int partitionCount) {
     std::vector<std::vector<string>> workerCombinations = getWorkerCombination(sqlite, graphId, partitionCount);
     std::map<string, int> workerWeightMap;
     std::vector<std::vector<string>>::iterator workerCombinationsIterator;
@@ -323,19 +358,17 @@ long StreamingTriangleCountExecutor::aggregateCentralStoreTriangles(
             }
         }
 
-        string aggregatorSqlStatement =
-                "SELECT ip,user,server_port,server_data_port "
-                "FROM worker "
-                "WHERE idworker=" + minWeightWorker + ";";
-
-        std::vector<vector<pair<string, string>>> result = sqlite->runSelect(aggregatorSqlStatement);
-
-        vector<pair<string, string>> aggregatorData = result.at(0);
+        std::shared_ptr<const ClusterTopology::Snapshot> topology = ClusterTopology::get(sqlite);
+        const ClusterTopology::Worker *aggregatorWorker = topology->getWorker(atoi(minWeightWorker.c_str()));
+        if (!aggregatorWorker) {
+            streaming_triangleCount_logger.error("Aggregator worker " + minWeightWorker + " is not in the topology");
+            continue;
+        }
 
-        std::string aggregatorIp = aggregatorData.at(0).second;
-        std::string aggregatorUser = aggregatorData.at(1).second;
-        std::string aggregatorPort = aggregatorData.at(2).second;
-        std::string aggregatorDataPort = aggregatorData.at(3).second;
+        std::string aggregatorIp = aggregatorWorker->host;
+        std::string aggregatorUser = aggregatorWorker->user;
+        std::string aggregatorPort = to_string(aggregatorWorker->port);
+        std::string aggregatorDataPort = to_string(aggregatorWorker->dataPort);
         std::string aggregatorPartitionId = minWeightWorker;
 
         if ((aggregatorIp.find("localhost") != std::string::npos) || aggregatorIp == masterIP) {
@@ -358,10 +391,15 @@ long StreamingTriangleCountExecutor::aggregateCentralStoreTriangles(
 
         workerWeightMap[minWeightWorker] = minimumWeight;
 
+        // The central relations of the partitions of the combination get their share of an edge window
+        std::string combinationWindow;
+        if (runMode == "2") {
+            combinationWindow = StreamingTriangleCounter::shareWindow(window, workerCombination.size(), partitionCount);
+        }
         triangleCountResponse.push_back(std::async(
                 std::launch::async, StreamingTriangleCountExecutor::countCentralStoreTriangles, aggregatorHost,
                 aggregatorPort, aggregatorHost, aggregatorPartitionId, adjustedPartitionIdList, centralCountList,
-                graphId, masterIP, 5, runMode));
+                graphId, masterIP, 5, runMode, combinationWindow));
     }
 
     for (auto &&futureCall : triangleCountResponse) {
@@ -378,7 +416,7 @@ long StreamingTriangleCountExecutor::aggregateCentralStoreTriangles(
         std::string triangle = *triangleIterator;
 
         if (!triangle.empty() && triangle != "NILL") {
-            if (runMode == "0") {
+            if (runMode != "1") {
                 uniqueTriangleSet.insert(triangle);
                 continue;
             }
@@ -404,7 +442,7 @@ long StreamingTriangleCountExecutor::aggregateCentralStoreTriangles(
         }
     }
 
-    if (runMode == "0") {
+    if (runMode != "1") {
         return uniqueTriangleSet.size();
     }
     return triangleCount - currentSize;
@@ -415,7 +453,7 @@ string StreamingTriangleCountExecutor::countCentralStoreTriangles(
         std::string host, std::string partitionId,
         std::string partitionIdList, std::string centralCountList,
         std::string graphId, std::string masterIP,
-        int threadPriority, std::string runMode) {
+        int threadPriority, std::string runMode, std::string window) {
     int port = stoi(aggregatorPort);
     int sockfd;
     if (centralSocketMap.find(port) == centralSocketMap.end()) {
@@ -572,6 +610,20 @@ string StreamingTriangleCountExecutor::countCentralStoreTriangles(
     }
     streaming_triangleCount_logger.info("Sent : mode " + runMode);
 
+    if (runMode == "2") {
+        response = Utils::read_str_trim_wrapper(sockfd, data, FRONTEND_DATA_LENGTH);
+        if (response.compare(JasmineGraphInstanceProtocol::OK) != 0) {
+            streaming_triangleCount_logger.error("Received : " + response + " instead of : " +
+                                                 JasmineGraphInstanceProtocol::OK);
+            return result;
+        }
+        if (!Utils::send_str_wrapper(sockfd, window)) {
+            streaming_triangleCount_logger.error("Error writing to socket");
+            return result;
+        }
+        streaming_triangleCount_logger.info("Sent : window " + window);
+    }
+
     response = Utils::read_str_trim_wrapper(sockfd, data, FRONTEND_DATA_LENGTH);
     response = Utils::trim_copy(response, " \f\n\r\t\v");
     string status = response.substr(response.size() - 5);
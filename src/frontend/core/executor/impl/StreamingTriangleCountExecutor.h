@@ -42,16 +42,18 @@ class StreamingTriangleCountExecutor : public AbstractExecutor{
         void execute();
 
         static long getTriangleCount(int graphId, std::string host, int port, int dataPort, int partitionId,
-                                     std::string masterIP, std::string runMode, StreamingSQLiteDBInterface streamingDB);
+                                     std::string masterIP, std::string runMode, std::string window,
+                                     StreamingSQLiteDBInterface streamingDB);
 
         static long aggregateCentralStoreTriangles(SQLiteDBInterface *sqlite, StreamingSQLiteDBInterface streamingdb,
                                                    std::string graphId, std::string masterIP,
-                                                   std::string mode, int partitionCount);
+                                                   std::string mode, std::string window, int partitionCount);
 
         static string countCentralStoreTriangles(std::string aggregatorHostName, std::string aggregatorPort,
                                                 std::string host, std::string partitionId, std::string partitionIdList,
                                                  std::string centralCountList, std::string graphId,
-                                                 std::string masterIP, int threadPriority, std::string mode);
+                                                 std::string masterIP, int threadPriority, std::string mode,
+                                                 std::string window);
 
         static std::vector<std::vector<string>> getWorkerCombination(SQLiteDBInterface *sqlite,
                                                                      std::string graphId, int partitionCount);
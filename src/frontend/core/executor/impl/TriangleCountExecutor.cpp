@@ -16,9 +16,14 @@ limitations under the License.
 #include <time.h>
 #include <unistd.h>
 
+#include <algorithm>
+
 #include "../../../../../globals.h"
 #include "../../../../k8s/K8sWorkerController.h"
 #include "../../../../scale/scaler.h"
+#include "../../../../server/ClusterTopology.h"
+#include "../../../../server/ReplicaManager.h"
+#include "../../scheduler/JobScheduler.h"
 
 using namespace std::chrono;
 
@@ -30,14 +35,16 @@ std::mutex responseVectorMutex;
 static std::mutex fileCombinationMutex;
 static std::mutex aggregateWeightMutex;
 
-static time_t last_exec_time = 0;
-
+// Load reported by a worker in its heartbeat
 static string isFileAccessibleToWorker(std::string graphId, std::string partitionId, std::string aggregatorHostName,
                                        std::string aggregatorPort, std::string masterIP, std::string fileType,
                                        std::string fileName);
 static long aggregateCentralStoreTriangles(SQLiteDBInterface *sqlite, std::string graphId, std::string masterIP,
                                            int threadPriority,
                                            const std::map<std::string, std::vector<string>> &partitionMap);
+static long shuffleCentralStoreTriangles(SQLiteDBInterface *sqlite, std::string graphId, std::string masterIP,
+                                         int jobId, const std::map<string, std::vector<string>> &partitionMap);
+static int openWorkerSession(std::string host, int port, std::string masterIP, char *data);
 static int updateTriangleTreeAndGetTriangleCount(
     const std::vector<std::string> &triangles,
     std::unordered_map<long, std::unordered_map<long, std::unordered_set<long>>> *triangleTree_p,
@@ -197,26 +204,69 @@ static std::vector<int> reallocate_parts(std::map<int, string> &alloc, std::set<
     return copying;
 }
 
-static void scale_up(std::map<string, int> &loads, map<string, string> &workers, int copy_cnt) {
+// Partitions copied to each new worker as soon as it is ready, while the rest of the scale up is still in progress
+static const int PRESTAGED_PARTITIONS_PER_WORKER = 2;
+
+/*
+ * Scales up for the partitions in `copying` and copies some of them to the new workers as they come up, so that the
+ * transfers overlap with the bring-up of the other workers. Returns the partitions copied this way and their new
+ * worker.
+ * */
+static map<int, string> scale_up(std::map<string, int> &loads, map<string, string> &workers, std::vector<int> &copying,
+                                 const std::map<int, std::vector<string>> &P_AVAIL, string graphId,
+                                 SQLiteDBInterface *sqlite) {
+    map<int, string> prestaged;
     int curr_load = 0;
     for (auto it = loads.begin(); it != loads.end(); it++) {
         curr_load += it->second;
     }
-    int n_cores = copy_cnt + curr_load - 3 * loads.size();
+    int n_cores = copying.size() + curr_load - 3 * loads.size();
     if (n_cores < 0) {
-        return;
+        return prestaged;
     }
     int n_workers = n_cores / 2 + 1;  // allocate a little more to prevent saturation
     if (n_cores % 2 > 0) n_workers++;
-    if (n_workers == 0) return;
+    if (n_workers == 0) return prestaged;
+
+    std::mutex prestageMutex;
+    std::vector<int> pending(copying.begin(), copying.end());
+    auto onReady = [&](const string &workerId, const string &address) {
+        for (int i = 0; i < PRESTAGED_PARTITIONS_PER_WORKER; i++) {
+            int partition;
+            {
+                std::lock_guard<std::mutex> lock(prestageMutex);
+                if (pending.empty()) return;
+                partition = pending.back();
+                pending.pop_back();
+            }
+            // `workers` is only read until scaleUp() returns
+            const auto &holders = P_AVAIL.find(partition)->second;
+            const auto &ip_port_from = Utils::split(workers.find(holders.front())->second, ':');
+            const auto &ip_port_to = Utils::split(address, ':');
+            if (Utils::transferPartition(ip_port_from[0], stoi(ip_port_from[1]), ip_port_to[0],
+                                         Conts::JASMINEGRAPH_INSTANCE_DATA_PORT, graphId, to_string(partition),
+                                         workerId, sqlite)) {
+                std::lock_guard<std::mutex> lock(prestageMutex);
+                prestaged[partition] = workerId;
+            } else {
+                std::lock_guard<std::mutex> lock(prestageMutex);
+                pending.push_back(partition);
+            }
+        }
+    };
 
     K8sWorkerController *k8sController = K8sWorkerController::getInstance();
-    map<string, string> w_new = k8sController->scaleUp(n_workers);
+    map<string, string> w_new = k8sController->scaleUp(n_workers, onReady);
 
     for (auto it = w_new.begin(); it != w_new.end(); it++) {
-        loads[it->first] = 0.1;
+        loads[it->first] = 0;
         workers[it->first] = it->second;
     }
+    for (auto it = prestaged.begin(); it != prestaged.end(); it++) {
+        loads[it->second]++;
+        copying.erase(std::remove(copying.begin(), copying.end(), it->first), copying.end());
+    }
+    return prestaged;
 }
 
 static int alloc_net_plan(std::map<int, string> &alloc, std::vector<int> &parts,
@@ -300,68 +350,96 @@ static int alloc_net_plan(std::map<int, string> &alloc, std::vector<int> &parts,
     return best;
 }
 
+int TriangleCountExecutor::getWorkerLoad(const Utils::WorkerHeartbeat *heartbeat, double publishedCpuUsage,
+                                         int assignedPartitions) {
+    double cpuUsage = heartbeat ? heartbeat->cpuUsage : publishedCpuUsage;
+    if (cpuUsage < 0) cpuUsage = 0;
+    int load = (int)(4 * std::min(cpuUsage, 1.0));
+    if (heartbeat) {
+        load = std::max(load, heartbeat->runningTasks);
+    }
+    load = std::max(load, assignedPartitions);
+    return std::min(load, 3);
+}
+
+int TriangleCountExecutor::allocatePartitions(const std::map<string, std::vector<string>> &partitionMap,
+                                              std::map<string, int> &loads, std::map<int, string> &alloc,
+                                              std::set<int> &remain) {
+    std::map<int, std::vector<string>> p_avail;
+    for (auto it = partitionMap.begin(); it != partitionMap.end(); it++) {
+        const auto &worker = it->first;
+        const auto loadIt = loads.find(worker);
+        bool saturated = loadIt != loads.end() && loadIt->second >= 3;
+        for (auto partitionIt = it->second.begin(); partitionIt != it->second.end(); partitionIt++) {
+            auto partition = stoi(*partitionIt);
+            std::vector<string> &partitionWorkers = p_avail[partition];
+            if (!saturated) {
+                partitionWorkers.push_back(worker);
+            }
+            remain.insert(partition);
+        }
+    }
+    return alloc_plan(alloc, remain, p_avail, loads);
+}
+
 static void filter_partitions(std::map<string, std::vector<string>> &partitionMap, SQLiteDBInterface *sqlite,
-                              string graphId) {
+                              string graphId, string masterIP) {
     map<string, string> workers;  // id => "ip:port"
-    const std::vector<vector<pair<string, string>>> &results =
-        sqlite->runSelect("SELECT DISTINCT idworker,ip,server_port FROM worker;");
-    for (int i = 0; i < results.size(); i++) {
-        string workerId = results[i][0].second;
-        string ip = results[i][1].second;
-        string port = results[i][2].second;
-        workers[workerId] = ip + ":" + port;
+    std::shared_ptr<const ClusterTopology::Snapshot> topology = ClusterTopology::get(sqlite);
+    for (auto it = topology->workers.begin(); it != topology->workers.end(); it++) {
+        workers[to_string(it->first)] = it->second.host + ":" + to_string(it->second.port);
+    }
+
+    std::map<string, std::future<bool>> heartbeatResponses;
+    std::map<string, Utils::WorkerHeartbeat> heartbeats;
+    for (auto it = workers.begin(); it != workers.end(); it++) {
+        heartbeatResponses[it->first] =
+            std::async(std::launch::async, Utils::requestWorkerHeartbeat, it->second, masterIP, &heartbeats[it->first]);
     }
 
+    // Workers that do not answer the heartbeat fall back to the CPU usage published to Prometheus
     map<string, int> loads;
-    const map<string, string> &cpu_map = Utils::getMetricMap("cpu_usage");
+    map<string, string> cpu_map;
+    bool cpuMapLoaded = false;
     for (auto it = workers.begin(); it != workers.end(); it++) {
         auto workerId = it->first;
         auto worker = it->second;
-        const auto workerLoadIt = cpu_map.find(worker);
-        if (workerLoadIt != cpu_map.end()) {
-            double load = stod(workerLoadIt->second.c_str());
-            if (load < 0) load = 0;
-            loads[workerId] = (int)(4 * load);
+        const Utils::WorkerHeartbeat *heartbeat = NULL;
+        double publishedCpuUsage = 0;
+        if (heartbeatResponses[workerId].get()) {
+            heartbeat = &heartbeats[workerId];
         } else {
-            loads[workerId] = 0;
+            if (!cpuMapLoaded) {
+                cpu_map = Utils::getMetricMap("cpu_usage");
+                cpuMapLoaded = true;
+            }
+            const auto workerLoadIt = cpu_map.find(worker);
+            if (workerLoadIt != cpu_map.end()) {
+                publishedCpuUsage = atof(workerLoadIt->second.c_str());
+            }
         }
+        const auto usedIt = used_workers.find(workerId);
+        int assignedPartitions = usedIt != used_workers.end() ? usedIt->second : 0;
+        loads[workerId] = TriangleCountExecutor::getWorkerLoad(heartbeat, publishedCpuUsage, assignedPartitions);
     }
 
-    std::map<int, std::vector<string>> p_avail;
-    std::set<int> remain;
+    std::map<int, std::vector<string>> P_AVAIL;
     for (auto it = partitionMap.begin(); it != partitionMap.end(); it++) {
-        auto worker = it->first;
-        auto &partitions = it->second;
-        for (auto partitionIt = partitions.begin(); partitionIt != partitions.end(); partitionIt++) {
-            auto partition = stoi(*partitionIt);
-            p_avail[partition].push_back(worker);
-            remain.insert(partition);
-        }
-    }
-    const std::map<int, std::vector<string>> P_AVAIL = p_avail;  // get a copy and make it const
-
-    for (auto loadIt = loads.begin(); loadIt != loads.end(); loadIt++) {
-        if (loadIt->second < 3) continue;
-        auto w = loadIt->first;
-        for (auto it = p_avail.begin(); it != p_avail.end(); it++) {
-            auto &partitionWorkers = it->second;
-            for (auto workerIt = partitionWorkers.begin(); workerIt != partitionWorkers.end();) {
-                if (*workerIt == w) {
-                    partitionWorkers.erase(workerIt);
-                } else {
-                    workerIt++;
-                }
-            }
+        for (auto partitionIt = it->second.begin(); partitionIt != it->second.end(); partitionIt++) {
+            P_AVAIL[stoi(*partitionIt)].push_back(it->first);
         }
     }
 
     std::map<int, string> alloc;
-    int unallocated = alloc_plan(alloc, remain, p_avail, loads);
+    std::set<int> remain;
+    int unallocated = TriangleCountExecutor::allocatePartitions(partitionMap, loads, alloc, remain);
     if (unallocated > 0) {
         triangleCount_logger.info(to_string(unallocated) + " partitions remaining after alloc_plan");
         auto copying = reallocate_parts(alloc, remain, P_AVAIL);
-        scale_up(loads, workers, copying.size());
-        triangleCount_logger.info("Scale up completed");
+        auto prestaged = scale_up(loads, workers, copying, P_AVAIL, graphId, sqlite);
+        alloc.insert(prestaged.begin(), prestaged.end());
+        triangleCount_logger.info("Scale up completed with " + to_string(prestaged.size()) +
+                                  " partitions copied to new workers");
 
         map<string, int> net_loads;
         for (auto it = loads.begin(); it != loads.end(); it++) {
@@ -382,14 +460,12 @@ static void filter_partitions(std::map<string, std::vector<string>> &partitionMa
         }
 
         if (!transfer.empty()) {
-            const std::vector<vector<pair<string, string>>> &workerData =
-                sqlite->runSelect("SELECT DISTINCT ip,server_port,server_data_port FROM worker;");
+            // Workers added by the scale up are in the topology by now
+            topology = ClusterTopology::get(sqlite);
             map<string, string> dataPortMap;  // "ip:port" => data_port
-            for (int i = 0; i < workerData.size(); i++) {
-                string ip = workerData[i][0].second;
-                string port = workerData[i][1].second;
-                string dport = workerData[i][2].second;
-                dataPortMap[ip + ":" + port] = dport;
+            for (auto it = topology->workers.begin(); it != topology->workers.end(); it++) {
+                const ClusterTopology::Worker &worker = it->second;
+                dataPortMap[worker.host + ":" + to_string(worker.port)] = to_string(worker.dataPort);
             }
             map<string, string> workers_r;  // "ip:port" => id
             for (auto it = workers.begin(); it != workers.end(); it++) {
@@ -426,12 +502,6 @@ static void filter_partitions(std::map<string, std::vector<string>> &partitionMa
 }
 
 void TriangleCountExecutor::execute() {
-    schedulerMutex.lock();
-    time_t curr_time = time(NULL);
-    // 8 seconds = upper bound to the time to send performance metrics after allocating trian task to a worker
-    if (curr_time < last_exec_time + 8) {
-        sleep(last_exec_time + 9 - curr_time);  // 9 = 8+1 to ensure it waits more than 8 seconds
-    }
     int uniqueId = getUid();
     std::string masterIP = request.getMasterIP();
     std::string graphId = request.getParameter(Conts::PARAM_KEYS::GRAPH_ID);
@@ -444,6 +514,11 @@ void TriangleCountExecutor::execute() {
     std::string autoCalibrateString = request.getParameter(Conts::PARAM_KEYS::AUTO_CALIBRATION);
     bool autoCalibrate = Utils::parseBoolean(autoCalibrateString);
 
+    std::string centralTrianglePlan = request.getParameter(Conts::PARAM_KEYS::CENTRAL_TRIANGLE_PLAN);
+    if (centralTrianglePlan.empty()) {
+        centralTrianglePlan = Utils::getJasmineGraphProperty("org.jasminegraph.triangles.centralplan");
+    }
+
     if (threadPriority == Conts::HIGH_PRIORITY_DEFAULT_VALUE) {
         highPriorityGraphList.push_back(graphId);
     }
@@ -476,6 +551,7 @@ void TriangleCountExecutor::execute() {
 
     long result = 0;
     bool isCompositeAggregation = false;
+    bool centralTrianglesFailed = false;
     Utils::worker aggregatorWorker;
     std::vector<std::future<long>> intermRes;
     std::vector<std::future<int>> statResponse;
@@ -483,43 +559,75 @@ void TriangleCountExecutor::execute() {
 
     auto begin = chrono::high_resolution_clock::now();
 
-    string sqlStatement =
-        "SELECT DISTINCT worker_idworker,partition_idpartition "
-        "FROM worker_has_partition INNER JOIN worker ON worker_has_partition.worker_idworker=worker.idworker "
-        "WHERE partition_graph_idgraph=" +
-        graphId + ";";
-
-    const std::vector<vector<pair<string, string>>> &results = sqlite->runSelect(sqlStatement);
-
-    std::map<string, std::vector<string>> partitionMap;
-
-    for (auto i = results.begin(); i != results.end(); ++i) {
-        const std::vector<pair<string, string>> &rowData = *i;
-
-        string workerID = rowData.at(0).second;
-        string partitionId = rowData.at(1).second;
+    std::map<string, std::vector<string>> partitionMap;  // worker id => partition ids
+    // Keeps the replica rounds from reclaiming the replicas of the job until it finishes
+    ReplicaLease replicaLease;
+    bool autoScaling = false;
+    if (jasminegraph_profile == PROFILE_K8S) {
+        std::unique_ptr<K8sInterface> k8sInterface(new K8sInterface());
+        autoScaling = k8sInterface->getJasmineGraphConfig("auto_scaling_enabled") == "true";
+    }
 
-        if (partitionMap.find(workerID) == partitionMap.end()) {
-            std::vector<string> partitionVec;
-            partitionVec.push_back(partitionId);
-            partitionMap[workerID] = partitionVec;
-        } else {
-            partitionMap[workerID].push_back(partitionId);
+    // Planning and reserving the workers happen under one lock so that concurrent jobs see each other's partitions
+    // in the worker loads before the workers themselves report them
+    schedulerMutex.lock();
+    std::shared_ptr<const ClusterTopology::Snapshot> topology = ClusterTopology::get(sqlite);
+    bool routed = false;
+    if (autoScaling) {
+        // filter_partitions() picks among all replicas and may add more
+        const auto &partitionsByWorker = topology->getPartitionsByWorker(atoi(graphId.c_str()));
+        for (auto i = partitionsByWorker.begin(); i != partitionsByWorker.end(); ++i) {
+            if (!topology->getWorker(i->first)) {
+                continue;
+            }
+            std::vector<string> &partitionVec = partitionMap[to_string(i->first)];
+            for (auto j = i->second.begin(); j != i->second.end(); ++j) {
+                partitionVec.push_back(to_string(*j));
+            }
+        }
+        filter_partitions(partitionMap, sqlite, graphId, masterIP);
+        std::map<int, std::vector<int>> assignment;
+        for (auto it = partitionMap.begin(); it != partitionMap.end(); it++) {
+            std::vector<int> &partitions = assignment[atoi(it->first.c_str())];
+            for (auto partitionIt = it->second.begin(); partitionIt != it->second.end(); partitionIt++) {
+                partitions.push_back(atoi(partitionIt->c_str()));
+            }
+        }
+        routed = replicaLease.acquire(atoi(graphId.c_str()), assignment);
+        if (!routed) {
+            triangleCount_logger.warn("A replica planned for graph " + graphId +
+                                      " was reclaimed, routing to the remaining replicas");
+            partitionMap.clear();
+            topology = ClusterTopology::get(sqlite);
         }
-
-        triangleCount_logger.info("###TRIANGLE-COUNT-EXECUTOR### Getting Triangle Count : PartitionId " + partitionId);
     }
-
-    if (results.size() > Conts::COMPOSITE_CENTRAL_STORE_WORKER_THRESHOLD) {
-        isCompositeAggregation = true;
+    if (!routed) {
+        std::map<int, int> loads;
+        for (auto it = used_workers.begin(); it != used_workers.end(); it++) {
+            loads[atoi(it->first.c_str())] = it->second;
+        }
+        const auto &routes = ReplicaManager::route(*topology, atoi(graphId.c_str()), loads, &replicaLease);
+        for (auto it = routes.begin(); it != routes.end(); it++) {
+            std::vector<string> &partitionVec = partitionMap[to_string(it->first)];
+            for (int partition : it->second) {
+                partitionVec.push_back(to_string(partition));
+            }
+        }
     }
-
-    if (jasminegraph_profile == PROFILE_K8S) {
-        std::unique_ptr<K8sInterface> k8sInterface(new K8sInterface());
-        if (k8sInterface->getJasmineGraphConfig("auto_scaling_enabled") == "true") {
-            filter_partitions(partitionMap, sqlite, graphId);
+    size_t placementCount = 0;
+    for (auto it = partitionMap.begin(); it != partitionMap.end(); it++) {
+        used_workers[it->first] += it->second.size();
+        placementCount += it->second.size();
+        for (auto partitionIt = it->second.begin(); partitionIt != it->second.end(); partitionIt++) {
+            triangleCount_logger.info("###TRIANGLE-COUNT-EXECUTOR### Getting Triangle Count : PartitionId " +
+                                      *partitionIt);
         }
     }
+    schedulerMutex.unlock();
+
+    if (placementCount > Conts::COMPOSITE_CENTRAL_STORE_WORKER_THRESHOLD) {
+        isCompositeAggregation = true;
+    }
 
     std::vector<std::vector<string>> fileCombinations;
     if (isCompositeAggregation) {
@@ -541,14 +649,6 @@ void TriangleCountExecutor::execute() {
         fileCombinations = AbstractExecutor::getCombinations(compositeCentralStoreFiles);
     }
 
-    for (auto it = partitionMap.begin(); it != partitionMap.end(); it++) {
-        string worker = it->first;
-        if (used_workers.find(worker) != used_workers.end()) {
-            used_workers[worker]++;
-        } else {
-            used_workers[worker] = 1;
-        }
-    }
 
     std::map<std::string, std::string> combinationWorkerMap;
     std::unordered_map<long, std::unordered_map<long, std::unordered_set<long>>> triangleTree;
@@ -605,9 +705,6 @@ void TriangleCountExecutor::execute() {
         isStatCollect = true;
     }
 
-    last_exec_time = time(NULL);
-    schedulerMutex.unlock();
-
     for (auto &&futureCall : intermRes) {
         triangleCount_logger.info("Waiting for result. uuid=" + to_string(uniqueId));
         result += futureCall.get();
@@ -616,8 +713,18 @@ void TriangleCountExecutor::execute() {
     combinationWorkerMap.clear();
 
     if (!isCompositeAggregation) {
-        long aggregatedTriangleCount =
-            aggregateCentralStoreTriangles(sqlite, graphId, masterIP, threadPriority, partitionMap);
+        long aggregatedTriangleCount = -1;
+        if (centralTrianglePlan == Conts::CENTRAL_TRIANGLE_PLAN::SHUFFLE) {
+            aggregatedTriangleCount = shuffleCentralStoreTriangles(sqlite, graphId, masterIP, uniqueId, partitionMap);
+        }
+        if (aggregatedTriangleCount < 0) {
+            aggregatedTriangleCount =
+                aggregateCentralStoreTriangles(sqlite, graphId, masterIP, threadPriority, partitionMap);
+        }
+        if (aggregatedTriangleCount < 0) {
+            // Reporting only the triangles inside partitions would silently undercount
+            centralTrianglesFailed = true;
+        }
         result += aggregatedTriangleCount;
         workerResponded = true;
         triangleCount_logger.log(
@@ -627,7 +734,7 @@ void TriangleCountExecutor::execute() {
     schedulerMutex.lock();
     for (auto it = partitionMap.begin(); it != partitionMap.end(); it++) {
         string worker = it->first;
-        used_workers[worker]--;
+        used_workers[worker] -= it->second.size();
     }
     for (auto it = used_workers.cbegin(); it != used_workers.cend();) {
         if (it->second <= 0) {
@@ -642,12 +749,14 @@ void TriangleCountExecutor::execute() {
 
     JobResponse jobResponse;
     jobResponse.setJobId(request.getJobId());
-    jobResponse.addParameter(Conts::PARAM_KEYS::TRIANGLE_COUNT, std::to_string(result));
-    responseVector.push_back(jobResponse);
-
-    responseVectorMutex.lock();
-    responseMap[request.getJobId()] = jobResponse;
-    responseVectorMutex.unlock();
+    if (centralTrianglesFailed) {
+        jobResponse.addParameter(Conts::PARAM_KEYS::ERROR_MESSAGE,
+                                 "Counting the triangles across partitions failed. A central store of graph " +
+                                     graphId + " is missing on a worker");
+    } else {
+        jobResponse.addParameter(Conts::PARAM_KEYS::TRIANGLE_COUNT, std::to_string(result));
+    }
+    JobScheduler::setResult(jobResponse);
 
     auto end = chrono::high_resolution_clock::now();
     auto dur = end - begin;
@@ -655,7 +764,7 @@ void TriangleCountExecutor::execute() {
 
     std::string durationString = std::to_string(msDuration);
 
-    if (canCalibrate || autoCalibrate) {
+    if ((canCalibrate || autoCalibrate) && !centralTrianglesFailed) {
         Utils::updateSLAInformation(perfDB, graphId, partitionCount, msDuration, TRIANGLES,
                                     Conts::SLA_CATEGORY::LATENCY);
         isStatCollect = false;
@@ -992,125 +1101,256 @@ static int updateTriangleTreeAndGetTriangleCount(
     return aggregateCount;
 }
 
+// worker_id => [ip,port,data_port]
+static map<string, vector<string>> getWorkerDataMap(SQLiteDBInterface *sqlite) {
+    map<string, vector<string>> workerDataMap;
+    std::shared_ptr<const ClusterTopology::Snapshot> topology = ClusterTopology::get(sqlite);
+    for (auto it = topology->workers.begin(); it != topology->workers.end(); it++) {
+        const ClusterTopology::Worker &worker = it->second;
+        workerDataMap[to_string(worker.id)] = {worker.host, to_string(worker.port), to_string(worker.dataPort)};
+    }
+    return workerDataMap;
+}
+
+/*
+ * Counts the triangles spanning three partitions. Every worker counts the triangles owned by the vertices of its
+ * partitions against the central stores of all the other partitions, so the workers only return counts and the master
+ * just sums them. Returns -1 if any worker could not count its share.
+ * */
 static long aggregateCentralStoreTriangles(SQLiteDBInterface *sqlite, std::string graphId, std::string masterIP,
                                            int threadPriority,
                                            const std::map<string, std::vector<string>> &partitionMap) {
     vector<string> partitionsVector;
-    std::map<string, string> partitionWorkerMap;  // partition_id => worker_id
     for (auto it = partitionMap.begin(); it != partitionMap.end(); it++) {
-        const auto &parts = it->second;
-        string worker = it->first;
-        for (auto partsIt = parts.begin(); partsIt != parts.end(); partsIt++) {
-            string partition = *partsIt;
-            partitionWorkerMap[partition] = worker;
-            partitionsVector.push_back(partition);
-        }
+        partitionsVector.insert(partitionsVector.end(), it->second.begin(), it->second.end());
+    }
+    if (partitionsVector.size() < 3) {
+        return 0;
     }
 
-    const std::vector<std::vector<string>> &partitionCombinations = AbstractExecutor::getCombinations(partitionsVector);
-    std::map<string, int> workerWeightMap;
-    std::vector<std::future<string>> triangleCountResponse;
-    std::string result = "";
-    long aggregatedTriangleCount = 0;
-
-    const std::vector<vector<pair<string, string>>> &workerDataResult =
-        sqlite->runSelect("SELECT DISTINCT idworker,ip,server_port,server_data_port FROM worker;");
-    map<string, vector<string>> workerDataMap;  // worker_id => [ip,port,data_port]
-    for (auto it = workerDataResult.begin(); it != workerDataResult.end(); it++) {
-        const auto &ipPortDport = *it;
-        string id = ipPortDport[0].second;
-        string ip = ipPortDport[1].second;
-        string port = ipPortDport[2].second;
-        string dport = ipPortDport[3].second;
-        workerDataMap[id] = {ip, port, dport};
-    }
-
-    for (auto partitonCombinationsIterator = partitionCombinations.begin();
-         partitonCombinationsIterator != partitionCombinations.end(); partitonCombinationsIterator++) {
-        const std::vector<string> &partitionCombination = *partitonCombinationsIterator;
-        std::vector<std::future<string>> remoteGraphCopyResponse;
-        int minimumWeight = 0;
-        std::string minWeightWorker;
-        std::string minWeightWorkerPartition;
-
-        for (auto partCombinationIterator = partitionCombination.begin();
-             partCombinationIterator != partitionCombination.end(); partCombinationIterator++) {
-            string part = *partCombinationIterator;
-            string workerId = partitionWorkerMap[part];
-            auto workerWeightMapIterator = workerWeightMap.find(workerId);
-            if (workerWeightMapIterator != workerWeightMap.end()) {
-                int weight = workerWeightMapIterator->second;
-
-                if (minimumWeight == 0 || minimumWeight > weight) {
-                    minimumWeight = weight + 1;
-                    minWeightWorker = workerId;
-                    minWeightWorkerPartition = part;
-                }
-            } else {
-                minimumWeight = 1;
-                minWeightWorker = workerId;
-                minWeightWorkerPartition = part;
-            }
-        }
-        workerWeightMap[minWeightWorker] = minimumWeight;
+    map<string, vector<string>> workerDataMap = getWorkerDataMap(sqlite);
 
-        const auto &workerData = workerDataMap[minWeightWorker];
+    // Each worker receives the central stores of the partitions it does not host, once for all of its partitions
+    std::vector<std::future<long>> triangleCountResponse;
+    for (auto it = partitionMap.begin(); it != partitionMap.end(); it++) {
+        string workerId = it->first;
+        const std::vector<string> &workerPartitions = it->second;
+        const auto &workerData = workerDataMap[workerId];
         std::string aggregatorIp = workerData[0];
         std::string aggregatorPort = workerData[1];
         std::string aggregatorDataPort = workerData[2];
 
-        std::string aggregatorPartitionId = minWeightWorkerPartition;
-
-        std::string partitionIdList = "";
-        for (auto partitionCombinationIterator = partitionCombination.begin();
-             partitionCombinationIterator != partitionCombination.end(); ++partitionCombinationIterator) {
-            string part = *partitionCombinationIterator;
-            string workerId = partitionWorkerMap[part];
-
-            if (part != minWeightWorkerPartition) {
-                partitionIdList += part + ",";
-            }
-            if (workerId != minWeightWorker) {
+        triangleCountResponse.push_back(std::async(std::launch::async, [=]() {
+            for (auto partIt = partitionsVector.begin(); partIt != partitionsVector.end(); partIt++) {
+                const string &part = *partIt;
+                if (std::find(workerPartitions.begin(), workerPartitions.end(), part) != workerPartitions.end()) {
+                    continue;
+                }
                 std::string centralStoreAvailable = isFileAccessibleToWorker(
                     graphId, part, aggregatorIp, aggregatorPort, masterIP,
                     JasmineGraphInstanceProtocol::FILE_TYPE_CENTRALSTORE_AGGREGATE, std::string());
-
                 if (centralStoreAvailable.compare("false") == 0) {
-                    remoteGraphCopyResponse.push_back(std::async(
-                        std::launch::async, TriangleCountExecutor::copyCentralStoreToAggregator, aggregatorIp,
-                        aggregatorPort, aggregatorDataPort, atoi(graphId.c_str()), atoi(part.c_str()), masterIP));
+                    TriangleCountExecutor::copyCentralStoreToAggregator(aggregatorIp, aggregatorPort,
+                                                                        aggregatorDataPort, atoi(graphId.c_str()),
+                                                                        atoi(part.c_str()), masterIP);
                 }
             }
-        }
 
-        for (auto &&futureCallCopy : remoteGraphCopyResponse) {
-            futureCallCopy.get();
+            // One request per worker, so that every central store is loaded once for all of the worker's partitions
+            std::string ownedPartitionIds = "";
+            std::string partitionIdList = "";
+            for (auto partIt = partitionsVector.begin(); partIt != partitionsVector.end(); partIt++) {
+                if (std::find(workerPartitions.begin(), workerPartitions.end(), *partIt) != workerPartitions.end()) {
+                    ownedPartitionIds += *partIt + ",";
+                } else {
+                    partitionIdList += *partIt + ",";
+                }
+            }
+            ownedPartitionIds = ownedPartitionIds.substr(0, ownedPartitionIds.size() - 1);
+            partitionIdList = partitionIdList.substr(0, partitionIdList.size() - 1);
+            return TriangleCountExecutor::countCentralStoreTriangles(aggregatorPort, aggregatorIp, ownedPartitionIds,
+                                                                     partitionIdList, graphId, masterIP,
+                                                                     threadPriority);
+        }));
+    }
+
+    long aggregatedTriangleCount = 0;
+    bool counted = true;
+    for (auto &&futureCall : triangleCountResponse) {
+        long workerTriangleCount = futureCall.get();
+        if (workerTriangleCount < 0) {
+            counted = false;
         }
+        aggregatedTriangleCount += workerTriangleCount;
+    }
+    if (!counted) {
+        triangleCount_logger.error("Central triangle count failed for graph " + graphId);
+        return -1;
+    }
+    return aggregatedTriangleCount;
+}
 
-        std::string adjustedPartitionIdList = partitionIdList.substr(0, partitionIdList.size() - 1);
+static int openWorkerSession(std::string host, int port, std::string masterIP, char *data) {
+    int sockfd = socket(AF_INET, SOCK_STREAM, 0);
+    if (sockfd < 0) {
+        triangleCount_logger.error("Cannot create socket");
+        return -1;
+    }
 
-        triangleCountResponse.push_back(std::async(
-            std::launch::async, TriangleCountExecutor::countCentralStoreTriangles, aggregatorPort, aggregatorIp,
-            aggregatorPartitionId, adjustedPartitionIdList, graphId, masterIP, threadPriority));
+    if (host.find('@') != std::string::npos) {
+        host = Utils::split(host, '@')[1];
     }
 
-    for (auto &&futureCall : triangleCountResponse) {
-        result = result + ":" + futureCall.get();
+    struct hostent *server = gethostbyname(host.c_str());
+    if (server == NULL) {
+        triangleCount_logger.error("ERROR, no host named " + host);
+        close(sockfd);
+        return -1;
     }
 
-    const std::vector<std::string> &triangles = Utils::split(result, ':');
-    std::set<std::string> uniqueTriangleSet;
-    for (auto triangleIterator = triangles.begin(); triangleIterator != triangles.end(); ++triangleIterator) {
-        std::string triangle = *triangleIterator;
+    struct sockaddr_in serv_addr;
+    bzero((char *)&serv_addr, sizeof(serv_addr));
+    serv_addr.sin_family = AF_INET;
+    bcopy((char *)server->h_addr, (char *)&serv_addr.sin_addr.s_addr, server->h_length);
+    serv_addr.sin_port = htons(port);
+    if (Utils::connect_wrapper(sockfd, (struct sockaddr *)&serv_addr, sizeof(serv_addr)) < 0) {
+        triangleCount_logger.error("ERROR connecting to " + host + ":" + std::to_string(port));
+        close(sockfd);
+        return -1;
+    }
 
-        if (!triangle.empty() && triangle != "NILL") {
-            uniqueTriangleSet.insert(triangle);
+    if (!Utils::performHandshake(sockfd, data, INSTANCE_DATA_LENGTH, masterIP)) {
+        Utils::send_str_wrapper(sockfd, JasmineGraphInstanceProtocol::CLOSE);
+        close(sockfd);
+        return -1;
+    }
+    return sockfd;
+}
+
+static bool shuffleCentralStoreAdjacency(std::string host, int port, std::string graphId, std::string partitionId,
+                                         std::string bucketList, std::string masterIP) {
+    char data[INSTANCE_DATA_LENGTH + 1];
+    int sockfd = openWorkerSession(host, port, masterIP, data);
+    if (sockfd < 0) {
+        return false;
+    }
+
+    bool shuffled = Utils::sendExpectResponse(sockfd, data, INSTANCE_DATA_LENGTH,
+                                              JasmineGraphInstanceProtocol::SHUFFLE_CENTRALSTORE_ADJACENCY,
+                                              JasmineGraphInstanceProtocol::OK) &&
+                    Utils::sendExpectResponse(sockfd, data, INSTANCE_DATA_LENGTH, graphId,
+                                              JasmineGraphInstanceProtocol::OK) &&
+                    Utils::sendExpectResponse(sockfd, data, INSTANCE_DATA_LENGTH, partitionId,
+                                              JasmineGraphInstanceProtocol::OK) &&
+                    Utils::sendChunkedString(sockfd, data, INSTANCE_DATA_LENGTH, bucketList) &&
+                    Utils::read_str_trim_wrapper(sockfd, data, INSTANCE_DATA_LENGTH) ==
+                        JasmineGraphInstanceProtocol::OK;
+    Utils::send_str_wrapper(sockfd, JasmineGraphInstanceProtocol::CLOSE);
+    close(sockfd);
+    return shuffled;
+}
+
+static long countShuffledCentralStoreTriangles(std::string host, int port, std::string graphId,
+                                               std::string bucketInfo, std::string partitionIdList,
+                                               std::string masterIP) {
+    char data[INSTANCE_DATA_LENGTH + 1];
+    int sockfd = openWorkerSession(host, port, masterIP, data);
+    if (sockfd < 0) {
+        return -1;
+    }
+
+    long triangleCount = -1;
+    if (Utils::sendExpectResponse(sockfd, data, INSTANCE_DATA_LENGTH,
+                                  JasmineGraphInstanceProtocol::COUNT_SHUFFLED_CENTRALSTORE_TRIANGLES,
+                                  JasmineGraphInstanceProtocol::OK) &&
+        Utils::sendExpectResponse(sockfd, data, INSTANCE_DATA_LENGTH, graphId, JasmineGraphInstanceProtocol::OK) &&
+        Utils::sendExpectResponse(sockfd, data, INSTANCE_DATA_LENGTH, bucketInfo, JasmineGraphInstanceProtocol::OK) &&
+        Utils::sendChunkedString(sockfd, data, INSTANCE_DATA_LENGTH, partitionIdList)) {
+        string response = Utils::read_str_trim_wrapper(sockfd, data, INSTANCE_DATA_LENGTH);
+        triangleCount_logger.info("Central triangles of bucket " + bucketInfo + " : " + response);
+        triangleCount = Utils::is_number(response) ? atol(response.c_str()) : -1;
+    }
+    Utils::send_str_wrapper(sockfd, JasmineGraphInstanceProtocol::CLOSE);
+    close(sockfd);
+    return triangleCount;
+}
+
+/*
+ * Counts the triangles spanning three partitions with one bucket per worker. Every partition first sends each bucket
+ * the out-neighbour lists it needs, then every bucket counts the triangles of the vertices hashed to it. The traffic
+ * is linear in the number of cut edges and no worker holds more than its share of the cut graph.
+ * The shuffled lists are named after jobId so that concurrent jobs on the same graph do not mix them up.
+ * Returns -1 if any of the steps failed.
+ * */
+static long shuffleCentralStoreTriangles(SQLiteDBInterface *sqlite, std::string graphId, std::string masterIP,
+                                         int jobId, const std::map<string, std::vector<string>> &partitionMap) {
+    std::string partitionIdList = "";
+    int partitionCount = 0;
+    for (auto it = partitionMap.begin(); it != partitionMap.end(); it++) {
+        for (auto partIt = it->second.begin(); partIt != it->second.end(); partIt++) {
+            partitionIdList += *partIt + ",";
+            partitionCount++;
         }
     }
+    if (partitionCount < 3) {
+        return 0;
+    }
+    partitionIdList = partitionIdList.substr(0, partitionIdList.size() - 1);
 
-    aggregatedTriangleCount = uniqueTriangleSet.size();
-    uniqueTriangleSet.clear();
+    map<string, vector<string>> workerDataMap = getWorkerDataMap(sqlite);
 
+    // One bucket per worker hosting a partition of the graph
+    std::vector<string> bucketWorkers;
+    std::string bucketHosts = "";
+    for (auto it = partitionMap.begin(); it != partitionMap.end(); it++) {
+        const auto &workerData = workerDataMap[it->first];
+        bucketWorkers.push_back(it->first);
+        bucketHosts += workerData[0] + ":" + workerData[2] + ",";
+    }
+    bucketHosts = bucketHosts.substr(0, bucketHosts.size() - 1);
+    int bucketCount = bucketWorkers.size();
+
+    std::vector<std::future<bool>> shuffleResponses;
+    for (int bucket = 0; bucket < bucketCount; bucket++) {
+        const auto &workerData = workerDataMap[bucketWorkers[bucket]];
+        const auto &workerPartitions = partitionMap.at(bucketWorkers[bucket]);
+        for (auto partIt = workerPartitions.begin(); partIt != workerPartitions.end(); partIt++) {
+            shuffleResponses.push_back(std::async(std::launch::async, shuffleCentralStoreAdjacency, workerData[0],
+                                                  atoi(workerData[1].c_str()), graphId, *partIt,
+                                                  std::to_string(jobId) + "|" + std::to_string(bucket) + "|" +
+                                                      bucketHosts,
+                                                  masterIP));
+        }
+    }
+    bool shuffled = true;
+    for (auto &&futureCall : shuffleResponses) {
+        shuffled = futureCall.get() && shuffled;
+    }
+
+    // Buckets are counted even after a failed shuffle so that the received lists are cleaned up
+    std::vector<std::future<long>> countResponses;
+    for (int bucket = 0; bucket < bucketCount; bucket++) {
+        const auto &workerData = workerDataMap[bucketWorkers[bucket]];
+        countResponses.push_back(std::async(std::launch::async, countShuffledCentralStoreTriangles, workerData[0],
+                                            atoi(workerData[1].c_str()), graphId,
+                                            std::to_string(jobId) + "|" + std::to_string(bucket) + "|" +
+                                                std::to_string(bucketCount),
+                                            partitionIdList, masterIP));
+    }
+    long aggregatedTriangleCount = 0;
+    for (auto &&futureCall : countResponses) {
+        long bucketTriangleCount = futureCall.get();
+        if (bucketTriangleCount < 0) {
+            shuffled = false;
+        }
+        aggregatedTriangleCount += bucketTriangleCount;
+    }
+
+    if (!shuffled) {
+        triangleCount_logger.error("Shuffled central triangle count failed for graph " + graphId +
+                                   ". Falling back to the owner plan");
+        return -1;
+    }
     return aggregatedTriangleCount;
 }
 
@@ -1239,7 +1479,7 @@ std::string TriangleCountExecutor::copyCompositeCentralStoreToAggregator(std::st
     std::string aggregatorFilePath = Utils::getJasmineGraphProperty("org.jasminegraph.server.instance.aggregatefolder");
     std::string aggregateStoreFile = aggregatorFilePath + "/" + fileName;
 
-    int fileSize = Utils::getFileSize(aggregateStoreFile);
+    long fileSize = Utils::getFileSize(aggregateStoreFile);
     std::string fileLength = to_string(fileSize);
 
     sockfd = socket(AF_INET, SOCK_STREAM, 0);
@@ -1357,6 +1597,9 @@ std::string TriangleCountExecutor::copyCompositeCentralStoreToAggregator(std::st
                 break;
             } else {
                 triangleCount_logger.error("Invalid response " + response);
+                Utils::send_str_wrapper(sockfd, JasmineGraphInstanceProtocol::CLOSE);
+                close(sockfd);
+                return response;
             }
         }
 
@@ -1379,6 +1622,11 @@ std::string TriangleCountExecutor::copyCompositeCentralStoreToAggregator(std::st
                 triangleCount_logger.log("Received : " + JasmineGraphInstanceProtocol::BATCH_UPLOAD_ACK, "info");
                 triangleCount_logger.log("CentralStore partition file upload completed", "info");
                 break;
+            } else {
+                triangleCount_logger.error("CentralStore partition file upload failed. Received: " + response);
+                Utils::send_str_wrapper(sockfd, JasmineGraphInstanceProtocol::CLOSE);
+                close(sockfd);
+                return response;
             }
         }
     } else {
@@ -1551,7 +1799,7 @@ std::string TriangleCountExecutor::copyCentralStoreToAggregator(std::string aggr
     std::string fileName = std::to_string(graphId) + "_centralstore_" + std::to_string(partitionId) + ".gz";
     std::string centralStoreFile = aggregatorDirPath + "/" + fileName;
 
-    int fileSize = Utils::getFileSize(centralStoreFile);
+    long fileSize = Utils::getFileSize(centralStoreFile);
     std::string fileLength = to_string(fileSize);
 
     sockfd = socket(AF_INET, SOCK_STREAM, 0);
@@ -1664,6 +1912,9 @@ std::string TriangleCountExecutor::copyCentralStoreToAggregator(std::string aggr
                 break;
             } else {
                 triangleCount_logger.error("Invalid response " + response);
+                Utils::send_str_wrapper(sockfd, JasmineGraphInstanceProtocol::CLOSE);
+                close(sockfd);
+                return response;
             }
         }
 
@@ -1686,6 +1937,11 @@ std::string TriangleCountExecutor::copyCentralStoreToAggregator(std::string aggr
                 triangleCount_logger.log("Received : " + JasmineGraphInstanceProtocol::BATCH_UPLOAD_ACK, "info");
                 triangleCount_logger.log("CentralStore partition file upload completed", "info");
                 break;
+            } else {
+                triangleCount_logger.error("CentralStore partition file upload failed. Received: " + response);
+                Utils::send_str_wrapper(sockfd, JasmineGraphInstanceProtocol::CLOSE);
+                close(sockfd);
+                return response;
             }
         }
     } else {
@@ -1697,28 +1953,29 @@ std::string TriangleCountExecutor::copyCentralStoreToAggregator(std::string aggr
     return response;
 }
 
-string TriangleCountExecutor::countCentralStoreTriangles(std::string aggregatorPort, std::string host,
-                                                         std::string partitionId, std::string partitionIdList,
-                                                         std::string graphId, std::string masterIP,
-                                                         int threadPriority) {
+long TriangleCountExecutor::countCentralStoreTriangles(std::string aggregatorPort, std::string host,
+                                                       std::string ownedPartitionIds, std::string partitionIdList,
+                                                       std::string graphId, std::string masterIP, int threadPriority) {
     int sockfd;
     char data[INSTANCE_DATA_LENGTH + 1];
     bool loop = false;
     socklen_t len;
     struct sockaddr_in serv_addr;
     struct hostent *server;
+    long triangleCount = -1;
 
     sockfd = socket(AF_INET, SOCK_STREAM, 0);
 
     if (sockfd < 0) {
         triangleCount_logger.error("Cannot create socket");
-        return 0;
+        return -1;
     }
 
     server = gethostbyname(host.c_str());
     if (server == NULL) {
         triangleCount_logger.error("ERROR, no host named " + host);
-        return 0;
+        close(sockfd);
+        return -1;
     }
 
     bzero((char *)&serv_addr, sizeof(serv_addr));
@@ -1727,7 +1984,8 @@ string TriangleCountExecutor::countCentralStoreTriangles(std::string aggregatorP
     serv_addr.sin_port = htons(atoi(aggregatorPort.c_str()));
     if (Utils::connect_wrapper(sockfd, (struct sockaddr *)&serv_addr, sizeof(serv_addr)) < 0) {
         triangleCount_logger.error("ERROR connecting");
-        return 0;
+        close(sockfd);
+        return -1;
     }
 
     int result_wr =
@@ -1777,12 +2035,12 @@ string TriangleCountExecutor::countCentralStoreTriangles(std::string aggregatorP
 
         if (response.compare(JasmineGraphInstanceProtocol::OK) == 0) {
             triangleCount_logger.log("Received : " + JasmineGraphInstanceProtocol::OK, "info");
-            result_wr = write(sockfd, partitionId.c_str(), partitionId.size());
+            result_wr = write(sockfd, ownedPartitionIds.c_str(), ownedPartitionIds.size());
 
             if (result_wr < 0) {
                 triangleCount_logger.log("Error writing to socket", "error");
             }
-            triangleCount_logger.log("Sent : Partition ID " + partitionId, "info");
+            triangleCount_logger.log("Sent : Owned Partition IDs " + ownedPartitionIds, "info");
 
             response = Utils::read_str_trim_wrapper(sockfd, data, INSTANCE_DATA_LENGTH);
         }
@@ -1810,21 +2068,10 @@ string TriangleCountExecutor::countCentralStoreTriangles(std::string aggregatorP
             triangleCount_logger.log("Sent : Thread Priority " + std::to_string(threadPriority), "info");
 
             response = Utils::read_str_trim_wrapper(sockfd, data, INSTANCE_DATA_LENGTH);
-            string status = response.substr(response.size() - 5);
-            std::basic_ostringstream<char> resultStream;
-            resultStream << response.substr(0, response.size() - 5);
-
-            while (status == "/SEND") {
-                result_wr = write(sockfd, status.c_str(), status.size());
-
-                if (result_wr < 0) {
-                    triangleCount_logger.log("Error writing to socket", "error");
-                }
-                response = Utils::read_str_trim_wrapper(sockfd, data, INSTANCE_DATA_LENGTH);
-                status = response.substr(response.size() - 5);
-                resultStream << response.substr(0, response.size() - 5);
+            triangleCount_logger.info("Central triangles owned by partitions " + ownedPartitionIds + " : " + response);
+            if (!response.empty()) {
+                triangleCount = atol(response.c_str());
             }
-            response = resultStream.str();
         }
 
     } else {
@@ -1833,7 +2080,7 @@ string TriangleCountExecutor::countCentralStoreTriangles(std::string aggregatorP
     }
     Utils::send_str_wrapper(sockfd, JasmineGraphInstanceProtocol::CLOSE);
     close(sockfd);
-    return response;
+    return triangleCount;
 }
 
 int TriangleCountExecutor::getUid() {
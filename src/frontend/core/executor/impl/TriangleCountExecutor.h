@@ -15,6 +15,7 @@ limitations under the License.
 #define JASMINEGRAPH_TRIANGLECOUNTEXECUTOR_H
 
 #include <chrono>
+#include <set>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -58,9 +59,27 @@ class TriangleCountExecutor : public AbstractExecutor {
                                                     std::string aggregatorDataPort, int graphId, int partitionId,
                                                     std::string masterIP);
 
-    static string countCentralStoreTriangles(std::string aggregatorPort, std::string host, std::string partitionId,
-                                             std::string partitionIdList, std::string graphId, std::string masterIP,
-                                             int threadPriority);
+    // Returns the number of cross-partition triangles owned by the comma separated partitions in ownedPartitionIds, or
+    // -1 if the worker could not count them
+    static long countCentralStoreTriangles(std::string aggregatorPort, std::string host, std::string ownedPartitionIds,
+                                           std::string partitionIdList, std::string graphId, std::string masterIP,
+                                           int threadPriority);
+
+    /*
+     * Load of a worker on the 0 to 3 scale that partitions are planned with: the highest of its CPU usage on a scale
+     * of 4 cores, the triangle tasks it runs and the partitions assigned to it by jobs that may not have reached it
+     * yet. `heartbeat` is null for a worker that did not answer, and publishedCpuUsage is used instead.
+     * */
+    static int getWorkerLoad(const Utils::WorkerHeartbeat *heartbeat, double publishedCpuUsage,
+                             int assignedPartitions);
+
+    /*
+     * Picks one holder for every partition in partitionMap (worker id => partitions it holds) among the workers below
+     * load 3, and adds the planned partitions to `loads`. Partitions no such worker holds are left in `remain`.
+     * Returns the number of those partitions.
+     * */
+    static int allocatePartitions(const std::map<string, std::vector<string>> &partitionMap,
+                                  std::map<string, int> &loads, std::map<int, string> &alloc, std::set<int> &remain);
 
     static bool proceedOrNot(std::set<string> partitionSet, int partitionId);
 
@@ -0,0 +1,81 @@
+/**
+Copyright 2024 JasmineGraph Team
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#include "JobMemoryEstimator.h"
+
+#include "../../../util/logger/Logger.h"
+#include "../../JasmineGraphFrontEndProtocol.h"
+
+Logger memoryEstimator_logger;
+
+// Bytes per vertex and per edge of a partition, and KB per task
+struct MemoryModel {
+    long vertexBytes;
+    long edgeBytes;
+    long taskKB;
+};
+
+// A vertex costs a std::map node and an unordered_set header (~112 bytes) per copy of the adjacency sets, and an
+// edge an unordered_set node and bucket (~32 bytes) per direction per copy.
+static const MemoryModel TRIANGLES_MODEL = {4 * 112, 3 * 2 * 32, 4096};  // 3 stores, copied, and a degree map
+static const MemoryModel PAGE_RANK_MODEL = {2 * 112 + 32, 2 * 32, 4096};  // adjacency, reverse edges and ranks
+static const MemoryModel DEFAULT_MODEL = {2 * 112, 2 * 32, 2048};
+
+static const MemoryModel &getModel(const std::string &jobType) {
+    if (jobType == TRIANGLES) {
+        return TRIANGLES_MODEL;
+    }
+    if (jobType == PAGE_RANK) {
+        return PAGE_RANK_MODEL;
+    }
+    return DEFAULT_MODEL;
+}
+
+long JobMemoryEstimator::estimate(const std::string &jobType, const PartitionSize &size) {
+    const MemoryModel &model = getModel(jobType);
+    return model.taskKB + (model.vertexBytes * size.vertices + model.edgeBytes * size.edges) / 1024;
+}
+
+std::map<int, JobMemoryEstimator::PartitionSize> JobMemoryEstimator::getPartitionSizes(SQLiteDBInterface *sqlite,
+                                                                                       const std::string &graphId) {
+    std::map<int, PartitionSize> sizes;
+    bool loaded = sqlite->forEachRow(
+        "SELECT idpartition, vertexcount, central_vertexcount, edgecount, central_edgecount_with_dups "
+        "FROM partition WHERE graph_idgraph = ?",
+        {graphId}, [&sizes](const DBRow &row) {
+            sizes[row.getInt(0)] = {row.getLong(1) + row.getLong(2), row.getLong(3) + row.getLong(4)};
+        });
+    if (!loaded) {
+        memoryEstimator_logger.warn("Could not read the partition sizes of graph " + graphId);
+    }
+    return sizes;
+}
+
+std::map<std::string, long> JobMemoryEstimator::estimateJob(
+    const std::string &jobType, const std::map<int, PartitionSize> &partitionSizes,
+    const std::map<std::string, std::vector<std::string>> &partitions) {
+    std::map<std::string, long> memory;
+    for (auto it = partitions.begin(); it != partitions.end(); it++) {
+        long &workerMemory = memory[it->first];
+        for (auto partitionIt = it->second.begin(); partitionIt != it->second.end(); partitionIt++) {
+            // Partitions with unknown sizes still cost a task
+            PartitionSize size = {0, 0};
+            auto sizeIt = partitionSizes.find(atoi(partitionIt->c_str()));
+            if (sizeIt != partitionSizes.end()) {
+                size = sizeIt->second;
+            }
+            workerMemory += estimate(jobType, size);
+        }
+    }
+    return memory;
+}
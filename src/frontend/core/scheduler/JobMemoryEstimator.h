@@ -0,0 +1,50 @@
+/**
+Copyright 2024 JasmineGraph Team
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#ifndef JASMINEGRAPH_JOBMEMORYESTIMATOR_H
+#define JASMINEGRAPH_JOBMEMORYESTIMATOR_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "../../../metadb/SQLiteDBInterface.h"
+
+/*
+ * Estimates the memory an analytics job needs on a worker from the sizes of the partitions it processes there.
+ *
+ * Workers hold a partition as adjacency sets (map<long, unordered_set<long>>) and most algorithms keep more than one
+ * copy of them, e.g. triangle counting loads the local, central and duplicate central stores and works on copies.
+ * The estimate is a per vertex and per edge cost for each algorithm plus a fixed cost per task. It errs on the high
+ * side; the scheduler uses it only to decide how many jobs may share a worker.
+ * */
+class JobMemoryEstimator {
+ public:
+    struct PartitionSize {
+        long vertices;
+        long edges;
+    };
+
+    // KB a job of the type needs to process one partition
+    static long estimate(const std::string &jobType, const PartitionSize &size);
+
+    // Sizes of the partitions of the graph, local and central stores together, by partition id
+    static std::map<int, PartitionSize> getPartitionSizes(SQLiteDBInterface *sqlite, const std::string &graphId);
+
+    // KB the job needs on each worker, for the partitions assigned to the worker
+    static std::map<std::string, long> estimateJob(const std::string &jobType,
+                                                   const std::map<int, PartitionSize> &partitionSizes,
+                                                   const std::map<std::string, std::vector<std::string>> &partitions);
+};
+
+#endif  // JASMINEGRAPH_JOBMEMORYESTIMATOR_H
@@ -13,94 +13,358 @@ limitations under the License.
 
 #include "JobScheduler.h"
 
+#include <condition_variable>
+
+#include "../../../server/JasmineGraphServer.h"
+#include "../../../server/ReplicaManager.h"
+
 #include "../../../util/Conts.h"
 #include "../../../util/logger/Logger.h"
 #include "../executor/AbstractExecutor.h"
 #include "../factory/ExecutorFactory.h"
+#include "JobMemoryEstimator.h"
 
 Logger jobScheduler_Logger;
-std::priority_queue<JobRequest> jobQueue;
-std::vector<JobResponse> responseVector;
 std::map<std::string, JobResponse> responseMap;
-std::vector<std::future<void>> JobScheduler::intermRes;
 bool workerResponded;
 std::vector<std::string> highPriorityGraphList;
+static std::condition_variable responseCondition;
+
+static const int DEFAULT_MAX_RUNNING_JOBS = 8;
+static const int DEFAULT_MAX_QUEUED_JOBS = 256;
+static const int DEFAULT_MAX_JOBS_PER_GRAPH = 2;
+static const int DEFAULT_MAX_JOBS_PER_WORKER = 4;
+static const double DEFAULT_MEMORY_BUDGET = 0.8;
+static const std::chrono::seconds MEMORY_BUDGET_REFRESH(30);
 
-JobScheduler::JobScheduler(SQLiteDBInterface *sqlite, PerformanceSQLiteDBInterface *perfDB) {
+static int getSchedulerLimit(const std::string &key, int defaultValue) {
+    int value = atoi(Utils::getJasmineGraphProperty(key).c_str());
+    return value > 0 ? value : defaultValue;
+}
+
+JobScheduler::JobScheduler(SQLiteDBInterface *sqlite, PerformanceSQLiteDBInterface *perfDB) : JobScheduler() {
     this->sqlite = sqlite;
     this->perfSqlite = perfDB;
 }
 
-JobScheduler::JobScheduler() {}
+JobScheduler::JobScheduler()
+    : sqlite(nullptr),
+      perfSqlite(nullptr),
+      maxRunningJobs(DEFAULT_MAX_RUNNING_JOBS),
+      maxQueuedJobs(DEFAULT_MAX_QUEUED_JOBS),
+      maxJobsPerGraph(DEFAULT_MAX_JOBS_PER_GRAPH),
+      maxJobsPerWorker(DEFAULT_MAX_JOBS_PER_WORKER),
+      memoryBudgetFraction(DEFAULT_MEMORY_BUDGET),
+      queuedJobs(0),
+      runningJobs(0),
+      stopped(false),
+      submittedJobs(0),
+      rejectedJobs(0),
+      completedJobs(0),
+      dispatchedJobs(0),
+      totalWaitMs(0),
+      maxWaitMs(0),
+      executors(nullptr),
+      metricsCollector(-1) {}
 
-void *startScheduler(void *dummyPt) {
-    JobScheduler *refToScheduler = (JobScheduler *)dummyPt;
-    PerformanceUtil::init();
-    while (true) {
-        if (jobQueue.size() > 0) {
-            jobScheduler_Logger.info("##JOB SCHEDULER## Jobs Available for Scheduling");
+JobScheduler::~JobScheduler() { stop(); }
 
-            std::vector<JobRequest> pendingHPJobList;
-            std::vector<std::string> highPriorityGraphList;
+void JobScheduler::stop() {
+    if (metricsCollector >= 0) {
+        MetricsRegistry::removeCollector(metricsCollector);
+        metricsCollector = -1;
+    }
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        stopped = true;
+    }
+    queueCondition.notify_all();
+    if (dispatcher.joinable()) {
+        dispatcher.join();
+    }
+    delete executors;
+    executors = nullptr;
+}
 
-            while (!jobQueue.empty()) {
-                JobRequest request = jobQueue.top();
+void JobScheduler::init() {
+    maxRunningJobs = getSchedulerLimit("org.jasminegraph.scheduler.maxjobs", DEFAULT_MAX_RUNNING_JOBS);
+    maxQueuedJobs = getSchedulerLimit("org.jasminegraph.scheduler.maxqueuedjobs", DEFAULT_MAX_QUEUED_JOBS);
+    maxJobsPerGraph = getSchedulerLimit("org.jasminegraph.scheduler.maxjobspergraph", DEFAULT_MAX_JOBS_PER_GRAPH);
+    maxJobsPerWorker = getSchedulerLimit("org.jasminegraph.scheduler.maxjobsperworker", DEFAULT_MAX_JOBS_PER_WORKER);
+    std::string memoryBudget = Utils::getJasmineGraphProperty("org.jasminegraph.scheduler.memorybudget");
+    if (!memoryBudget.empty()) {
+        memoryBudgetFraction = atof(memoryBudget.c_str());
+    }
+    start();
+}
 
-                if (request.getPriority() == Conts::HIGH_PRIORITY_DEFAULT_VALUE && request.getJobType() == TRIANGLES) {
-                    pendingHPJobList.push_back(request);
-                    highPriorityGraphList.push_back(request.getParameter(Conts::PARAM_KEYS::GRAPH_ID));
-                    jobQueue.pop();
-                } else {
-                    jobQueue.pop();
-                    JobScheduler::processJob(request, refToScheduler->sqlite, refToScheduler->perfSqlite);
-                }
+void JobScheduler::start() {
+    executors = new ctpl::thread_pool(maxRunningJobs);
+    dispatcher = std::thread(&JobScheduler::dispatch, this);
+    metricsCollector = MetricsRegistry::addCollector([this] { publishMetrics(); });
+}
+
+void JobScheduler::publishMetrics() {
+    static Gauge &queueDepth = MetricsRegistry::gauge("jasminegraph_scheduler_queue_depth", "Jobs waiting to start");
+    static Gauge &running = MetricsRegistry::gauge("jasminegraph_scheduler_running_jobs", "Jobs running");
+    static Gauge &submitted =
+        MetricsRegistry::gauge("jasminegraph_scheduler_submitted_jobs", "Jobs submitted since the server started");
+    static Gauge &rejected =
+        MetricsRegistry::gauge("jasminegraph_scheduler_rejected_jobs", "Jobs rejected since the server started");
+    static Gauge &completed =
+        MetricsRegistry::gauge("jasminegraph_scheduler_completed_jobs", "Jobs completed since the server started");
+    static Gauge &averageWait =
+        MetricsRegistry::gauge("jasminegraph_scheduler_average_wait_ms", "Average time jobs waited in the queue");
+    static Gauge &maxWait =
+        MetricsRegistry::gauge("jasminegraph_scheduler_max_wait_ms", "Longest time a job waited in the queue");
+    static Gauge &reservedMemory = MetricsRegistry::gauge("jasminegraph_scheduler_reserved_memory_kb",
+                                                          "Worker memory reserved by running jobs");
+
+    Metrics metrics = getMetrics();
+    queueDepth.set(metrics.queueDepth);
+    running.set(metrics.runningJobs);
+    submitted.set(metrics.submittedJobs);
+    rejected.set(metrics.rejectedJobs);
+    completed.set(metrics.completedJobs);
+    averageWait.set(metrics.averageWaitMs);
+    maxWait.set(metrics.maxWaitMs);
+    reservedMemory.set(metrics.reservedMemory);
+}
+
+void JobScheduler::dispatch() {
+    std::unique_lock<std::mutex> lock(queueMutex);
+    while (!stopped) {
+        if (!submittedJobQueue.empty()) {
+            admitSubmittedJobs(lock);
+            continue;
+        }
+        std::vector<QueuedJob> jobs = takeRunnableJobs();
+        if (jobs.empty()) {
+            // Woken up by pushJob() and finishJob()
+            queueCondition.wait(lock);
+            continue;
+        }
+        lock.unlock();
+
+        std::vector<QueuedJob> pendingHPJobList;
+        for (auto &job : jobs) {
+            if (job.request.getPriority() == Conts::HIGH_PRIORITY_DEFAULT_VALUE &&
+                job.request.getJobType() == TRIANGLES) {
+                pendingHPJobList.push_back(job);
+            } else {
+                startJob(job);
             }
+        }
 
-            if (pendingHPJobList.size() > 0) {
-                jobScheduler_Logger.info("##JOB SCHEDULER## High Priority Jobs in Queue: " +
-                                         std::to_string(pendingHPJobList.size()));
-                std::string masterIP = pendingHPJobList[0].getMasterIP();
-                std::string jobType = pendingHPJobList[0].getJobType();
-                std::string category = pendingHPJobList[0].getParameter(Conts::PARAM_KEYS::CATEGORY);
-
-                std::vector<long> scheduleTimeVector = PerformanceUtil::getResourceAvailableTime(
-                    highPriorityGraphList, jobType, category, masterIP, pendingHPJobList);
-
-                for (int index = 0; index != pendingHPJobList.size(); ++index) {
-                    JobRequest hpRequest = pendingHPJobList[index];
-                    long queueTime = scheduleTimeVector[index];
-
-                    if (queueTime < 0) {
-                        JobResponse failedJobResponse;
-                        failedJobResponse.setJobId(hpRequest.getJobId());
-                        failedJobResponse.addParameter(Conts::PARAM_KEYS::ERROR_MESSAGE,
-                                                       "Rejecting the job request because "
-                                                       "SLA cannot be maintained");
-                        responseVectorMutex.lock();
-                        responseMap[hpRequest.getJobId()] = failedJobResponse;
-                        responseVectorMutex.unlock();
-                        continue;
-                    }
-
-                    hpRequest.addParameter(Conts::PARAM_KEYS::QUEUE_TIME, std::to_string(queueTime));
-                    JobScheduler::processJob(hpRequest, refToScheduler->sqlite, refToScheduler->perfSqlite);
+        if (pendingHPJobList.size() > 0) {
+            PerformanceUtil::init();
+            jobScheduler_Logger.info("##JOB SCHEDULER## High Priority Jobs in Queue: " +
+                                     std::to_string(pendingHPJobList.size()));
+            std::vector<JobRequest> hpRequests;
+            std::vector<std::string> hpGraphList;
+            for (auto &job : pendingHPJobList) {
+                hpRequests.push_back(job.request);
+                hpGraphList.push_back(job.graphId);
+            }
+            std::string masterIP = hpRequests[0].getMasterIP();
+            std::string jobType = hpRequests[0].getJobType();
+            std::string category = hpRequests[0].getParameter(Conts::PARAM_KEYS::CATEGORY);
+
+            std::vector<long> scheduleTimeVector =
+                PerformanceUtil::getResourceAvailableTime(hpGraphList, jobType, category, masterIP, hpRequests);
+
+            for (size_t index = 0; index != pendingHPJobList.size(); ++index) {
+                QueuedJob &hpJob = pendingHPJobList[index];
+                long queueTime = scheduleTimeVector[index];
+
+                if (queueTime < 0) {
+                    rejectJob(hpJob.request, "Rejecting the job request because SLA cannot be maintained");
+                    finishJob(hpJob);
+                    continue;
                 }
+
+                hpJob.request.addParameter(Conts::PARAM_KEYS::QUEUE_TIME, std::to_string(queueTime));
+                startJob(hpJob);
+            }
+        }
+        lock.lock();
+    }
+}
+
+/*
+ * Looks up the workers and memory demand of the jobs submitted since the last call, and refreshes the memory budgets
+ * of those workers, with queueMutex released. The jobs then join their priority level in submission order.
+ * */
+void JobScheduler::admitSubmittedJobs(std::unique_lock<std::mutex> &lock) {
+    std::deque<QueuedJob> submitted;
+    submitted.swap(submittedJobQueue);
+    lock.unlock();
+    for (auto &job : submitted) {
+        locateJob(job);
+    }
+    lock.lock();
+    for (auto &job : submitted) {
+        jobLevels[job.request.getPriority()].push_back(job);
+    }
+}
+
+/*
+ * Takes every job that can start now, highest priority first. Executor, graph and worker slots are reserved for the
+ * returned jobs. Must be called with queueMutex held.
+ * */
+std::vector<JobScheduler::QueuedJob> JobScheduler::takeRunnableJobs() {
+    std::vector<QueuedJob> runnable;
+    auto now = std::chrono::steady_clock::now();
+    for (auto level = jobLevels.begin(); level != jobLevels.end() && runningJobs < maxRunningJobs;) {
+        std::deque<QueuedJob> &jobs = level->second;
+        for (auto it = jobs.begin(); it != jobs.end() && runningJobs < maxRunningJobs;) {
+            if (!canStart(*it)) {
+                ++it;
+                continue;
+            }
+            runningJobs++;
+            runningJobsPerGraph[it->graphId]++;
+            for (auto &worker : it->workers) {
+                runningJobsPerWorker[worker]++;
             }
+            for (auto &demand : it->memory) {
+                reservedMemoryPerWorker[demand.first] += demand.second;
+            }
+
+            double waitMs = std::chrono::duration<double, std::milli>(now - it->submitTime).count();
+            dispatchedJobs++;
+            totalWaitMs += waitMs;
+            maxWaitMs = std::max(maxWaitMs, waitMs);
+            queuedJobs--;
+            jobScheduler_Logger.info("##JOB SCHEDULER## Starting job " + it->request.getJobId() + " after waiting " +
+                                     std::to_string((long)waitMs) + " ms. Queue depth: " + std::to_string(queuedJobs));
+
+            runnable.push_back(*it);
+            it = jobs.erase(it);
+        }
+        if (jobs.empty()) {
+            level = jobLevels.erase(level);
         } else {
-            std::this_thread::sleep_for(std::chrono::seconds(Conts::SCHEDULER_SLEEP_TIME));
+            ++level;
         }
     }
-    return NULL;
+    return runnable;
 }
 
-void JobScheduler::init() {
-    pthread_t schedulerThread;
-    pthread_create(&schedulerThread, NULL, startScheduler, this);
-    pthread_detach(schedulerThread);
+bool JobScheduler::canStart(const JobScheduler::QueuedJob &job) {
+    auto graphIt = runningJobsPerGraph.find(job.graphId);
+    if (graphIt != runningJobsPerGraph.end() && graphIt->second >= maxJobsPerGraph) {
+        return false;
+    }
+    for (auto &worker : job.workers) {
+        auto workerIt = runningJobsPerWorker.find(worker);
+        if (workerIt != runningJobsPerWorker.end() && workerIt->second >= maxJobsPerWorker) {
+            return false;
+        }
+    }
+    for (auto &demand : job.memory) {
+        // Workers that have not reported their memory are not limited
+        auto budgetIt = memoryBudgets.find(demand.first);
+        if (budgetIt == memoryBudgets.end()) {
+            continue;
+        }
+        auto reservedIt = reservedMemoryPerWorker.find(demand.first);
+        if (reservedIt != reservedMemoryPerWorker.end() && reservedIt->second + demand.second > budgetIt->second) {
+            return false;
+        }
+    }
+    return true;
 }
 
-void JobScheduler::processJob(JobRequest request, SQLiteDBInterface *sqlite, PerformanceSQLiteDBInterface *perfDB) {
-    intermRes.push_back(std::async(std::launch::async, JobScheduler::executeJob, request, sqlite, perfDB));
+void JobScheduler::estimateMemory(JobScheduler::QueuedJob &job,
+                                  const std::map<std::string, std::vector<std::string>> &partitions) {
+    if (!sqlite) {
+        return;
+    }
+    const auto &partitionSizes = JobMemoryEstimator::getPartitionSizes(sqlite, job.graphId);
+    job.memory = JobMemoryEstimator::estimateJob(job.request.getJobType(), partitionSizes, partitions);
+    for (auto it = job.memory.begin(); it != job.memory.end(); it++) {
+        jobScheduler_Logger.debug("##JOB SCHEDULER## Job " + job.request.getJobId() + " needs " +
+                                  std::to_string(it->second) + " KB on " + it->first);
+    }
+}
+
+/*
+ * Asks the workers of the job whose budgets are older than MEMORY_BUDGET_REFRESH for their memory usage. The memory
+ * used by running jobs is reserved already, so only the rest is taken off the share of the worker's memory.
+ * */
+void JobScheduler::refreshMemoryBudgets(const JobScheduler::QueuedJob &job) {
+    auto now = std::chrono::steady_clock::now();
+    std::vector<std::string> staleWorkers;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        for (auto &worker : job.workers) {
+            auto timeIt = memoryBudgetTimes.find(worker);
+            if (timeIt == memoryBudgetTimes.end() || now - timeIt->second >= MEMORY_BUDGET_REFRESH) {
+                // Claimed before asking so that a worker that does not answer is not asked for every job
+                memoryBudgetTimes[worker] = now;
+                staleWorkers.push_back(worker);
+            }
+        }
+    }
+    JobRequest request = job.request;
+    std::string masterIP = request.getMasterIP();
+    for (auto &worker : staleWorkers) {
+        Utils::WorkerHeartbeat heartbeat;
+        if (!Utils::requestWorkerHeartbeat(worker, masterIP, &heartbeat) ||
+            heartbeat.totalMemory <= 0) {
+            continue;
+        }
+        std::lock_guard<std::mutex> lock(queueMutex);
+        long otherMemory = heartbeat.usedMemory;
+        auto reservedIt = reservedMemoryPerWorker.find(worker);
+        if (reservedIt != reservedMemoryPerWorker.end()) {
+            otherMemory -= reservedIt->second;
+        }
+        long budget = (long)(heartbeat.totalMemory * memoryBudgetFraction) - std::max(otherMemory, 0L);
+        memoryBudgets[worker] = std::max(budget, 0L);
+        jobScheduler_Logger.info("##JOB SCHEDULER## Memory budget of worker " + worker + ": " +
+                                 std::to_string(memoryBudgets[worker]) + " KB");
+    }
+}
+
+void JobScheduler::startJob(const JobScheduler::QueuedJob &job) {
+    executors->push([this, job](int id) {
+        runJob(job.request);
+        finishJob(job);
+    });
+}
+
+void JobScheduler::runJob(const JobRequest &request) { JobScheduler::executeJob(request, sqlite, perfSqlite); }
+
+void JobScheduler::finishJob(const JobScheduler::QueuedJob &job) {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        runningJobs--;
+        completedJobs++;
+        if (--runningJobsPerGraph[job.graphId] <= 0) {
+            runningJobsPerGraph.erase(job.graphId);
+        }
+        for (auto &worker : job.workers) {
+            if (--runningJobsPerWorker[worker] <= 0) {
+                runningJobsPerWorker.erase(worker);
+            }
+        }
+        for (auto &demand : job.memory) {
+            if ((reservedMemoryPerWorker[demand.first] -= demand.second) <= 0) {
+                reservedMemoryPerWorker.erase(demand.first);
+            }
+        }
+    }
+    queueCondition.notify_one();
+}
+
+void JobScheduler::rejectJob(JobRequest request, std::string reason) {
+    jobScheduler_Logger.error("##JOB SCHEDULER## Job " + request.getJobId() + ": " + reason);
+    JobResponse failedJobResponse;
+    failedJobResponse.setJobId(request.getJobId());
+    failedJobResponse.addParameter(Conts::PARAM_KEYS::ERROR_MESSAGE, reason);
+    JobScheduler::setResult(failedJobResponse);
 }
 
 void JobScheduler::executeJob(JobRequest request, SQLiteDBInterface *sqlite, PerformanceSQLiteDBInterface *perfDB) {
@@ -115,23 +379,81 @@ void JobScheduler::executeJob(JobRequest request, SQLiteDBInterface *sqlite, Per
     delete abstractExecutor;
 }
 
-void JobScheduler::pushJob(JobRequest jobDetails) { jobQueue.push(jobDetails); }
+void JobScheduler::locateJob(JobScheduler::QueuedJob &job) {
+    if (job.graphId.empty()) {
+        return;
+    }
+    const auto &graphPartitionedHosts = JasmineGraphServer::getGraphPartitionedHosts(job.graphId);
+    std::map<std::string, std::vector<std::string>> partitions;  // worker => partition ids
+    for (auto it = graphPartitionedHosts.begin(); it != graphPartitionedHosts.end(); it++) {
+        std::string worker = it->first + ":" + std::to_string(it->second.port);
+        job.workers.push_back(worker);
+        partitions[worker] = it->second.partitionID;
+    }
+    if (memoryBudgetFraction > 0) {
+        estimateMemory(job, partitions);
+        refreshMemoryBudgets(job);
+    }
+}
 
-JobResponse JobScheduler::getResult(JobRequest jobRequest) {
-    JobResponse jobResponse;
-    bool responseFound = false;
+void JobScheduler::pushJob(JobRequest jobDetails) {
+    QueuedJob job;
+    job.request = jobDetails;
+    job.graphId = jobDetails.getParameter(Conts::PARAM_KEYS::GRAPH_ID);
+    if (!job.graphId.empty()) {
+        ReplicaManager::recordAccess(atoi(job.graphId.c_str()));
+    }
+    job.submitTime = std::chrono::steady_clock::now();
 
-    while (!responseFound) {
-        responseVectorMutex.lock();
-        if (responseMap.find(jobRequest.getJobId()) != responseMap.end()) {
-            jobResponse = responseMap[jobRequest.getJobId()];
-            responseFound = true;
-        }
-        responseVectorMutex.unlock();
-        if (!responseFound) {
-            usleep(50000);
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        if (queuedJobs >= maxQueuedJobs) {
+            rejectedJobs++;
+        } else {
+            submittedJobQueue.push_back(job);
+            queuedJobs++;
+            submittedJobs++;
+            jobScheduler_Logger.info("##JOB SCHEDULER## Queued job " + jobDetails.getJobId() +
+                                     ". Queue depth: " + std::to_string(queuedJobs));
+            queueCondition.notify_one();
+            return;
         }
     }
+    rejectJob(jobDetails, "Rejecting the job request because the job queue is full");
+}
 
+JobResponse JobScheduler::getResult(JobRequest jobRequest) {
+    std::string jobId = jobRequest.getJobId();
+    std::unique_lock<std::mutex> lock(responseVectorMutex);
+    responseCondition.wait(lock, [&jobId]() { return responseMap.find(jobId) != responseMap.end(); });
+
+    auto responseIt = responseMap.find(jobId);
+    JobResponse jobResponse = responseIt->second;
+    responseMap.erase(responseIt);
     return jobResponse;
 }
+
+void JobScheduler::setResult(JobResponse jobResponse) {
+    {
+        std::lock_guard<std::mutex> lock(responseVectorMutex);
+        responseMap[jobResponse.getJobId()] = jobResponse;
+    }
+    responseCondition.notify_all();
+}
+
+JobScheduler::Metrics JobScheduler::getMetrics() {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    Metrics metrics;
+    metrics.queueDepth = queuedJobs;
+    metrics.runningJobs = runningJobs;
+    metrics.submittedJobs = submittedJobs;
+    metrics.rejectedJobs = rejectedJobs;
+    metrics.completedJobs = completedJobs;
+    metrics.averageWaitMs = dispatchedJobs > 0 ? totalWaitMs / dispatchedJobs : 0;
+    metrics.maxWaitMs = maxWaitMs;
+    metrics.reservedMemory = 0;
+    for (auto it = reservedMemoryPerWorker.begin(); it != reservedMemoryPerWorker.end(); it++) {
+        metrics.reservedMemory += it->second;
+    }
+    return metrics;
+}
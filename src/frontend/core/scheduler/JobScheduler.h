@@ -15,35 +15,139 @@ limitations under the License.
 #define JASMINEGRAPH_JOBSCHEDULER_H
 
 #include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
 #include <future>
+#include <map>
+#include <mutex>
 #include <thread>
+#include <vector>
 
 #include "../../../metadb/SQLiteDBInterface.h"
+#include "../../../performance/metrics/MetricsRegistry.h"
 #include "../../../performance/metrics/PerformanceUtil.h"
 #include "../../../performancedb/PerformanceSQLiteDBInterface.h"
+#include "../../../util/scheduler/ctpl_stl.h"
 #include "../CoreConstants.h"
 #include "../domain/JobRequest.h"
 #include "../domain/JobResponse.h"
 
+/*
+ * Schedules analytics jobs on a bounded executor.
+ *
+ * Jobs wait in a multi-level queue, one FIFO level per priority, and the dispatcher is woken whenever a job is
+ * submitted or finishes. A job is started only when an executor slot is free and neither its graph nor any worker
+ * holding a partition of the graph is at its concurrency limit. Jobs that cannot start are skipped, so lower
+ * priority jobs of other graphs keep the executors busy. Submissions beyond the queue capacity are rejected.
+ *
+ * Each worker also has a memory budget, a share of its memory less what it uses outside the jobs started here. A job
+ * reserves the memory JobMemoryEstimator expects it to need on each of its workers and waits while that would exceed
+ * the budget of one of them. A job that does not fit in a budget at all runs alone on the worker.
+ *
+ * Submitting a job only queues it. The workers, memory demand and memory budgets a job is admitted against are looked
+ * up on the dispatcher thread, so clients never wait on the metadb or on worker heartbeats.
+ * */
 class JobScheduler {
  public:
+    struct Metrics {
+        long queueDepth;
+        long runningJobs;
+        long submittedJobs;
+        long rejectedJobs;
+        long completedJobs;
+        double averageWaitMs;
+        double maxWaitMs;
+        long reservedMemory;  // KB, on all workers
+    };
+
     JobScheduler(SQLiteDBInterface *sqlite, PerformanceSQLiteDBInterface *perfDB);
 
     JobScheduler();
 
+    virtual ~JobScheduler();
+
     void init();
 
-    static void processJob(JobRequest request, SQLiteDBInterface *sqlite, PerformanceSQLiteDBInterface *perfDB);
+    // Stops dispatching and waits for the running jobs
+    void stop();
 
     static void executeJob(JobRequest request, SQLiteDBInterface *sqlite, PerformanceSQLiteDBInterface *perfDB);
 
     void pushJob(JobRequest jobDetails);
 
+    // Blocks until the response of the job is published and takes it out of the response map
     JobResponse getResult(JobRequest jobRequest);
 
+    // Publishes the response of a finished job and wakes up the clients waiting for it
+    static void setResult(JobResponse jobResponse);
+
+    Metrics getMetrics();
+
     SQLiteDBInterface *sqlite;
     PerformanceSQLiteDBInterface *perfSqlite;
-    static std::vector<std::future<void>> intermRes;
+
+ protected:
+    struct QueuedJob {
+        JobRequest request;
+        std::string graphId;
+        std::vector<std::string> workers;
+        std::map<std::string, long> memory;  // KB needed on each worker
+        std::chrono::steady_clock::time_point submitTime;
+    };
+
+    int maxRunningJobs;
+    int maxQueuedJobs;
+    int maxJobsPerGraph;
+    int maxJobsPerWorker;
+    double memoryBudgetFraction;
+
+    // Starts the executors and the dispatcher with the current limits
+    void start();
+
+    // Finds the workers of a job and its memory demand on them. Called on the dispatcher thread.
+    virtual void locateJob(QueuedJob &job);
+
+    // Runs a job on an executor
+    virtual void runJob(const JobRequest &request);
+
+ private:
+    std::mutex queueMutex;
+    std::condition_variable queueCondition;
+    // Jobs submitted since the dispatcher last looked, in submission order
+    std::deque<QueuedJob> submittedJobQueue;
+    // Priority levels, highest first. Each level is served in submission order.
+    std::map<int, std::deque<QueuedJob>, std::greater<int>> jobLevels;
+    std::map<std::string, int> runningJobsPerGraph;
+    std::map<std::string, int> runningJobsPerWorker;
+    std::map<std::string, long> reservedMemoryPerWorker;
+    std::map<std::string, long> memoryBudgets;
+    std::map<std::string, std::chrono::steady_clock::time_point> memoryBudgetTimes;
+    long queuedJobs;
+    long runningJobs;
+    bool stopped;
+
+    long submittedJobs;
+    long rejectedJobs;
+    long completedJobs;
+    long dispatchedJobs;
+    double totalWaitMs;
+    double maxWaitMs;
+
+    ctpl::thread_pool *executors;
+    std::thread dispatcher;
+    int metricsCollector;
+
+    void dispatch();
+    void admitSubmittedJobs(std::unique_lock<std::mutex> &lock);
+    std::vector<QueuedJob> takeRunnableJobs();
+    bool canStart(const QueuedJob &job);
+    void estimateMemory(QueuedJob &job, const std::map<std::string, std::vector<std::string>> &partitions);
+    void refreshMemoryBudgets(const QueuedJob &job);
+    void startJob(const QueuedJob &job);
+    void finishJob(const QueuedJob &job);
+    void rejectJob(JobRequest request, std::string reason);
+    void publishMetrics();
 };
 
 inline bool operator<(const JobRequest& lhs, const JobRequest& rhs) { return lhs.priority < rhs.priority; }
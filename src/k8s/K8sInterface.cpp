@@ -45,8 +45,10 @@ K8sInterface::K8sInterface() {
 }
 
 K8sInterface::~K8sInterface() {
-    apiClient_free(apiClient);
-    apiClient = nullptr;
+    if (apiClient) {
+        apiClient_free(apiClient);
+        apiClient = nullptr;
+    }
 }
 
 v1_deployment_list_t *K8sInterface::getDeploymentList(char *labelSelectors) {
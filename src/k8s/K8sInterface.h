@@ -32,38 +32,42 @@ class K8sInterface {
 
     K8sInterface();
 
-    ~K8sInterface();
+    virtual ~K8sInterface();
 
-    v1_service_list_t *getServiceList(char *labelSelectors);
+    virtual v1_service_list_t *getServiceList(char *labelSelectors);
 
-    v1_deployment_t *createJasmineGraphWorkerDeployment(int workerId, const std::string &ip,
-                                                        const std::string &masterIp) const;
+    virtual v1_deployment_t *createJasmineGraphWorkerDeployment(int workerId, const std::string &ip,
+                                                                const std::string &masterIp) const;
 
-    v1_status_t *deleteJasmineGraphWorkerDeployment(int workerId) const;
+    virtual v1_status_t *deleteJasmineGraphWorkerDeployment(int workerId) const;
 
-    v1_service_t *createJasmineGraphWorkerService(int workerId) const;
+    virtual v1_service_t *createJasmineGraphWorkerService(int workerId) const;
 
-    v1_service_t *deleteJasmineGraphWorkerService(int workerId) const;
+    virtual v1_service_t *deleteJasmineGraphWorkerService(int workerId) const;
 
-    v1_deployment_list_t *getDeploymentList(char *labelSelectors);
+    virtual v1_deployment_list_t *getDeploymentList(char *labelSelectors);
 
-    v1_service_t *createJasmineGraphMasterService();
+    virtual v1_service_t *createJasmineGraphMasterService();
 
-    v1_service_t *deleteJasmineGraphMasterService();
+    virtual v1_service_t *deleteJasmineGraphMasterService();
 
-    std::string getMasterIp();
+    virtual std::string getMasterIp();
 
-    v1_node_list_t *getNodes();
+    virtual v1_node_list_t *getNodes();
 
-    std::string getJasmineGraphConfig(std::string key);
+    virtual std::string getJasmineGraphConfig(std::string key);
 
-    v1_persistent_volume_t *createJasmineGraphPersistentVolume(int workerId) const;
+    virtual v1_persistent_volume_t *createJasmineGraphPersistentVolume(int workerId) const;
 
-    v1_persistent_volume_claim_t *createJasmineGraphPersistentVolumeClaim(int workerId) const;
+    virtual v1_persistent_volume_claim_t *createJasmineGraphPersistentVolumeClaim(int workerId) const;
 
-    v1_persistent_volume_t *deleteJasmineGraphPersistentVolume(int workerId) const;
+    virtual v1_persistent_volume_t *deleteJasmineGraphPersistentVolume(int workerId) const;
 
-    v1_persistent_volume_claim_t *deleteJasmineGraphPersistentVolumeClaim(int workerId) const;
+    virtual v1_persistent_volume_claim_t *deleteJasmineGraphPersistentVolumeClaim(int workerId) const;
+
+ protected:
+    // Used by test doubles, which do not talk to a cluster
+    explicit K8sInterface(apiClient_t *apiClient) : apiClient(apiClient) {}
 
  private:
     std::string loadFromConfig(std::string key);
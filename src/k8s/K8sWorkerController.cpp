@@ -15,18 +15,30 @@ limitations under the License.
 
 #include <stdlib.h>
 
+#include <chrono>
+#include <condition_variable>
 #include <stdexcept>
 #include <utility>
 
+#include "../server/ClusterTopology.h"
+
 Logger controller_logger;
 
 std::vector<JasmineGraphServer::worker> K8sWorkerController::workerList = {};
+static std::mutex workerListMutex;
 static int TIME_OUT = 900;
+// Workers that do not report ready are probed at this interval
+static const int READY_PROBE_INTERVAL = 10;
 static std::vector<int> activeWorkerIds = {};
 std::mutex workerIdMutex;
+// The Kubernetes client is not thread safe, so requests through the shared interface are serialized
 std::mutex k8sSpawnMutex;
 static volatile int nextWorkerId = 0;
 
+static std::mutex readyMutex;
+static std::condition_variable readyCondition;
+static std::set<std::string> readyWorkers;  // ips of workers that reported ready and are not picked up yet
+
 static inline int getNextWorkerId(int count) {
     const std::lock_guard<std::mutex> lock(workerIdMutex);
     int returnId = nextWorkerId;
@@ -34,21 +46,28 @@ static inline int getNextWorkerId(int count) {
     return returnId;
 }
 
-K8sWorkerController::K8sWorkerController(std::string masterIp, int numberOfWorkers, SQLiteDBInterface *metadb) {
+K8sWorkerController::K8sWorkerController(std::string masterIp, int numberOfWorkers, SQLiteDBInterface *metadb,
+                                         K8sInterface *interface) {
     this->masterIp = std::move(masterIp);
     this->numberOfWorkers = 0;
     apiClient_setupGlobalEnv();
-    this->interface = new K8sInterface();
+    this->interface = interface ? interface : new K8sInterface();
     this->metadb = *metadb;
 }
 
+static K8sWorkerController *instance = nullptr;
+
 K8sWorkerController::~K8sWorkerController() {
+    for (auto &start : warmPoolStarts) {
+        start.wait();
+    }
     delete this->interface;
     apiClient_unsetupGlobalEnv();
+    if (instance == this) {
+        instance = nullptr;
+    }
 }
 
-static K8sWorkerController *instance = nullptr;
-
 K8sWorkerController *K8sWorkerController::getInstance() {
     if (instance == nullptr) {
         controller_logger.error("K8sWorkerController is not instantiated");
@@ -59,23 +78,28 @@ K8sWorkerController *K8sWorkerController::getInstance() {
 
 static std::mutex instanceMutex;
 K8sWorkerController *K8sWorkerController::getInstance(std::string masterIp, int numberOfWorkers,
-                                                      SQLiteDBInterface *metadb) {
+                                                      SQLiteDBInterface *metadb, K8sInterface *interface) {
     if (instance == nullptr) {
         instanceMutex.lock();
         if (instance == nullptr) {  // double-checking lock
-            instance = new K8sWorkerController(masterIp, numberOfWorkers, metadb);
+            instance = new K8sWorkerController(masterIp, numberOfWorkers, metadb, interface);
             try {
                 instance->maxWorkers = stoi(instance->interface->getJasmineGraphConfig("max_worker_count"));
             } catch (std::invalid_argument &e) {
                 controller_logger.error("Invalid max_worker_count value. Defaulted to 4");
                 instance->maxWorkers = 4;
             }
+            int warmPoolSize = atoi(instance->interface->getJasmineGraphConfig("warm_pool_size").c_str());
+            instance->warmPoolSize = warmPoolSize > 0 ? warmPoolSize : 0;
 
             // Delete all the workers from the database
             metadb->runUpdate("DELETE FROM worker");
             int workersAttached = instance->attachExistingWorkers();
+            instance->numberOfWorkers = workersAttached;
             if (numberOfWorkers - workersAttached > 0) {
                 instance->scaleUp(numberOfWorkers - workersAttached);
+            } else {
+                instance->refillWarmPool();
             }
         }
         instanceMutex.unlock();
@@ -83,103 +107,151 @@ K8sWorkerController *K8sWorkerController::getInstance(std::string masterIp, int
     return instance;
 }
 
-std::string K8sWorkerController::spawnWorker(int workerId) {
-    k8sSpawnMutex.lock();
-    controller_logger.info("Spawning worker " + to_string(workerId));
-    auto volume = this->interface->createJasmineGraphPersistentVolume(workerId);
-    if (volume != nullptr && volume->metadata != nullptr && volume->metadata->name != nullptr) {
-        controller_logger.info("Worker " + std::to_string(workerId) + " persistent volume created successfully");
-    } else {
-        controller_logger.error("Worker " + std::to_string(workerId) + " persistent volume creation failed");
-        throw std::runtime_error("Worker " + std::to_string(workerId) + " persistent volume creation failed");
+void K8sWorkerController::workerReady(const std::string &ip) {
+    {
+        std::lock_guard<std::mutex> lock(readyMutex);
+        readyWorkers.insert(ip);
     }
+    readyCondition.notify_all();
+    controller_logger.info("Worker " + ip + " reported ready");
+}
 
-    auto claim = this->interface->createJasmineGraphPersistentVolumeClaim(workerId);
-    if (claim != nullptr && claim->metadata != nullptr && claim->metadata->name != nullptr) {
-        controller_logger.info("Worker " + std::to_string(workerId) + " persistent volume claim created successfully");
-    } else {
-        controller_logger.error("Worker " + std::to_string(workerId) + " persistent volume claim creation failed");
-        throw std::runtime_error("Worker " + std::to_string(workerId) + " persistent volume claim creation failed");
+// Fallback for workers that cannot reach the master to report ready
+static bool isWorkerResponding(const std::string &ip) {
+    struct hostent *server = gethostbyname(ip.c_str());
+    if (server == NULL) {
+        controller_logger.error("ERROR, no host named " + ip);
+        return false;
     }
-
-    v1_service_t *service = this->interface->createJasmineGraphWorkerService(workerId);
-    if (service != nullptr && service->metadata != nullptr && service->metadata->name != nullptr) {
-        controller_logger.info("Worker " + std::to_string(workerId) + " service created successfully");
-    } else {
-        controller_logger.error("Worker " + std::to_string(workerId) + " service creation failed");
-        throw std::runtime_error("Worker " + std::to_string(workerId) + " service creation failed");
+    int sockfd = socket(AF_INET, SOCK_STREAM, 0);
+    if (sockfd < 0) {
+        controller_logger.error("Cannot create socket");
+        return false;
     }
-
-    std::string ip(service->spec->cluster_ip);
-
-    v1_deployment_t *deployment = this->interface->createJasmineGraphWorkerDeployment(workerId, ip, this->masterIp);
-    if (deployment != nullptr && deployment->metadata != nullptr && deployment->metadata->name != nullptr) {
-        controller_logger.info("Worker " + std::to_string(workerId) + " deployment created successfully");
-    } else {
-        controller_logger.error("Worker " + std::to_string(workerId) + " deployment creation failed");
-        throw std::runtime_error("Worker " + std::to_string(workerId) + " deployment creation failed");
+    struct sockaddr_in serv_addr;
+    bzero((char *)&serv_addr, sizeof(serv_addr));
+    serv_addr.sin_family = AF_INET;
+    bcopy((char *)server->h_addr, (char *)&serv_addr.sin_addr.s_addr, server->h_length);
+    serv_addr.sin_port = htons(Conts::JASMINEGRAPH_INSTANCE_PORT);
+    if (Utils::connect_wrapper(sockfd, (struct sockaddr *)&serv_addr, sizeof(serv_addr)) < 0) {
+        close(sockfd);
+        return false;
     }
-    k8sSpawnMutex.unlock();
-    controller_logger.info("Waiting for worker " + to_string(workerId) + " to respond");
-    int waiting = 0;
-    while (true) {
-        int sockfd;
-        struct sockaddr_in serv_addr;
-        struct hostent *server;
+    Utils::send_str_wrapper(sockfd, JasmineGraphInstanceProtocol::CLOSE);
+    close(sockfd);
+    return true;
+}
 
-        sockfd = socket(AF_INET, SOCK_STREAM, 0);
-        if (sockfd < 0) {
-            controller_logger.error("Cannot create socket");
+static bool waitUntilReady(const std::string &ip) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(TIME_OUT);
+    std::unique_lock<std::mutex> lock(readyMutex);
+    while (true) {
+        if (readyCondition.wait_for(lock, std::chrono::seconds(READY_PROBE_INTERVAL),
+                                    [&ip] { return readyWorkers.count(ip) > 0; })) {
+            readyWorkers.erase(ip);
+            return true;
+        }
+        lock.unlock();
+        bool responding = isWorkerResponding(ip);
+        lock.lock();
+        if (responding) {
+            readyWorkers.erase(ip);
+            return true;
         }
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+    }
+}
 
-        server = gethostbyname(ip.c_str());
-        if (server == NULL) {
-            controller_logger.error("ERROR, no host named " + ip);
+bool K8sWorkerController::startWorker(int workerId, StartedWorker &started) {
+    std::string ip;
+    {
+        std::lock_guard<std::mutex> lock(k8sSpawnMutex);
+        controller_logger.info("Spawning worker " + to_string(workerId));
+        auto volume = this->interface->createJasmineGraphPersistentVolume(workerId);
+        if (volume != nullptr && volume->metadata != nullptr && volume->metadata->name != nullptr) {
+            controller_logger.info("Worker " + std::to_string(workerId) + " persistent volume created successfully");
+        } else {
+            controller_logger.error("Worker " + std::to_string(workerId) + " persistent volume creation failed");
+            return false;
         }
 
-        bzero((char *)&serv_addr, sizeof(serv_addr));
-        serv_addr.sin_family = AF_INET;
-        bcopy((char *)server->h_addr, (char *)&serv_addr.sin_addr.s_addr, server->h_length);
-        serv_addr.sin_port = htons(Conts::JASMINEGRAPH_INSTANCE_PORT);
+        auto claim = this->interface->createJasmineGraphPersistentVolumeClaim(workerId);
+        if (claim != nullptr && claim->metadata != nullptr && claim->metadata->name != nullptr) {
+            controller_logger.info("Worker " + std::to_string(workerId) +
+                                   " persistent volume claim created successfully");
+        } else {
+            controller_logger.error("Worker " + std::to_string(workerId) +
+                                    " persistent volume claim creation failed");
+            return false;
+        }
 
-        if (Utils::connect_wrapper(sockfd, (struct sockaddr *)&serv_addr, sizeof(serv_addr)) < 0) {
-            waiting += 30;  // Added overhead in connection retry attempts
-            sleep(10);
+        v1_service_t *service = this->interface->createJasmineGraphWorkerService(workerId);
+        if (service != nullptr && service->metadata != nullptr && service->metadata->name != nullptr) {
+            controller_logger.info("Worker " + std::to_string(workerId) + " service created successfully");
         } else {
-            Utils::send_str_wrapper(sockfd, JasmineGraphInstanceProtocol::CLOSE);
-            close(sockfd);
-            break;
+            controller_logger.error("Worker " + std::to_string(workerId) + " service creation failed");
+            return false;
         }
 
-        if (waiting >= TIME_OUT) {
-            controller_logger.error("Error in spawning new worker");
-            deleteWorker(workerId);
-            close(sockfd);
-            return "";
+        ip = std::string(service->spec->cluster_ip);
+        started.ip = ip;
+        started.serviceName = std::string(service->metadata->name);
+
+        v1_deployment_t *deployment =
+            this->interface->createJasmineGraphWorkerDeployment(workerId, ip, this->masterIp);
+        if (deployment != nullptr && deployment->metadata != nullptr && deployment->metadata->name != nullptr) {
+            controller_logger.info("Worker " + std::to_string(workerId) + " deployment created successfully");
+        } else {
+            controller_logger.error("Worker " + std::to_string(workerId) + " deployment creation failed");
+            return false;
         }
     }
+
+    controller_logger.info("Waiting for worker " + to_string(workerId) + " to respond");
+    if (!waitUntilReady(ip)) {
+        controller_logger.error("Error in spawning new worker");
+        deleteWorkerResources(workerId);
+        return false;
+    }
     controller_logger.info("Worker " + to_string(workerId) + " responded");
+    return true;
+}
 
-    JasmineGraphServer::worker worker = {
-        .hostname = ip, .port = Conts::JASMINEGRAPH_INSTANCE_PORT, .dataPort = Conts::JASMINEGRAPH_INSTANCE_DATA_PORT};
-    K8sWorkerController::workerList.push_back(worker);
-    std::string insertQuery =
-        "INSERT INTO worker (host_idhost, server_port, server_data_port, name, ip, idworker) "
-        "VALUES ( -1, " +
-        std::to_string(Conts::JASMINEGRAPH_INSTANCE_PORT) + ", " +
-        std::to_string(Conts::JASMINEGRAPH_INSTANCE_DATA_PORT) + ", " + "'" + std::string(service->metadata->name) +
-        "', " + "'" + ip + "', " + std::to_string(workerId) + ")";
-    int status = metadb.runInsert(insertQuery);
+std::string K8sWorkerController::registerWorker(int workerId, const StartedWorker &started) {
+    JasmineGraphServer::worker worker = {.hostname = started.ip,
+                                         .port = Conts::JASMINEGRAPH_INSTANCE_PORT,
+                                         .dataPort = Conts::JASMINEGRAPH_INSTANCE_DATA_PORT};
+    {
+        std::lock_guard<std::mutex> lock(workerListMutex);
+        K8sWorkerController::workerList.push_back(worker);
+        activeWorkerIds.push_back(workerId);
+    }
+    int status = metadb.runInsert(
+        "INSERT INTO worker (host_idhost, server_port, server_data_port, name, ip, idworker, status) "
+        "VALUES (-1, ?, ?, ?, ?, ?, 'started')",
+        {std::to_string(Conts::JASMINEGRAPH_INSTANCE_PORT), std::to_string(Conts::JASMINEGRAPH_INSTANCE_DATA_PORT),
+         started.serviceName, started.ip, std::to_string(workerId)});
     if (status == -1) {
         controller_logger.error("Worker " + std::to_string(workerId) + " database insertion failed");
+    } else {
+        ClusterTopology::addWorker({workerId, started.serviceName, started.ip, "", Conts::JASMINEGRAPH_INSTANCE_PORT,
+                                    Conts::JASMINEGRAPH_INSTANCE_DATA_PORT});
     }
-    activeWorkerIds.push_back(workerId);
-    return ip + ":" + to_string(Conts::JASMINEGRAPH_INSTANCE_PORT);
+    return started.ip + ":" + to_string(Conts::JASMINEGRAPH_INSTANCE_PORT);
+}
+
+std::string K8sWorkerController::spawnWorker(int workerId) {
+    StartedWorker started;
+    if (!startWorker(workerId, started)) {
+        return "";
+    }
+    return registerWorker(workerId, started);
 }
 
 void K8sWorkerController::deleteWorker(int workerId) {
-    std::string selectQuery = "SELECT ip, server_port FROM worker WHERE idworker = " + std::to_string(workerId);
-    auto result = metadb.runSelect(selectQuery);
+    auto result = metadb.runSelect("SELECT ip, server_port FROM worker WHERE idworker = ?", {std::to_string(workerId)});
     if (result.size() == 0) {
         controller_logger.error("Worker " + std::to_string(workerId) + " not found in the database");
         return;
@@ -192,6 +264,27 @@ void K8sWorkerController::deleteWorker(int workerId) {
         controller_logger.error("Worker " + std::to_string(workerId) + " graceful shutdown failed");
     }
 
+    deleteWorkerResources(workerId);
+
+    metadb.runUpdate("DELETE FROM worker WHERE idworker = ?", {std::to_string(workerId)});
+    metadb.runUpdate("DELETE FROM worker_has_partition WHERE worker_idworker = ?", {std::to_string(workerId)});
+    ClusterTopology::removeWorker(workerId);
+    {
+        std::lock_guard<std::mutex> lock(workerListMutex);
+        activeWorkerIds.erase(std::remove(activeWorkerIds.begin(), activeWorkerIds.end(), workerId),
+                              activeWorkerIds.end());
+        for (auto it = workerList.begin(); it != workerList.end(); it++) {
+            if (it->hostname == ip) {
+                workerList.erase(it);
+                break;
+            }
+        }
+    }
+    this->numberOfWorkers--;
+}
+
+void K8sWorkerController::deleteWorkerResources(int workerId) {
+    std::lock_guard<std::mutex> lock(k8sSpawnMutex);
     v1_status_t *status = this->interface->deleteJasmineGraphWorkerDeployment(workerId);
     if (status != nullptr && status->code == 0) {
         controller_logger.info("Worker " + std::to_string(workerId) + " deployment deleted successfully");
@@ -219,12 +312,6 @@ void K8sWorkerController::deleteWorker(int workerId) {
     } else {
         controller_logger.error("Worker " + std::to_string(workerId) + " persistent volume claim deletion failed");
     }
-
-    std::string deleteQuery = "DELETE FROM worker WHERE idworker = " + std::to_string(workerId);
-    metadb.runUpdate(deleteQuery);
-    deleteQuery = "DELETE FROM worker_has_partition WHERE worker_idworker = " + std::to_string(workerId);
-    metadb.runUpdate(deleteQuery);
-    std::remove(activeWorkerIds.begin(), activeWorkerIds.end(), workerId);
 }
 
 int K8sWorkerController::attachExistingWorkers() {
@@ -256,23 +343,8 @@ int K8sWorkerController::attachExistingWorkers() {
                         service = static_cast<v1_service_t *>(service_list->items->firstEntry->data);
                     }
 
-                    std::string ip(service->spec->cluster_ip);
-                    JasmineGraphServer::worker worker = {.hostname = ip,
-                                                         .port = Conts::JASMINEGRAPH_INSTANCE_PORT,
-                                                         .dataPort = Conts::JASMINEGRAPH_INSTANCE_DATA_PORT};
-                    K8sWorkerController::workerList.push_back(worker);
-                    std::string insertQuery =
-                        "INSERT INTO worker (host_idhost, server_port, server_data_port, name, ip, idworker) "
-                        "VALUES ( -1, " +
-                        std::to_string(Conts::JASMINEGRAPH_INSTANCE_PORT) + ", " +
-                        std::to_string(Conts::JASMINEGRAPH_INSTANCE_DATA_PORT) + ", " + "'" +
-                        std::string(service->metadata->name) + "', " + "'" + ip + "', " + std::to_string(workerId) +
-                        ")";
-                    int status = metadb.runInsert(insertQuery);
-                    if (status == -1) {
-                        controller_logger.error("Worker " + std::to_string(workerId) + " database insertion failed");
-                    }
-                    activeWorkerIds.push_back(workerId);
+                    registerWorker(workerId, {std::string(service->spec->cluster_ip),
+                                              std::string(service->metadata->name)});
                     break;
                 }
             }
@@ -287,6 +359,11 @@ std::string K8sWorkerController::getMasterIp() const { return this->masterIp; }
 
 int K8sWorkerController::getNumberOfWorkers() const { return numberOfWorkers; }
 
+int K8sWorkerController::getWarmWorkerCount() {
+    std::lock_guard<std::mutex> lock(warmPoolMutex);
+    return warmPool.size();
+}
+
 /*
  * @deprecated
  */
@@ -295,36 +372,124 @@ void K8sWorkerController::setNumberOfWorkers(int newNumberOfWorkers) {
         for (int i = this->numberOfWorkers; i < newNumberOfWorkers; i++) {
             this->spawnWorker(i);
         }
+        this->numberOfWorkers = newNumberOfWorkers;
     } else if (newNumberOfWorkers < this->numberOfWorkers) {
-        for (int i = newNumberOfWorkers; i < this->numberOfWorkers; i++) {
-            this->deleteWorker(i);
+        std::vector<int> workerIds;
+        {
+            std::lock_guard<std::mutex> lock(workerListMutex);
+            workerIds = activeWorkerIds;
         }
+        // deleteWorker() updates the worker count
+        for (int i = newNumberOfWorkers; i < (int)workerIds.size(); i++) {
+            this->deleteWorker(workerIds[i]);
+        }
+    }
+    if (newNumberOfWorkers == 0) {
+        releaseWarmPool();
     }
-    this->numberOfWorkers = newNumberOfWorkers;
 }
 
-std::map<string, string> K8sWorkerController::scaleUp(int count) {
-    if (this->numberOfWorkers + count > this->maxWorkers) {
-        count = this->maxWorkers - this->numberOfWorkers;
+void K8sWorkerController::releaseWarmPool() {
+    std::vector<std::future<void>> starts;
+    {
+        std::lock_guard<std::mutex> lock(warmPoolMutex);
+        warmPoolSize = 0;
+        starts.swap(warmPoolStarts);
     }
-    std::map<string, string> workers;
-    if (count <= 0) return workers;
-    controller_logger.info("Scale up with " + to_string(count) + " new workers");
-    std::future<string> asyncCalls[count];
-    int nextWorkerId = getNextWorkerId(count);
+    for (auto &start : starts) {
+        start.wait();
+    }
+    std::map<int, StartedWorker> warmWorkers;
+    {
+        std::lock_guard<std::mutex> lock(warmPoolMutex);
+        warmWorkers.swap(warmPool);
+    }
+    for (auto it = warmWorkers.begin(); it != warmWorkers.end(); it++) {
+        deleteWorkerResources(it->first);
+    }
+}
+
+void K8sWorkerController::refillWarmPool() {
+    std::lock_guard<std::mutex> lock(warmPoolMutex);
+    warmPoolStarts.erase(std::remove_if(warmPoolStarts.begin(), warmPoolStarts.end(),
+                                        [](std::future<void> &start) {
+                                            return start.wait_for(std::chrono::seconds(0)) ==
+                                                   std::future_status::ready;
+                                        }),
+                         warmPoolStarts.end());
+    int pending = warmPool.size() + warmPoolStarting;
+    int count = std::min((int)warmPoolSize - pending, maxWorkers - numberOfWorkers - pending);
+    if (count <= 0) return;
+    controller_logger.info("Starting " + to_string(count) + " workers for the warm pool");
+    int firstWorkerId = getNextWorkerId(count);
     for (int i = 0; i < count; i++) {
-        asyncCalls[i] = std::async(&K8sWorkerController::spawnWorker, this, nextWorkerId + i);
+        int workerId = firstWorkerId + i;
+        warmPoolStarting++;
+        warmPoolStarts.push_back(std::async(std::launch::async, [this, workerId]() {
+            StartedWorker started;
+            bool success = startWorker(workerId, started);
+            std::lock_guard<std::mutex> lock(warmPoolMutex);
+            warmPoolStarting--;
+            if (success) {
+                warmPool[workerId] = started;
+            }
+        }));
+    }
+}
+
+std::map<string, string> K8sWorkerController::scaleUp(int count, ReadyCallback onReady) {
+    std::map<string, string> workers;
+    std::map<int, StartedWorker> warmWorkers;
+    {
+        std::lock_guard<std::mutex> lock(warmPoolMutex);
+        // Warm workers that are still starting already hold a place under the limit. Idle warm workers do not need
+        // one of their own, as they are taken before new workers are spawned.
+        int available = this->maxWorkers - this->numberOfWorkers - warmPoolStarting;
+        if (count > available) {
+            count = available;
+        }
+        if (count <= 0) return workers;
+        controller_logger.info("Scale up with " + to_string(count) + " new workers");
+        while (!warmPool.empty() && (int)warmWorkers.size() < count) {
+            warmWorkers.insert(*warmPool.begin());
+            warmPool.erase(warmPool.begin());
+        }
+    }
+    if (!warmWorkers.empty()) {
+        controller_logger.info("Taking " + to_string(warmWorkers.size()) + " workers from the warm pool");
+    }
+
+    std::vector<std::future<std::pair<string, string>>> asyncCalls;
+    for (auto it = warmWorkers.begin(); it != warmWorkers.end(); it++) {
+        int workerId = it->first;
+        StartedWorker started = it->second;
+        asyncCalls.push_back(std::async(std::launch::async, [this, workerId, started, onReady]() {
+            std::string address = registerWorker(workerId, started);
+            if (onReady) onReady(to_string(workerId), address);
+            return std::make_pair(to_string(workerId), address);
+        }));
+    }
+    int spawnCount = count - warmWorkers.size();
+    int firstWorkerId = spawnCount > 0 ? getNextWorkerId(spawnCount) : 0;
+    for (int i = 0; i < spawnCount; i++) {
+        int workerId = firstWorkerId + i;
+        asyncCalls.push_back(std::async(std::launch::async, [this, workerId, onReady]() {
+            std::string address = spawnWorker(workerId);
+            if (!address.empty() && onReady) onReady(to_string(workerId), address);
+            return std::make_pair(to_string(workerId), address);
+        }));
     }
 
     int success = 0;
-    for (int i = 0; i < count; i++) {
-        std::string result = asyncCalls[i].get();
-        if (!result.empty()) {
+    for (auto &call : asyncCalls) {
+        std::pair<string, string> result = call.get();
+        if (!result.second.empty()) {
             success++;
-            workers.insert(std::make_pair(to_string(nextWorkerId + i), result));
+            workers.insert(result);
         }
     }
     this->numberOfWorkers += success;
+    refillWarmPool();
     return workers;
 }
 
@@ -340,4 +505,5 @@ void K8sWorkerController::scaleDown(const set<int> workerIds) {
     for (int i = 0; i < count; i++) {
         threads[i].join();
     }
+    refillWarmPool();
 }
@@ -16,6 +16,11 @@ class K8sWorkerController;
 #ifndef JASMINEGRAPH_K8SWORKERCONTROLLER_H
 #define JASMINEGRAPH_K8SWORKERCONTROLLER_H
 
+#include <atomic>
+#include <functional>
+#include <future>
+#include <map>
+#include <mutex>
 #include <set>
 #include <vector>
 
@@ -28,7 +33,16 @@ extern "C" {
 #include "./K8sInterface.h"
 
 class K8sWorkerController {
+ public:
+    // Called with the id and the "ip:port" of each new worker as soon as it is ready
+    typedef std::function<void(const std::string &workerId, const std::string &address)> ReadyCallback;
+
  private:
+    struct StartedWorker {
+        std::string ip;
+        std::string serviceName;
+    };
+
     K8sInterface *interface;
     SQLiteDBInterface metadb;
 
@@ -36,29 +50,61 @@ class K8sWorkerController {
     std::atomic<int> numberOfWorkers;
     int maxWorkers;
 
-    K8sWorkerController(std::string masterIp, int numberOfWorkers, SQLiteDBInterface *metadb);
+    // Workers started ahead of demand and not yet in the metadb, so that scaling up does not wait for pods to start
+    size_t warmPoolSize = 0;
+    std::map<int, StartedWorker> warmPool;
+    int warmPoolStarting = 0;
+    std::vector<std::future<void>> warmPoolStarts;
+    std::mutex warmPoolMutex;
+
+    K8sWorkerController(std::string masterIp, int numberOfWorkers, SQLiteDBInterface *metadb,
+                        K8sInterface *interface);
+
+    // Creates the resources of the worker and waits until it reports ready. Returns false if it did not start.
+    bool startWorker(int workerId, StartedWorker &started);
+
+    // Adds a started worker to the metadb and the cluster topology and returns its "ip:port"
+    std::string registerWorker(int workerId, const StartedWorker &started);
 
     std::string spawnWorker(int workerId);
 
     void deleteWorker(int workerId);
 
+    void deleteWorkerResources(int workerId);
+
     int attachExistingWorkers();
 
+    // Starts workers in the background until the warm pool is full or the worker limit is reached
+    void refillWarmPool();
+
+    // Deletes the idle workers and stops refilling the pool
+    void releaseWarmPool();
+
  public:
     static std::vector<JasmineGraphServer::worker> workerList;
 
     ~K8sWorkerController();
 
-    static K8sWorkerController *getInstance(std::string masterIp, int numberOfWorkers, SQLiteDBInterface *metadb);
+    // `interface` is owned by the controller. A new K8sInterface is created when it is null.
+    static K8sWorkerController *getInstance(std::string masterIp, int numberOfWorkers, SQLiteDBInterface *metadb,
+                                            K8sInterface *interface = nullptr);
     static K8sWorkerController *getInstance();
 
+    // Called when a worker reports to the master that its services are up
+    static void workerReady(const std::string &ip);
+
     std::string getMasterIp() const;
 
     int getNumberOfWorkers() const;
 
+    // Number of started workers waiting in the warm pool
+    int getWarmWorkerCount();
+
     void setNumberOfWorkers(int newNumberOfWorkers);
 
-    std::map<string, string> scaleUp(int numberOfWorkers);
+    // Takes workers from the warm pool first and starts the rest in parallel. `onReady` is called for every new worker
+    // as it becomes ready, while the others are still starting, so callers can begin staging data on it.
+    std::map<string, string> scaleUp(int numberOfWorkers, ReadyCallback onReady = nullptr);
     void scaleDown(const set<int> workerIds);
 };
 
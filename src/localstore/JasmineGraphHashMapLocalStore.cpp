@@ -159,7 +159,9 @@ void JasmineGraphHashMapLocalStore::addEdge(long startVid, long endVid) {
     }
 }
 
-map<long, unordered_set<long>> JasmineGraphHashMapLocalStore::getUnderlyingHashMap() { return localSubGraphMap; }
+const map<long, unordered_set<long>> &JasmineGraphHashMapLocalStore::getUnderlyingHashMap() const {
+    return localSubGraphMap;
+}
 
 void JasmineGraphHashMapLocalStore::initialize() {}
 
@@ -106,7 +106,7 @@ class JasmineGraphHashMapLocalStore : public JasmineGraphLocalStore {
 
     map<long, long> getInDegreeDistributionHashMap();
 
-    map<long, unordered_set<long>> getUnderlyingHashMap();
+    const map<long, unordered_set<long>> &getUnderlyingHashMap() const;
 
     void initialize();
 
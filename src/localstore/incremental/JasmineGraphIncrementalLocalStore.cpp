@@ -17,6 +17,8 @@ limitations under the License.
 #include <stdexcept>
 
 #include "../../nativestore/RelationBlock.h"
+#include "../../performance/metrics/MetricsRegistry.h"
+#include "../../query/algorithms/triangles/StreamingTriangleCounter.h"
 #include "../../util/logger/Logger.h"
 #include "../../util/Utils.h"
 
@@ -28,9 +30,74 @@ JasmineGraphIncrementalLocalStore::JasmineGraphIncrementalLocalStore(unsigned in
     gc.partitionID = partitionID;
     gc.maxLabelSize = std::stoi(Utils::getJasmineGraphProperty("org.jasminegraph.nativestore.max.label.size"));
     gc.openMode = openMode;
+    gc.numericIds = Utils::getJasmineGraphProperty("org.jasminegraph.nativestore.numeric.ids") == "true";
     this->nm = new NodeManager(gc);
 };
 
+JasmineGraphIncrementalLocalStore::~JasmineGraphIncrementalLocalStore() {
+    // The counters read the adjacency snapshots of the node manager
+    this->triangleCounters.clear();
+    delete this->nm;
+}
+
+std::shared_ptr<StreamingTriangleCounter> JasmineGraphIncrementalLocalStore::getTriangleCounter(
+    const std::string &window) {
+    return this->getTriangleCounter("local|" + window, window,
+                                    {this->nm->getAdjacencySnapshot(true), this->nm->getAdjacencySnapshot(false)},
+                                    false);
+}
+
+std::shared_ptr<StreamingTriangleCounter> JasmineGraphIncrementalLocalStore::getCentralTriangleCounter(
+    const std::string &partitionIds, const std::vector<JasmineGraphIncrementalLocalStore *> &stores,
+    const std::string &window) {
+    std::vector<AdjacencySnapshot *> snapshots;
+    for (JasmineGraphIncrementalLocalStore *store : stores) {
+        snapshots.push_back(store->nm->getAdjacencySnapshot(false));
+    }
+    // A windowed count lists the central triangles in the window, so the counter keeps them
+    return this->getTriangleCounter("central|" + window + "|" + partitionIds, window, snapshots, !window.empty());
+}
+
+/**
+ * Windows come with each query, so windowed counters are evicted, least recently used first, once there are
+ * MAX_WINDOW_COUNTERS of them. Counters in use by a count are freed when it ends.
+ * */
+std::shared_ptr<StreamingTriangleCounter> JasmineGraphIncrementalLocalStore::getTriangleCounter(
+    const std::string &key, const std::string &window, const std::vector<AdjacencySnapshot *> &snapshots,
+    bool keepTriangles) {
+    std::lock_guard<std::mutex> guard(this->triangleCountersLock);
+    auto it = this->triangleCounters.find(key);
+    if (it != this->triangleCounters.end()) {
+        it->second.lastUse = ++this->triangleCounterUses;
+        return it->second.counter;
+    }
+    TriangleWindow parsed = TriangleWindow();
+    if (!window.empty() && !StreamingTriangleCounter::parseWindow(window, parsed)) {
+        incremental_localstore_logger.error("Invalid streaming triangle window " + window);
+        return NULL;
+    }
+    if (!window.empty()) {
+        size_t windowCounters = 0;
+        auto leastRecent = this->triangleCounters.end();
+        for (auto entry = this->triangleCounters.begin(); entry != this->triangleCounters.end(); entry++) {
+            if (entry->second.windowed) {
+                windowCounters++;
+                if (leastRecent == this->triangleCounters.end() ||
+                    entry->second.lastUse < leastRecent->second.lastUse) {
+                    leastRecent = entry;
+                }
+            }
+        }
+        if (windowCounters >= JasmineGraphIncrementalLocalStore::MAX_WINDOW_COUNTERS) {
+            this->triangleCounters.erase(leastRecent);
+        }
+    }
+    std::shared_ptr<StreamingTriangleCounter> counter =
+        std::make_shared<StreamingTriangleCounter>(snapshots, parsed, keepTriangles);
+    this->triangleCounters[key] = TriangleCounterEntry{counter, !window.empty(), ++this->triangleCounterUses};
+    return counter;
+}
+
 std::pair<std::string, unsigned int> JasmineGraphIncrementalLocalStore::getIDs(std::string edgeString) {
     try {
         auto edgeJson = json::parse(edgeString);
@@ -46,56 +113,87 @@ std::pair<std::string, unsigned int> JasmineGraphIncrementalLocalStore::getIDs(s
     }
 }
 
+// IDs of a partition with numeric IDs can be JSON numbers or strings of digits
+static unsigned long getNumericID(const json &idJson) {
+    if (idJson.is_number_unsigned()) {
+        return idJson.get<unsigned long>();
+    }
+    return std::stoul(idJson.get<std::string>());
+}
+
+std::map<std::string, std::string> JasmineGraphIncrementalLocalStore::getProperties(const json& propertiesJson) {
+    std::map<std::string, std::string> properties;
+    for (auto it = propertiesJson.begin(); it != propertiesJson.end(); it++) {
+        properties[it.key()] = it.value().get<std::string>();
+    }
+    return properties;
+}
+
 void JasmineGraphIncrementalLocalStore::addEdgeFromString(std::string edgeString) {
+    static Counter &localEdges = MetricsRegistry::counter("jasminegraph_stream_edges_ingested_total",
+                                                          "Streamed edges added to the native store",
+                                                          {{"type", "local"}});
+    static Counter &centralEdges = MetricsRegistry::counter("jasminegraph_stream_edges_ingested_total",
+                                                            "Streamed edges added to the native store",
+                                                            {{"type", "central"}});
+    static Counter &failedEdges = MetricsRegistry::counter("jasminegraph_stream_edges_failed_total",
+                                                           "Streamed edges that could not be added");
+    // The edge and its properties reach the DBs in the same group commit
+    WriteAheadLog::Operation operation(this->nm->getWriteAheadLog());
     try {
         auto edgeJson = json::parse(edgeString);
 
         auto sourceJson = edgeJson["source"];
         auto destinationJson = edgeJson["destination"];
 
-        std::string sId = std::string(sourceJson["id"]);
-        std::string dId = std::string(destinationJson["id"]);
-
         RelationBlock* newRelation;
-        if (edgeJson["EdgeType"] == "Central") {
-            newRelation = this->nm->addCentralEdge({sId, dId});
+        if (this->nm->hasNumericIds()) {
+            std::pair<unsigned long, unsigned long> edge(getNumericID(sourceJson["id"]),
+                                                         getNumericID(destinationJson["id"]));
+            if (edgeJson["EdgeType"] == "Central") {
+                newRelation = this->nm->addCentralEdge(edge);
+            } else {
+                newRelation = this->nm->addLocalEdge(edge);
+            }
         } else {
-            newRelation = this->nm->addLocalEdge({sId, dId});
+            std::string sId = std::string(sourceJson["id"]);
+            std::string dId = std::string(destinationJson["id"]);
+            if (edgeJson["EdgeType"] == "Central") {
+                newRelation = this->nm->addCentralEdge({sId, dId});
+            } else {
+                newRelation = this->nm->addLocalEdge({sId, dId});
+            }
         }
         if (!newRelation) {
+            failedEdges.inc();
             return;
         }
-        char value[PropertyLink::MAX_VALUE_SIZE] = {};
+        if (edgeJson["EdgeType"] == "Central") {
+            centralEdges.inc();
+        } else {
+            localEdges.inc();
+        }
 
+        // All properties of an entity go to its property record in a single write
         if (edgeJson.contains("properties")) {
-            auto edgeProperties = edgeJson["properties"];
-            for (auto it = edgeProperties.begin(); it != edgeProperties.end(); it++) {
-                strcpy(value, it.value().get<std::string>().c_str());
-                if (edgeJson["EdgeType"] == "Central") {
-                    newRelation->addCentralProperty(std::string(it.key()), &value[0]);
-                } else {
-                    newRelation->addLocalProperty(std::string(it.key()), &value[0]);
-                }
+            const auto &edgeProperties = getProperties(edgeJson["properties"]);
+            if (edgeJson["EdgeType"] == "Central") {
+                newRelation->addCentralProperties(edgeProperties);
+            } else {
+                newRelation->addLocalProperties(edgeProperties);
             }
         }
-
         if (sourceJson.contains("properties")) {
-            auto sourceProps = sourceJson["properties"];
-            for (auto it = sourceProps.begin(); it != sourceProps.end(); it++) {
-                strcpy(value, it.value().get<std::string>().c_str());
-                newRelation->getSource()->addProperty(std::string(it.key()), &value[0]);
-            }
+            this->nm->addNodeProperties(newRelation->getSource(), getProperties(sourceJson["properties"]));
         }
         if (destinationJson.contains("properties")) {
-            auto destProps = destinationJson["properties"];
-            for (auto it = destProps.begin(); it != destProps.end(); it++) {
-                strcpy(value, it.value().get<std::string>().c_str());
-                newRelation->getDestination()->addProperty(std::string(it.key()), &value[0]);
-            }
+            this->nm->addNodeProperties(newRelation->getDestination(), getProperties(destinationJson["properties"]));
         }
 
-        incremental_localstore_logger.debug("Edge (" + sId + ", " + dId + ") Added successfully!");
+        incremental_localstore_logger.debug("Edge (" + newRelation->getSource()->id + ", " +
+                                            newRelation->getDestination()->id + ") Added successfully!");
     } catch (const std::exception&) {  // TODO tmkasun: Handle multiple types of exceptions
+        failedEdges.inc();
         incremental_localstore_logger.log(
             "Error while processing edge data = " + edgeString +
                 "Could be due to JSON parsing error or error while persisting the data to disk",
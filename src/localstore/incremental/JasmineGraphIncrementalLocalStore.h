@@ -11,22 +11,55 @@ See the License for the specific language governing permissions and
 limitations under the License.
  */
 
+#include <map>
+#include <memory>
+#include <mutex>
 #include <nlohmann/json.hpp>
 #include <string>
+#include <vector>
 using json = nlohmann::json;
 
 #include "../../nativestore/NodeManager.h"
 #ifndef Incremental_LocalStore
 #define Incremental_LocalStore
 
+class StreamingTriangleCounter;
+
 class JasmineGraphIncrementalLocalStore {
  public:
     GraphConfig gc;
     NodeManager *nm;
+    // Triangles of the local and central edges of the partition, kept across streaming triangle counts. Each window,
+    // as StreamingTriangleCounter::parseWindow() reads it, has a counter of its own. Only the counters of the last
+    // MAX_WINDOW_COUNTERS windows used are kept. Null if the window is not valid.
+    std::shared_ptr<StreamingTriangleCounter> getTriangleCounter(const std::string &window = "");
+    // Triangles of the central edges of the given stores, which this partition aggregates. partitionIds names them.
+    std::shared_ptr<StreamingTriangleCounter> getCentralTriangleCounter(
+        const std::string &partitionIds, const std::vector<JasmineGraphIncrementalLocalStore *> &stores,
+        const std::string &window = "");
     void addEdgeFromString(std::string edgeString);
     static std::pair<std::string, unsigned int> getIDs(std::string edgeString);
+    static std::map<std::string, std::string> getProperties(const json &propertiesJson);
     JasmineGraphIncrementalLocalStore(unsigned int graphID = 0,
                                       unsigned int partitionID = 0, std::string openMode = "trunk");
+    ~JasmineGraphIncrementalLocalStore();
+
+    static const size_t MAX_WINDOW_COUNTERS = 16;
+
+ private:
+    struct TriangleCounterEntry {
+        std::shared_ptr<StreamingTriangleCounter> counter;
+        bool windowed;
+        unsigned long lastUse;
+    };
+
+    std::mutex triangleCountersLock;
+    std::map<std::string, TriangleCounterEntry> triangleCounters;  // By window, and partitions for central ones
+    unsigned long triangleCounterUses = 0;
+
+    std::shared_ptr<StreamingTriangleCounter> getTriangleCounter(const std::string &key, const std::string &window,
+                                                                 const std::vector<AdjacencySnapshot *> &snapshots,
+                                                                 bool keepTriangles);
 };
 
 #endif
@@ -36,8 +36,8 @@ int SQLiteDBInterface::init() {
         }
     }
 
-    if (sqlite3_open(this->databaseLocation.c_str(), &database)) {
-        db_logger.error("Cannot open database: " + string(sqlite3_errmsg(database)));
+    if (openPool()) {
+        db_logger.error("Cannot open database: " + this->databaseLocation);
         return -1;
     }
     db_logger.info("Database opened successfully :" + this->databaseLocation);
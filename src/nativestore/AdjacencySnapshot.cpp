@@ -0,0 +1,75 @@
+/**
+Copyright 2024 JasmineGraph Team
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+**/
+
+#include "AdjacencySnapshot.h"
+
+#include <algorithm>
+#include <chrono>
+
+AdjacencySnapshot::AdjacencySnapshot() { pthread_rwlock_init(&this->lock, NULL); }
+
+AdjacencySnapshot::~AdjacencySnapshot() { pthread_rwlock_destroy(&this->lock); }
+
+void AdjacencySnapshot::add(long source, long destination) {
+    this->add(source, destination,
+              std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch())
+                  .count());
+}
+
+void AdjacencySnapshot::add(long source, long destination, unsigned int ingestTime) {
+    pthread_rwlock_wrlock(&this->lock);
+    this->edges.push_back(std::make_pair(source, destination));
+    this->ingestTimes.push_back(ingestTime);
+    this->adjacency[source].insert(destination);
+    pthread_rwlock_unlock(&this->lock);
+}
+
+unsigned long AdjacencySnapshot::epoch() {
+    pthread_rwlock_rdlock(&this->lock);
+    unsigned long current = this->edges.size();
+    pthread_rwlock_unlock(&this->lock);
+    return current;
+}
+
+std::map<long, std::unordered_set<long>> AdjacencySnapshot::adjacencyList() {
+    pthread_rwlock_rdlock(&this->lock);
+    std::map<long, std::unordered_set<long>> copy = this->adjacency;
+    pthread_rwlock_unlock(&this->lock);
+    return copy;
+}
+
+std::vector<std::pair<long, long>> AdjacencySnapshot::edgesSince(unsigned long epoch, unsigned long *current) {
+    std::vector<std::pair<long, long>> added;
+    pthread_rwlock_rdlock(&this->lock);
+    *current = this->edges.size();
+    if (epoch < *current) {
+        added.assign(this->edges.begin() + epoch, this->edges.end());
+    }
+    pthread_rwlock_unlock(&this->lock);
+    return added;
+}
+
+std::vector<std::pair<long, long>> AdjacencySnapshot::edgesBetween(unsigned long from, unsigned long to,
+                                                                   std::vector<unsigned int> *ingestTimes) {
+    std::vector<std::pair<long, long>> added;
+    pthread_rwlock_rdlock(&this->lock);
+    to = std::min(to, (unsigned long)this->edges.size());
+    if (from < to) {
+        added.assign(this->edges.begin() + from, this->edges.begin() + to);
+        if (ingestTimes) {
+            ingestTimes->insert(ingestTimes->end(), this->ingestTimes.begin() + from, this->ingestTimes.begin() + to);
+        }
+    }
+    pthread_rwlock_unlock(&this->lock);
+    return added;
+}
@@ -0,0 +1,56 @@
+/**
+Copyright 2024 JasmineGraph Team
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+**/
+
+#include <pthread.h>
+
+#include <map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#ifndef JASMINEGRAPH_ADJACENCYSNAPSHOT_H
+#define JASMINEGRAPH_ADJACENCYSNAPSHOT_H
+
+/**
+ * In-memory adjacency of one relation DB of a streaming partition, kept up to date as relations are added.
+ *
+ * Each relation added to the snapshot gets the next epoch, counting from 1, so the epoch of the snapshot is the number
+ * of relations it holds. Analytics remember the epoch they last saw and ask for the edges added since then instead of
+ * reading the relation DB again. Each edge also keeps the time it was ingested, for analytics over a time window.
+ * **/
+class AdjacencySnapshot {
+ public:
+    AdjacencySnapshot();
+    ~AdjacencySnapshot();
+
+    // Adds an edge ingested now
+    void add(long source, long destination);
+    void add(long source, long destination, unsigned int ingestTime);
+    unsigned long epoch();
+    // Destinations of the relations of each source
+    std::map<long, std::unordered_set<long>> adjacencyList();
+    // Edges added after the given epoch, in the order they were added. Sets current to the epoch of the last of them.
+    std::vector<std::pair<long, long>> edgesSince(unsigned long epoch, unsigned long *current);
+    // Edges with epochs after from and up to to, or up to the current epoch if it is lower. Their ingest times, in
+    // seconds since the Unix epoch, are appended to ingestTimes if it is given.
+    std::vector<std::pair<long, long>> edgesBetween(unsigned long from, unsigned long to,
+                                                    std::vector<unsigned int> *ingestTimes = NULL);
+
+ private:
+    pthread_rwlock_t lock;
+    std::vector<std::pair<long, long>> edges;  // Edge of epoch i + 1
+    std::vector<unsigned int> ingestTimes;     // Ingest time of the edge of epoch i + 1
+    std::map<long, std::unordered_set<long>> adjacency;
+};
+
+#endif  // JASMINEGRAPH_ADJACENCYSNAPSHOT_H
@@ -16,14 +16,14 @@ limitations under the License.
 #include <sstream>
 #include <vector>
 
+#include "../performance/metrics/MetricsRegistry.h"
 #include "../util/logger/Logger.h"
 #include "RelationBlock.h"
 
 Logger node_block_logger;
 pthread_mutex_t lockSaveNode;
-pthread_mutex_t lockAddNodeProperty;
 
-NodeBlock::NodeBlock(std::string id, unsigned int nodeId, unsigned int address, unsigned int propRef,
+NodeBlock::NodeBlock(std::string id, unsigned long nodeId, unsigned int address, unsigned int propRef,
                      unsigned int edgeRef, unsigned int centralEdgeRef, unsigned char edgeRefPID, const char* _label,
                      bool usage)
     : id(id),
@@ -46,17 +46,18 @@ void NodeBlock::setLabel(const char *_label) {
 }
 
 void NodeBlock::save() {
+    static Counter &nodeWrites = MetricsRegistry::counter("jasminegraph_nativestore_block_writes_total",
+                                                          "Blocks written to the native store", {{"block", "node"}});
+    nodeWrites.inc();
     //    pthread_mutex_lock(&lockSaveNode);
-    char _label[PropertyLink::MAX_VALUE_SIZE] = {0};
-    std::strcpy(_label, id.c_str());
-
-    bool isSmallLabel = id.length() <= sizeof(label) * 2;
-        if (isSmallLabel) {
-            std::strcpy(this->label, this->id.c_str());
-        }
+    // The label holds the ID and its terminating null char
+    bool isSmallLabel = NodeBlock::numericIds || id.length() < sizeof(label);
+    if (isSmallLabel && !NodeBlock::numericIds) {
+        std::strcpy(this->label, this->id.c_str());
+    }
     NodeBlock::nodesDB->seekp(this->addr);
     NodeBlock::nodesDB->put(this->usage);                                                                       // 1
-    NodeBlock::nodesDB->write(reinterpret_cast<char*>(&(this->nodeId)), sizeof(this->nodeId));                  // 4
+    NodeBlock::nodesDB->write(reinterpret_cast<char*>(&(this->nodeId)), sizeof(this->nodeId));                  // 8
     NodeBlock::nodesDB->write(reinterpret_cast<char*>(&(this->edgeRef)), sizeof(this->edgeRef));                // 4
     NodeBlock::nodesDB->write(reinterpret_cast<char*>(&(this->centralEdgeRef)), sizeof(this->centralEdgeRef));  // 4
     NodeBlock::nodesDB->put(this->edgeRefPID);                                                                  // 1
@@ -65,33 +66,37 @@ void NodeBlock::save() {
     NodeBlock::nodesDB->flush();  // Sync the file with in-memory stream
     //    pthread_mutex_unlock(&lockSaveNode);
 
-        if (!isSmallLabel) {
-            this->addProperty("label", _label);
-        }
+    if (!isSmallLabel) {
+        this->addProperty("label", this->id);
+    }
 }
 
-void NodeBlock::addProperty(std::string name, const char* value) {
-    if (this->propRef == 0) {
-        PropertyLink* newLink = PropertyLink::create(name, value);
-        //        pthread_mutex_lock(&lockAddNodeProperty);
-        if (newLink) {
-            this->propRef = newLink->blockAddress;
-            // If it was an empty prop link before inserting, Then update the property reference of this node
-            // block
-            //            node_block_logger.info("propRef = " + std::to_string(this->propRef));
-            NodeBlock::nodesDB->seekp(this->addr + sizeof(this->nodeId) + sizeof(this->edgeRef) +
-                                      sizeof(this->centralEdgeRef) + sizeof(this->edgeRefPID));
-            NodeBlock::nodesDB->write(reinterpret_cast<char*>(&(this->propRef)), sizeof(this->propRef));
-            NodeBlock::nodesDB->flush();
-        } else {
-            node_block_logger.error("Error occurred while adding a new property link to " +
-                        std::to_string(this->addr) + " node block");
-        }
-    } else {
-        this->propRef = this->getPropertyHead()->insert(name, value);
+void NodeBlock::addProperty(std::string name, const std::string& value) { this->addProperties({{name, value}}); }
+
+/**
+ * Write the properties to the property record of the node in one go. The record moves when it grows, in which case
+ * the property reference of this node block is updated.
+ * */
+void NodeBlock::addProperties(const std::map<std::string, std::string>& properties) {
+    unsigned int newPropRef = PropertyStore::nodeProperties->putAll(this->propRef, properties);
+    if (newPropRef == 0) {
+        node_block_logger.error("Error occurred while adding properties to " + std::to_string(this->addr) +
+                                " node block");
+        return;
+    }
+    if (newPropRef != this->propRef) {
+        this->propRef = newPropRef;
+        NodeBlock::nodesDB->seekp(this->addr + sizeof(this->usage) + sizeof(this->nodeId) + sizeof(this->edgeRef) +
+                                  sizeof(this->centralEdgeRef) + sizeof(this->edgeRefPID));
+        NodeBlock::nodesDB->write(reinterpret_cast<char*>(&(this->propRef)), sizeof(this->propRef));
+        NodeBlock::nodesDB->flush();
     }
 }
 
+bool NodeBlock::getProperty(const std::string& name, std::string& value) {
+    return PropertyStore::nodeProperties->get(this->propRef, name, value);
+}
+
 bool NodeBlock::updateLocalRelation(RelationBlock* newRelation, bool relocateHead) {
     unsigned int edgeReferenceAddress = newRelation->addr;
     unsigned int thisAddress = this->addr;
@@ -361,23 +366,21 @@ std::list<NodeBlock*> NodeBlock::getAllEdgeNodes() {
     return allEdges;
 }
 
-std::map<std::string, char*> NodeBlock::getAllProperties() {
-    std::map<std::string, char*> allProperties;
-    PropertyLink* current = this->getPropertyHead();
-    while (current) {
-        allProperties.insert({current->name, current->value});
-        PropertyLink* temp = current->next();
-        delete current;  // To prevent memory leaks
-        current = temp;
+std::map<std::string, std::string> NodeBlock::getAllProperties() {
+    std::map<std::string, std::string> allProperties;
+    if (!PropertyStore::nodeProperties->readAll(this->propRef, allProperties)) {
+        node_block_logger.error("Error while reading the properties of node block " + std::to_string(this->addr));
     }
-    delete current;
     return allProperties;
 }
 
 NodeBlock* NodeBlock::get(unsigned int blockAddress) {
+    static Counter &nodeReads = MetricsRegistry::counter("jasminegraph_nativestore_block_reads_total",
+                                                         "Blocks read from the native store", {{"block", "node"}});
+    nodeReads.inc();
     NodeBlock* nodeBlockPointer = NULL;
     NodeBlock::nodesDB->seekg(blockAddress);
-    unsigned int nodeId;
+    unsigned long nodeId;
     unsigned int edgeRef;
     unsigned int centralEdgeRef;
     unsigned char edgeRefPID;
@@ -389,7 +392,7 @@ NodeBlock* NodeBlock::get(unsigned int blockAddress) {
     if (!NodeBlock::nodesDB->get(usageBlock)) {
         node_block_logger.error("Error while reading usage data from block " + std::to_string(blockAddress));
     }
-    if (!NodeBlock::nodesDB->read(reinterpret_cast<char*>(&nodeId), sizeof(unsigned int))) {
+    if (!NodeBlock::nodesDB->read(reinterpret_cast<char*>(&nodeId), sizeof(nodeId))) {
         node_block_logger.error("Error while reading nodeId  data from block " + std::to_string(blockAddress));
     }
     if (!NodeBlock::nodesDB->read(reinterpret_cast<char*>(&edgeRef), sizeof(unsigned int))) {
@@ -417,16 +420,15 @@ NodeBlock* NodeBlock::get(unsigned int blockAddress) {
     node_block_logger.debug("Label = " + std::string(label));
     node_block_logger.debug("Length of label = " + std::to_string(strlen(label)));
     node_block_logger.debug("edgeRef = " + std::to_string(edgeRef));
-    if (strlen(label) != 0) {
+    if (NodeBlock::numericIds) {
+        id = std::to_string(nodeId);
+    } else if (strlen(label) != 0) {
         id = std::string(label);
     }
     nodeBlockPointer =
         new NodeBlock(id, nodeId, blockAddress, propRef, edgeRef, centralEdgeRef, edgeRefPID, label, usage);
     if (nodeBlockPointer->id.length() == 0) {  // if label not found in node block look in the properties
-        std::map<std::string, char*> props = nodeBlockPointer->getAllProperties();
-        if (props["label"]) {
-            nodeBlockPointer->id = props["label"];
-        } else {
+        if (!nodeBlockPointer->getProperty("label", nodeBlockPointer->id)) {
             node_block_logger.error("Could not find node ID/Label for node with block address = " +
                 std::to_string(nodeBlockPointer->addr));
         }
@@ -438,5 +440,5 @@ NodeBlock* NodeBlock::get(unsigned int blockAddress) {
     return nodeBlockPointer;
 }
 
-PropertyLink* NodeBlock::getPropertyHead() { return PropertyLink::get(this->propRef); }
 thread_local std::fstream* NodeBlock::nodesDB = NULL;
+thread_local bool NodeBlock::numericIds = false;
@@ -17,7 +17,7 @@ limitations under the License.
 #include <map>
 #include <string>
 
-#include "PropertyLink.h"
+#include "PropertyStore.h"
 
 class RelationBlock;  // Forward declaration
 
@@ -29,35 +29,38 @@ class NodeBlock {
     bool isDirected = false;
 
  public:
-    static const unsigned long BLOCK_SIZE = 24;  // Size of a node block in bytes
+    static const unsigned long BLOCK_SIZE = 28;  // Size of a node block in bytes
     static const unsigned int LABEL_SIZE = 6;    // Size of a node label in bytes
     unsigned int addr = 0;
     std::string id = "";  // Node ID for this block ie: citation paper ID, Facebook accout ID, Twitter account ID etc
 
     char usage = false;   // Whether this block is in use or not
-    unsigned int nodeId;  // nodeId for each block
+    unsigned long nodeId;  // Numeric node ID, the whole ID of a node of a store with numeric IDs
     unsigned int edgeRef = 0;         // edges database block address for relations size of edgeRef is 4 bytes
     unsigned int centralEdgeRef = 0;  // edges cut database block address for edge cut relations
     unsigned char edgeRefPID = 0;     // Partition ID of the edge reference
-    unsigned int propRef = 0;         // Properties DB block address for node properties
+    unsigned int propRef = 0;         // Address of the property record of the node in the node property store
     char label[LABEL_SIZE] = {
         0};  // Initialize with null chars label === ID if length(id) < 6 else ID will be stored as a Node's property
 
     static thread_local std::fstream *nodesDB;
+    // Whether the node IDs of the store of this thread are numeric. Their nodes have neither a label nor a label
+    // property.
+    static thread_local bool numericIds;
 
     /**
      * This constructor is used when creating a node for very first time.
      * Where user don't have properties DB address or edge DB addresses
      *
      **/
-    NodeBlock(std::string newId, unsigned int node, unsigned int address) {
+    NodeBlock(std::string newId, unsigned long node, unsigned int address) {
         id = newId;
         nodeId = node;
         addr = address;
         usage = true;
     };
 
-    NodeBlock(std::string id, unsigned int nodeId, unsigned int address, unsigned int propRef, unsigned int edgeRef,
+    NodeBlock(std::string id, unsigned long nodeId, unsigned int address, unsigned int propRef, unsigned int edgeRef,
               unsigned int centralEdgeRef, unsigned char edgeRefPID, const char *_label, bool usage);
 
     void save();
@@ -67,10 +70,10 @@ class NodeBlock {
     int getFlags();
     static NodeBlock *get(unsigned int);
 
-    void addProperty(std::string, const char *);
-    std::map<std::string, char *> getProperty(std::string);
-    PropertyLink *getPropertyHead();
-    std::map<std::string, char *> getAllProperties();
+    void addProperty(std::string, const std::string &);
+    void addProperties(const std::map<std::string, std::string> &);
+    bool getProperty(const std::string &, std::string &);
+    std::map<std::string, std::string> getAllProperties();
 
     bool updateLocalRelation(RelationBlock *, bool relocateHead = true);
     bool updateCentralRelation(RelationBlock *newRelation, bool relocateHead = true);
@@ -0,0 +1,106 @@
+/**
+Copyright 2024 JasmineGraph Team
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+**/
+
+#include "NodeIdIndex.h"
+
+static const unsigned int INITIAL_BITS = 10;
+
+const unsigned long NodeIdIndex::FREE;
+
+NodeIdIndex::NodeIdIndex()
+    : ids(1UL << INITIAL_BITS, FREE),
+      nodeIndexes(1UL << INITIAL_BITS),
+      count(0),
+      shift(64 - INITIAL_BITS),
+      hasFreeId(false),
+      freeIdNodeIndex(0) {}
+
+// Fibonacci hashing, so that consecutive IDs spread over the table
+size_t NodeIdIndex::slot(unsigned long id) const { return (id * 0x9E3779B97F4A7C15UL) >> this->shift; }
+
+bool NodeIdIndex::find(unsigned long id, unsigned int &nodeIndex) const {
+    if (id == FREE) {
+        nodeIndex = this->freeIdNodeIndex;
+        return this->hasFreeId;
+    }
+    size_t mask = this->ids.size() - 1;
+    for (size_t i = this->slot(id);; i = (i + 1) & mask) {
+        if (this->ids[i] == id) {
+            nodeIndex = this->nodeIndexes[i];
+            return true;
+        }
+        if (this->ids[i] == FREE) {
+            return false;
+        }
+    }
+}
+
+bool NodeIdIndex::insert(unsigned long id, unsigned int nodeIndex) {
+    if (id == FREE) {
+        if (this->hasFreeId) {
+            return false;
+        }
+        this->hasFreeId = true;
+        this->freeIdNodeIndex = nodeIndex;
+        this->count++;
+        return true;
+    }
+    if ((this->count + 1) * 4 > this->ids.size() * 3) {
+        this->grow();
+    }
+    size_t mask = this->ids.size() - 1;
+    size_t i = this->slot(id);
+    for (; this->ids[i] != FREE; i = (i + 1) & mask) {
+        if (this->ids[i] == id) {
+            return false;
+        }
+    }
+    this->ids[i] = id;
+    this->nodeIndexes[i] = nodeIndex;
+    this->count++;
+    return true;
+}
+
+void NodeIdIndex::grow() {
+    std::vector<unsigned long> oldIds(this->ids.size() * 2, FREE);
+    std::vector<unsigned int> oldNodeIndexes(this->ids.size() * 2);
+    oldIds.swap(this->ids);
+    oldNodeIndexes.swap(this->nodeIndexes);
+    this->shift--;
+    size_t mask = this->ids.size() - 1;
+    for (size_t j = 0; j < oldIds.size(); j++) {
+        if (oldIds[j] == FREE) {
+            continue;
+        }
+        size_t i = this->slot(oldIds[j]);
+        while (this->ids[i] != FREE) {
+            i = (i + 1) & mask;
+        }
+        this->ids[i] = oldIds[j];
+        this->nodeIndexes[i] = oldNodeIndexes[j];
+    }
+}
+
+std::vector<std::pair<unsigned long, unsigned int>> NodeIdIndex::entries() const {
+    std::vector<std::pair<unsigned long, unsigned int>> all;
+    all.reserve(this->count);
+    for (size_t i = 0; i < this->ids.size(); i++) {
+        if (this->ids[i] != FREE) {
+            all.push_back(std::make_pair(this->ids[i], this->nodeIndexes[i]));
+        }
+    }
+    if (this->hasFreeId) {
+        all.push_back(std::make_pair(FREE, this->freeIdNodeIndex));
+    }
+    return all;
+}
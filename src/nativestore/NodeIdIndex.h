@@ -0,0 +1,51 @@
+/**
+Copyright 2024 JasmineGraph Team
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+**/
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#ifndef JASMINEGRAPH_NODEIDINDEX_H
+#define JASMINEGRAPH_NODEIDINDEX_H
+
+/**
+ * Index from numeric node IDs to node block indexes.
+ *
+ * Open addressing with linear probing over two flat arrays, so an entry takes 12 bytes plus the free slots instead of
+ * a heap allocated hash node holding a string key. The table doubles when it is three quarters full.
+ * **/
+class NodeIdIndex {
+ public:
+    NodeIdIndex();
+
+    bool find(unsigned long id, unsigned int &nodeIndex) const;
+    // Returns false if the ID is already in the index
+    bool insert(unsigned long id, unsigned int nodeIndex);
+    size_t size() const { return count; }
+    std::vector<std::pair<unsigned long, unsigned int>> entries() const;
+
+ private:
+    static const unsigned long FREE = ~0UL;  // Marks a free slot. That ID is kept outside the table.
+
+    std::vector<unsigned long> ids;
+    std::vector<unsigned int> nodeIndexes;
+    size_t count;
+    unsigned int shift;  // 64 - log2 of the number of slots
+    bool hasFreeId;
+    unsigned int freeIdNodeIndex;
+
+    size_t slot(unsigned long id) const;
+    void grow();
+};
+
+#endif  // JASMINEGRAPH_NODEIDINDEX_H
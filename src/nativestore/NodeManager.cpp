@@ -15,22 +15,29 @@ limitations under the License.
 
 #include <sys/stat.h>
 
+#include <cstdint>
+#include <cstring>
 #include <exception>
 #include <mutex>
 
 #include "../util/Utils.h"
 #include "../util/logger/Logger.h"
 #include "NodeBlock.h"  // To setup node DB
-#include "PropertyEdgeLink.h"
-#include "PropertyLink.h"
+#include "PropertyStore.h"
 #include "RelationBlock.h"
 #include "iostream"
 #include <sys/stat.h>
 
 Logger node_manager_logger;
-pthread_mutex_t lockEdgeAdd;
+thread_local NodeManager *NodeManager::attachedManager = NULL;
 
-NodeManager::NodeManager(GraphConfig gConfig) {
+static const char RELATION_DB_MAGIC[4] = {'J', 'G', 'R', 'B'};
+static const unsigned int RELATION_DB_VERSION = 1;  // Relation blocks of 14 records, ending with the ingest time
+static const char NODE_DB_MAGIC[4] = {'J', 'G', 'N', 'B'};
+static const unsigned int NODE_DB_VERSION = 1;  // Node blocks of 28 bytes, with 8 byte numeric IDs
+
+NodeManager::NodeManager(GraphConfig gConfig)
+    : nextNodeIndex(1), nextLocalRelationIndex(1), nextCentralRelationIndex(1) {
     this->graphID = gConfig.graphID;
     this->partitionID = gConfig.partitionID;
     Utils utils;
@@ -39,17 +46,18 @@ NodeManager::NodeManager(GraphConfig gConfig) {
         utils.getJasmineGraphProperty("org.jasminegraph.server.instance.datafolder");
     std::string graphPrefix = instanceDataFolderLocation + "/g" + std::to_string(graphID);
     dbPrefix = graphPrefix + "_p" + std::to_string(partitionID);
-    std::string nodesDBPath = dbPrefix + "_nodes.db";
-    indexDBPath = dbPrefix + "_nodes.index.db";
-    std::string propertiesDBPath = dbPrefix + "_properties.db";
-    std::string edgePropertiesDBPath = dbPrefix + "_edge_properties.db";
-    std::string relationsDBPath = dbPrefix + "_relations.db";
-    std::string centralRelationsDBPath = dbPrefix + "_central_relations.db";
+    nodesDBPath = dbPrefix + "_nodes.db";
+    std::string stringIndexDBPath = dbPrefix + "_nodes.index.db";
+    std::string numericIndexDBPath = dbPrefix + "_nodes.numeric.index.db";
+    std::string propertyKeysDBPath = dbPrefix + "_property_keys.db";
+    std::string propertiesDBPath = dbPrefix + "_node_props.db";
+    std::string edgePropertiesDBPath = dbPrefix + "_edge_props.db";
+    relationsDBPath = dbPrefix + "_relations.db";
+    centralRelationsDBPath = dbPrefix + "_central_relations.db";
     // This needs to be set in order to prevent index DB key overflows
     // Expected maximum length of a key in the dataset
 
     node_manager_logger.info("Derived nodesDBPath: " + nodesDBPath);
-    node_manager_logger.info("Derived index_db_loc: " + indexDBPath);
 
     if (gConfig.maxLabelSize) {
         setIndexKeySize(gConfig.maxLabelSize);
@@ -60,44 +68,94 @@ NodeManager::NodeManager(GraphConfig gConfig) {
     }
 
     std::ios_base::openmode openMode = std::ios::in | std::ios::out;  // Default mode
-    if (gConfig.openMode == NodeManager::FILE_MODE) {
-        this->nodeIndex = readNodeIndex();
-    } else {
+    this->readOnly = gConfig.openMode == NodeManager::READ_MODE;
+    if (gConfig.openMode != NodeManager::FILE_MODE && !this->readOnly) {
         openMode |= std::ios::trunc;
     }
 
+    // The index a partition was created with keeps its ID mode
+    if (openMode & std::ios::trunc) {
+        this->numericIds = gConfig.numericIds;
+        std::remove((this->numericIds ? stringIndexDBPath : numericIndexDBPath).c_str());
+    } else {
+        this->numericIds = Utils::fileExistsWithReadPermission(numericIndexDBPath) ||
+                           (!Utils::fileExistsWithReadPermission(stringIndexDBPath) && gConfig.numericIds);
+    }
+    indexDBPath = this->numericIds ? numericIndexDBPath : stringIndexDBPath;
+    node_manager_logger.info("Derived index_db_loc: " + indexDBPath);
+
+    // Replaying the log must happen before anything is read from the DBs
+    this->wal = new WriteAheadLog(dbPrefix + "_store.wal",
+                                  {nodesDBPath, relationsDBPath, centralRelationsDBPath, indexDBPath});
+    if (!this->wal->open(openMode & std::ios::trunc, this->readOnly) ||
+        !this->wal->loadBlockMap(WriteAheadLog::RELATIONS, RelationBlock::BLOCK_SIZE) ||
+        !this->wal->loadBlockMap(WriteAheadLog::CENTRAL_RELATIONS, RelationBlock::BLOCK_SIZE)) {
+        node_manager_logger.error("Using the DBs of " + dbPrefix + " without the write-ahead log");
+        delete this->wal;
+        this->wal = NULL;
+    }
+    if (gConfig.openMode == NodeManager::FILE_MODE) {
+        if (this->numericIds) {
+            this->readNumericNodeIndex();
+        } else {
+            this->nodeIndex = readNodeIndex();
+        }
+    }
+
     if (gConfig.openMode == NodeManager::FILE_MODE) {
         node_manager_logger.info("Using APPEND mode for file operations.");
+    } else if (this->readOnly) {
+        node_manager_logger.info("Using READ mode for file operations.");
     } else {
         node_manager_logger.info("Using TRUNC mode for file operations.");
     }
 
-    NodeBlock::nodesDB = Utils::openFile(nodesDBPath, openMode);
-    PropertyLink::propertiesDB = Utils::openFile(propertiesDBPath, openMode);
-    PropertyEdgeLink::edgePropertiesDB = Utils::openFile(edgePropertiesDBPath, openMode);
-    RelationBlock::relationsDB = utils.openFile(relationsDBPath, openMode);
-    RelationBlock::centralRelationsDB = Utils::openFile(centralRelationsDBPath, openMode);
+    this->propertyKeys = new PropertyKeys(propertyKeysDBPath, openMode);
+    this->nodeProperties = new PropertyStore(propertiesDBPath, openMode, this->propertyKeys);
+    this->edgeProperties = new PropertyStore(edgePropertiesDBPath, openMode, this->propertyKeys);
+    this->setThreadHandles(this->openDB(nodesDBPath, WriteAheadLog::NODES, openMode),
+                           this->openDB(relationsDBPath, WriteAheadLog::RELATIONS, openMode),
+                           this->openDB(centralRelationsDBPath, WriteAheadLog::CENTRAL_RELATIONS, openMode));
+    this->localAdjacency = new AdjacencySnapshot();
+    this->centralAdjacency = new AdjacencySnapshot();
+    this->loadedRelations[0] = 0;
+    this->loadedRelations[1] = 0;
+    this->incompatible =
+        !this->checkNodeFormat() || !this->checkRelationFormat(true) || !this->checkRelationFormat(false);
+    if (this->incompatible) {
+        node_manager_logger.error("The stream of " + dbPrefix + " must be ingested again into new DBs");
+    } else if (this->readOnly) {
+        this->refreshAdjacency();
+    } else {
+        this->loadAdjacency(true);
+        this->loadAdjacency(false);
+    }
+    this->compactor = NULL;
+    if (this->wal && this->wal->ownsLog()) {
+        // Property records are written in place, so they must be on disk before the blocks referring to them
+        this->wal->setSyncHook([this]() {
+            this->propertyKeys->flush();
+            this->nodeProperties->flush();
+            this->edgeProperties->flush();
+        });
+        this->wal->start(
+            std::stoul(Utils::getJasmineGraphProperty("org.jasminegraph.nativestore.wal.group.bytes")),
+            std::stoul(Utils::getJasmineGraphProperty("org.jasminegraph.nativestore.wal.group.ms")),
+            std::stoul(Utils::getJasmineGraphProperty("org.jasminegraph.nativestore.wal.checkpoint.bytes")));
+        unsigned long compactionInterval =
+            std::stoul(Utils::getJasmineGraphProperty("org.jasminegraph.nativestore.compaction.interval"));
+        if (compactionInterval > 0 && !this->incompatible) {
+            this->compactor = new RelationCompactor(
+                this->wal, compactionInterval,
+                std::stoul(Utils::getJasmineGraphProperty("org.jasminegraph.nativestore.compaction.min.relations")));
+        }
+    }
 
     //    RelationBlock::centralpropertiesDB =
     //            new std::fstream(dbPrefix + "_central_relations.db", std::ios::in | std::ios::out | openMode |
     //            std::ios::binary);
-    // TODO (tmkasun): set PropertyLink nextPropertyIndex after validating by modulus check from file number of bytes
 
     node_manager_logger.info("NodesDB, PropertiesDB, and RelationsDB files opened (or created) successfully.");
-    //    unsigned int nextAddress;
-    //    unsigned int propertyBlockAddress = 0;
-    //    PropertyLink::propertiesDB->seekg(propertyBlockAddress * PropertyLink::PROPERTY_BLOCK_SIZE);
-    //    if (PropertyLink::propertiesDB && PropertyLink::propertiesDB->is_open()) {
-    //        PropertyLink::propertiesDB->seekg(propertyBlockAddress * PropertyLink::PROPERTY_BLOCK_SIZE);
-    //        if (!PropertyLink::propertiesDB->read(reinterpret_cast<char*>(&(nextAddress)), sizeof(unsigned int))) {
-    //            node_manager_logger.error("Error while reading node property next address from block = " +
-    //            std::to_string(propertyBlockAddress));
-    //        }
-    //    } else {
-    //        node_manager_logger.error("Failed to open propertiesDB file.");
-    //    }
-    //
-    //    node_manager_logger.log("Checking NextAddress : " + nextAddress, "info");
 
     if (dbSize(nodesDBPath) % NodeBlock::BLOCK_SIZE != 0) {
         node_manager_logger.warn("NodesDB size: " + std::to_string(dbSize(nodesDBPath)) +
@@ -118,30 +176,15 @@ NodeManager::NodeManager(GraphConfig gConfig) {
 
     struct stat stat_buf;
 
-    if (stat(propertiesDBPath.c_str(), &stat_buf) == 0) {
-        PropertyLink::nextPropertyIndex = (stat_buf.st_size / PropertyLink::PROPERTY_BLOCK_SIZE) == 0 ? 1 :
-                (stat_buf.st_size / PropertyLink::PROPERTY_BLOCK_SIZE);
-
-    } else {
-        node_manager_logger.error("Error getting file size for: " + propertiesDBPath);
-    }
-
-    if (stat(edgePropertiesDBPath.c_str(), &stat_buf) == 0) {
-        PropertyEdgeLink::nextPropertyIndex = (stat_buf.st_size / PropertyEdgeLink::PROPERTY_BLOCK_SIZE) == 0 ? 1 :
-                                            (stat_buf.st_size / PropertyEdgeLink::PROPERTY_BLOCK_SIZE);
-    } else {
-        node_manager_logger.error("Error getting file size for: " + edgePropertiesDBPath);
-    }
-
     if (stat(relationsDBPath.c_str(), &stat_buf) == 0) {
-        RelationBlock::nextLocalRelationIndex = (stat_buf.st_size / RelationBlock::BLOCK_SIZE) == 0 ? 1 :
+        this->nextLocalRelationIndex = (stat_buf.st_size / RelationBlock::BLOCK_SIZE) == 0 ? 1 :
                                         (stat_buf.st_size / RelationBlock::BLOCK_SIZE);
     } else {
         node_manager_logger.error("Error getting file size for: " + relationsDBPath);
     }
 
     if (stat(centralRelationsDBPath.c_str(), &stat_buf) == 0) {
-        RelationBlock::nextCentralRelationIndex = (stat_buf.st_size / RelationBlock::BLOCK_SIZE)== 0 ? 1 :
+        this->nextCentralRelationIndex = (stat_buf.st_size / RelationBlock::BLOCK_SIZE)== 0 ? 1 :
                                                 (stat_buf.st_size / RelationBlock::BLOCK_SIZE);
     } else {
         node_manager_logger.error("Error getting file size for: " + centralRelationsDBPath);
@@ -149,6 +192,86 @@ NodeManager::NodeManager(GraphConfig gConfig) {
     node_manager_logger.info("Node Manager Execution Completed!");
 }
 
+NodeManager::~NodeManager() {
+    delete this->compactor;
+    if (NodeManager::attachedManager == this) {
+        NodeManager::attachedManager = NULL;
+        NodeBlock::nodesDB = NULL;
+        RelationBlock::relationsDB = NULL;
+        RelationBlock::centralRelationsDB = NULL;
+        RelationBlock::nextLocalRelationIndex = NULL;
+        RelationBlock::nextCentralRelationIndex = NULL;
+    }
+    for (std::fstream *file : this->threadFiles) {
+        delete file;
+    }
+    delete this->wal;  // Commits the pending writes
+    if (PropertyStore::nodeProperties == this->nodeProperties) {
+        PropertyStore::nodeProperties = NULL;
+    }
+    if (PropertyStore::edgeProperties == this->edgeProperties) {
+        PropertyStore::edgeProperties = NULL;
+    }
+    delete this->nodeProperties;
+    delete this->edgeProperties;
+    delete this->propertyKeys;
+    delete this->localAdjacency;
+    delete this->centralAdjacency;
+}
+
+void NodeManager::setThreadHandles(std::fstream *nodesDB, std::fstream *relationsDB,
+                                   std::fstream *centralRelationsDB) {
+    NodeBlock::nodesDB = nodesDB;
+    NodeBlock::numericIds = this->numericIds;
+    RelationBlock::relationsDB = relationsDB;
+    RelationBlock::centralRelationsDB = centralRelationsDB;
+    RelationBlock::nextLocalRelationIndex = &this->nextLocalRelationIndex;
+    RelationBlock::nextCentralRelationIndex = &this->nextCentralRelationIndex;
+    PropertyStore::nodeProperties = this->nodeProperties;
+    PropertyStore::edgeProperties = this->edgeProperties;
+    NodeManager::attachedManager = this;
+    std::lock_guard<std::mutex> guard(this->nodeIndexLock);
+    this->threadFiles.push_back(nodesDB);
+    this->threadFiles.push_back(relationsDB);
+    this->threadFiles.push_back(centralRelationsDB);
+}
+
+/**
+ * Every thread reads and writes the DB files through its own streams. A stream discards its buffer when seeking, and
+ * the blocks are flushed after each write, so the threads see each other's writes. Streams over the write-ahead log
+ * share its pending writes.
+ * */
+void NodeManager::attachThread() {
+    if (NodeManager::attachedManager == this) {
+        return;
+    }
+    std::ios_base::openmode openMode = std::ios::in | std::ios::out;
+    this->setThreadHandles(this->openDB(this->nodesDBPath, WriteAheadLog::NODES, openMode),
+                           this->openDB(this->relationsDBPath, WriteAheadLog::RELATIONS, openMode),
+                           this->openDB(this->centralRelationsDBPath, WriteAheadLog::CENTRAL_RELATIONS, openMode));
+}
+
+std::fstream *NodeManager::openDB(const std::string &path, WriteAheadLog::FileId file,
+                                  std::ios_base::openmode openMode) {
+    if (this->wal) {
+        return this->wal->openStream(file);
+    }
+    return Utils::openFile(path, openMode);
+}
+
+std::mutex &NodeManager::vertexLock(unsigned long nodeId) {
+    return this->vertexLocks[nodeId % NodeManager::VERTEX_LOCK_STRIPES];
+}
+
+static unsigned long numericId(const std::string &nodeId) { return std::stoul(nodeId); }
+
+static unsigned long numericId(unsigned long nodeId) { return nodeId; }
+
+std::unordered_map<std::string, unsigned int> NodeManager::copyNodeIndex() {
+    std::lock_guard<std::mutex> guard(this->nodeIndexLock);
+    return this->nodeIndex;
+}
+
 std::unordered_map<std::string, unsigned int> NodeManager::readNodeIndex() {
     std::ifstream index_db(indexDBPath, std::ios::app | std::ios::binary);
     std::unordered_map<std::string, unsigned int> _nodeIndex;  // temporary node index data holder
@@ -159,7 +282,7 @@ std::unordered_map<std::string, unsigned int> NodeManager::readNodeIndex() {
             node_manager_logger.error("Index DB size does not comply to index block size Path = " + indexDBPath);
             node_manager_logger.error("Node index DB in " + indexDBPath + " is corrupted!");
         }
-        NodeManager::nextNodeIndex = iSize/dataWidth;
+        NodeManager::nextNodeIndex = iSize/dataWidth + 1;  // Node block 0 holds the layout
         char nodeIDC[NodeManager::INDEX_KEY_SIZE];
         bzero(nodeIDC, NodeManager::INDEX_KEY_SIZE);  // Fill with null chars before putting data
         unsigned int nodeIndexId;
@@ -181,6 +304,33 @@ std::unordered_map<std::string, unsigned int> NodeManager::readNodeIndex() {
     return _nodeIndex;
 }
 
+/**
+ * Entries of the numeric node index are the node ID followed by the node index
+ * */
+void NodeManager::readNumericNodeIndex() {
+    std::ifstream index_db(indexDBPath, std::ios::binary);
+    if (!index_db.is_open()) {
+        node_manager_logger.error("Error while opening the node index DB");
+        return;
+    }
+    const unsigned long dataWidth = sizeof(unsigned long) + sizeof(unsigned int);
+    int iSize = dbSize(indexDBPath);
+    if (iSize % dataWidth != 0) {
+        node_manager_logger.error("Node index DB in " + indexDBPath + " is corrupted!");
+    }
+    this->nextNodeIndex = iSize / dataWidth + 1;  // Node block 0 holds the layout
+    unsigned long nodeId;
+    unsigned int nodeIndexId;
+    for (size_t i = 0; i < iSize / dataWidth; i++) {
+        if (!index_db.read(reinterpret_cast<char *>(&nodeId), sizeof(nodeId)) ||
+            !index_db.read(reinterpret_cast<char *>(&nodeIndexId), sizeof(nodeIndexId))) {
+            node_manager_logger.error("Error while reading index data from block i = " + std::to_string(i));
+            break;
+        }
+        this->numericNodeIndex.insert(nodeId, nodeIndexId);
+    }
+}
+
 RelationBlock *NodeManager::addLocalRelation(NodeBlock source, NodeBlock destination) {
     RelationBlock *newRelation = NULL;
     if (source.edgeRef == 0 || destination.edgeRef == 0 ||
@@ -227,65 +377,149 @@ RelationBlock *NodeManager::addCentralRelation(NodeBlock source, NodeBlock desti
     return newRelation;
 }
 
+/**
+ * Must be called with the lock stripe of the node held, so that a node is only added once
+ * */
 NodeBlock *NodeManager::addNode(std::string nodeId) {
-    unsigned int assignedNodeIndex;
-    node_manager_logger.debug("Adding node index " + std::to_string(this->nextNodeIndex));
-    if (this->nodeIndex.find(nodeId) == this->nodeIndex.end()) {
+    if (this->incompatible) {
+        node_manager_logger.error("Cannot add a node to " + dbPrefix + ", whose DBs have another layout");
+        return NULL;
+    }
+    if (this->numericIds) {
+        return this->addNode(std::stoul(nodeId));
+    }
+    bool found;
+    {
+        std::lock_guard<std::mutex> guard(this->nodeIndexLock);
+        found = this->nodeIndex.find(nodeId) != this->nodeIndex.end();
+    }
+    if (!found) {
         node_manager_logger.debug("Can't find NodeId (" + nodeId + ") in the index database");
-        unsigned int vertexId = std::stoul(nodeId);
-        NodeBlock *sourceBlk = new NodeBlock(nodeId, vertexId, this->nextNodeIndex * NodeBlock::BLOCK_SIZE);
-        this->addNodeIndex(nodeId, this->nextNodeIndex);
-        assignedNodeIndex = this->nextNodeIndex;
-        this->nextNodeIndex++;
-        sourceBlk->setLabel(nodeId.c_str());
+        unsigned long vertexId = std::stoul(nodeId);
+        unsigned int assignedNodeIndex = this->nextNodeIndex++;
+        NodeBlock *sourceBlk = new NodeBlock(nodeId, vertexId, assignedNodeIndex * NodeBlock::BLOCK_SIZE);
         sourceBlk->save();
+        this->addNodeIndex(nodeId, assignedNodeIndex);
         return sourceBlk;
     }
     node_manager_logger.debug("NodeId found in index for node ID " + nodeId);
     return this->get(nodeId);
 }
 
-RelationBlock *NodeManager::addLocalEdge(std::pair<std::string, std::string> edge) {
-    pthread_mutex_lock(&lockEdgeAdd);
+NodeBlock *NodeManager::addNode(unsigned long nodeId) {
+    unsigned int nodeIndex;
+    bool found;
+    {
+        std::lock_guard<std::mutex> guard(this->nodeIndexLock);
+        found = this->numericNodeIndex.find(nodeId, nodeIndex);
+    }
+    if (found) {
+        return this->readNode(std::to_string(nodeId), nodeIndex);
+    }
+    nodeIndex = this->nextNodeIndex++;
+    NodeBlock *node = new NodeBlock(std::to_string(nodeId), nodeId, nodeIndex * NodeBlock::BLOCK_SIZE);
+    node->save();
+    this->addNodeIndex(nodeId, nodeIndex);
+    return node;
+}
+
+/**
+ * Adding an edge changes the relation lists of both of its nodes, so it holds the lock stripes of both. The stripes
+ * are taken in address order to avoid deadlocks between threads adding edges in opposite directions.
+ * */
+template <typename ID>
+RelationBlock *NodeManager::addEdge(const std::pair<ID, ID> &edge, bool isLocal) {
+    if (this->incompatible) {
+        node_manager_logger.error("Cannot add an edge to " + dbPrefix + ", whose DBs have another layout");
+        return NULL;
+    }
+    // Begun before taking the stripes, as a commit waiting for the running operations blocks new ones
+    WriteAheadLog::Operation operation(this->wal);
+    std::mutex *first = &this->vertexLock(numericId(edge.first));
+    std::mutex *second = &this->vertexLock(numericId(edge.second));
+    if (second < first) {
+        std::swap(first, second);
+    }
+    std::unique_lock<std::mutex> firstGuard(*first);
+    std::unique_lock<std::mutex> secondGuard;
+    if (second != first) {
+        secondGuard = std::unique_lock<std::mutex>(*second);
+    }
 
     NodeBlock *sourceNode = this->addNode(edge.first);
     NodeBlock *destNode = this->addNode(edge.second);
-    RelationBlock *newRelation = this->addLocalRelation(*sourceNode, *destNode);
+    RelationBlock *newRelation = isLocal ? this->addLocalRelation(*sourceNode, *destNode)
+                                         : this->addCentralRelation(*sourceNode, *destNode);
     if (newRelation) {
         newRelation->setDestination(destNode);
         newRelation->setSource(sourceNode);
     }
-    pthread_mutex_unlock(&lockEdgeAdd);
+    if (secondGuard.owns_lock()) {
+        secondGuard.unlock();
+    }
+    firstGuard.unlock();
+    if (newRelation) {
+        this->getAdjacencySnapshot(isLocal)->add(sourceNode->nodeId, destNode->nodeId, newRelation->ingestTime);
+    }
 
     node_manager_logger.debug("DEBUG: Source DB block address " + std::to_string(sourceNode->addr) +
                               " Destination DB block address " + std::to_string(destNode->addr));
     return newRelation;
 }
 
+RelationBlock *NodeManager::addLocalEdge(std::pair<std::string, std::string> edge) {
+    if (this->numericIds) {
+        return this->addLocalEdge(std::make_pair(std::stoul(edge.first), std::stoul(edge.second)));
+    }
+    return this->addEdge(edge, true);
+}
+
 RelationBlock *NodeManager::addCentralEdge(std::pair<std::string, std::string> edge) {
-    //    std::unique_lock<std::mutex> guard1(lockCentralEdgeAdd);
-    //
-    //    guard1.lock();
-    pthread_mutex_lock(&lockEdgeAdd);
+    if (this->numericIds) {
+        return this->addCentralEdge(std::make_pair(std::stoul(edge.first), std::stoul(edge.second)));
+    }
+    return this->addEdge(edge, false);
+}
 
-    NodeBlock *sourceNode = this->addNode(edge.first);
-    NodeBlock *destNode = this->addNode(edge.second);
-    RelationBlock *newRelation = this->addCentralRelation(*sourceNode, *destNode);
-    if (newRelation) {
-        newRelation->setDestination(destNode);
-        newRelation->setSource(sourceNode);
+RelationBlock *NodeManager::addLocalEdge(std::pair<unsigned long, unsigned long> edge) {
+    if (!this->numericIds) {
+        return this->addLocalEdge(std::make_pair(std::to_string(edge.first), std::to_string(edge.second)));
     }
-    pthread_mutex_unlock(&lockEdgeAdd);
+    return this->addEdge(edge, true);
+}
 
-    //    guard1.unlock();
-    node_manager_logger.debug("DEBUG: Source DB block address " + std::to_string(sourceNode->addr) +
-                              " Destination DB block address " + std::to_string(destNode->addr));
-    return newRelation;
+RelationBlock *NodeManager::addCentralEdge(std::pair<unsigned long, unsigned long> edge) {
+    if (!this->numericIds) {
+        return this->addCentralEdge(std::make_pair(std::to_string(edge.first), std::to_string(edge.second)));
+    }
+    return this->addEdge(edge, false);
+}
+
+/**
+ * Another thread may have moved the property record of the node since the block was read, so the property reference
+ * is read again under the lock stripe of the node.
+ * */
+void NodeManager::addNodeProperties(NodeBlock *node, const std::map<std::string, std::string> &properties) {
+    WriteAheadLog::Operation operation(this->wal);
+    std::lock_guard<std::mutex> guard(this->vertexLock(node->nodeId));
+    NodeBlock *current = NodeBlock::get(node->addr);
+    node->propRef = current->propRef;
+    delete current;
+    node->addProperties(properties);
 }
 
 void NodeManager::addNodeIndex(std::string nodeId, unsigned int nodeIndex) {
-    this->nodeIndex.insert({nodeId, this->nextNodeIndex});
+    std::lock_guard<std::mutex> guard(this->nodeIndexLock);
+    this->nodeIndex.insert({nodeId, nodeIndex});
 
+    if (this->wal) {
+        std::string entry(NodeManager::INDEX_KEY_SIZE, '\0');
+        nodeId.copy(&entry[0], NodeManager::INDEX_KEY_SIZE);
+        entry.append(reinterpret_cast<char *>(&nodeIndex), sizeof(unsigned int));
+        this->wal->write(WriteAheadLog::NODE_INDEX, this->wal->size(WriteAheadLog::NODE_INDEX), entry.data(),
+                         entry.size());
+        return;
+    }
     std::ofstream index_db(indexDBPath, std::ios::app | std::ios::binary);
     if (index_db.is_open()) {
         char nodeIDC[NodeManager::INDEX_KEY_SIZE] = {0};  // Initialize with null chars
@@ -301,6 +535,23 @@ void NodeManager::addNodeIndex(std::string nodeId, unsigned int nodeIndex) {
     index_db.close();
 }
 
+void NodeManager::addNodeIndex(unsigned long nodeId, unsigned int nodeIndex) {
+    std::lock_guard<std::mutex> guard(this->nodeIndexLock);
+    this->numericNodeIndex.insert(nodeId, nodeIndex);
+
+    std::string entry(reinterpret_cast<char *>(&nodeId), sizeof(nodeId));
+    entry.append(reinterpret_cast<char *>(&nodeIndex), sizeof(nodeIndex));
+    if (this->wal) {
+        this->wal->write(WriteAheadLog::NODE_INDEX, this->wal->size(WriteAheadLog::NODE_INDEX), entry.data(),
+                         entry.size());
+        return;
+    }
+    std::ofstream index_db(indexDBPath, std::ios::app | std::ios::binary);
+    if (!index_db.write(entry.data(), entry.size())) {
+        node_manager_logger.error("Failed to write the node index entry of node " + std::to_string(nodeId));
+    }
+}
+
 int NodeManager::dbSize(std::string path) {
     /*
         The structure stat contains at least the following members:
@@ -335,14 +586,43 @@ int NodeManager::dbSize(std::string path) {
  * @Deprecated use NodeBlock.get() instead
  **/
 NodeBlock *NodeManager::get(std::string nodeId) {
+    if (this->numericIds) {
+        return this->get(std::stoul(nodeId));
+    }
+    unsigned int nodeIndex;
+    {
+        std::lock_guard<std::mutex> guard(this->nodeIndexLock);
+        auto it = this->nodeIndex.find(nodeId);
+        if (it == this->nodeIndex.end()) {  // Not found
+            return NULL;
+        }
+        nodeIndex = it->second;
+    }
+    return this->readNode(nodeId, nodeIndex);
+}
+
+NodeBlock *NodeManager::get(unsigned long nodeId) {
+    if (!this->numericIds) {
+        return this->get(std::to_string(nodeId));
+    }
+    unsigned int nodeIndex;
+    {
+        std::lock_guard<std::mutex> guard(this->nodeIndexLock);
+        if (!this->numericNodeIndex.find(nodeId, nodeIndex)) {
+            return NULL;
+        }
+    }
+    return this->readNode(std::to_string(nodeId), nodeIndex);
+}
+
+NodeBlock *NodeManager::readNode(const std::string &nodeId, unsigned int nodeIndex) {
     NodeBlock *nodeBlockPointer = NULL;
-    if (this->nodeIndex.find(nodeId) == this->nodeIndex.end()) {  // Not found
-        return nodeBlockPointer;
+    if (this->incompatible) {
+        return NULL;  // The node blocks would be misread
     }
-    unsigned int nodeIndex = this->nodeIndex[nodeId];
     const unsigned int blockAddress = nodeIndex * NodeBlock::BLOCK_SIZE;
     NodeBlock::nodesDB->seekg(blockAddress);
-    unsigned int vertexId;
+    unsigned long vertexId;
     unsigned int edgeRef;
     unsigned int centralEdgeRef;
     unsigned char edgeRefPID;
@@ -353,7 +633,7 @@ NodeBlock *NodeManager::get(std::string nodeId) {
     if (!NodeBlock::nodesDB->read(reinterpret_cast<char *>(&usageBlock), sizeof(unsigned char))) {
         node_manager_logger.error("Error while reading usage data from block " + std::to_string(blockAddress));
     }
-    if (!NodeBlock::nodesDB->read(reinterpret_cast<char *>(&vertexId), sizeof(unsigned int))) {
+    if (!NodeBlock::nodesDB->read(reinterpret_cast<char *>(&vertexId), sizeof(vertexId))) {
         node_manager_logger.error("Error while reading nodeId  data from block " + std::to_string(blockAddress));
     }
     if (!NodeBlock::nodesDB->read(reinterpret_cast<char *>(&edgeRef), sizeof(unsigned int))) {
@@ -394,15 +674,29 @@ NodeBlock *NodeManager::get(std::string nodeId) {
 }
 
 void NodeManager::persistNodeIndex() {
+    if (this->numericIds) {
+        std::vector<std::pair<unsigned long, unsigned int>> entries;
+        {
+            std::lock_guard<std::mutex> guard(this->nodeIndexLock);
+            entries = this->numericNodeIndex.entries();
+        }
+        std::ofstream index_db(indexDBPath, std::ios::trunc | std::ios::binary);
+        for (auto &entry : entries) {
+            index_db.write(reinterpret_cast<char *>(&entry.first), sizeof(entry.first));
+            index_db.write(reinterpret_cast<char *>(&entry.second), sizeof(entry.second));
+        }
+        return;
+    }
+    const auto &nodeIndex = this->copyNodeIndex();
     std::ofstream index_db(indexDBPath, std::ios::trunc | std::ios::binary);
     if (index_db.is_open()) {
-        if (this->nodeIndex.size() > 0 && (this->nodeIndex.begin()->first.length() > NodeManager::INDEX_KEY_SIZE)) {
+        if (nodeIndex.size() > 0 && (nodeIndex.begin()->first.length() > NodeManager::INDEX_KEY_SIZE)) {
             node_manager_logger.error("Node label/ID is longer ( " +
-                                      std::to_string(this->nodeIndex.begin()->first.length()) +
+                                      std::to_string(nodeIndex.begin()->first.length()) +
                                       " ) than the index key size " + std::to_string(NodeManager::INDEX_KEY_SIZE));
             node_manager_logger.error("Node label/ID is longer than the index key size!");
         }
-        for (auto nodeMap : this->nodeIndex) {
+        for (auto nodeMap : nodeIndex) {
             char nodeIDC[NodeManager::INDEX_KEY_SIZE] = {0};  // Initialize with null chars
             std::strcpy(nodeIDC, nodeMap.first.c_str());
             index_db.write(nodeIDC, sizeof(nodeIDC));
@@ -420,33 +714,49 @@ void NodeManager::persistNodeIndex() {
  * Default limit is 10
  * */
 std::list<NodeBlock> NodeManager::getLimitedGraph(int limit) {
-    int i = 0;
     std::list<NodeBlock> vertices;
-    for (auto it : this->nodeIndex) {
-        i++;
-        if (i > limit) {
-            break;
-        }
-        auto nodeId = it.first;
-        NodeBlock *node = this->get(nodeId);
+    for (NodeBlock *node : this->getIndexedNodes(limit)) {
         vertices.push_back(*node);
     }
     return vertices;
 }
 
 /**
- * Return all nodes
+ * Node blocks of the nodes in the index, at most limit of them
  * */
-std::list<NodeBlock*> NodeManager::getGraph() {
-    std::list<NodeBlock*> vertices;
-    for (auto it : this->nodeIndex) {
-        auto nodeId = it.first;
-        NodeBlock *node = this->get(nodeId);
-        vertices.push_back(node);
-        node_manager_logger.debug("Read node index for node  " + nodeId + " with node index " +
+std::vector<NodeBlock *> NodeManager::getIndexedNodes(size_t limit) {
+    std::vector<NodeBlock *> nodes;
+    if (this->incompatible) {
+        return nodes;
+    }
+    if (this->numericIds) {
+        std::vector<std::pair<unsigned long, unsigned int>> entries;
+        {
+            std::lock_guard<std::mutex> guard(this->nodeIndexLock);
+            entries = this->numericNodeIndex.entries();
+        }
+        for (size_t i = 0; i < entries.size() && i < limit; i++) {
+            nodes.push_back(this->readNode(std::to_string(entries[i].first), entries[i].second));
+        }
+        return nodes;
+    }
+    for (auto it : this->copyNodeIndex()) {
+        if (nodes.size() >= limit) {
+            break;
+        }
+        nodes.push_back(this->readNode(it.first, it.second));
+        node_manager_logger.debug("Read node index for node  " + it.first + " with node index " +
                                   std::to_string(it.second));
     }
-    return vertices;
+    return nodes;
+}
+
+/**
+ * Return all nodes
+ * */
+std::list<NodeBlock*> NodeManager::getGraph() {
+    const std::vector<NodeBlock *> &nodes = this->getIndexedNodes(SIZE_MAX);
+    return std::list<NodeBlock *>(nodes.begin(), nodes.end());
 }
 
 /**
@@ -454,14 +764,10 @@ std::list<NodeBlock*> NodeManager::getGraph() {
  * */
 std::list<NodeBlock*> NodeManager::getCentralGraph() {
     std::list<NodeBlock*> vertices;
-    for (auto it : this->nodeIndex) {
-        auto nodeId = it.first;
-        NodeBlock *node = this->get(nodeId);
+    for (NodeBlock *node : this->getIndexedNodes(SIZE_MAX)) {
         if (node->getCentralRelationHead()) {
             vertices.push_back(node);
         }
-        node_manager_logger.debug("Read node index for central node " + nodeId + " with node index " +
-                                  std::to_string(it.second));
     }
     return vertices;
 }
@@ -469,9 +775,7 @@ std::list<NodeBlock*> NodeManager::getCentralGraph() {
 // Get adjacency list for the graph
 std::map<long, std::unordered_set<long>> NodeManager::getAdjacencyList() {
     map<long, std::unordered_set<long>> adjacencyList;
-    for (auto it : this->nodeIndex) {
-        auto nodeId = it.first;
-        NodeBlock *node = this->get(nodeId);
+    for (NodeBlock *node : this->getIndexedNodes(SIZE_MAX)) {
         std::unordered_set<long> neighbors;
         std::list<NodeBlock*> neighborNodes = node->getAllEdgeNodes();
 
@@ -484,32 +788,166 @@ std::map<long, std::unordered_set<long>> NodeManager::getAdjacencyList() {
 }
 
 std::map<long, std::unordered_set<long>> NodeManager::getAdjacencyList(bool isLocal) {
-    std::map<long, std::unordered_set<long>> adjacencyList;
+    return this->getAdjacencySnapshot(isLocal)->adjacencyList();
+}
 
-    int relationBlockSize = RelationBlock::BLOCK_SIZE;
-    long  newRelationCount;
+/**
+ * Reads the relations that are in the DB when the store is opened into the adjacency snapshot, in block order
+ * */
+void NodeManager::loadAdjacency(bool isLocal) {
+    AdjacencySnapshot *snapshot = this->getAdjacencySnapshot(isLocal);
+    long count = this->relationCount(isLocal);
+    for (long i = 1; i <= count; i++) {
+        RelationBlock *relationBlock = isLocal ? RelationBlock::getLocalRelation(i * RelationBlock::BLOCK_SIZE)
+                                               : RelationBlock::getCentralRelation(i * RelationBlock::BLOCK_SIZE);
+        if (!relationBlock) {
+            node_manager_logger.error("Error while reading relation " + std::to_string(i) + " of " + dbPrefix);
+            continue;
+        }
+        NodeBlock *source = relationBlock->getSource();
+        NodeBlock *destination = relationBlock->getDestination();
+        snapshot->add(source->nodeId, destination->nodeId, relationBlock->ingestTime);
+        delete source;
+        delete destination;
+        delete relationBlock;
+    }
+}
 
-    if (isLocal) {
-         newRelationCount = dbSize(dbPrefix + "_relations.db") / relationBlockSize - 1;
-    } else {
-         newRelationCount = dbSize(dbPrefix + "_central_relations.db") / relationBlockSize - 1;
+/**
+ * Reads the relation blocks appended since the last refresh through the log, so the calling thread needs no DB handles
+ * of its own. The owner appends relations in block order, so the snapshots get them in the order it added them.
+ * */
+void NodeManager::refreshAdjacency() {
+    std::lock_guard<std::mutex> guard(this->refreshLock);
+    if (this->incompatible) {
+        return;
+    }
+    if (!this->wal || !this->wal->refresh()) {
+        node_manager_logger.error("Cannot read the relations added to " + dbPrefix);
+        return;
+    }
+    std::vector<unsigned int> record(RelationBlock::BLOCK_SIZE / RelationBlock::RECORD_SIZE);
+    for (bool isLocal : {false, true}) {
+        WriteAheadLog::FileId file = isLocal ? WriteAheadLog::RELATIONS : WriteAheadLog::CENTRAL_RELATIONS;
+        AdjacencySnapshot *snapshot = this->getAdjacencySnapshot(isLocal);
+        long count = this->relationCount(isLocal);
+        long &loaded = this->loadedRelations[isLocal];
+        while (loaded < count) {
+            unsigned long source;
+            unsigned long destination;
+            if (this->wal->read(file, (loaded + 1) * RelationBlock::BLOCK_SIZE, reinterpret_cast<char *>(record.data()),
+                                RelationBlock::BLOCK_SIZE) != RelationBlock::BLOCK_SIZE ||
+                this->wal->read(WriteAheadLog::NODES, record[(int)RelationOffsets::SOURCE] + sizeof(NodeBlock::usage),
+                                reinterpret_cast<char *>(&source), sizeof(source)) != sizeof(source) ||
+                this->wal->read(WriteAheadLog::NODES,
+                                record[(int)RelationOffsets::DESTINATION] + sizeof(NodeBlock::usage),
+                                reinterpret_cast<char *>(&destination), sizeof(destination)) != sizeof(destination)) {
+                // Read again by the next refresh
+                node_manager_logger.error("Error while reading relation " + std::to_string(loaded + 1) + " of " +
+                                          dbPrefix);
+                break;
+            }
+            snapshot->add(source, destination, record[(int)RelationOffsets::INGEST_TIME]);
+            loaded++;
+        }
     }
+}
 
-    RelationBlock* relationBlock;
+/**
+ * Block 0 of a relation DB holds no relation. After the block map header of the write-ahead log it records the layout
+ * of the relation blocks, which a new DB gets when it is created. A DB without it was written with another block size
+ * and would be misread, so it is refused.
+ * */
+bool NodeManager::checkRelationFormat(bool isLocal) {
+    WriteAheadLog::FileId file = isLocal ? WriteAheadLog::RELATIONS : WriteAheadLog::CENTRAL_RELATIONS;
+    std::fstream *db = isLocal ? RelationBlock::relationsDB : RelationBlock::centralRelationsDB;
+    const std::string &path = isLocal ? this->relationsDBPath : this->centralRelationsDBPath;
+    char format[sizeof(RELATION_DB_MAGIC) + sizeof(RELATION_DB_VERSION)];
+    memcpy(format, RELATION_DB_MAGIC, sizeof(RELATION_DB_MAGIC));
+    memcpy(format + sizeof(RELATION_DB_MAGIC), &RELATION_DB_VERSION, sizeof(RELATION_DB_VERSION));
+    unsigned long offset = WriteAheadLog::BLOCK_MAP_HEADER_SIZE;
+
+    if (this->relationCount(isLocal) < 0) {
+        if (this->readOnly) {
+            return true;  // Not created by the owner yet
+        }
+        std::string block(RelationBlock::BLOCK_SIZE, '\0');
+        memcpy(&block[offset], format, sizeof(format));
+        if (this->wal) {
+            this->wal->write(file, 0, block.data(), block.size());
+        } else {
+            db->seekp(0);
+            db->write(block.data(), block.size());
+            db->flush();
+        }
+        return true;
+    }
+
+    char stored[sizeof(format)] = {0};
+    if (this->wal) {
+        this->wal->read(file, offset, stored, sizeof(stored));
+    } else {
+        db->seekg(offset);
+        db->read(stored, sizeof(stored));
+        db->clear();
+    }
+    if (memcmp(stored, format, sizeof(format)) != 0) {
+        node_manager_logger.error(path + " was written with another relation block layout than the " +
+                                  std::to_string(RelationBlock::BLOCK_SIZE) + " byte blocks of this version");
+        return false;
+    }
+    return true;
+}
 
-    for (int i = 1; i <=  newRelationCount ; i++) {
-        if (isLocal) {
-            relationBlock = RelationBlock::getLocalRelation(i * relationBlockSize);
+/**
+ * Node block 0 holds the layout of the nodes DB in place of a node ID, leaving its relation heads empty
+ * */
+bool NodeManager::checkNodeFormat() {
+    char format[sizeof(NODE_DB_MAGIC) + sizeof(NODE_DB_VERSION)];
+    memcpy(format, NODE_DB_MAGIC, sizeof(NODE_DB_MAGIC));
+    memcpy(format + sizeof(NODE_DB_MAGIC), &NODE_DB_VERSION, sizeof(NODE_DB_VERSION));
+    unsigned long offset = sizeof(NodeBlock::usage);
+    long size = this->wal ? static_cast<long>(this->wal->size(WriteAheadLog::NODES)) : dbSize(this->nodesDBPath);
+
+    if (size <= 0) {
+        if (this->readOnly) {
+            return true;  // Not created by the owner yet
+        }
+        std::string block(NodeBlock::BLOCK_SIZE, '\0');
+        memcpy(&block[offset], format, sizeof(format));
+        if (this->wal) {
+            this->wal->write(WriteAheadLog::NODES, 0, block.data(), block.size());
         } else {
-            relationBlock = RelationBlock::getCentralRelation(i * relationBlockSize);
+            NodeBlock::nodesDB->seekp(0);
+            NodeBlock::nodesDB->write(block.data(), block.size());
+            NodeBlock::nodesDB->flush();
         }
-        long src = std::stol(relationBlock->getSource()->id);
-        long dest = std::stol(relationBlock->getDestination()->id);
+        return true;
+    }
 
-        // Insert into adjacency list
-        adjacencyList[src].insert(dest);
+    char stored[sizeof(format)] = {0};
+    if (this->wal) {
+        this->wal->read(WriteAheadLog::NODES, offset, stored, sizeof(stored));
+    } else {
+        NodeBlock::nodesDB->seekg(offset);
+        NodeBlock::nodesDB->read(stored, sizeof(stored));
+        NodeBlock::nodesDB->clear();
     }
-    return adjacencyList;
+    if (memcmp(stored, format, sizeof(format)) != 0) {
+        node_manager_logger.error(this->nodesDBPath + " was written with another node block layout than the " +
+                                  std::to_string(NodeBlock::BLOCK_SIZE) + " byte blocks of this version");
+        return false;
+    }
+    return true;
+}
+
+// Number of relation blocks in the DB, including the ones not committed yet
+long NodeManager::relationCount(bool isLocal) {
+    if (this->wal) {
+        WriteAheadLog::FileId file = isLocal ? WriteAheadLog::RELATIONS : WriteAheadLog::CENTRAL_RELATIONS;
+        return this->wal->size(file) / RelationBlock::BLOCK_SIZE - 1;
+    }
+    return dbSize(isLocal ? this->relationsDBPath : this->centralRelationsDBPath) / RelationBlock::BLOCK_SIZE - 1;
 }
 
 // Get degree map
@@ -526,15 +964,19 @@ std::map<long, long> NodeManager::getDistributionMap() {
 /**
  *
  * When closing the node manager,
- * It closes all the open databases and persist the node index in-memory hash map to node index database
+ * It closes all the open databases and persist the node index in-memory hash map to node index database.
+ * With the write-ahead log the node index is written along with the node blocks, and a checkpoint puts both on disk.
  *
  * **/
 void NodeManager::close() {
-    this->persistNodeIndex();
-    if (PropertyLink::propertiesDB) {
-        PropertyLink::propertiesDB->flush();
-        PropertyLink::propertiesDB->close();
+    if (this->wal) {
+        this->wal->checkpoint();
+    } else {
+        this->persistNodeIndex();
     }
+    this->propertyKeys->flush();
+    this->nodeProperties->flush();
+    this->edgeProperties->flush();
     if (NodeBlock::nodesDB) {
         NodeBlock::nodesDB->flush();
         NodeBlock::nodesDB->close();
@@ -577,3 +1019,4 @@ std::string NodeManager::getDbPrefix() {
 }
 
 const std::string NodeManager::FILE_MODE = "app";  // for appending to existing DB
+const std::string NodeManager::READ_MODE = "read";  // for reading a DB that another store updates
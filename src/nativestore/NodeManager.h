@@ -11,12 +11,20 @@ See the License for the specific language governing permissions and
 limitations under the License.
 **/
 
+#include <atomic>
 #include <fstream>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
+#include "AdjacencySnapshot.h"
 #include "NodeBlock.h"
+#include "NodeIdIndex.h"
+#include "PropertyStore.h"
+#include "RelationCompactor.h"
+#include "WriteAheadLog.h"
 
 #ifndef NODE_MANAGER
 #define NODE_MANAGER
@@ -26,29 +34,88 @@ struct GraphConfig {
     unsigned int graphID;
     unsigned int partitionID;
     std::string openMode;
+    bool numericIds;  // Only decides the ID mode of a new partition, an existing one keeps the mode it was created with
 };
 
+/**
+ * Native store of a graph partition.
+ *
+ * Any number of threads can add edges to the same partition. Each thread needs its own handles to the DB files, which
+ * it gets from attachThread(). Block indexes are allocated atomically, and the relation lists of a vertex are only
+ * changed while holding the lock stripe of the vertex, so adding edges only contends on edges sharing a stripe.
+ *
+ * The node, relation and node index DBs are written through a write-ahead log with group commit. Only one store of a
+ * partition can own its log; another store opened on the same partition, for example to read it for a query, reads
+ * the DBs directly and sees the committed edges. The store that owns the log also compacts the relation DBs.
+ *
+ * A partition either has numeric node IDs, which are kept in the node blocks and indexed by number, or string IDs,
+ * which are kept in the labels or label properties of the nodes and indexed by string.
+ *
+ * The adjacency of the local and the central relations is read once when the store is opened and then updated as
+ * edges are added, so streaming analytics do not read the relation DBs again. Edges added by another store of the
+ * partition are not seen by it.
+ * **/
 class NodeManager {
  private:
-    unsigned int nextNodeIndex = 0;
+    static const int VERTEX_LOCK_STRIPES = 64;
+
+    std::atomic<unsigned int> nextNodeIndex;
+    std::atomic<unsigned int> nextLocalRelationIndex;
+    std::atomic<unsigned int> nextCentralRelationIndex;
     std::fstream* nodeDBT;
     unsigned int graphID = 0;
     unsigned int partitionID = 0;
     std::string dbPrefix;
     static const std::string FILE_MODE;
+    static const std::string READ_MODE;
     unsigned long INDEX_KEY_SIZE = 6;  // Size of an index key entry in bytes
     std::string indexDBPath;
+    bool numericIds;
+    bool readOnly;
     std::unordered_map<std::string, unsigned int> nodeIndex;
+    NodeIdIndex numericNodeIndex;  // The node index of a partition with numeric IDs
+    std::mutex nodeIndexLock;
+    std::mutex vertexLocks[VERTEX_LOCK_STRIPES];
+    PropertyKeys* propertyKeys;
+    PropertyStore* nodeProperties;
+    PropertyStore* edgeProperties;
+    WriteAheadLog* wal;
+    RelationCompactor* compactor;
+    AdjacencySnapshot* localAdjacency;
+    AdjacencySnapshot* centralAdjacency;
+    long loadedRelations[2];  // Central and local relations in the snapshots of a read-only store
+    bool incompatible;  // The DBs have another block layout, so no nodes or relations are read or added
+    std::mutex refreshLock;
+    std::string nodesDBPath;
+    std::string relationsDBPath;
+    std::string centralRelationsDBPath;
+    std::vector<std::fstream*> threadFiles;  // Handles opened by attachThread(), guarded by nodeIndexLock
+    static thread_local NodeManager* attachedManager;
 
     void persistNodeIndex();
     std::unordered_map<std::string, unsigned int> readNodeIndex();
+    void readNumericNodeIndex();
+    std::unordered_map<std::string, unsigned int> copyNodeIndex();
     void addNodeIndex(std::string nodeId, unsigned int nodeIndex);
+    void addNodeIndex(unsigned long nodeId, unsigned int nodeIndex);
+    void setThreadHandles(std::fstream* nodesDB, std::fstream* relationsDB, std::fstream* centralRelationsDB);
+    std::mutex& vertexLock(unsigned long nodeId);
+    template <typename ID>
+    RelationBlock* addEdge(const std::pair<ID, ID>& edge, bool isLocal);
+    NodeBlock* addNode(unsigned long nodeId);
+    NodeBlock* readNode(const std::string& nodeId, unsigned int nodeIndex);
+    std::vector<NodeBlock*> getIndexedNodes(size_t limit);
+    std::fstream* openDB(const std::string& path, WriteAheadLog::FileId file, std::ios_base::openmode openMode);
+    long relationCount(bool isLocal);
+    bool checkNodeFormat();
+    bool checkRelationFormat(bool isLocal);
+    void loadAdjacency(bool isLocal);
 
  public:
     static unsigned int nextPropertyIndex;  // Next available property block index
 
     NodeManager(GraphConfig);
-    ~NodeManager() { delete NodeBlock::nodesDB; };
+    ~NodeManager();
 
     void setIndexKeySize(unsigned long);
     static int dbSize(std::string path);
@@ -56,15 +123,29 @@ class NodeManager {
     int getPartitionID();
     std::string getDbPrefix();
     void close();
+    // Opens the DB files for the calling thread, which can then add and read edges concurrently with other threads
+    void attachThread();
+    // Null if the DBs are used directly. Updates that must be committed together run in one WriteAheadLog::Operation.
+    WriteAheadLog* getWriteAheadLog() { return wal; }
+    AdjacencySnapshot* getAdjacencySnapshot(bool isLocal) { return isLocal ? localAdjacency : centralAdjacency; }
+    // Adds the relations that the store owning the partition added since the last refresh to the snapshots of a
+    // read-only store
+    void refreshAdjacency();
+    bool hasNumericIds() { return numericIds; }
 
     RelationBlock* addLocalEdge(std::pair<std::string, std::string>);
     RelationBlock* addCentralEdge(std::pair<std::string, std::string> edge);
+    // Add edges by numeric node IDs, which a partition with numeric IDs takes without converting them
+    RelationBlock* addLocalEdge(std::pair<unsigned long, unsigned long> edge);
+    RelationBlock* addCentralEdge(std::pair<unsigned long, unsigned long> edge);
 
     RelationBlock* addLocalRelation(NodeBlock, NodeBlock);
     RelationBlock* addCentralRelation(NodeBlock source, NodeBlock destination);
 
     NodeBlock* addNode(std::string);  // will return DB block address
+    void addNodeProperties(NodeBlock* node, const std::map<std::string, std::string>& properties);
     NodeBlock* get(std::string);
+    NodeBlock* get(unsigned long nodeId);
 
     std::list<NodeBlock*> getCentralGraph();
     std::list<NodeBlock> getLimitedGraph(int limit = 10);
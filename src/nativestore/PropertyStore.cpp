@@ -0,0 +1,432 @@
+/**
+Copyright 2024 JasmineGraph Team
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+**/
+
+#include "PropertyStore.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <thread>
+
+#include "../performance/metrics/MetricsRegistry.h"
+#include "../util/logger/Logger.h"
+
+Logger property_store_logger;
+
+static const char PROPERTY_STORE_MAGIC[4] = {'J', 'G', 'P', 'S'};
+static const unsigned int PROPERTY_STORE_VERSION = 1;
+
+thread_local PropertyStore *PropertyStore::nodeProperties = NULL;
+thread_local PropertyStore *PropertyStore::edgeProperties = NULL;
+
+static int openStoreFile(const std::string &path, std::ios_base::openmode openMode) {
+    int flags = O_RDWR | O_CREAT;
+    if (openMode & std::ios::trunc) {
+        flags |= O_TRUNC;
+    }
+    int fd = open(path.c_str(), flags, 0644);
+    if (fd < 0) {
+        property_store_logger.error("Cannot open " + path + ": " + strerror(errno));
+    }
+    return fd;
+}
+
+// Reads up to length bytes at the offset. Returns the number of bytes read, which is short only at the end of the file,
+// or -1 on error.
+static ssize_t preadFully(int fd, char *buffer, size_t length, off_t offset) {
+    size_t done = 0;
+    while (done < length) {
+        ssize_t n = pread(fd, buffer + done, length - done, offset + done);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        if (n == 0) {
+            break;
+        }
+        done += n;
+    }
+    return done;
+}
+
+static bool pwriteFully(int fd, const char *buffer, size_t length, off_t offset) {
+    size_t done = 0;
+    while (done < length) {
+        ssize_t n = pwrite(fd, buffer + done, length - done, offset + done);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        done += n;
+    }
+    return true;
+}
+
+static long fileSizeOf(int fd) {
+    struct stat stat_buf;
+    if (fd < 0 || fstat(fd, &stat_buf) != 0) {
+        return -1;
+    }
+    return stat_buf.st_size;
+}
+
+PropertyKeys::PropertyKeys(const std::string &path, std::ios_base::openmode openMode) : fileSize(0) {
+    pthread_rwlock_init(&this->namesLock, NULL);
+    this->fd = openStoreFile(path, openMode);
+    long size = fileSizeOf(this->fd);
+    if (size <= 0) {
+        return;
+    }
+    std::string data(size, '\0');
+    if (preadFully(this->fd, &data[0], size, 0) != size) {
+        property_store_logger.error("Error while reading the property keys DB " + path);
+        return;
+    }
+    size_t position = 0;
+    while (position + sizeof(unsigned short) <= data.size()) {
+        unsigned short length;
+        memcpy(&length, &data[position], sizeof(length));
+        if (position + sizeof(length) + length > data.size()) {
+            break;
+        }
+        std::string name = data.substr(position + sizeof(length), length);
+        position += sizeof(length) + length;
+        this->names.push_back(name);
+        this->ids[name] = this->names.size();
+    }
+    if (position != data.size()) {
+        property_store_logger.error("Truncated property key " + std::to_string(this->names.size() + 1) + " in " +
+                                    path);
+    }
+    // New keys overwrite a truncated entry
+    this->fileSize = position;
+}
+
+PropertyKeys::~PropertyKeys() {
+    if (this->fd >= 0) {
+        close(this->fd);
+    }
+    pthread_rwlock_destroy(&this->namesLock);
+}
+
+unsigned int PropertyKeys::find(const std::string &name) {
+    pthread_rwlock_rdlock(&this->namesLock);
+    auto it = this->ids.find(name);
+    unsigned int id = it == this->ids.end() ? 0 : it->second;
+    pthread_rwlock_unlock(&this->namesLock);
+    return id;
+}
+
+unsigned int PropertyKeys::intern(const std::string &name) {
+    unsigned int id = this->find(name);
+    if (id) {
+        return id;
+    }
+    if (name.length() > PropertyKeys::MAX_NAME_SIZE) {
+        property_store_logger.error("Property name is longer than " + std::to_string(PropertyKeys::MAX_NAME_SIZE) +
+                                    " bytes");
+        return 0;
+    }
+    pthread_rwlock_wrlock(&this->namesLock);
+    auto it = this->ids.find(name);  // Another writer may have added it
+    if (it != this->ids.end()) {
+        id = it->second;
+        pthread_rwlock_unlock(&this->namesLock);
+        return id;
+    }
+    unsigned short length = name.length();
+    std::string entry(reinterpret_cast<char *>(&length), sizeof(length));
+    entry.append(name);
+    if (!pwriteFully(this->fd, entry.data(), entry.size(), this->fileSize)) {
+        pthread_rwlock_unlock(&this->namesLock);
+        property_store_logger.error("Error while adding the property key " + name);
+        return 0;
+    }
+    this->fileSize += entry.size();
+    this->names.push_back(name);
+    id = this->names.size();
+    this->ids[name] = id;
+    pthread_rwlock_unlock(&this->namesLock);
+    return id;
+}
+
+std::string PropertyKeys::name(unsigned int id) {
+    std::string name;
+    pthread_rwlock_rdlock(&this->namesLock);
+    if (id > 0 && id <= this->names.size()) {
+        name = this->names[id - 1];
+    }
+    pthread_rwlock_unlock(&this->namesLock);
+    return name;
+}
+
+unsigned int PropertyKeys::size() {
+    pthread_rwlock_rdlock(&this->namesLock);
+    unsigned int size = this->names.size();
+    pthread_rwlock_unlock(&this->namesLock);
+    return size;
+}
+
+void PropertyKeys::flush() {
+    if (this->fd >= 0) {
+        fdatasync(this->fd);
+    }
+}
+
+PropertyStore::PropertyStore(const std::string &path, std::ios_base::openmode openMode, PropertyKeys *keys)
+    : path(path), keys(keys), nextAddress(PropertyStore::HEADER_SIZE), writeSequence(0) {
+    this->fd = openStoreFile(path, openMode);
+    long size = fileSizeOf(this->fd);
+    if (size < 0) {
+        return;
+    }
+    if (size == 0) {
+        char header[PropertyStore::HEADER_SIZE];
+        memcpy(header, PROPERTY_STORE_MAGIC, sizeof(PROPERTY_STORE_MAGIC));
+        memcpy(header + sizeof(PROPERTY_STORE_MAGIC), &PROPERTY_STORE_VERSION, sizeof(PROPERTY_STORE_VERSION));
+        if (!pwriteFully(this->fd, header, sizeof(header), 0)) {
+            property_store_logger.error("Error while writing the header of " + path);
+        }
+        return;
+    }
+    char header[PropertyStore::HEADER_SIZE] = {0};
+    if (preadFully(this->fd, header, sizeof(header), 0) != sizeof(header) ||
+        memcmp(header, PROPERTY_STORE_MAGIC, sizeof(PROPERTY_STORE_MAGIC)) != 0) {
+        property_store_logger.error(path + " is not a property store DB");
+    }
+    this->nextAddress = size;
+}
+
+PropertyStore::~PropertyStore() {
+    if (this->fd >= 0) {
+        close(this->fd);
+    }
+}
+
+bool PropertyStore::readRecordData(unsigned int address, std::string &data, unsigned int &capacity) {
+    if (address < PropertyStore::HEADER_SIZE || address >= this->nextAddress.load()) {
+        property_store_logger.error("Invalid property record address " + std::to_string(address) + " in " + path);
+        return false;
+    }
+    // Most records fit in the read ahead, so they take a single read
+    data.resize(PropertyStore::READ_AHEAD);
+    ssize_t got = preadFully(this->fd, &data[0], data.size(), address);
+    if (got < (ssize_t)PropertyStore::RECORD_HEADER_SIZE) {
+        return false;
+    }
+    unsigned int length;
+    memcpy(&capacity, &data[0], sizeof(capacity));
+    memcpy(&length, &data[sizeof(capacity)], sizeof(length));
+    size_t recordSize = PropertyStore::RECORD_HEADER_SIZE + length;
+    if (length > capacity || address + recordSize > this->nextAddress.load()) {
+        return false;
+    }
+    if (recordSize > (size_t)got) {
+        data.resize(recordSize);
+        if (preadFully(this->fd, &data[got], recordSize - got, address + got) != (ssize_t)(recordSize - got)) {
+            return false;
+        }
+    }
+    data.resize(recordSize);
+    return true;
+}
+
+bool PropertyStore::readRecord(unsigned int address, Record &record, unsigned int &capacity) {
+    static Counter &propertyReads = MetricsRegistry::counter(
+        "jasminegraph_nativestore_block_reads_total", "Blocks read from the native store", {{"block", "property"}});
+    propertyReads.inc();
+    std::string data;
+    bool read;
+    while (true) {
+        unsigned long sequence = this->writeSequence.load(std::memory_order_acquire);
+        if (sequence & 1) {
+            std::this_thread::yield();
+            continue;
+        }
+        read = this->readRecordData(address, data, capacity);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (this->writeSequence.load(std::memory_order_relaxed) == sequence) {
+            break;
+        }
+    }
+    if (!read) {
+        property_store_logger.error("Error while reading the property record at " + std::to_string(address) + " in " +
+                                    path);
+        return false;
+    }
+
+    record.clear();
+    size_t position = PropertyStore::RECORD_HEADER_SIZE;
+    while (position + 2 * sizeof(unsigned int) <= data.size()) {
+        unsigned int keyId;
+        unsigned int valueLength;
+        memcpy(&keyId, &data[position], sizeof(keyId));
+        memcpy(&valueLength, &data[position + sizeof(keyId)], sizeof(valueLength));
+        position += 2 * sizeof(unsigned int);
+        if (position + valueLength > data.size()) {
+            break;
+        }
+        record.push_back({keyId, data.substr(position, valueLength)});
+        position += valueLength;
+    }
+    if (position != data.size()) {
+        property_store_logger.error("Corrupted property record at " + std::to_string(address) + " in " + path);
+        return false;
+    }
+    return true;
+}
+
+// Must be called with the write lock held
+unsigned int PropertyStore::writeRecord(unsigned int address, unsigned int capacity, const Record &record) {
+    static Counter &propertyWrites = MetricsRegistry::counter(
+        "jasminegraph_nativestore_block_writes_total", "Blocks written to the native store", {{"block", "property"}});
+    propertyWrites.inc();
+    unsigned long length = 0;
+    for (auto &property : record) {
+        length += 2 * sizeof(unsigned int) + property.second.length();
+    }
+    unsigned long endAddress = this->nextAddress.load();
+    bool append = address == 0 || length > capacity;
+    if (append) {
+        // Grow by doubling so that an entity gaining properties one by one is moved O(log n) times
+        unsigned long newCapacity = std::max<unsigned long>(PropertyStore::MIN_CAPACITY, 2UL * capacity);
+        while (newCapacity < length) {
+            newCapacity *= 2;
+        }
+        if (endAddress + PropertyStore::RECORD_HEADER_SIZE + newCapacity > UINT_MAX) {
+            property_store_logger.error("Property store " + path + " is full");
+            return 0;
+        }
+        address = endAddress;
+        capacity = newCapacity;
+    }
+
+    std::string data;
+    data.reserve(PropertyStore::RECORD_HEADER_SIZE + capacity);
+    unsigned int length32 = length;
+    data.append(reinterpret_cast<const char *>(&capacity), sizeof(capacity));
+    data.append(reinterpret_cast<const char *>(&length32), sizeof(length32));
+    for (auto &property : record) {
+        unsigned int valueLength = property.second.length();
+        data.append(reinterpret_cast<const char *>(&property.first), sizeof(property.first));
+        data.append(reinterpret_cast<const char *>(&valueLength), sizeof(valueLength));
+        data.append(property.second);
+    }
+    if (append) {
+        // Reserve the whole capacity on disk. Nobody reads an appended record before its address is returned.
+        data.resize(PropertyStore::RECORD_HEADER_SIZE + capacity, '\0');
+        if (!pwriteFully(this->fd, data.data(), data.size(), address)) {
+            property_store_logger.error("Error while writing the property record at " + std::to_string(address) +
+                                        " in " + path);
+            return 0;
+        }
+        this->nextAddress = endAddress + data.size();
+        return address;
+    }
+
+    this->writeSequence.fetch_add(1, std::memory_order_acq_rel);
+    bool written = pwriteFully(this->fd, data.data(), data.size(), address);
+    this->writeSequence.fetch_add(1, std::memory_order_release);
+    if (!written) {
+        property_store_logger.error("Error while writing the property record at " + std::to_string(address) + " in " +
+                                    path);
+        return 0;
+    }
+    return address;
+}
+
+unsigned int PropertyStore::put(unsigned int address, const std::string &name, const std::string &value) {
+    return this->putAll(address, {{name, value}});
+}
+
+unsigned int PropertyStore::putAll(unsigned int address, const std::map<std::string, std::string> &properties) {
+    // Key IDs are interned outside the write lock of the store, the dictionary has its own
+    std::vector<std::pair<unsigned int, const std::string *>> updates;
+    for (auto &property : properties) {
+        unsigned int keyId = this->keys->intern(property.first);
+        if (!keyId) {
+            return 0;
+        }
+        updates.push_back({keyId, &property.second});
+    }
+
+    std::lock_guard<std::mutex> guard(this->writeLock);
+    Record record;
+    unsigned int capacity = 0;
+    if (address && !this->readRecord(address, record, capacity)) {
+        return 0;
+    }
+    for (auto &update : updates) {
+        bool replaced = false;
+        for (auto &existing : record) {
+            if (existing.first == update.first) {
+                existing.second = *update.second;
+                replaced = true;
+                break;
+            }
+        }
+        if (!replaced) {
+            record.push_back({update.first, *update.second});
+        }
+    }
+    return this->writeRecord(address, capacity, record);
+}
+
+bool PropertyStore::readAll(unsigned int address, std::map<std::string, std::string> &properties) {
+    if (address == 0) {
+        return true;
+    }
+    Record record;
+    unsigned int capacity;
+    if (!this->readRecord(address, record, capacity)) {
+        return false;
+    }
+    for (auto &property : record) {
+        properties[this->keys->name(property.first)] = property.second;
+    }
+    return true;
+}
+
+bool PropertyStore::get(unsigned int address, const std::string &name, std::string &value) {
+    unsigned int keyId = this->keys->find(name);
+    if (address == 0 || keyId == 0) {
+        return false;
+    }
+    Record record;
+    unsigned int capacity;
+    if (!this->readRecord(address, record, capacity)) {
+        return false;
+    }
+    for (auto &property : record) {
+        if (property.first == keyId) {
+            value = property.second;
+            return true;
+        }
+    }
+    return false;
+}
+
+void PropertyStore::flush() {
+    if (this->fd >= 0) {
+        fdatasync(this->fd);
+    }
+}
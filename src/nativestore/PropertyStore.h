@@ -0,0 +1,116 @@
+/**
+Copyright 2024 JasmineGraph Team
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+**/
+
+#include <pthread.h>
+
+#include <atomic>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#ifndef JASMINEGRAPH_PROPERTYSTORE_H
+#define JASMINEGRAPH_PROPERTYSTORE_H
+
+/**
+ * Dictionary of property names of a partition.
+ *
+ * Every property name is stored once in the keys DB and referred to by its ID everywhere else. The DB is a sequence of
+ * (length, name) entries and the ID of a name is its position in the file starting from 1, so 0 means "no key".
+ * Lookups share a read lock and only adding a new name takes the write lock.
+ * **/
+class PropertyKeys {
+ public:
+    static const unsigned long MAX_NAME_SIZE = 0xFFFF;
+
+    PropertyKeys(const std::string &path, std::ios_base::openmode openMode);
+    ~PropertyKeys();
+
+    // Returns the ID of the name, adding it to the dictionary if it is new. Returns 0 on failure.
+    unsigned int intern(const std::string &name);
+    // Returns the ID of the name or 0 if it is not in the dictionary
+    unsigned int find(const std::string &name);
+    std::string name(unsigned int id);
+    unsigned int size();
+    void flush();
+
+ private:
+    int fd;
+    unsigned long fileSize;
+    pthread_rwlock_t namesLock;
+    std::vector<std::string> names;
+    std::unordered_map<std::string, unsigned int> ids;
+};
+
+/**
+ * Variable length property records of the nodes or of the relations of a partition.
+ *
+ * All properties of an entity are kept together in one record, so they are read with a single I/O:
+ *
+ *     | capacity (4) | length (4) | key ID (4) | value length (4) | value | key ID (4) | ... |
+ *
+ * The address of a record is its byte offset in the DB. The DB starts with a header so that address 0 means "no
+ * properties", as for the other references of the native store. A record is rewritten in place while it fits in its
+ * capacity and is otherwise moved to the end of the DB with twice the capacity, so callers must store the address
+ * returned by the write methods.
+ *
+ * Records are read with pread() and written with pwrite(), so there is no shared file cursor and a store can be used
+ * by any number of threads. Writers of a store are serialised by its own mutex. Readers take no lock; they check a
+ * sequence number that writers bump before and after each write and read again if a write overlapped.
+ * **/
+class PropertyStore {
+ public:
+    typedef std::vector<std::pair<unsigned int, std::string>> Record;  // (key ID, value) pairs
+
+    static const unsigned int HEADER_SIZE = 8;
+    static const unsigned int RECORD_HEADER_SIZE = 2 * sizeof(unsigned int);
+    static const unsigned int MIN_CAPACITY = 64;
+    static const unsigned int READ_AHEAD = 512;  // Bytes read for a record before its length is known
+
+    static thread_local PropertyStore *nodeProperties;
+    static thread_local PropertyStore *edgeProperties;
+
+    PropertyStore(const std::string &path, std::ios_base::openmode openMode, PropertyKeys *keys);
+    ~PropertyStore();
+
+    // Adds or replaces properties of the record at the address (0 for a new record). Returns the address of the
+    // record, which changes when it has to grow, or 0 on failure.
+    unsigned int put(unsigned int address, const std::string &name, const std::string &value);
+    unsigned int putAll(unsigned int address, const std::map<std::string, std::string> &properties);
+
+    // Reads all properties of the record at the address
+    bool readAll(unsigned int address, std::map<std::string, std::string> &properties);
+    // Reads one property. Returns false if the record does not have it.
+    bool get(unsigned int address, const std::string &name, std::string &value);
+
+    PropertyKeys *getKeys() { return keys; }
+    // Syncs the written records to the disk
+    void flush();
+
+ private:
+    std::string path;
+    int fd;
+    PropertyKeys *keys;
+    std::mutex writeLock;
+    std::atomic<unsigned long> nextAddress;
+    std::atomic<unsigned long> writeSequence;  // Odd while a record is being written
+
+    bool readRecordData(unsigned int address, std::string &data, unsigned int &capacity);
+    bool readRecord(unsigned int address, Record &record, unsigned int &capacity);
+    unsigned int writeRecord(unsigned int address, unsigned int capacity, const Record &record);
+};
+
+#endif  // JASMINEGRAPH_PROPERTYSTORE_H
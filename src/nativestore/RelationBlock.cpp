@@ -13,16 +13,21 @@ limitations under the License.
 
 #include "RelationBlock.h"
 
+#include <chrono>
 #include <sstream>
 #include <vector>
 
+#include "../performance/metrics/MetricsRegistry.h"
 #include "../util/logger/Logger.h"
 #include "NodeManager.h"
 
 Logger relation_block_logger;
-pthread_mutex_t lockAddProperty;
 
 RelationBlock* RelationBlock::addLocalRelation(NodeBlock source, NodeBlock destination) {
+    static Counter &relationWrites = MetricsRegistry::counter("jasminegraph_nativestore_block_writes_total",
+                                                              "Blocks written to the native store",
+                                                              {{"block", "local_relation"}});
+    relationWrites.inc();
     int RECORD_SIZE = sizeof(unsigned int);
 
     NodeRelation sourceData;
@@ -33,8 +38,8 @@ RelationBlock* RelationBlock::addLocalRelation(NodeBlock source, NodeBlock desti
 
     //    unsigned int relationPropAddr = this;
 
-    long relationBlockAddress = RelationBlock::nextLocalRelationIndex *
-            RelationBlock::BLOCK_SIZE;  // Block size is 4 * 13
+    long relationBlockAddress = RelationBlock::nextLocalRelationIndex->fetch_add(1) *
+            RelationBlock::BLOCK_SIZE;  // Block size is 4 * 14
 
     RelationBlock::relationsDB->seekg(relationBlockAddress);
     if (!RelationBlock::relationsDB->write(reinterpret_cast<char*>(&source.nodeId), RECORD_SIZE)) {
@@ -125,12 +130,24 @@ RelationBlock* RelationBlock::addLocalRelation(NodeBlock source, NodeBlock desti
         return NULL;
     }
 
-    RelationBlock::nextLocalRelationIndex += 1;
+    unsigned int ingestTime = std::chrono::duration_cast<std::chrono::seconds>(
+                                  std::chrono::system_clock::now().time_since_epoch()).count();
+    if (!RelationBlock::relationsDB->write(reinterpret_cast<char*>(&ingestTime), RECORD_SIZE)) {
+        relation_block_logger.error("ERROR: Error while writing relation ingest time into relation block address " +
+                                    std::to_string(relationBlockAddress));
+        return NULL;
+    }
+
     RelationBlock::relationsDB->flush();
-    return new RelationBlock(relationBlockAddress, sourceData, destinationData, this->propertyAddress);
+    return new RelationBlock(relationBlockAddress, sourceData, destinationData, this->propertyAddress,
+                             ingestTime);
 }
 
 RelationBlock* RelationBlock::addCentralRelation(NodeBlock source, NodeBlock destination) {
+    static Counter &relationWrites = MetricsRegistry::counter("jasminegraph_nativestore_block_writes_total",
+                                                              "Blocks written to the native store",
+                                                              {{"block", "central_relation"}});
+    relationWrites.inc();
     relation_block_logger.debug("Writing central relation with source " + std::to_string(source.nodeId) +
                                " and destination " + std::to_string(destination.nodeId));
     int RECORD_SIZE = sizeof(unsigned int);
@@ -142,7 +159,7 @@ RelationBlock* RelationBlock::addCentralRelation(NodeBlock source, NodeBlock des
     destinationData.address = destination.addr;
 
     long relationBlockAddress =
-        RelationBlock::nextCentralRelationIndex * RelationBlock::BLOCK_SIZE;  // Block size is 4 * 11
+        RelationBlock::nextCentralRelationIndex->fetch_add(1) * RelationBlock::BLOCK_SIZE;  // Block size is 4 * 14
     RelationBlock::centralRelationsDB->seekg(relationBlockAddress);
     if (!RelationBlock::centralRelationsDB->write(reinterpret_cast<char*>(&source.nodeId), RECORD_SIZE)) {
         relation_block_logger.error("ERROR: Error while writing  sourceAddr " + std::to_string(source.nodeId) +
@@ -234,16 +251,28 @@ RelationBlock* RelationBlock::addCentralRelation(NodeBlock source, NodeBlock des
         return NULL;
     }
 
-    RelationBlock::nextCentralRelationIndex += 1;
+    unsigned int ingestTime = std::chrono::duration_cast<std::chrono::seconds>(
+                                  std::chrono::system_clock::now().time_since_epoch()).count();
+    if (!RelationBlock::centralRelationsDB->write(reinterpret_cast<char*>(&ingestTime), RECORD_SIZE)) {
+        relation_block_logger.error("ERROR: Error while writing relation ingest time into relation block address " +
+                                    std::to_string(relationBlockAddress));
+        return NULL;
+    }
+
     RelationBlock::centralRelationsDB->flush();
-    return new RelationBlock(relationBlockAddress, sourceData, destinationData, this->propertyAddress);
+    return new RelationBlock(relationBlockAddress, sourceData, destinationData, this->propertyAddress,
+                             ingestTime);
 }
 
 RelationBlock* RelationBlock::getLocalRelation(unsigned int address) {
+    static Counter &relationReads = MetricsRegistry::counter("jasminegraph_nativestore_block_reads_total",
+                                                             "Blocks read from the native store",
+                                                             {{"block", "local_relation"}});
     int RECORD_SIZE = sizeof(unsigned int);
     if (address == 0) {
         return NULL;
     }
+    relationReads.inc();
     if (address % RelationBlock::BLOCK_SIZE != 0) {
         relation_block_logger.error("Exception: Invalid relation block address !!\n received address = " + address);
         return NULL;
@@ -344,14 +373,27 @@ RelationBlock* RelationBlock::getLocalRelation(unsigned int address) {
         return NULL;
     }
 
-    return new RelationBlock(address, source, destination, propertyReference);
+    unsigned int ingestTime;
+    if (!RelationBlock::relationsDB->read(reinterpret_cast<char*>(&ingestTime),
+                                          RECORD_SIZE)) {  // < ------ relation data offset ID = 13
+        relation_block_logger.error(
+            "ERROR: Error while reading local relation ingest time data "
+            "offset ID = 13 from relation block address " + std::to_string(address));
+        return NULL;
+    }
+
+    return new RelationBlock(address, source, destination, propertyReference, ingestTime);
 }
 
 RelationBlock* RelationBlock::getCentralRelation(unsigned int address) {
+    static Counter &relationReads = MetricsRegistry::counter("jasminegraph_nativestore_block_reads_total",
+                                                             "Blocks read from the native store",
+                                                             {{"block", "central_relation"}});
     int RECORD_SIZE = sizeof(unsigned int);
     if (address == 0) {
         return NULL;
     }
+    relationReads.inc();
     if (address % RelationBlock::BLOCK_SIZE != 0) {
         relation_block_logger.error("Exception: Invalid relation block address !!\n received address = " + address);
         return NULL;
@@ -453,7 +495,16 @@ RelationBlock* RelationBlock::getCentralRelation(unsigned int address) {
         return NULL;
     }
 
-    return new RelationBlock(address, source, destination, propertyReference);
+    unsigned int ingestTime;
+    if (!RelationBlock::centralRelationsDB->read(reinterpret_cast<char*>(&ingestTime),
+                                                 RECORD_SIZE)) {  // < ------ relation data offset ID = 13
+        relation_block_logger.error(
+            "ERROR: Error while reading central relation ingest time data offset ID = 13 from "
+            "relation block address " + std::to_string(address));
+        return NULL;
+    }
+
+    return new RelationBlock(address, source, destination, propertyReference, ingestTime);
 }
 
 RelationBlock* RelationBlock::nextLocalSource() {
@@ -609,57 +660,61 @@ bool RelationBlock::updateCentralRelationRecords(RelationOffsets recordOffset, u
 }
 
 bool RelationBlock::isInUse() { return this->usage == '\1'; }
-thread_local unsigned int RelationBlock::nextLocalRelationIndex =
-        1;  // Starting with 1 because of the 0 and '\0' differentiation issue
-thread_local unsigned int RelationBlock::nextCentralRelationIndex =
-    1;  // Starting with 1 because of the 0 and '\0' differentiation issue
-
-
-void RelationBlock::addLocalProperty(std::string name, char* value) {
-    if (this->propertyAddress == 0) {
-        PropertyEdgeLink* newLink = PropertyEdgeLink::create(name, value);
-        if (newLink) {
-            this->propertyAddress = newLink->blockAddress;
-            // If it was an empty prop link before inserting, Then update the property reference of this node
-            // block
-            this->updateLocalRelationRecords(RelationOffsets::RELATION_PROPS, this->propertyAddress);
-        } else {
-            relation_block_logger.error("Error occurred while adding a new property link to " +
-                    std::to_string(this->addr) + " node block");
-        }
-    } else {
-        this->propertyAddress = this->getPropertyHead()->insert(name, value);
+// Shared by the threads writing to a partition. Indexes start with 1 because of the 0 and '\0' differentiation issue.
+thread_local std::atomic<unsigned int>* RelationBlock::nextLocalRelationIndex = NULL;
+thread_local std::atomic<unsigned int>* RelationBlock::nextCentralRelationIndex = NULL;
+
+
+void RelationBlock::addLocalProperty(std::string name, const std::string& value) {
+    this->addLocalProperties({{name, value}});
+}
+
+void RelationBlock::addCentralProperty(std::string name, const std::string& value) {
+    this->addCentralProperties({{name, value}});
+}
+
+/**
+ * Write the properties to the property record of the relation in one go. The record moves when it grows, in which
+ * case the property reference of this relation block is updated.
+ * */
+bool RelationBlock::addLocalProperties(const std::map<std::string, std::string>& properties) {
+    unsigned int newAddress = PropertyStore::edgeProperties->putAll(this->propertyAddress, properties);
+    if (newAddress == 0) {
+        relation_block_logger.error("Error occurred while adding properties to relation block " +
+                                    std::to_string(this->addr));
+        return false;
     }
+    if (newAddress != this->propertyAddress) {
+        this->propertyAddress = newAddress;
+        return this->updateLocalRelationRecords(RelationOffsets::RELATION_PROPS, this->propertyAddress);
+    }
+    return true;
 }
-void RelationBlock::addCentralProperty(std::string name, char* value) {
-    if (this->propertyAddress == 0) {
-        PropertyEdgeLink* newLink = PropertyEdgeLink::create(name, value);
-        if (newLink) {
-            this->propertyAddress = newLink->blockAddress;
-            // If it was an empty prop link before inserting, Then update the property reference of this node
-            // block
-            this->updateCentralRelationRecords(RelationOffsets::RELATION_PROPS, this->propertyAddress);
-        } else {
-            relation_block_logger.error("Error occurred while adding a new property link to " +
-                    std::to_string(this->addr) + " node block");
-        }
-    } else {
-        this->propertyAddress = this->getPropertyHead()->insert(name, value);
+
+bool RelationBlock::addCentralProperties(const std::map<std::string, std::string>& properties) {
+    unsigned int newAddress = PropertyStore::edgeProperties->putAll(this->propertyAddress, properties);
+    if (newAddress == 0) {
+        relation_block_logger.error("Error occurred while adding properties to central relation block " +
+                                    std::to_string(this->addr));
+        return false;
+    }
+    if (newAddress != this->propertyAddress) {
+        this->propertyAddress = newAddress;
+        return this->updateCentralRelationRecords(RelationOffsets::RELATION_PROPS, this->propertyAddress);
     }
+    return true;
 }
 
-PropertyEdgeLink* RelationBlock::getPropertyHead() { return PropertyEdgeLink::get(this->propertyAddress); }
+bool RelationBlock::getProperty(const std::string& name, std::string& value) {
+    return PropertyStore::edgeProperties->get(this->propertyAddress, name, value);
+}
 
-std::map<std::string, char*> RelationBlock::getAllProperties() {
-    std::map<std::string, char*> allProperties;
-    PropertyEdgeLink* current = this->getPropertyHead();
-    while (current) {
-        allProperties.insert({current->name, current->value});
-        PropertyEdgeLink* temp = current->next();
-        delete current;  // To prevent memory leaks
-        current = temp;
+std::map<std::string, std::string> RelationBlock::getAllProperties() {
+    std::map<std::string, std::string> allProperties;
+    if (!PropertyStore::edgeProperties->readAll(this->propertyAddress, allProperties)) {
+        relation_block_logger.error("Error while reading the properties of relation block " +
+                                    std::to_string(this->addr));
     }
-    delete current;
     return allProperties;
 }
 
@@ -687,7 +742,7 @@ NodeBlock* RelationBlock::getDestination() {
     return NULL;
 }
 
-thread_local const unsigned long RelationBlock::BLOCK_SIZE = RelationBlock::RECORD_SIZE * 13;
+thread_local const unsigned long RelationBlock::BLOCK_SIZE = RelationBlock::RECORD_SIZE * 14;
 // One relation block holds 11 recods such as source addres, destination address, source next relation address etc.
 // and one record is typically 4 bytes (size of unsigned int)
 thread_local std::fstream* RelationBlock::relationsDB = NULL;
@@ -11,13 +11,14 @@ See the License for the specific language governing permissions and
 limitations under the License.
 **/
 
+#include <atomic>
 #include <cstring>
 #include <fstream>
 #include <set>
 #include <string>
 
 #include "NodeBlock.h"
-#include "PropertyEdgeLink.h"
+#include "PropertyStore.h"
 
 #ifndef RELATION_BLOCK
 #define RELATION_BLOCK
@@ -43,6 +44,7 @@ enum class RelationOffsets : int {
     DESTINATION_PREVIOUS = 10,
     DESTINATION_PREVIOUS_PID = 11,
     RELATION_PROPS = 12,
+    INGEST_TIME = 13,
 };
 
 /**
@@ -69,8 +71,13 @@ class RelationBlock {
         this->destinationBlock = &destination;
     }
 
-    RelationBlock(unsigned int addr, NodeRelation source, NodeRelation destination, unsigned int propertyAddress)
-        : addr(addr), source(source), destination(destination), propertyAddress(propertyAddress){
+    RelationBlock(unsigned int addr, NodeRelation source, NodeRelation destination, unsigned int propertyAddress,
+                  unsigned int ingestTime = 0)
+        : addr(addr),
+          source(source),
+          destination(destination),
+          propertyAddress(propertyAddress),
+          ingestTime(ingestTime) {
         this->sourceBlock = NodeBlock::get(source.address);
         this->destinationBlock = NodeBlock::get(destination.address);
     };
@@ -79,10 +86,10 @@ class RelationBlock {
     unsigned int addr = 0;  // Block size * block ID for this block
     NodeRelation source;
     NodeRelation destination;
-    unsigned int propertyAddress = 0;
-    PropertyEdgeLink *propertyHead = NULL;
-    static thread_local unsigned int nextLocalRelationIndex;
-    static thread_local unsigned int nextCentralRelationIndex;
+    unsigned int propertyAddress = 0;  // Address of the property record of the relation in the edge property store
+    unsigned int ingestTime = 0;  // When the relation was added, in seconds since the Unix epoch
+    static thread_local std::atomic<unsigned int> *nextLocalRelationIndex;
+    static thread_local std::atomic<unsigned int> *nextCentralRelationIndex;
     static thread_local const unsigned long BLOCK_SIZE;  // Size of a relation record block in bytes
     static thread_local std::string DB_PATH;
     static thread_local std::fstream *relationsDB;
@@ -129,11 +136,13 @@ class RelationBlock {
     static RelationBlock *getLocalRelation(unsigned int);
     static RelationBlock *getCentralRelation(unsigned int address);
 
-    void addLocalProperty(std::string, char *);
-    void addCentralProperty(std::string name, char *value);
+    void addLocalProperty(std::string, const std::string &);
+    void addCentralProperty(std::string name, const std::string &value);
+    bool addLocalProperties(const std::map<std::string, std::string> &);
+    bool addCentralProperties(const std::map<std::string, std::string> &properties);
 
-    PropertyEdgeLink *getPropertyHead();
-    std::map<std::string, char *> getAllProperties();
+    bool getProperty(const std::string &, std::string &);
+    std::map<std::string, std::string> getAllProperties();
 };
 
 #endif
@@ -0,0 +1,133 @@
+/**
+Copyright 2024 JasmineGraph Team
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+**/
+
+#include "RelationCompactor.h"
+
+#include <chrono>
+#include <vector>
+
+#include "../util/logger/Logger.h"
+#include "NodeBlock.h"
+#include "RelationBlock.h"
+
+Logger relation_compactor_logger;
+
+static WriteAheadLog::FileId relationFile(bool isLocal) {
+    return isLocal ? WriteAheadLog::RELATIONS : WriteAheadLog::CENTRAL_RELATIONS;
+}
+
+RelationCompactor::RelationCompactor(WriteAheadLog *wal, unsigned long intervalSeconds, unsigned long minRelations)
+    : wal(wal), intervalSeconds(intervalSeconds), minRelations(minRelations), stopping(false) {
+    // The relations already in the DBs count as compacted, so a partition is not compacted right after it is opened
+    for (bool isLocal : {false, true}) {
+        this->compactedBlocks[isLocal] = wal->size(relationFile(isLocal)) / RelationBlock::BLOCK_SIZE;
+    }
+    this->worker = std::thread(&RelationCompactor::run, this);
+}
+
+RelationCompactor::~RelationCompactor() {
+    {
+        std::lock_guard<std::mutex> guard(this->stopLock);
+        this->stopping = true;
+    }
+    this->stopCondition.notify_one();
+    this->worker.join();
+}
+
+void RelationCompactor::run() {
+    std::unique_lock<std::mutex> lock(this->stopLock);
+    while (!this->stopCondition.wait_for(lock, std::chrono::seconds(this->intervalSeconds),
+                                         [this]() { return this->stopping; })) {
+        lock.unlock();
+        for (bool isLocal : {true, false}) {
+            unsigned long blocks = this->wal->size(relationFile(isLocal)) / RelationBlock::BLOCK_SIZE;
+            if (blocks < this->compactedBlocks[isLocal] + this->minRelations) {
+                continue;
+            }
+            auto start = std::chrono::steady_clock::now();
+            if (RelationCompactor::compact(this->wal, isLocal)) {
+                this->compactedBlocks[isLocal] = blocks;
+                auto elapsed =
+                    std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+                relation_compactor_logger.info("Compacted " + std::to_string(blocks - 1) +
+                                               (isLocal ? " local" : " central") + " relations in " +
+                                               std::to_string(elapsed.count()) + " ms");
+            }
+        }
+        lock.lock();
+    }
+}
+
+/**
+ * Every relation has one source, so taking the relations of each node where it is the source, in the order of its
+ * relation list, places every linked relation once. Relations that are in no list go to the end in their old order.
+ *
+ * The lists are walked and the blocks copied while updates go on, so a walk can see relations added since the
+ * relocation began, which are skipped, or a list in the middle of an update, which ends the walk. Such relations are
+ * placed at the end, and the blocks the updates wrote are copied again when the relocation finishes.
+ * */
+bool RelationCompactor::compact(WriteAheadLog *wal, bool isLocal) {
+    WriteAheadLog::FileId file = relationFile(isLocal);
+    // Offset of the head of the relation list in a node block, after the usage flag, the node ID and, for central
+    // relations, the head of the local list
+    unsigned long headOffset =
+        sizeof(NodeBlock::usage) + sizeof(NodeBlock::nodeId) + (isLocal ? 0 : sizeof(NodeBlock::edgeRef));
+    const unsigned long blockSize = RelationBlock::BLOCK_SIZE;
+    unsigned long blocks = wal->beginRelocation(file);
+    if (blocks < 2) {
+        wal->cancelRelocation(file);
+        return true;
+    }
+    unsigned long nodes = wal->size(WriteAheadLog::NODES) / NodeBlock::BLOCK_SIZE;
+    std::vector<unsigned int> order;
+    order.reserve(blocks - 1);
+    std::vector<bool> placed(blocks, false);
+    std::vector<unsigned int> record(blockSize / RelationBlock::RECORD_SIZE);
+    for (unsigned long node = 1; node < nodes; node++) {  // Node block 0 holds the layout
+        unsigned int nodeAddress = node * NodeBlock::BLOCK_SIZE;
+        unsigned int address = 0;
+        wal->read(WriteAheadLog::NODES, nodeAddress + headOffset, reinterpret_cast<char *>(&address), sizeof(address));
+        // Bounded in case a list has a cycle
+        unsigned long maxSteps = wal->size(file) / blockSize;
+        for (unsigned long steps = 0; address != 0 && steps < maxSteps; steps++) {
+            unsigned long block = address / blockSize;
+            if (address % blockSize != 0 ||
+                wal->read(file, address, reinterpret_cast<char *>(record.data()), blockSize) != blockSize) {
+                relation_compactor_logger.warn("Invalid relation address " + std::to_string(address) +
+                                               " in the relations of node " + std::to_string(nodeAddress));
+                break;
+            }
+            if (record[(int)RelationOffsets::SOURCE] == nodeAddress) {
+                if (block < blocks && !placed[block]) {
+                    placed[block] = true;
+                    order.push_back(block);
+                }
+                address = record[(int)RelationOffsets::SOURCE_NEXT];
+            } else if (record[(int)RelationOffsets::DESTINATION] == nodeAddress) {
+                address = record[(int)RelationOffsets::DESTINATION_NEXT];
+            } else {
+                break;  // Being updated
+            }
+        }
+    }
+    for (unsigned long block = 1; block < blocks; block++) {
+        if (!placed[block]) {
+            order.push_back(block);
+        }
+    }
+    if (!wal->copyBlocks(file, order) || !wal->exclusive([wal, file]() { return wal->finishRelocation(file); })) {
+        wal->cancelRelocation(file);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,55 @@
+/**
+Copyright 2024 JasmineGraph Team
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+**/
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "WriteAheadLog.h"
+
+#ifndef JASMINEGRAPH_RELATIONCOMPACTOR_H
+#define JASMINEGRAPH_RELATIONCOMPACTOR_H
+
+/**
+ * Background compaction of the relation DBs of a streaming partition.
+ *
+ * Relations are appended in arrival order and linked into the relation lists of both of their nodes, so walking the
+ * neighbours of a node jumps across the whole DB. Compaction stores the relations of each source node next to each
+ * other, in the order of its relation list, so most of a neighbourhood is read from consecutive blocks.
+ *
+ * The blocks are moved by a WriteAheadLog relocation, which keeps their addresses, so node heads, relation lists and
+ * readers that go through the relations by address are not affected. A DB is compacted when it has gained enough
+ * relations since it was last compacted, checked at a fixed interval. Updates of the partition go on while the blocks
+ * are copied and only wait while the blocks they changed in the meantime are copied again and the DB is replaced.
+ * **/
+class RelationCompactor {
+ public:
+    RelationCompactor(WriteAheadLog *wal, unsigned long intervalSeconds, unsigned long minRelations);
+    ~RelationCompactor();
+
+    static bool compact(WriteAheadLog *wal, bool isLocal);
+
+ private:
+    WriteAheadLog *wal;
+    unsigned long intervalSeconds;
+    unsigned long minRelations;
+    unsigned long compactedBlocks[2];  // Blocks of the central and the local relation DB at the last compaction
+    std::thread worker;
+    std::mutex stopLock;
+    std::condition_variable stopCondition;
+    bool stopping;
+
+    void run();
+};
+
+#endif  // JASMINEGRAPH_RELATIONCOMPACTOR_H
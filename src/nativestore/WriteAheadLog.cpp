@@ -0,0 +1,921 @@
+/**
+Copyright 2024 JasmineGraph Team
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+**/
+
+#include "WriteAheadLog.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iterator>
+
+#include "../performance/metrics/MetricsRegistry.h"
+#include "../util/logger/Logger.h"
+
+Logger wal_logger;
+
+static const char WAL_MAGIC[4] = {'J', 'G', 'W', 'L'};
+static const char BLOCK_MAP_MAGIC[4] = {'J', 'G', 'B', 'M'};
+static const size_t RELOCATE_BUFFER_SIZE = 1024 * 1024;
+static const unsigned int WAL_VERSION = 1;
+static const unsigned char COMMIT_RECORD = 0xFF;
+// File ID, offset and length of a record, followed by the data and the checksum
+static const size_t RECORD_HEADER_SIZE = sizeof(unsigned char) + sizeof(uint64_t) + sizeof(uint32_t);
+
+const unsigned int WriteAheadLog::HEADER_SIZE;
+const unsigned int WriteAheadLog::BLOCK_MAP_HEADER_SIZE;
+thread_local WriteAheadLog *WriteAheadLog::operationLog = NULL;
+thread_local int WriteAheadLog::operationDepth = 0;
+
+// Block 0 of a relocated DB starts with the generation of its block map
+static void putBlockMapHeader(char *block, unsigned int generation) {
+    memcpy(block, BLOCK_MAP_MAGIC, sizeof(BLOCK_MAP_MAGIC));
+    memcpy(block + sizeof(BLOCK_MAP_MAGIC), &generation, sizeof(generation));
+}
+
+static ssize_t preadFully(int fd, char *buffer, size_t length, off_t offset) {
+    size_t done = 0;
+    while (done < length) {
+        ssize_t n = pread(fd, buffer + done, length - done, offset + done);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        if (n == 0) {
+            break;
+        }
+        done += n;
+    }
+    return done;
+}
+
+static bool pwriteFully(int fd, const char *buffer, size_t length, off_t offset) {
+    size_t done = 0;
+    while (done < length) {
+        ssize_t n = pwrite(fd, buffer + done, length - done, offset + done);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        done += n;
+    }
+    return true;
+}
+
+static long fileSizeOf(int fd) {
+    struct stat stat_buf;
+    if (fd < 0 || fstat(fd, &stat_buf) != 0) {
+        return -1;
+    }
+    return stat_buf.st_size;
+}
+
+// FNV-1a
+static uint32_t checksum(const char *data, size_t length, uint32_t hash = 2166136261u) {
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (unsigned char)data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static void appendRecord(std::string &log, unsigned char file, uint64_t offset, const char *data, uint32_t length) {
+    size_t start = log.size();
+    log.append(reinterpret_cast<const char *>(&file), sizeof(file));
+    log.append(reinterpret_cast<const char *>(&offset), sizeof(offset));
+    log.append(reinterpret_cast<const char *>(&length), sizeof(length));
+    log.append(data, length);
+    uint32_t sum = checksum(&log[start], log.size() - start);
+    log.append(reinterpret_cast<const char *>(&sum), sizeof(sum));
+}
+
+// Adds a write to the extents, merging it with the extents it overlaps or touches
+static void putExtent(std::map<unsigned long, std::string> &extents, unsigned long offset, const char *data,
+                      size_t length) {
+    unsigned long start = offset;
+    unsigned long end = offset + length;
+    auto first = extents.upper_bound(offset);
+    if (first != extents.begin()) {
+        auto previous = std::prev(first);
+        if (previous->first + previous->second.size() >= offset) {
+            first = previous;
+        }
+    }
+    auto last = first;
+    while (last != extents.end() && last->first <= end) {
+        start = std::min(start, last->first);
+        end = std::max(end, (unsigned long)(last->first + last->second.size()));
+        last++;
+    }
+    std::string merged(end - start, '\0');
+    for (auto it = first; it != last; it++) {
+        memcpy(&merged[it->first - start], it->second.data(), it->second.size());
+    }
+    memcpy(&merged[offset - start], data, length);
+    extents.erase(first, last);
+    extents[start].swap(merged);
+}
+
+/**
+ * Stream buffer over a DB that goes through the write-ahead log. The blocks are written field by field followed by a
+ * flush(), so consecutive writes are collected and go to the log as one write when the stream is flushed or seeks.
+ * */
+class WALFileBuf : public std::streambuf {
+ public:
+    WALFileBuf(WriteAheadLog *log, WriteAheadLog::FileId file)
+        : log(log), file(file), position(0), pendingStart(0) {}
+
+ protected:
+    std::streamsize xsputn(const char *data, std::streamsize length) override {
+        if (!this->pending.empty() && this->position != this->pendingStart + this->pending.size()) {
+            this->sync();
+        }
+        if (this->pending.empty()) {
+            this->pendingStart = this->position;
+        }
+        this->pending.append(data, length);
+        this->position += length;
+        return length;
+    }
+
+    int_type overflow(int_type c) override {
+        if (traits_type::eq_int_type(c, traits_type::eof())) {
+            return traits_type::not_eof(c);
+        }
+        char ch = traits_type::to_char_type(c);
+        this->xsputn(&ch, 1);
+        return c;
+    }
+
+    std::streamsize xsgetn(char *data, std::streamsize length) override {
+        this->sync();
+        size_t read = this->log->read(this->file, this->position, data, length);
+        this->position += read;
+        return read;
+    }
+
+    int_type underflow() override {
+        this->sync();
+        char ch;
+        if (this->log->read(this->file, this->position, &ch, 1) != 1) {
+            return traits_type::eof();
+        }
+        return traits_type::to_int_type(ch);
+    }
+
+    int_type uflow() override {
+        int_type c = this->underflow();
+        if (!traits_type::eq_int_type(c, traits_type::eof())) {
+            this->position++;
+        }
+        return c;
+    }
+
+    pos_type seekoff(off_type offset, std::ios_base::seekdir direction, std::ios_base::openmode) override {
+        this->sync();
+        long base = 0;
+        if (direction == std::ios_base::cur) {
+            base = this->position;
+        } else if (direction == std::ios_base::end) {
+            base = this->log->size(this->file);
+        }
+        if (base + offset < 0) {
+            return pos_type(off_type(-1));
+        }
+        this->position = base + offset;
+        return pos_type(this->position);
+    }
+
+    pos_type seekpos(pos_type position, std::ios_base::openmode which) override {
+        return this->seekoff(off_type(position), std::ios_base::beg, which);
+    }
+
+    int sync() override {
+        if (!this->pending.empty()) {
+            this->log->write(this->file, this->pendingStart, this->pending.data(), this->pending.size());
+            this->pending.clear();
+        }
+        return 0;
+    }
+
+ private:
+    WriteAheadLog *log;
+    WriteAheadLog::FileId file;
+    unsigned long position;
+    unsigned long pendingStart;
+    std::string pending;
+};
+
+WriteAheadLog::WriteAheadLog(const std::string &path, const std::vector<std::string> &filePaths)
+    : path(path),
+      filePaths(filePaths),
+      fd(-1),
+      owner(false),
+      readOnly(false),
+      logSize(HEADER_SIZE),
+      groupBytes(0),
+      groupMillis(0),
+      checkpointBytes(0),
+      stopping(false),
+      commitRequested(false) {
+    pthread_rwlockattr_t attributes;
+    pthread_rwlockattr_init(&attributes);
+    // Commits must not starve behind a steady stream of operations. Operations never take the lock twice.
+    pthread_rwlockattr_setkind_np(&attributes, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+    pthread_rwlock_init(&this->operationLock, &attributes);
+    pthread_rwlockattr_destroy(&attributes);
+    for (int i = 0; i < FILE_COUNT; i++) {
+        this->fds[i] = -1;
+        this->fileSizes[i] = 0;
+        this->blockSizes[i] = 0;
+        this->generations[i] = 0;
+    }
+}
+
+WriteAheadLog::~WriteAheadLog() {
+    if (this->committer.joinable()) {
+        {
+            std::lock_guard<std::mutex> guard(this->committerLock);
+            this->stopping = true;
+        }
+        this->committerCondition.notify_one();
+        this->committer.join();
+    }
+    if (this->fd >= 0) {
+        this->checkpoint();
+        close(this->fd);  // Also releases the lock on the log
+    }
+    for (int i = 0; i < FILE_COUNT; i++) {
+        this->endRelocation((FileId)i);
+        if (this->fds[i] >= 0) {
+            close(this->fds[i]);
+        }
+    }
+    for (WALFileBuf *buffer : this->buffers) {
+        delete buffer;
+    }
+    pthread_rwlock_destroy(&this->operationLock);
+}
+
+bool WriteAheadLog::open(bool truncate, bool readOnly) {
+    this->readOnly = readOnly;
+    if (!readOnly) {
+        this->fd = ::open(this->path.c_str(), O_RDWR | O_CREAT, 0644);
+        if (this->fd < 0) {
+            wal_logger.error("Cannot open the write-ahead log " + this->path + ": " + strerror(errno));
+            return false;
+        }
+        this->owner = flock(this->fd, LOCK_EX | LOCK_NB) == 0;
+        if (!this->owner) {
+            wal_logger.info("The write-ahead log " + this->path + " is owned by another store");
+            close(this->fd);
+            this->fd = -1;
+        }
+    }
+    for (int i = 0; i < FILE_COUNT; i++) {
+        int flags = readOnly ? O_RDONLY : O_RDWR | O_CREAT | (truncate ? O_TRUNC : 0);
+        this->fds[i] = ::open(this->filePaths[i].c_str(), flags, 0644);
+        if (this->fds[i] < 0) {
+            wal_logger.error("Cannot open " + this->filePaths[i] + ": " + strerror(errno));
+            return false;
+        }
+        this->fileSizes[i] = fileSizeOf(this->fds[i]);
+    }
+    if (!this->owner) {
+        return true;
+    }
+    // A relocation that did not reach its rename() is abandoned
+    for (const std::string &filePath : this->filePaths) {
+        unlink((filePath + ".compact").c_str());
+    }
+
+    char header[HEADER_SIZE];
+    if (!truncate && fileSizeOf(this->fd) >= (long)HEADER_SIZE) {
+        if (preadFully(this->fd, header, HEADER_SIZE, 0) != HEADER_SIZE ||
+            memcmp(header, WAL_MAGIC, sizeof(WAL_MAGIC)) != 0) {
+            wal_logger.error("Invalid write-ahead log header in " + this->path);
+            return false;
+        }
+        if (!this->replay()) {
+            return false;
+        }
+    }
+    memcpy(header, WAL_MAGIC, sizeof(WAL_MAGIC));
+    memcpy(header + sizeof(WAL_MAGIC), &WAL_VERSION, sizeof(WAL_VERSION));
+    if (ftruncate(this->fd, 0) != 0 || !pwriteFully(this->fd, header, HEADER_SIZE, 0) || fdatasync(this->fd) != 0) {
+        wal_logger.error("Cannot reset the write-ahead log " + this->path + ": " + strerror(errno));
+        return false;
+    }
+    this->logSize = HEADER_SIZE;
+    for (int i = 0; i < FILE_COUNT; i++) {
+        this->fileSizes[i] = fileSizeOf(this->fds[i]);
+    }
+    return true;
+}
+
+/**
+ * Applies the committed groups of the log to the DBs and syncs them, after which the log can be reset
+ * */
+bool WriteAheadLog::replay() {
+    struct Write {
+        unsigned char file;
+        uint64_t offset;
+        std::string data;
+    };
+    std::vector<Write> group;
+    unsigned long position = HEADER_SIZE;
+    unsigned long groups = 0;
+    unsigned long writes = 0;
+    char header[RECORD_HEADER_SIZE];
+    while (preadFully(this->fd, header, RECORD_HEADER_SIZE, position) == (ssize_t)RECORD_HEADER_SIZE) {
+        Write write;
+        uint32_t length;
+        memcpy(&write.file, header, sizeof(write.file));
+        memcpy(&write.offset, header + sizeof(write.file), sizeof(write.offset));
+        memcpy(&length, header + sizeof(write.file) + sizeof(write.offset), sizeof(length));
+        if ((write.file >= FILE_COUNT && write.file != COMMIT_RECORD) || length > (1u << 30)) {
+            break;
+        }
+        write.data.resize(length);
+        uint32_t storedSum;
+        if (preadFully(this->fd, &write.data[0], length, position + RECORD_HEADER_SIZE) != length ||
+            preadFully(this->fd, reinterpret_cast<char *>(&storedSum), sizeof(storedSum),
+                       position + RECORD_HEADER_SIZE + length) != sizeof(storedSum) ||
+            checksum(write.data.data(), length, checksum(header, RECORD_HEADER_SIZE)) != storedSum) {
+            break;
+        }
+        position += RECORD_HEADER_SIZE + length + sizeof(storedSum);
+        if (write.file != COMMIT_RECORD) {
+            group.push_back(std::move(write));
+            continue;
+        }
+        for (const Write &groupWrite : group) {
+            if (!pwriteFully(this->fds[groupWrite.file], groupWrite.data.data(), groupWrite.data.size(),
+                             groupWrite.offset)) {
+                wal_logger.error("Cannot replay the write-ahead log into " + this->filePaths[groupWrite.file] + ": " +
+                                 strerror(errno));
+                return false;
+            }
+        }
+        writes += group.size();
+        groups++;
+        group.clear();
+    }
+    if (!group.empty()) {
+        wal_logger.warn("Discarding " + std::to_string(group.size()) + " uncommitted writes at the end of " +
+                        this->path);
+    }
+    for (int i = 0; i < FILE_COUNT; i++) {
+        if (fdatasync(this->fds[i]) != 0) {
+            wal_logger.error("Cannot sync " + this->filePaths[i] + ": " + strerror(errno));
+            return false;
+        }
+    }
+    if (groups > 0) {
+        wal_logger.info("Replayed " + std::to_string(writes) + " writes of " + std::to_string(groups) +
+                        " groups from " + this->path);
+    }
+    return true;
+}
+
+void WriteAheadLog::start(unsigned long groupBytes, unsigned long groupMillis, unsigned long checkpointBytes) {
+    this->groupBytes = groupBytes;
+    this->groupMillis = std::max(groupMillis, 1UL);
+    this->checkpointBytes = checkpointBytes;
+    this->committer = std::thread(&WriteAheadLog::run, this);
+}
+
+void WriteAheadLog::setSyncHook(std::function<void()> hook) { this->syncHook = hook; }
+
+std::fstream *WriteAheadLog::openStream(FileId file) {
+    WALFileBuf *buffer = new WALFileBuf(this, file);
+    {
+        std::lock_guard<std::mutex> guard(this->pendingLock);
+        this->buffers.push_back(buffer);
+    }
+    std::fstream *stream = new std::fstream();
+    static_cast<std::ios &>(*stream).rdbuf(buffer);
+    return stream;
+}
+
+void WriteAheadLog::beginOperation() {
+    if (WriteAheadLog::operationLog == this) {
+        WriteAheadLog::operationDepth++;
+        return;
+    }
+    pthread_rwlock_rdlock(&this->operationLock);
+    if (!WriteAheadLog::operationLog) {
+        WriteAheadLog::operationLog = this;
+        WriteAheadLog::operationDepth = 1;
+    }
+}
+
+void WriteAheadLog::endOperation() {
+    if (WriteAheadLog::operationLog == this) {
+        if (--WriteAheadLog::operationDepth > 0) {
+            return;
+        }
+        WriteAheadLog::operationLog = NULL;
+    }
+    pthread_rwlock_unlock(&this->operationLock);
+}
+
+/**
+ * The owner replaces a relocated DB by rename(), so a DB whose path no longer refers to the open file is opened again
+ * together with its new block map. Pending writes of the owner are not visible until it commits them.
+ * */
+bool WriteAheadLog::refresh() {
+    if (this->owner) {
+        return true;
+    }
+    bool done = true;
+    pthread_rwlock_wrlock(&this->operationLock);
+    for (int i = 0; i < FILE_COUNT; i++) {
+        struct stat opened;
+        struct stat current;
+        if (fstat(this->fds[i], &opened) == 0 && stat(this->filePaths[i].c_str(), &current) == 0 &&
+            (opened.st_dev != current.st_dev || opened.st_ino != current.st_ino)) {
+            int newFd = ::open(this->filePaths[i].c_str(), this->readOnly ? O_RDONLY : O_RDWR);
+            if (newFd < 0) {
+                wal_logger.error("Cannot open " + this->filePaths[i] + ": " + strerror(errno));
+                done = false;
+                continue;
+            }
+            close(this->fds[i]);
+            this->fds[i] = newFd;
+            if (this->blockSizes[i] > 0) {
+                done = this->loadBlockMap((FileId)i, this->blockSizes[i]) && done;
+            }
+        }
+        long size = fileSizeOf(this->fds[i]);
+        std::lock_guard<std::mutex> guard(this->pendingLock);
+        this->fileSizes[i] = size > 0 ? size : 0;
+    }
+    pthread_rwlock_unlock(&this->operationLock);
+    return done;
+}
+
+std::string WriteAheadLog::mapPath(FileId file, unsigned int generation) {
+    return this->filePaths[file] + ".map." + std::to_string(generation);
+}
+
+/**
+ * The map and the block size of the DB are in the file of the generation recorded in block 0. A DB that was never
+ * relocated has no generation.
+ * */
+bool WriteAheadLog::loadBlockMap(FileId file, unsigned long blockSize) {
+    this->blockSizes[file] = blockSize;
+    char header[WriteAheadLog::BLOCK_MAP_HEADER_SIZE];
+    if (preadFully(this->fds[file], header, sizeof(header), 0) != sizeof(header) ||
+        memcmp(header, BLOCK_MAP_MAGIC, sizeof(BLOCK_MAP_MAGIC)) != 0) {
+        return true;
+    }
+    unsigned int generation;
+    memcpy(&generation, header + sizeof(BLOCK_MAP_MAGIC), sizeof(generation));
+    std::string path = this->mapPath(file, generation);
+    int mapFd = ::open(path.c_str(), O_RDONLY);
+    long size = fileSizeOf(mapFd);
+    char mapHeader[sizeof(BLOCK_MAP_MAGIC) + sizeof(unsigned long)];
+    unsigned long storedBlockSize;
+    bool loaded = size >= (long)sizeof(mapHeader) && (size - sizeof(mapHeader)) % sizeof(unsigned int) == 0 &&
+                  preadFully(mapFd, mapHeader, sizeof(mapHeader), 0) == sizeof(mapHeader) &&
+                  memcmp(mapHeader, BLOCK_MAP_MAGIC, sizeof(BLOCK_MAP_MAGIC)) == 0;
+    if (loaded) {
+        memcpy(&storedBlockSize, mapHeader + sizeof(BLOCK_MAP_MAGIC), sizeof(storedBlockSize));
+        std::vector<unsigned int> map((size - sizeof(mapHeader)) / sizeof(unsigned int));
+        size_t mapBytes = map.size() * sizeof(unsigned int);
+        loaded = storedBlockSize == blockSize &&
+                 preadFully(mapFd, reinterpret_cast<char *>(map.data()), mapBytes, sizeof(mapHeader)) ==
+                     (ssize_t)mapBytes;
+        this->blockMaps[file].swap(map);
+    }
+    if (mapFd >= 0) {
+        close(mapFd);
+    }
+    if (!loaded) {
+        wal_logger.error("Cannot read the block map " + path + " of " + this->filePaths[file]);
+        this->blockMaps[file].clear();
+        return false;
+    }
+    this->generations[file] = generation;
+    if (this->owner && generation > 0) {
+        unlink(this->mapPath(file, generation - 1).c_str());  // Left behind if the last relocation was interrupted
+    }
+    return true;
+}
+
+unsigned long WriteAheadLog::physical(FileId file, unsigned long offset) {
+    const std::vector<unsigned int> &map = this->blockMaps[file];
+    if (map.empty()) {
+        return offset;
+    }
+    unsigned long block = offset / this->blockSizes[file];
+    if (block == 0 || block > map.size()) {
+        return offset;
+    }
+    return (unsigned long)map[block - 1] * this->blockSizes[file] + offset % this->blockSizes[file];
+}
+
+void WriteAheadLog::write(FileId file, unsigned long offset, const char *data, size_t length) {
+    Operation operation(this);
+    if (this->relocations[file].active && length > 0) {
+        std::lock_guard<std::mutex> guard(this->pendingLock);
+        unsigned long blockSize = this->blockSizes[file];
+        for (unsigned long block = offset / blockSize; block <= (offset + length - 1) / blockSize; block++) {
+            this->relocations[file].written.insert(block);
+        }
+    }
+    while (length > 0) {
+        size_t piece = length;
+        if (!this->blockMaps[file].empty()) {
+            piece = std::min((unsigned long)length, this->blockSizes[file] - offset % this->blockSizes[file]);
+        }
+        this->writePhysical(file, this->physical(file, offset), data, piece);
+        offset += piece;
+        data += piece;
+        length -= piece;
+    }
+}
+
+void WriteAheadLog::writePhysical(FileId file, unsigned long offset, const char *data, size_t length) {
+    if (!this->owner) {
+        if (!pwriteFully(this->fds[file], data, length, offset)) {
+            wal_logger.error("Error while writing " + this->filePaths[file] + ": " + strerror(errno));
+            return;
+        }
+        std::lock_guard<std::mutex> guard(this->pendingLock);
+        this->fileSizes[file] = std::max(this->fileSizes[file], offset + length);
+        return;
+    }
+    bool full;
+    {
+        std::lock_guard<std::mutex> guard(this->pendingLock);
+        appendRecord(this->pendingLog, file, offset, data, length);
+        putExtent(this->pending[file], offset, data, length);
+        full = this->groupBytes > 0 && this->pendingLog.size() >= this->groupBytes;
+    }
+    if (full && !this->commitRequested.exchange(true)) {
+        std::lock_guard<std::mutex> guard(this->committerLock);
+        this->committerCondition.notify_one();
+    }
+}
+
+/**
+ * The DB files only change in a commit, which cannot run during an operation, so they are read without holding the
+ * pending lock
+ * */
+size_t WriteAheadLog::read(FileId file, unsigned long offset, char *data, size_t length) {
+    Operation operation(this);
+    return this->readExclusive(file, offset, data, length);
+}
+
+size_t WriteAheadLog::readExclusive(FileId file, unsigned long offset, char *data, size_t length) {
+    size_t done = 0;
+    while (done < length) {
+        size_t piece = length - done;
+        if (!this->blockMaps[file].empty()) {
+            piece = std::min((unsigned long)piece, this->blockSizes[file] - offset % this->blockSizes[file]);
+        }
+        size_t read = this->readPhysical(file, this->physical(file, offset), data + done, piece);
+        done += read;
+        offset += read;
+        if (read < piece) {
+            break;
+        }
+    }
+    return done;
+}
+
+size_t WriteAheadLog::readPhysical(FileId file, unsigned long offset, char *data, size_t length) {
+    unsigned long end;
+    unsigned long fileSize;
+    {
+        std::lock_guard<std::mutex> guard(this->pendingLock);
+        if (!this->owner && offset + length > this->fileSizes[file]) {
+            // The store that owns the log may have added blocks since
+            long size = fileSizeOf(this->fds[file]);
+            this->fileSizes[file] = std::max(this->fileSizes[file], size > 0 ? (unsigned long)size : 0);
+        }
+        fileSize = this->fileSizes[file];
+        end = this->sizeLocked(file);
+    }
+    if (offset >= end) {
+        return 0;
+    }
+    length = std::min((unsigned long)length, end - offset);
+    size_t onDisk = offset < fileSize ? std::min((unsigned long)length, fileSize - offset) : 0;
+    if (onDisk > 0 && preadFully(this->fds[file], data, onDisk, offset) != (ssize_t)onDisk) {
+        wal_logger.error("Error while reading " + this->filePaths[file] + ": " + strerror(errno));
+        return 0;
+    }
+    memset(data + onDisk, 0, length - onDisk);
+
+    std::lock_guard<std::mutex> guard(this->pendingLock);
+    const Extents &extents = this->pending[file];
+    auto it = extents.upper_bound(offset);
+    if (it != extents.begin()) {
+        it--;
+    }
+    for (; it != extents.end() && it->first < offset + length; it++) {
+        unsigned long start = std::max(it->first, offset);
+        unsigned long stop = std::min((unsigned long)(it->first + it->second.size()), offset + length);
+        if (start < stop) {
+            memcpy(data + (start - offset), it->second.data() + (start - it->first), stop - start);
+        }
+    }
+    return length;
+}
+
+unsigned long WriteAheadLog::size(FileId file) {
+    std::lock_guard<std::mutex> guard(this->pendingLock);
+    return this->sizeLocked(file);
+}
+
+unsigned long WriteAheadLog::sizeLocked(FileId file) {
+    unsigned long size = this->fileSizes[file];
+    const Extents &extents = this->pending[file];
+    if (!extents.empty()) {
+        size = std::max(size, (unsigned long)(extents.rbegin()->first + extents.rbegin()->second.size()));
+    }
+    return size;
+}
+
+bool WriteAheadLog::commit() {
+    pthread_rwlock_wrlock(&this->operationLock);
+    bool committed = this->commitLocked();
+    pthread_rwlock_unlock(&this->operationLock);
+    return committed;
+}
+
+bool WriteAheadLog::checkpoint() {
+    pthread_rwlock_wrlock(&this->operationLock);
+    bool done = this->commitLocked() && this->checkpointLocked();
+    pthread_rwlock_unlock(&this->operationLock);
+    return done;
+}
+
+/**
+ * Must be called with the operation lock held exclusively. The pending writes are only applied to the DBs after the
+ * log is synced. If writing the log fails they stay pending and are tried again in the next commit.
+ * */
+bool WriteAheadLog::commitLocked() {
+    static Counter &commits = MetricsRegistry::counter("jasminegraph_nativestore_wal_commits_total",
+                                                       "Groups committed to the native store write-ahead log");
+    static Counter &loggedBytes = MetricsRegistry::counter("jasminegraph_nativestore_wal_bytes_total",
+                                                           "Bytes written to the native store write-ahead log");
+    std::lock_guard<std::mutex> guard(this->pendingLock);
+    this->commitRequested = false;
+    if (this->pendingLog.empty()) {
+        return true;
+    }
+    if (this->syncHook) {
+        this->syncHook();
+    }
+    size_t groupSize = this->pendingLog.size();
+    appendRecord(this->pendingLog, COMMIT_RECORD, 0, NULL, 0);
+    if (!pwriteFully(this->fd, this->pendingLog.data(), this->pendingLog.size(), this->logSize) ||
+        fdatasync(this->fd) != 0) {
+        wal_logger.error("Cannot write the write-ahead log " + this->path + ": " + strerror(errno));
+        this->pendingLog.resize(groupSize);
+        return false;
+    }
+    this->logSize += this->pendingLog.size();
+    loggedBytes.inc(this->pendingLog.size());
+    this->pendingLog.clear();
+
+    for (int i = 0; i < FILE_COUNT; i++) {
+        for (auto it = this->pending[i].begin(); it != this->pending[i].end(); it++) {
+            // The log has the write, so a failure here is repaired when the log is replayed
+            if (!pwriteFully(this->fds[i], it->second.data(), it->second.size(), it->first)) {
+                wal_logger.error("Error while writing " + this->filePaths[i] + ": " + strerror(errno));
+            }
+            this->fileSizes[i] = std::max(this->fileSizes[i], (unsigned long)(it->first + it->second.size()));
+        }
+        this->pending[i].clear();
+    }
+    commits.inc();
+    return true;
+}
+
+bool WriteAheadLog::checkpointLocked() {
+    for (int i = 0; i < FILE_COUNT; i++) {
+        if (fdatasync(this->fds[i]) != 0) {
+            wal_logger.error("Cannot sync " + this->filePaths[i] + ": " + strerror(errno));
+            return false;
+        }
+    }
+    if (!this->owner) {
+        return true;
+    }
+    if (ftruncate(this->fd, HEADER_SIZE) != 0 || fdatasync(this->fd) != 0) {
+        wal_logger.error("Cannot truncate the write-ahead log " + this->path + ": " + strerror(errno));
+        return false;
+    }
+    this->logSize = HEADER_SIZE;
+    return true;
+}
+
+/**
+ * The work runs with the operation lock held, so it reads with readExclusive() and must not begin operations
+ * */
+bool WriteAheadLog::exclusive(const std::function<bool()> &work) {
+    pthread_rwlock_wrlock(&this->operationLock);
+    bool done = this->commitLocked() && this->checkpointLocked() && work();
+    pthread_rwlock_unlock(&this->operationLock);
+    return done;
+}
+
+/**
+ * Takes the operation lock exclusively, so every operation either ended before the relocation began, and its writes
+ * are copied, or records the blocks it writes
+ * */
+unsigned long WriteAheadLog::beginRelocation(FileId file) {
+    pthread_rwlock_wrlock(&this->operationLock);
+    this->endRelocation(file);
+    Relocation &relocation = this->relocations[file];
+    if (this->owner && this->blockSizes[file] > 0) {
+        std::lock_guard<std::mutex> guard(this->pendingLock);
+        relocation.active = true;
+        relocation.blocks = this->sizeLocked(file) / this->blockSizes[file];
+    }
+    pthread_rwlock_unlock(&this->operationLock);
+    return relocation.blocks;
+}
+
+/**
+ * The blocks are read through the log as operations go on. A block that an operation changes while it is copied is
+ * recorded as written, so finishRelocation() copies it again.
+ * */
+bool WriteAheadLog::copyBlocks(FileId file, const std::vector<unsigned int> &order) {
+    Relocation &relocation = this->relocations[file];
+    unsigned long blockSize = this->blockSizes[file];
+    if (!relocation.active || relocation.fd >= 0 || relocation.blocks != order.size() + 1) {
+        wal_logger.error("Cannot relocate the blocks of " + this->filePaths[file]);
+        return false;
+    }
+    std::vector<unsigned int> map(order.size(), 0);
+    for (size_t i = 0; i < order.size(); i++) {
+        if (order[i] == 0 || order[i] > map.size() || map[order[i] - 1] != 0) {
+            wal_logger.error("Block order for " + this->filePaths[file] + " does not hold every block once");
+            return false;
+        }
+        map[order[i] - 1] = i + 1;
+    }
+
+    std::string compactPath = this->filePaths[file] + ".compact";
+    int newFd = ::open(compactPath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (newFd < 0) {
+        wal_logger.error("Cannot create " + compactPath + ": " + strerror(errno));
+        return false;
+    }
+    relocation.fd = newFd;
+    relocation.map.swap(map);
+    std::string buffer(blockSize, '\0');
+    std::string block(blockSize, '\0');
+    unsigned long written = 0;
+    bool done = this->read(file, 0, &buffer[0], blockSize) == blockSize;
+    putBlockMapHeader(&buffer[0], this->generations[file] + 1);
+    for (size_t i = 0; done && i < order.size(); i++) {
+        done = this->read(file, (unsigned long)order[i] * blockSize, &block[0], blockSize) == blockSize;
+        buffer.append(block);
+        if (buffer.size() >= RELOCATE_BUFFER_SIZE) {
+            done = done && pwriteFully(newFd, buffer.data(), buffer.size(), written);
+            written += buffer.size();
+            buffer.clear();
+        }
+    }
+    done = done && pwriteFully(newFd, buffer.data(), buffer.size(), written);
+    if (!done) {
+        wal_logger.error("Error while copying the blocks of " + this->filePaths[file] + ": " + strerror(errno));
+    }
+    return done;
+}
+
+/**
+ * Runs with the DB checkpointed, so the blocks written since beginRelocation() are read from the DB. Blocks added
+ * since then are stored at their logical address, after the relocated ones. The new DB replaces the DB with rename(),
+ * and a crash before the rename leaves the DB as it was. Block addresses stay logical, so nothing that refers to a
+ * block has to change.
+ * */
+bool WriteAheadLog::finishRelocation(FileId file) {
+    static Counter &relocatedBlocks = MetricsRegistry::counter("jasminegraph_nativestore_relocated_blocks_total",
+                                                               "Blocks rewritten by native store compaction");
+    Relocation &relocation = this->relocations[file];
+    if (!relocation.active || relocation.fd < 0) {
+        wal_logger.error("Cannot relocate the blocks of " + this->filePaths[file]);
+        return false;
+    }
+    unsigned long blockSize = this->blockSizes[file];
+    unsigned long end = this->fileSizes[file];
+    std::string block(blockSize, '\0');
+    bool done = true;
+    unsigned int generation = this->generations[file] + 1;
+    for (auto it = relocation.written.begin(); done && it != relocation.written.end(); it++) {
+        if (*it >= relocation.blocks) {
+            continue;
+        }
+        done = this->readExclusive(file, *it * blockSize, &block[0], blockSize) == blockSize;
+        if (*it == 0) {
+            putBlockMapHeader(&block[0], generation);
+        }
+        unsigned long target = *it == 0 ? 0 : (unsigned long)relocation.map[*it - 1] * blockSize;
+        done = done && pwriteFully(relocation.fd, block.data(), blockSize, target);
+    }
+    for (unsigned long offset = relocation.blocks * blockSize; done && offset < end; offset += blockSize) {
+        size_t length = this->readExclusive(file, offset, &block[0], blockSize);
+        done = length > 0 && pwriteFully(relocation.fd, block.data(), length, offset);
+    }
+
+    std::string compactPath = this->filePaths[file] + ".compact";
+    std::string newMapPath = this->mapPath(file, generation);
+    std::string mapData(BLOCK_MAP_MAGIC, sizeof(BLOCK_MAP_MAGIC));
+    mapData.append(reinterpret_cast<char *>(&blockSize), sizeof(blockSize));
+    mapData.append(reinterpret_cast<char *>(relocation.map.data()), relocation.map.size() * sizeof(unsigned int));
+    int mapFd = done ? ::open(newMapPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644) : -1;
+    done = done && mapFd >= 0 && pwriteFully(mapFd, mapData.data(), mapData.size(), 0) && fdatasync(mapFd) == 0;
+    if (mapFd >= 0) {
+        close(mapFd);
+    }
+    done = done && fdatasync(relocation.fd) == 0 && rename(compactPath.c_str(), this->filePaths[file].c_str()) == 0;
+    if (!done) {
+        wal_logger.error("Error while relocating the blocks of " + this->filePaths[file] + ": " + strerror(errno));
+        unlink(newMapPath.c_str());
+        this->endRelocation(file);
+        return false;
+    }
+    size_t separator = this->filePaths[file].rfind('/');
+    int directoryFd = ::open(separator == std::string::npos ? "." : this->filePaths[file].substr(0, separator).c_str(),
+                             O_RDONLY);
+    if (directoryFd >= 0) {
+        fsync(directoryFd);
+        close(directoryFd);
+    }
+
+    close(this->fds[file]);
+    this->fds[file] = relocation.fd;
+    this->fileSizes[file] = std::max(end, relocation.blocks * blockSize);
+    this->blockMaps[file].swap(relocation.map);
+    this->generations[file] = generation;
+    unlink(this->mapPath(file, generation - 1).c_str());
+    relocatedBlocks.inc(relocation.blocks - 1);
+    relocation.fd = -1;
+    this->endRelocation(file);
+    return true;
+}
+
+void WriteAheadLog::cancelRelocation(FileId file) {
+    pthread_rwlock_wrlock(&this->operationLock);
+    this->endRelocation(file);
+    pthread_rwlock_unlock(&this->operationLock);
+}
+
+// Must be called with the operation lock held exclusively
+void WriteAheadLog::endRelocation(FileId file) {
+    Relocation &relocation = this->relocations[file];
+    if (relocation.fd >= 0) {
+        close(relocation.fd);
+        unlink((this->filePaths[file] + ".compact").c_str());
+        relocation.fd = -1;
+    }
+    std::lock_guard<std::mutex> guard(this->pendingLock);
+    relocation.active = false;
+    relocation.blocks = 0;
+    relocation.written.clear();
+    relocation.map.clear();
+}
+
+void WriteAheadLog::run() {
+    std::unique_lock<std::mutex> lock(this->committerLock);
+    while (!this->stopping) {
+        this->committerCondition.wait_for(lock, std::chrono::milliseconds(this->groupMillis),
+                                          [this]() { return this->stopping || this->commitRequested; });
+        if (this->stopping) {
+            break;
+        }
+        lock.unlock();
+        if (this->commit() && this->logSize > this->checkpointBytes) {
+            this->checkpoint();
+        }
+        lock.lock();
+    }
+}
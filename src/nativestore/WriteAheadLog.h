@@ -0,0 +1,183 @@
+/**
+Copyright 2024 JasmineGraph Team
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+**/
+
+#include <pthread.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef JASMINEGRAPH_WRITEAHEADLOG_H
+#define JASMINEGRAPH_WRITEAHEADLOG_H
+
+class WALFileBuf;
+
+/**
+ * Write-ahead log of the block DBs of a partition.
+ *
+ * Writes to the DBs are not made in place. They are appended to the log in memory and kept there, where readers see
+ * them, until a group commit writes the log to disk, syncs it and only then writes the blocks to the DBs. All writes
+ * to a block between two commits reach its DB as one write. A group is committed when the pending writes reach a size
+ * threshold or when a time threshold has passed, whichever comes first.
+ *
+ * The writes of an operation, such as adding an edge and its properties, are made between beginOperation() and
+ * endOperation(). A commit waits for the running operations, so a group only holds whole operations and a crash cannot
+ * leave half linked relation lists. Opening the log replays the groups that were committed but may not have reached
+ * the DBs. Once the DBs are synced the log is truncated (a checkpoint).
+ *
+ * Log records are (file, offset, length, data, checksum) and each group ends with a commit record. Replay stops at
+ * the first record that is torn or fails its checksum and ignores writes after the last commit record.
+ *
+ * Only one store of a partition owns the log. Other stores of the partition read and write the DBs directly through it.
+ * A read-only store neither takes the log nor writes the DBs, and refresh() catches up with what the owner wrote.
+ *
+ * A DB of fixed size blocks can have a block map, which a relocation writes when it stores the blocks in a new order.
+ * Block addresses stay logical: the map gives the physical block of each logical block, and blocks added after the
+ * relocation are stored at their logical address. Block 0 of such a DB starts with the generation of its map, which
+ * is kept in a file next to the DB, so replacing the DB by rename() switches to the new map atomically. The rest of
+ * block 0 belongs to the DB and is kept by relocations.
+ * **/
+class WriteAheadLog {
+ public:
+    enum FileId { NODES = 0, RELATIONS, CENTRAL_RELATIONS, NODE_INDEX, FILE_COUNT };
+
+    // Scope of an operation. A null log is allowed so callers do not need to check whether a store has one.
+    class Operation {
+     public:
+        explicit Operation(WriteAheadLog *log) : log(log) {
+            if (log) {
+                log->beginOperation();
+            }
+        }
+        ~Operation() {
+            if (log) {
+                log->endOperation();
+            }
+        }
+
+     private:
+        WriteAheadLog *log;
+    };
+
+    static const unsigned int HEADER_SIZE = 8;
+    static const unsigned int BLOCK_MAP_HEADER_SIZE = 8;  // Bytes of block 0 that hold the block map generation
+
+    // filePaths are the DBs in FileId order
+    WriteAheadLog(const std::string &path, const std::vector<std::string> &filePaths);
+    ~WriteAheadLog();
+
+    // Takes the log if no other store owns it and replays it, or empties the log and the DBs when truncate is set.
+    // A read-only log only opens the DBs for reading. Returns false if the DBs cannot be opened.
+    bool open(bool truncate, bool readOnly = false);
+    // Makes the DBs written by the store that owns the log since they were opened visible to a store that does not
+    bool refresh();
+    bool ownsLog() { return owner; }
+    // Reads the block map of a DB whose blocks can be relocated
+    bool loadBlockMap(FileId file, unsigned long blockSize);
+    // Starts committing groups in the background
+    void start(unsigned long groupBytes, unsigned long groupMillis, unsigned long checkpointBytes);
+    // Called before each commit to sync the files that logged blocks refer to, such as property records
+    void setSyncHook(std::function<void()> hook);
+
+    // A stream that reads and writes the DB through the log. The stream is owned by the caller.
+    std::fstream *openStream(FileId file);
+
+    void beginOperation();
+    void endOperation();
+
+    void write(FileId file, unsigned long offset, const char *data, size_t length);
+    // Reads the DB as if the pending writes were made. Returns the number of bytes read, short at the end of the DB.
+    size_t read(FileId file, unsigned long offset, char *data, size_t length);
+    unsigned long size(FileId file);
+
+    bool commit();
+    bool checkpoint();
+
+    // Runs work with all operations stopped and the pending writes checkpointed
+    bool exclusive(const std::function<bool()> &work);
+    // Same as read() without taking the operation lock. Only for use inside exclusive().
+    size_t readExclusive(FileId file, unsigned long offset, char *data, size_t length);
+
+    // Relocation rewrites the DB so that its logical blocks are stored in a given order from physical block 1 on, while
+    // operations go on. beginRelocation() starts recording the blocks that are written and returns the number of blocks
+    // of the DB. copyBlocks() copies those blocks to a new DB in the order, which must hold each of them but block 0
+    // once, and keeps block 0 in its place. finishRelocation(), which is for use inside exclusive(), copies the blocks
+    // written or added since and replaces the DB. A relocation that fails before finishRelocation() is ended with
+    // cancelRelocation().
+    unsigned long beginRelocation(FileId file);
+    bool copyBlocks(FileId file, const std::vector<unsigned int> &order);
+    bool finishRelocation(FileId file);
+    void cancelRelocation(FileId file);
+
+ private:
+    typedef std::map<unsigned long, std::string> Extents;  // Pending writes of a DB by offset, never overlapping
+
+    std::string path;
+    std::vector<std::string> filePaths;
+    int fd;
+    bool owner;
+    bool readOnly;
+    int fds[FILE_COUNT];
+    unsigned long fileSizes[FILE_COUNT];
+    unsigned long blockSizes[FILE_COUNT];
+    unsigned int generations[FILE_COUNT];
+    std::vector<unsigned int> blockMaps[FILE_COUNT];  // Physical block of logical block i + 1
+    struct Relocation {
+        bool active = false;              // Changed only with the operation lock held exclusively
+        unsigned long blocks = 0;         // Blocks of the DB when the relocation began
+        std::set<unsigned long> written;  // Logical blocks written since, guarded by the pending lock
+        int fd = -1;                      // The new DB
+        std::vector<unsigned int> map;    // Block map of the new DB
+    } relocations[FILE_COUNT];
+    std::atomic<unsigned long> logSize;
+    unsigned long groupBytes;
+    unsigned long groupMillis;
+    unsigned long checkpointBytes;
+    std::function<void()> syncHook;
+
+    // Held shared by operations and exclusively by commits
+    pthread_rwlock_t operationLock;
+    static thread_local WriteAheadLog *operationLog;
+    static thread_local int operationDepth;
+
+    std::mutex pendingLock;
+    std::string pendingLog;
+    Extents pending[FILE_COUNT];
+
+    std::thread committer;
+    std::mutex committerLock;
+    std::condition_variable committerCondition;
+    bool stopping;
+    std::atomic<bool> commitRequested;
+    std::vector<WALFileBuf *> buffers;
+
+    bool replay();
+    std::string mapPath(FileId file, unsigned int generation);
+    unsigned long physical(FileId file, unsigned long offset);
+    unsigned long sizeLocked(FileId file);
+    size_t readPhysical(FileId file, unsigned long offset, char *data, size_t length);
+    void writePhysical(FileId file, unsigned long offset, const char *data, size_t length);
+    bool commitLocked();
+    bool checkpointLocked();
+    void endRelocation(FileId file);
+    void run();
+};
+
+#endif  // JASMINEGRAPH_WRITEAHEADLOG_H
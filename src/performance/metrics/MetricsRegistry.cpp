@@ -0,0 +1,336 @@
+/**
+Copyright 2024 JasmineGraph Team
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#include "MetricsRegistry.h"
+
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+
+#include "../../util/logger/Logger.h"
+
+Logger metrics_logger;
+
+static std::string formatValue(double value) {
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%.17g", value);
+    return buffer;
+}
+
+static void addSample(std::string &out, const std::string &name, const std::string &labels, const std::string &value) {
+    out += name;
+    if (!labels.empty()) {
+        out += "{" + labels + "}";
+    }
+    out += " " + value + "\n";
+}
+
+static void addDouble(std::atomic<double> &target, double amount) {
+    double expected = target.load(std::memory_order_relaxed);
+    while (!target.compare_exchange_weak(expected, expected + amount, std::memory_order_relaxed)) {
+    }
+}
+
+static int threadShard() {
+    static std::atomic<int> nextShard(0);
+    thread_local int shard = nextShard.fetch_add(1, std::memory_order_relaxed);
+    return shard;
+}
+
+Counter::Counter() {
+    for (int i = 0; i < SHARDS; i++) {
+        shards[i].value.store(0, std::memory_order_relaxed);
+    }
+}
+
+void *Counter::operator new(size_t size) {
+    void *pointer = NULL;
+    if (posix_memalign(&pointer, alignof(Counter), size) != 0) {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void Counter::operator delete(void *pointer) { free(pointer); }
+
+void Counter::inc(long amount) { shards[threadShard() % SHARDS].value.fetch_add(amount, std::memory_order_relaxed); }
+
+long Counter::value() const {
+    long total = 0;
+    for (int i = 0; i < SHARDS; i++) {
+        total += shards[i].value.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+void Counter::render(const std::string &name, const std::string &labels, std::string &out) const {
+    addSample(out, name, labels, std::to_string(value()));
+}
+
+Gauge::Gauge() : current(0) {}
+
+void Gauge::set(double value) { current.store(value, std::memory_order_relaxed); }
+
+void Gauge::add(double amount) { addDouble(current, amount); }
+
+double Gauge::value() const { return current.load(std::memory_order_relaxed); }
+
+void Gauge::render(const std::string &name, const std::string &labels, std::string &out) const {
+    addSample(out, name, labels, formatValue(value()));
+}
+
+Histogram::Histogram(const std::vector<double> &bounds) : bounds(bounds), buckets(bounds.size() + 1), total(0) {
+    for (auto &bucket : buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+void Histogram::observe(double value) {
+    size_t bucket = std::lower_bound(bounds.begin(), bounds.end(), value) - bounds.begin();
+    buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    addDouble(total, value);
+}
+
+long Histogram::count() const {
+    long observations = 0;
+    for (auto &bucket : buckets) {
+        observations += bucket.load(std::memory_order_relaxed);
+    }
+    return observations;
+}
+
+double Histogram::sum() const { return total.load(std::memory_order_relaxed); }
+
+std::vector<long> Histogram::bucketCounts() const {
+    std::vector<long> counts;
+    for (auto &bucket : buckets) {
+        counts.push_back(bucket.load(std::memory_order_relaxed));
+    }
+    return counts;
+}
+
+void Histogram::render(const std::string &name, const std::string &labels, std::string &out) const {
+    std::string prefix = labels.empty() ? "" : labels + ",";
+    long cumulative = 0;
+    for (size_t i = 0; i < bounds.size(); i++) {
+        cumulative += buckets[i].load(std::memory_order_relaxed);
+        addSample(out, name + "_bucket", prefix + "le=\"" + formatValue(bounds[i]) + "\"", std::to_string(cumulative));
+    }
+    cumulative += buckets[bounds.size()].load(std::memory_order_relaxed);
+    addSample(out, name + "_bucket", prefix + "le=\"+Inf\"", std::to_string(cumulative));
+    addSample(out, name + "_sum", labels, formatValue(sum()));
+    addSample(out, name + "_count", labels, std::to_string(cumulative));
+}
+
+std::vector<double> Histogram::exponentialBounds(double start, double factor, int count) {
+    std::vector<double> result;
+    double bound = start;
+    for (int i = 0; i < count; i++) {
+        result.push_back(bound);
+        bound *= factor;
+    }
+    return result;
+}
+
+const std::vector<double> &Histogram::latencyBounds() {
+    static const std::vector<double> bounds = exponentialBounds(0.0001, 2, 20);
+    return bounds;
+}
+
+ScopedTimer::ScopedTimer(Histogram &histogram) : histogram(histogram), start(std::chrono::steady_clock::now()) {}
+
+ScopedTimer::~ScopedTimer() {
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    histogram.observe(elapsed.count());
+}
+
+namespace {
+struct Family {
+    std::string type;
+    std::string help;
+    std::map<std::string, std::unique_ptr<Metric>> metrics;  // rendered labels => metric
+};
+}  // namespace
+
+static std::mutex registryMutex;
+static std::map<std::string, Family> families;
+// Metrics whose name was already registered with another type. They work but are not exported.
+static std::vector<std::unique_ptr<Metric>> orphans;
+static std::mutex collectorMutex;
+static std::map<int, std::function<void()>> collectors;
+static int nextCollectorId = 0;
+
+static std::string renderLabels(const MetricsRegistry::Labels &labels) {
+    std::string rendered;
+    for (auto it = labels.begin(); it != labels.end(); it++) {
+        if (!rendered.empty()) {
+            rendered += ",";
+        }
+        rendered += it->first + "=\"";
+        for (char c : it->second) {
+            if (c == '\\' || c == '"') {
+                rendered += '\\';
+                rendered += c;
+            } else if (c == '\n') {
+                rendered += "\\n";
+            } else {
+                rendered += c;
+            }
+        }
+        rendered += "\"";
+    }
+    return rendered;
+}
+
+template <typename T>
+static T &getOrCreate(const std::string &name, const std::string &help, const std::string &type,
+                      const MetricsRegistry::Labels &labels, std::function<T *()> create) {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    Family &family = families[name];
+    if (family.type.empty()) {
+        family.type = type;
+        family.help = help;
+    } else if (family.type != type) {
+        metrics_logger.error("Metric " + name + " is already registered as a " + family.type);
+        orphans.emplace_back(create());
+        return *static_cast<T *>(orphans.back().get());
+    }
+    std::unique_ptr<Metric> &metric = family.metrics[renderLabels(labels)];
+    if (!metric) {
+        metric.reset(create());
+    }
+    return *static_cast<T *>(metric.get());
+}
+
+Counter &MetricsRegistry::counter(const std::string &name, const std::string &help, const Labels &labels) {
+    return getOrCreate<Counter>(name, help, "counter", labels, [] { return new Counter(); });
+}
+
+Gauge &MetricsRegistry::gauge(const std::string &name, const std::string &help, const Labels &labels) {
+    return getOrCreate<Gauge>(name, help, "gauge", labels, [] { return new Gauge(); });
+}
+
+Histogram &MetricsRegistry::histogram(const std::string &name, const std::string &help, const Labels &labels,
+                                      const std::vector<double> &bounds) {
+    return getOrCreate<Histogram>(name, help, "histogram", labels, [&bounds] { return new Histogram(bounds); });
+}
+
+int MetricsRegistry::addCollector(std::function<void()> collector) {
+    std::lock_guard<std::mutex> lock(collectorMutex);
+    int id = nextCollectorId++;
+    collectors[id] = collector;
+    return id;
+}
+
+void MetricsRegistry::removeCollector(int id) {
+    std::lock_guard<std::mutex> lock(collectorMutex);
+    collectors.erase(id);
+}
+
+std::string MetricsRegistry::render() {
+    {
+        std::lock_guard<std::mutex> lock(collectorMutex);
+        for (auto it = collectors.begin(); it != collectors.end(); it++) {
+            it->second();
+        }
+    }
+
+    std::string out;
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for (auto it = families.begin(); it != families.end(); it++) {
+        const Family &family = it->second;
+        out += "# HELP " + it->first + " " + family.help + "\n";
+        out += "# TYPE " + it->first + " " + family.type + "\n";
+        for (auto metricIt = family.metrics.begin(); metricIt != family.metrics.end(); metricIt++) {
+            metricIt->second->render(it->first, metricIt->first, out);
+        }
+    }
+    return out;
+}
+
+static const int METRICS_CONNECTION_TIMEOUT_SECONDS = 2;
+
+static bool sendAll(int fd, const std::string &data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            return false;
+        }
+        sent += n;
+    }
+    return true;
+}
+
+static void serveMetrics(int listenFd) {
+    while (true) {
+        int connFd = accept(listenFd, NULL, NULL);
+        if (connFd < 0) {
+            continue;
+        }
+        // A client that connects and never sends its request, or never reads the reply, would otherwise stall the
+        // endpoint for every scraper after it
+        struct timeval timeout = {METRICS_CONNECTION_TIMEOUT_SECONDS, 0};
+        setsockopt(connFd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(connFd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        char request[1024];
+        ssize_t length = recv(connFd, request, sizeof(request) - 1, 0);
+        std::string response;
+        if (length > 0) {
+            request[length] = 0;
+            if (strncmp(request, "GET /metrics", 12) == 0) {
+                std::string body = MetricsRegistry::render();
+                response = "HTTP/1.1 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: " +
+                           std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+            } else {
+                response = "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+            }
+            sendAll(connFd, response);
+        }
+        close(connFd);
+    }
+}
+
+bool MetricsRegistry::startEndpoint(int port) {
+    int listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    if (listenFd < 0) {
+        metrics_logger.error("Cannot create socket for the metrics endpoint");
+        return false;
+    }
+    int reuse = 1;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = INADDR_ANY;
+    address.sin_port = htons(port);
+    if (bind(listenFd, (struct sockaddr *)&address, sizeof(address)) < 0 || listen(listenFd, 16) < 0) {
+        metrics_logger.error("Cannot serve metrics on port " + std::to_string(port));
+        close(listenFd);
+        return false;
+    }
+    std::thread(serveMetrics, listenFd).detach();
+    metrics_logger.info("Serving metrics on port " + std::to_string(port));
+    return true;
+}
@@ -0,0 +1,127 @@
+/**
+Copyright 2024 JasmineGraph Team
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#ifndef JASMINEGRAPH_METRICSREGISTRY_H
+#define JASMINEGRAPH_METRICSREGISTRY_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+class Metric {
+ public:
+    virtual ~Metric() {}
+    // Appends the samples of the metric in the Prometheus text format. `labels` is the rendered label list.
+    virtual void render(const std::string &name, const std::string &labels, std::string &out) const = 0;
+};
+
+// Monotonic counter. Increments go to one of several cache line sized shards picked per thread, so threads counting
+// on the same hot path do not contend on one cache line.
+class Counter : public Metric {
+ public:
+    Counter();
+
+    // The global operator new of C++11 does not align beyond alignof(max_align_t), which the shards need
+    static void *operator new(size_t size);
+    static void operator delete(void *pointer);
+
+    void inc(long amount = 1);
+    long value() const;
+    void render(const std::string &name, const std::string &labels, std::string &out) const override;
+
+ private:
+    static const int SHARDS = 16;
+    struct alignas(64) Shard {
+        std::atomic<long> value;
+    };
+    Shard shards[SHARDS];
+};
+
+class Gauge : public Metric {
+ public:
+    Gauge();
+
+    void set(double value);
+    void add(double amount);
+    double value() const;
+    void render(const std::string &name, const std::string &labels, std::string &out) const override;
+
+ private:
+    std::atomic<double> current;
+};
+
+// Histogram with fixed exponential bucket bounds, so that relative precision is the same from microseconds to minutes
+class Histogram : public Metric {
+ public:
+    explicit Histogram(const std::vector<double> &bounds);
+
+    void observe(double value);
+    long count() const;
+    double sum() const;
+    // Number of observations in each bucket, the last one being the overflow bucket. Not cumulative.
+    std::vector<long> bucketCounts() const;
+    void render(const std::string &name, const std::string &labels, std::string &out) const override;
+
+    static std::vector<double> exponentialBounds(double start, double factor, int count);
+    // 100 us to about 52 s, doubling
+    static const std::vector<double> &latencyBounds();
+
+ private:
+    std::vector<double> bounds;
+    std::vector<std::atomic<long>> buckets;
+    std::atomic<double> total;
+};
+
+// Observes the seconds elapsed between its construction and destruction
+class ScopedTimer {
+ public:
+    explicit ScopedTimer(Histogram &histogram);
+    ~ScopedTimer();
+
+ private:
+    Histogram &histogram;
+    std::chrono::steady_clock::time_point start;
+};
+
+/*
+ * Process wide registry of metrics served on the /metrics endpoint.
+ *
+ * Metrics are created on first use and live until the process exits, so callers keep the returned reference, usually
+ * in a function local static, and update it without going through the registry again. Collectors are run before
+ * every scrape to refresh gauges whose values are kept elsewhere.
+ * */
+class MetricsRegistry {
+ public:
+    typedef std::map<std::string, std::string> Labels;
+
+    static Counter &counter(const std::string &name, const std::string &help, const Labels &labels = Labels());
+    static Gauge &gauge(const std::string &name, const std::string &help, const Labels &labels = Labels());
+    static Histogram &histogram(const std::string &name, const std::string &help, const Labels &labels = Labels(),
+                                const std::vector<double> &bounds = Histogram::latencyBounds());
+
+    // Returns an id for removeCollector()
+    static int addCollector(std::function<void()> collector);
+    static void removeCollector(int id);
+
+    // All metrics in the Prometheus text exposition format
+    static std::string render();
+
+    // Serves GET /metrics on the given port from a background thread. Returns false if the port cannot be bound.
+    static bool startEndpoint(int port);
+};
+
+#endif  // JASMINEGRAPH_METRICSREGISTRY_H
@@ -35,37 +35,9 @@ void PerformanceUtil::init() {
 }
 
 int PerformanceUtil::collectPerformanceStatistics() {
-    // Host level
-    double cpuUsage = StatisticCollector::getCpuUsage();
-    Utils::send_job("", "cpu_usage", std::to_string(cpuUsage));
-
-    long rxBytes = StatisticCollector::getRXBytes();
-    Utils::send_job("", "rx_bytes", std::to_string(rxBytes));
-
-    long txBytes = StatisticCollector::getTXBytes();
-    Utils::send_job("", "tx_bytes", std::to_string(txBytes));
-
-    long totalMemoryUsage = StatisticCollector::getTotalMemoryUsage();
-    Utils::send_job("", "total_memory", std::to_string(totalMemoryUsage));
-
-    long usedSwapSpace = StatisticCollector::getUsedSwapSpace();
-    Utils::send_job("", "used_swap_space", std::to_string(usedSwapSpace));
-
-    double currentLoadAverage = StatisticCollector::getLoadAverage();
-    Utils::send_job("", "load_average", std::to_string(currentLoadAverage));
-
-    long totalSwapSpace = StatisticCollector::getTotalSwapSpace();
-    Utils::send_job("", "total_swap_space", std::to_string(totalSwapSpace));
-
-    // Per process
-    long memoryUsage = StatisticCollector::getMemoryUsageByProcess();
-    Utils::send_job("", "memory_usage", std::to_string(memoryUsage));
-
-    int threadCount = StatisticCollector::getThreadCount();
-    Utils::send_job("", "thread_count", std::to_string(threadCount));
-
-    int socketCount = StatisticCollector::getSocketCount();
-    Utils::send_job("", "socket_count", std::to_string(socketCount));
+    // The sampler keeps the statistics up to date in the background, so pushing them is a single request
+    const StatisticsSampler::Snapshot &snapshot = StatisticsSampler::latest();
+    Utils::send_jobs("", StatisticsSampler::toMetrics(snapshot));
 
     scheduler_logger.info("Pushed performance metrics");
     return 0;
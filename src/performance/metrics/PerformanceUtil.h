@@ -32,6 +32,7 @@ limitations under the License.
 #include "../../util/Utils.h"
 #include "../../util/logger/Logger.h"
 #include "StatisticCollector.h"
+#include "StatisticsSampler.h"
 
 #ifndef JASMINEGRAPH_PERFORMANCEUTIL_H
 #define JASMINEGRAPH_PERFORMANCEUTIL_H
@@ -116,6 +116,9 @@ long StatisticCollector::getTotalSwapSpace() {
 long StatisticCollector::getRXBytes() {
     FILE *file = fopen("/sys/class/net/eth0/statistics/rx_bytes", "r");
     long result = -1;
+    if (!file) {
+        return result;
+    }
     fscanf(file, "%li", &result);
     fclose(file);
     return result;
@@ -124,6 +127,9 @@ long StatisticCollector::getRXBytes() {
 long StatisticCollector::getTXBytes() {
     FILE *file = fopen("/sys/class/net/eth0/statistics/tx_bytes", "r");
     long result = -1;
+    if (!file) {
+        return result;
+    }
     fscanf(file, "%li", &result);
     fclose(file);
     return result;
@@ -143,9 +149,10 @@ int StatisticCollector::getSocketCount() {
         const char *filename = dir->d_name;
         if (filename[0] < '0' || '9' < filename[0]) continue;
         sprintf(path, "/proc/self/fd/%s", filename);
-        size_t len = readlink(path, link_buf, sizeof(link_buf) - 1);
+        ssize_t len = readlink(path, link_buf, sizeof(link_buf) - 1);
+        if (len <= 0) continue;
         link_buf[len] = 0;
-        if (len > 0 && strncmp("socket:", link_buf, 7) == 0) {
+        if (strncmp("socket:", link_buf, 7) == 0) {
             count++;
         }
     }
@@ -163,7 +170,7 @@ static long parseLine(char *line) {
     return val;
 }
 
-static void getCpuCycles(long long *totalp, long long *idlep) {
+void StatisticCollector::getCpuCycles(long long *totalp, long long *idlep) {
     *totalp = 0;
     *idlep = 0;
     FILE *fp = fopen("/proc/stat", "r");
@@ -49,6 +49,8 @@ class StatisticCollector {
     static long getTXBytes();
     static int getSocketCount();
     static double getCpuUsage();
+    // Cumulative CPU time of all cores and the idle part of it, in clock ticks
+    static void getCpuCycles(long long *totalp, long long *idlep);
     static long getTotalMemoryAllocated();
     static int getTotalNumberofCores();
     static long getTotalMemoryUsage();
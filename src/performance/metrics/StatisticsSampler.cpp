@@ -0,0 +1,173 @@
+/**
+Copyright 2024 JasmineGraph Team
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#include "StatisticsSampler.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "../../util/logger/Logger.h"
+#include "MetricsRegistry.h"
+#include "StatisticCollector.h"
+
+Logger sampler_logger;
+
+static SnapshotRing<StatisticsSampler::Snapshot, StatisticsSampler::HISTORY_SIZE> snapshots;
+
+static std::mutex samplerMutex;
+static std::condition_variable samplerCondition;
+static std::thread samplerThread;
+static bool samplerRunning = false;
+
+// Counters of the previous sample, from which usage and rates are derived
+static std::mutex counterMutex;
+static bool haveCounters = false;
+static long long lastCpuTotal = 0;
+static long long lastCpuIdle = 0;
+static long lastRxBytes = 0;
+static long lastTxBytes = 0;
+static long lastTimestamp = 0;
+
+void StatisticsSampler::start(int intervalSeconds) {
+    if (intervalSeconds <= 0) {
+        intervalSeconds = 1;
+    }
+    std::lock_guard<std::mutex> lock(samplerMutex);
+    if (samplerRunning) {
+        return;
+    }
+    samplerRunning = true;
+    samplerThread = std::thread(&StatisticsSampler::run, intervalSeconds);
+    MetricsRegistry::addCollector([] {
+        Snapshot snapshot;
+        if (!snapshots.latest(snapshot)) {
+            return;
+        }
+        for (const auto &metric : toMetrics(snapshot)) {
+            MetricsRegistry::gauge("jasminegraph_" + metric.first, "Latest sample of " + metric.first)
+                .set(atof(metric.second.c_str()));
+        }
+    });
+    sampler_logger.info("Sampling statistics every " + std::to_string(intervalSeconds) + " seconds");
+}
+
+void StatisticsSampler::stop() {
+    {
+        std::lock_guard<std::mutex> lock(samplerMutex);
+        if (!samplerRunning) {
+            return;
+        }
+        samplerRunning = false;
+    }
+    samplerCondition.notify_all();
+    if (samplerThread.joinable()) {
+        samplerThread.join();
+    }
+}
+
+void StatisticsSampler::run(int intervalSeconds) {
+    std::unique_lock<std::mutex> lock(samplerMutex);
+    while (samplerRunning) {
+        lock.unlock();
+        snapshots.push(sample());
+        lock.lock();
+        samplerCondition.wait_for(lock, std::chrono::seconds(intervalSeconds), [] { return !samplerRunning; });
+    }
+}
+
+StatisticsSampler::Snapshot StatisticsSampler::latest() {
+    Snapshot snapshot;
+    if (snapshots.latest(snapshot)) {
+        return snapshot;
+    }
+    return sample();
+}
+
+std::vector<StatisticsSampler::Snapshot> StatisticsSampler::history() {
+    std::vector<Snapshot> result;
+    Snapshot snapshot;
+    for (size_t age = snapshots.size(); age > 0; age--) {
+        if (snapshots.get(age - 1, snapshot)) {
+            result.push_back(snapshot);
+        }
+    }
+    return result;
+}
+
+StatisticsSampler::Snapshot StatisticsSampler::sample() {
+    Snapshot snapshot;
+    snapshot.timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
+                             std::chrono::system_clock::now().time_since_epoch())
+                             .count();
+    snapshot.loadAverage = StatisticCollector::getLoadAverage();
+    snapshot.totalMemoryUsage = StatisticCollector::getTotalMemoryUsage();
+    snapshot.totalMemory = StatisticCollector::getTotalMemoryAllocated();
+    snapshot.usedSwapSpace = StatisticCollector::getUsedSwapSpace();
+    snapshot.totalSwapSpace = StatisticCollector::getTotalSwapSpace();
+    snapshot.rxBytes = StatisticCollector::getRXBytes();
+    snapshot.txBytes = StatisticCollector::getTXBytes();
+    snapshot.processMemoryUsage = StatisticCollector::getMemoryUsageByProcess();
+    snapshot.threadCount = StatisticCollector::getThreadCount();
+    snapshot.socketCount = StatisticCollector::getSocketCount();
+
+    long long cpuTotal;
+    long long cpuIdle;
+    StatisticCollector::getCpuCycles(&cpuTotal, &cpuIdle);
+
+    std::lock_guard<std::mutex> lock(counterMutex);
+    snapshot.cpuUsage = 0;
+    snapshot.rxBytesPerSecond = 0;
+    snapshot.txBytesPerSecond = 0;
+    if (haveCounters) {
+        long long diffTotal = cpuTotal - lastCpuTotal;
+        if (diffTotal > 0) {
+            snapshot.cpuUsage = (diffTotal - (cpuIdle - lastCpuIdle)) / (double)diffTotal;
+        }
+        double seconds = (snapshot.timestamp - lastTimestamp) / 1000.0;
+        if (seconds > 0) {
+            snapshot.rxBytesPerSecond = (snapshot.rxBytes - lastRxBytes) / seconds;
+            snapshot.txBytesPerSecond = (snapshot.txBytes - lastTxBytes) / seconds;
+        }
+    } else if (cpuTotal > 0) {
+        // Without a previous sample the usage since boot is the best estimate
+        snapshot.cpuUsage = (cpuTotal - cpuIdle) / (double)cpuTotal;
+    }
+    haveCounters = true;
+    lastCpuTotal = cpuTotal;
+    lastCpuIdle = cpuIdle;
+    lastRxBytes = snapshot.rxBytes;
+    lastTxBytes = snapshot.txBytes;
+    lastTimestamp = snapshot.timestamp;
+    return snapshot;
+}
+
+std::vector<std::pair<std::string, std::string>> StatisticsSampler::toMetrics(const Snapshot &snapshot) {
+    return {
+        // Host level
+        {"cpu_usage", std::to_string(snapshot.cpuUsage)},
+        {"rx_bytes", std::to_string(snapshot.rxBytes)},
+        {"tx_bytes", std::to_string(snapshot.txBytes)},
+        {"rx_bytes_per_second", std::to_string(snapshot.rxBytesPerSecond)},
+        {"tx_bytes_per_second", std::to_string(snapshot.txBytesPerSecond)},
+        {"total_memory", std::to_string(snapshot.totalMemoryUsage)},
+        {"used_swap_space", std::to_string(snapshot.usedSwapSpace)},
+        {"load_average", std::to_string(snapshot.loadAverage)},
+        {"total_swap_space", std::to_string(snapshot.totalSwapSpace)},
+        // Per process
+        {"memory_usage", std::to_string(snapshot.processMemoryUsage)},
+        {"thread_count", std::to_string(snapshot.threadCount)},
+        {"socket_count", std::to_string(snapshot.socketCount)},
+    };
+}
@@ -0,0 +1,138 @@
+/**
+Copyright 2024 JasmineGraph Team
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#ifndef JASMINEGRAPH_STATISTICSSAMPLER_H
+#define JASMINEGRAPH_STATISTICSSAMPLER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+ * Ring of the most recent snapshots with one writer and any number of readers.
+ *
+ * Every slot carries a sequence number that is odd while the writer is filling it. Readers copy a slot and retry if
+ * its sequence changed or was odd, so neither side ever takes a lock.
+ * */
+template <typename T, size_t CAPACITY>
+class SnapshotRing {
+ public:
+    SnapshotRing() : written(0) {
+        for (size_t i = 0; i < CAPACITY; i++) {
+            slots[i].sequence.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    // Must only be called from the writer thread
+    void push(const T &value) {
+        uint64_t index = written.load(std::memory_order_relaxed);
+        Slot &slot = slots[index % CAPACITY];
+        uint64_t sequence = slot.sequence.load(std::memory_order_relaxed);
+        slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.value = value;
+        slot.sequence.store(sequence + 2, std::memory_order_release);
+        written.store(index + 1, std::memory_order_release);
+    }
+
+    // Copies the latest snapshot. Returns false if nothing was written yet.
+    bool latest(T &value) const { return get(0, value); }
+
+    // Copies the snapshot `age` pushes before the latest one. Returns false if it was overwritten or never written.
+    bool get(size_t age, T &value) const {
+        while (true) {
+            uint64_t count = written.load(std::memory_order_acquire);
+            if (age >= count || age >= CAPACITY) {
+                return false;
+            }
+            const Slot &slot = slots[(count - 1 - age) % CAPACITY];
+            uint64_t before = slot.sequence.load(std::memory_order_acquire);
+            if (before & 1) {
+                continue;
+            }
+            value = slot.value;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            uint64_t after = slot.sequence.load(std::memory_order_relaxed);
+            if (before == after && written.load(std::memory_order_acquire) - count < CAPACITY - age) {
+                return true;
+            }
+        }
+    }
+
+    uint64_t size() const {
+        uint64_t count = written.load(std::memory_order_acquire);
+        return count < CAPACITY ? count : CAPACITY;
+    }
+
+ private:
+    struct Slot {
+        std::atomic<uint64_t> sequence;
+        T value;
+    };
+
+    Slot slots[CAPACITY];
+    std::atomic<uint64_t> written;
+};
+
+/*
+ * Samples host and process statistics from /proc on a background thread.
+ *
+ * Counters such as CPU time and network bytes are turned into usage and rates from the difference to the previous
+ * sample, so reading the latest values never blocks. Schedulers, SLA estimation and the metric push read the latest
+ * snapshot instead of sampling themselves.
+ * */
+class StatisticsSampler {
+ public:
+    struct Snapshot {
+        long timestamp;  // milliseconds since epoch
+        double cpuUsage;
+        double loadAverage;
+        long totalMemoryUsage;
+        long totalMemory;
+        long usedSwapSpace;
+        long totalSwapSpace;
+        long rxBytes;
+        long txBytes;
+        double rxBytesPerSecond;
+        double txBytesPerSecond;
+        long processMemoryUsage;
+        int threadCount;
+        int socketCount;
+    };
+
+    static const size_t HISTORY_SIZE = 64;
+
+    // Starts the sampling thread. Calling it again has no effect.
+    static void start(int intervalSeconds);
+
+    static void stop();
+
+    // Copies the latest snapshot. Takes a sample on the calling thread if the sampler has not produced one yet.
+    static Snapshot latest();
+
+    // Snapshots from the oldest to the latest one still in the ring
+    static std::vector<Snapshot> history();
+
+    // Metric name and value pairs in the form they are pushed to Prometheus
+    static std::vector<std::pair<std::string, std::string>> toMetrics(const Snapshot &snapshot);
+
+ private:
+    static Snapshot sample();
+    static void run(int intervalSeconds);
+};
+
+#endif  // JASMINEGRAPH_STATISTICSSAMPLER_H
@@ -28,9 +28,9 @@ int PerformanceSQLiteDBInterface::init() {
         }
     }
 
-    int rc = sqlite3_open(this->databaseLocation.c_str(), &database);
+    int rc = openPool();
     if (rc) {
-        perfdb_logger.error("Cannot open database: " + string(sqlite3_errmsg(database)));
+        perfdb_logger.error("Cannot open database: " + this->databaseLocation);
         return -1;
     }
     perfdb_logger.info("Database opened successfully");
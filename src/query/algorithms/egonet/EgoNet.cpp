@@ -0,0 +1,221 @@
+/**
+Copyright 2024 JasmineGraph Team
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#include "EgoNet.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "../../../util/logger/Logger.h"
+
+Logger egonet_logger;
+
+static const char EGONET_MAGIC[4] = {'J', 'G', 'E', 'N'};
+static const size_t EGONET_BUFFER_SIZE = 256 * 1024;
+// Gallop through the longer list when it is this many times longer than the shorter one
+static const size_t GALLOP_RATIO = 32;
+
+EgoNet::EgoNet() : cacheNeighbours(false) {}
+
+void EgoNet::addStore(const AdjacencyMap &store) { stores.push_back(&store); }
+
+void EgoNet::addReverseStore(const AdjacencyMap &store) {
+    for (auto it = store.begin(); it != store.end(); it++) {
+        for (long vertex : it->second) {
+            reverse[vertex].push_back(it->first);
+        }
+    }
+}
+
+void EgoNet::collectNeighbours(long vertex, std::vector<long> &out) const {
+    out.clear();
+    for (const AdjacencyMap *store : stores) {
+        auto it = store->find(vertex);
+        if (it != store->end()) {
+            out.insert(out.end(), it->second.begin(), it->second.end());
+        }
+    }
+    auto reverseIt = reverse.find(vertex);
+    if (reverseIt != reverse.end()) {
+        out.insert(out.end(), reverseIt->second.begin(), reverseIt->second.end());
+    }
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+}
+
+const std::vector<long> &EgoNet::getNeighbours(long vertex) {
+    if (!cacheNeighbours) {
+        collectNeighbours(vertex, scratch);
+        return scratch;
+    }
+    auto it = neighbourCache.find(vertex);
+    if (it == neighbourCache.end()) {
+        it = neighbourCache.emplace(vertex, std::vector<long>()).first;
+        collectNeighbours(vertex, it->second);
+        it->second.shrink_to_fit();
+    }
+    return it->second;
+}
+
+void EgoNet::intersect(const std::vector<long> &a, const std::vector<long> &b, std::vector<long> &out) {
+    const std::vector<long> &small = a.size() <= b.size() ? a : b;
+    const std::vector<long> &large = a.size() <= b.size() ? b : a;
+    if (small.empty()) {
+        return;
+    }
+    if (small.size() * GALLOP_RATIO < large.size()) {
+        auto position = large.begin();
+        for (long value : small) {
+            // Everything before low is smaller than value. high is the end or not smaller than value.
+            auto low = position;
+            auto high = position;
+            size_t step = 1;
+            while (high != large.end() && *high < value) {
+                low = high + 1;
+                high = (size_t)(large.end() - low) > step ? low + step : large.end();
+                step <<= 1;
+            }
+            position = std::lower_bound(low, high, value);
+            if (position == large.end()) {
+                return;
+            }
+            if (*position == value) {
+                out.push_back(value);
+            }
+        }
+        return;
+    }
+    auto i = a.begin();
+    auto j = b.begin();
+    while (i != a.end() && j != b.end()) {
+        if (*i < *j) {
+            i++;
+        } else if (*j < *i) {
+            j++;
+        } else {
+            out.push_back(*i);
+            i++;
+            j++;
+        }
+    }
+}
+
+long EgoNet::stream(long ego, const EdgeSink &sink) {
+    // Copied because the neighbour lists of the neighbours are built in the same buffer
+    const std::vector<long> egoNeighbours = getNeighbours(ego);
+    long edges = 0;
+    for (long neighbour : egoNeighbours) {
+        if (neighbour != ego) {
+            sink(ego, ego, neighbour);
+            edges++;
+        }
+    }
+    std::vector<long> common;
+    for (long neighbour : egoNeighbours) {
+        if (neighbour == ego) {
+            continue;
+        }
+        common.clear();
+        intersect(getNeighbours(neighbour), egoNeighbours, common);
+        for (long vertex : common) {
+            if (vertex != neighbour && vertex != ego) {
+                sink(ego, neighbour, vertex);
+                edges++;
+            }
+        }
+    }
+    return edges;
+}
+
+long EgoNet::streamAll(const EdgeSink &sink) {
+    // The stores are sorted maps, so the egos come out of a k-way merge of their keys in ascending order
+    std::vector<std::pair<AdjacencyMap::const_iterator, AdjacencyMap::const_iterator>> cursors;
+    for (const AdjacencyMap *store : stores) {
+        cursors.push_back(std::make_pair(store->begin(), store->end()));
+    }
+    long edges = 0;
+    while (true) {
+        bool found = false;
+        long ego = 0;
+        for (auto &cursor : cursors) {
+            if (cursor.first != cursor.second && (!found || cursor.first->first < ego)) {
+                ego = cursor.first->first;
+                found = true;
+            }
+        }
+        if (!found) {
+            break;
+        }
+        for (auto &cursor : cursors) {
+            if (cursor.first != cursor.second && cursor.first->first == ego) {
+                cursor.first++;
+            }
+        }
+        edges += stream(ego, sink);
+    }
+    return edges;
+}
+
+long EgoNet::writeAll(const std::string &filePath) {
+    FILE *file = fopen(filePath.c_str(), "wb");
+    if (!file) {
+        egonet_logger.error("Cannot open " + filePath + " for writing");
+        return -1;
+    }
+    setvbuf(file, NULL, _IOFBF, EGONET_BUFFER_SIZE);
+    bool failed = fwrite(EGONET_MAGIC, 1, sizeof(EGONET_MAGIC), file) != sizeof(EGONET_MAGIC);
+    long edges = streamAll([file, &failed](long ego, long from, long to) {
+        int64_t edge[3] = {ego, from, to};
+        if (!failed && fwrite(edge, sizeof(edge), 1, file) != 1) {
+            failed = true;
+        }
+    });
+    failed = (fclose(file) != 0) || failed;
+    if (failed) {
+        egonet_logger.error("Writing ego networks to " + filePath + " failed");
+        return -1;
+    }
+    return edges;
+}
+
+EgoNetReader::EgoNetReader(const std::string &filePath) : file(fopen(filePath.c_str(), "rb")), failed(false) {
+    char magic[sizeof(EGONET_MAGIC)];
+    if (!file || fread(magic, 1, sizeof(magic), file) != sizeof(magic) ||
+        memcmp(magic, EGONET_MAGIC, sizeof(magic)) != 0) {
+        egonet_logger.error("Cannot read ego networks from " + filePath);
+        failed = true;
+    }
+}
+
+EgoNetReader::~EgoNetReader() {
+    if (file) {
+        fclose(file);
+    }
+}
+
+bool EgoNetReader::next(long &ego, long &from, long &to) {
+    if (failed) {
+        return false;
+    }
+    int64_t edge[3];
+    if (fread(edge, sizeof(edge), 1, file) != 1) {
+        failed = ferror(file) != 0;
+        return false;
+    }
+    ego = edge[0];
+    from = edge[1];
+    to = edge[2];
+    return true;
+}
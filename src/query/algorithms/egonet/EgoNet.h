@@ -0,0 +1,93 @@
+/**
+Copyright 2024 JasmineGraph Team
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#ifndef JASMINEGRAPH_EGONET_H
+#define JASMINEGRAPH_EGONET_H
+
+#include <stdio.h>
+
+#include <functional>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/*
+ * Ego networks computed one ego at a time.
+ *
+ * The ego network of a vertex is the vertex, its neighbours and the edges among them. Neighbour lists are gathered
+ * from a set of adjacency stores, sorted and deduplicated, and the edges among the neighbours are found by
+ * intersecting the sorted neighbour list of each neighbour with the one of the ego. Edges are handed to the sink as
+ * they are found, so memory is bounded by the largest neighbourhood instead of the sum of all ego networks.
+ *
+ * Edges are reported as (ego, from, to): first (ego, ego, n) for every neighbour n, then (ego, n, m) for every
+ * neighbour m of n that is also a neighbour of the ego.
+ * */
+class EgoNet {
+ public:
+    typedef std::map<long, std::unordered_set<long>> AdjacencyMap;
+    typedef std::function<void(long ego, long from, long to)> EdgeSink;
+
+    EgoNet();
+
+    // Neighbours of u in the store are store[u]. The store must outlive the EgoNet.
+    void addStore(const AdjacencyMap &store);
+    // Neighbours of v in the store are the vertices u with v in store[u]. Indexes the store, which can be dropped.
+    void addReverseStore(const AdjacencyMap &store);
+    // Keeps every sorted neighbour list once built. Makes streamAll() faster at the cost of one copy of the stores.
+    void setCacheNeighbours(bool cache) { cacheNeighbours = cache; }
+
+    // Sorted neighbours of the vertex across the stores. The reference is valid until the next call.
+    const std::vector<long> &getNeighbours(long vertex);
+
+    // Streams the ego network of the vertex and returns its number of edges
+    long stream(long ego, const EdgeSink &sink);
+    // Streams the ego networks of the vertices with neighbours in the forward stores, in ascending vertex order
+    long streamAll(const EdgeSink &sink);
+    // Writes the ego networks of streamAll() to a binary file. Returns the number of edges or -1 on failure.
+    long writeAll(const std::string &filePath);
+
+    // Common elements of two sorted vectors, appended to `out`. Gallops through the longer one when the lengths
+    // differ a lot, so that intersecting with the list of a hub costs O(small * log(large)).
+    static void intersect(const std::vector<long> &a, const std::vector<long> &b, std::vector<long> &out);
+
+ private:
+    std::vector<const AdjacencyMap *> stores;
+    std::unordered_map<long, std::vector<long>> reverse;
+    bool cacheNeighbours;
+    std::unordered_map<long, std::vector<long>> neighbourCache;
+    std::vector<long> scratch;
+
+    void collectNeighbours(long vertex, std::vector<long> &out) const;
+};
+
+/*
+ * Binary ego network files start with a magic header followed by one (ego, from, to) triple of 64 bit integers in host
+ * byte order per edge.
+ * */
+class EgoNetReader {
+ public:
+    explicit EgoNetReader(const std::string &filePath);
+    ~EgoNetReader();
+
+    // Returns false at the end of the file or on a read error
+    bool next(long &ego, long &from, long &to);
+    bool good() const { return !failed; }
+
+ private:
+    FILE *file;
+    bool failed;
+};
+
+#endif  // JASMINEGRAPH_EGONET_H
@@ -20,8 +20,9 @@ Logger predictor_logger;
 
 void JasminGraphLinkPredictor::initiateLinkPrediction(std::string graphID, std::string path, std::string masterIP) {
     JasmineGraphServer *jasmineServer = JasmineGraphServer::getInstance();
+    ReplicaLease replicaLease;
     std::map<std::string, JasmineGraphServer::workerPartitions> graphPartitionedHosts =
-        jasmineServer->getGraphPartitionedHosts(graphID);
+        jasmineServer->getGraphPartitionedHosts(graphID, &replicaLease);
 
     std::map<std::string, JasmineGraphServer::workerPartitions> remainHostMap;
     std::string selectedHostName;
@@ -158,7 +159,7 @@ int JasminGraphLinkPredictor::sendQueryToWorker(std::string host, int port, int
                                  "info");
 
             std::string fileName = Utils::getFileName(filePath);
-            int fileSize = Utils::getFileSize(filePath);
+            long fileSize = Utils::getFileSize(filePath);
             std::string fileLength = to_string(fileSize);
 
             bzero(data, 301);
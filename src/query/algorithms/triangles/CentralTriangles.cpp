@@ -0,0 +1,277 @@
+/**
+Copyright 2024 JasmineGraph Team
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#include "CentralTriangles.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "../../../util/logger/Logger.h"
+
+Logger central_triangles_logger;
+
+static const char ADJACENCY_MAGIC[4] = {'J', 'G', 'C', 'A'};
+static const size_t ADJACENCY_BUFFER_SIZE = 256 * 1024;
+
+static inline uint64_t zigzagEncode(long value) { return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63); }
+
+static inline long zigzagDecode(uint64_t value) { return (long)(value >> 1) ^ -(long)(value & 1); }
+
+static inline bool writeVarint(FILE *file, uint64_t value) {
+    uint8_t bytes[10];
+    int count = 0;
+    while (value >= 0x80) {
+        bytes[count++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    bytes[count++] = (uint8_t)value;
+    return fwrite(bytes, 1, count, file) == (size_t)count;
+}
+
+static inline bool readVarint(FILE *file, uint64_t &value) {
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        int byte = getc(file);
+        if (byte == EOF) {
+            return false;
+        }
+        value |= (uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::pair<const long *, const long *> CentralTriangles::OrientedGraph::outNeighbours(long vertex) const {
+    auto it = std::lower_bound(vertices.begin(), vertices.end(), vertex);
+    if (it == vertices.end() || *it != vertex) {
+        return std::make_pair(nullptr, nullptr);
+    }
+    size_t index = it - vertices.begin();
+    const long *base = neighbours.data();
+    return std::make_pair(base + offsets[index], base + offsets[index + 1]);
+}
+
+void CentralTriangles::addEdges(std::map<long, std::unordered_set<long>> &cutGraph,
+                                const std::map<long, std::unordered_set<long>> &edges) {
+    for (auto it = edges.begin(); it != edges.end(); it++) {
+        long from = it->first;
+        for (long to : it->second) {
+            if (from == to) {
+                continue;
+            }
+            cutGraph[from].insert(to);
+            cutGraph[to].insert(from);
+        }
+    }
+}
+
+CentralTriangles::OrientedGraph CentralTriangles::orient(const std::map<long, std::unordered_set<long>> &cutGraph) {
+    auto ranksBelow = [&cutGraph](long vertex, size_t degree, long other) {
+        auto otherIt = cutGraph.find(other);
+        size_t otherDegree = otherIt == cutGraph.end() ? 0 : otherIt->second.size();
+        return degree < otherDegree || (degree == otherDegree && vertex < other);
+    };
+
+    OrientedGraph graph;
+    graph.vertices.reserve(cutGraph.size());
+    graph.offsets.reserve(cutGraph.size() + 1);
+    graph.offsets.push_back(0);
+    for (auto it = cutGraph.begin(); it != cutGraph.end(); it++) {
+        long vertex = it->first;
+        size_t degree = it->second.size();
+        size_t begin = graph.neighbours.size();
+        for (long neighbour : it->second) {
+            if (ranksBelow(vertex, degree, neighbour)) {
+                graph.neighbours.push_back(neighbour);
+            }
+        }
+        std::sort(graph.neighbours.begin() + begin, graph.neighbours.end());
+        graph.vertices.push_back(vertex);
+        graph.offsets.push_back(graph.neighbours.size());
+    }
+    return graph;
+}
+
+long CentralTriangles::countOwnedTriangles(const std::map<long, std::unordered_set<long>> &cutGraph,
+                                           const std::unordered_set<long> &ownedVertices) {
+    return countOwnedTriangles(orient(cutGraph), ownedVertices);
+}
+
+long CentralTriangles::countOwnedTriangles(const OrientedGraph &graph, const std::unordered_set<long> &ownedVertices) {
+    return countOwnedTriangles(
+        graph, [&ownedVertices](long vertex) { return ownedVertices.find(vertex) != ownedVertices.end(); });
+}
+
+long CentralTriangles::countOwnedTriangles(const OrientedGraph &graph, const std::function<bool(long)> &isOwned) {
+    long count = 0;
+    const long *base = graph.neighbours.data();
+    for (size_t i = 0; i < graph.vertices.size(); i++) {
+        if (!isOwned(graph.vertices[i])) {
+            continue;
+        }
+        const long *begin = base + graph.offsets[i];
+        const long *end = base + graph.offsets[i + 1];
+        // With x < y < z in rank order, the triangle is found once at x through its middle vertex y
+        for (const long *middle = begin; middle != end; middle++) {
+            auto middleNeighbours = graph.outNeighbours(*middle);
+            count += intersectionSize(begin, end, middleNeighbours.first, middleNeighbours.second);
+        }
+    }
+    return count;
+}
+
+long CentralTriangles::intersectionSize(const long *first, const long *firstEnd, const long *second,
+                                        const long *secondEnd) {
+    long size = 0;
+    while (first != firstEnd && second != secondEnd) {
+        if (*first < *second) {
+            first++;
+        } else if (*second < *first) {
+            second++;
+        } else {
+            size++;
+            first++;
+            second++;
+        }
+    }
+    return size;
+}
+
+int CentralTriangles::ownerBucket(long vertex, int bucketCount) {
+    // Fibonacci hashing spreads consecutive ids, which partitioners tend to keep together, over the buckets
+    uint64_t hash = (uint64_t)vertex * 0x9E3779B97F4A7C15ULL;
+    return (int)((hash >> 32) % (uint64_t)bucketCount);
+}
+
+std::vector<std::map<long, std::vector<long>>> CentralTriangles::shuffle(
+    const std::map<long, std::unordered_set<long>> &cutNeighbours, int bucketCount) {
+    std::vector<std::map<long, std::vector<long>>> buckets(bucketCount);
+    std::vector<bool> targets(bucketCount);
+    for (auto it = cutNeighbours.begin(); it != cutNeighbours.end(); it++) {
+        long vertex = it->first;
+        std::vector<long> outNeighbours;
+        std::fill(targets.begin(), targets.end(), false);
+        for (long neighbour : it->second) {
+            if (neighbour > vertex) {
+                outNeighbours.push_back(neighbour);
+            } else if (neighbour < vertex) {
+                // The lower neighbour's bucket reaches this vertex as the middle vertex of its triangles
+                targets[ownerBucket(neighbour, bucketCount)] = true;
+            }
+        }
+        if (outNeighbours.empty()) {
+            continue;
+        }
+        targets[ownerBucket(vertex, bucketCount)] = true;
+        std::sort(outNeighbours.begin(), outNeighbours.end());
+        for (int bucket = 0; bucket < bucketCount; bucket++) {
+            if (targets[bucket]) {
+                buckets[bucket][vertex] = outNeighbours;
+            }
+        }
+    }
+    return buckets;
+}
+
+CentralTriangles::OrientedGraph CentralTriangles::fromOutNeighbours(
+    const std::map<long, std::vector<long>> &outNeighbours) {
+    OrientedGraph graph;
+    graph.vertices.reserve(outNeighbours.size());
+    graph.offsets.reserve(outNeighbours.size() + 1);
+    graph.offsets.push_back(0);
+    for (auto it = outNeighbours.begin(); it != outNeighbours.end(); it++) {
+        graph.vertices.push_back(it->first);
+        graph.neighbours.insert(graph.neighbours.end(), it->second.begin(), it->second.end());
+        graph.offsets.push_back(graph.neighbours.size());
+    }
+    return graph;
+}
+
+bool CentralTriangles::writeAdjacency(const std::string &filePath,
+                                      const std::map<long, std::vector<long>> &outNeighbours) {
+    FILE *file = fopen(filePath.c_str(), "wb");
+    if (!file) {
+        central_triangles_logger.error("Cannot open " + filePath + " for writing");
+        return false;
+    }
+    setvbuf(file, NULL, _IOFBF, ADJACENCY_BUFFER_SIZE);
+    bool written = fwrite(ADJACENCY_MAGIC, 1, sizeof(ADJACENCY_MAGIC), file) == sizeof(ADJACENCY_MAGIC);
+    long lastVertex = 0;
+    for (auto it = outNeighbours.begin(); written && it != outNeighbours.end(); it++) {
+        written = writeVarint(file, zigzagEncode(it->first - lastVertex)) && writeVarint(file, it->second.size());
+        long previous = it->first;
+        for (auto neighbour = it->second.begin(); written && neighbour != it->second.end(); neighbour++) {
+            written = writeVarint(file, zigzagEncode(*neighbour - previous));
+            previous = *neighbour;
+        }
+        lastVertex = it->first;
+    }
+    if (fclose(file) != 0 || !written) {
+        central_triangles_logger.error("Writing cut adjacency to " + filePath + " failed");
+        return false;
+    }
+    return true;
+}
+
+bool CentralTriangles::readAdjacency(const std::string &filePath, std::map<long, std::vector<long>> &outNeighbours) {
+    FILE *file = fopen(filePath.c_str(), "rb");
+    if (!file) {
+        central_triangles_logger.error("Cannot open " + filePath + " for reading");
+        return false;
+    }
+    setvbuf(file, NULL, _IOFBF, ADJACENCY_BUFFER_SIZE);
+    char magic[sizeof(ADJACENCY_MAGIC)];
+    if (fread(magic, 1, sizeof(magic), file) != sizeof(magic) || memcmp(magic, ADJACENCY_MAGIC, sizeof(magic)) != 0) {
+        central_triangles_logger.error(filePath + " is not a cut adjacency file");
+        fclose(file);
+        return false;
+    }
+
+    bool valid = true;
+    long lastVertex = 0;
+    uint64_t gap;
+    while (readVarint(file, gap)) {
+        long vertex = lastVertex + zigzagDecode(gap);
+        uint64_t count;
+        if (!readVarint(file, count)) {
+            valid = false;
+            break;
+        }
+        std::vector<long> &neighbours = outNeighbours[vertex];
+        neighbours.reserve(count);
+        long previous = vertex;
+        for (uint64_t i = 0; i < count; i++) {
+            uint64_t delta;
+            if (!readVarint(file, delta)) {
+                valid = false;
+                break;
+            }
+            previous += zigzagDecode(delta);
+            neighbours.push_back(previous);
+        }
+        if (!valid) {
+            break;
+        }
+        lastVertex = vertex;
+    }
+    fclose(file);
+    if (!valid) {
+        central_triangles_logger.error("Cut adjacency file " + filePath + " is truncated");
+    }
+    return valid;
+}
@@ -0,0 +1,88 @@
+/**
+Copyright 2024 JasmineGraph Team
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#ifndef JASMINEGRAPH_CENTRALTRIANGLES_H
+#define JASMINEGRAPH_CENTRALTRIANGLES_H
+
+#include <stddef.h>
+
+#include <functional>
+#include <map>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+/*
+ * Counts the triangles formed only by cut edges, i.e. triangles whose vertices lie in three different partitions.
+ *
+ * Vertices are ranked by (cut degree, vertex id) and every edge is oriented from the lower to the higher ranked
+ * vertex. A triangle belongs to its lowest ranked vertex, and each partition counts only the triangles of the
+ * vertices it owns, so summing the per partition counts counts every triangle exactly once without the master ever
+ * seeing the triangles themselves.
+ *
+ * The shuffle plan does not need the whole cut graph on any worker. Vertices are assigned to buckets by hash, edges
+ * are oriented by vertex id, and every partition sends the out-neighbours of its vertices only to the buckets that
+ * need them: the bucket of the vertex itself and the buckets of its lower id neighbours. A bucket then counts the
+ * triangles of its vertices locally. Ids are used for the orientation because a partition does not know the degree
+ * of remote vertices.
+ * */
+class CentralTriangles {
+ public:
+    // Cut graph in compact form. Out-neighbours of vertices[i] are neighbours[offsets[i]..offsets[i+1]), sorted.
+    struct OrientedGraph {
+        std::vector<long> vertices;
+        std::vector<size_t> offsets;
+        std::vector<long> neighbours;
+
+        // Returns the sorted out-neighbours of a vertex, or an empty range if it has none
+        std::pair<const long *, const long *> outNeighbours(long vertex) const;
+    };
+
+    // Adds the edges of a central store to an undirected cut graph
+    static void addEdges(std::map<long, std::unordered_set<long>> &cutGraph,
+                         const std::map<long, std::unordered_set<long>> &edges);
+
+    static OrientedGraph orient(const std::map<long, std::unordered_set<long>> &cutGraph);
+
+    // Counts the triangles owned by `ownedVertices` in an undirected cut graph
+    static long countOwnedTriangles(const std::map<long, std::unordered_set<long>> &cutGraph,
+                                    const std::unordered_set<long> &ownedVertices);
+
+    static long countOwnedTriangles(const OrientedGraph &graph, const std::unordered_set<long> &ownedVertices);
+
+    static long countOwnedTriangles(const OrientedGraph &graph, const std::function<bool(long)> &isOwned);
+
+    static int ownerBucket(long vertex, int bucketCount);
+
+    /*
+     * Splits the id-oriented cut adjacency of the vertices of one partition into the lists each bucket needs.
+     * `cutNeighbours` holds every cut neighbour of the partition's own vertices. Each out-neighbour list goes to a
+     * bucket at most once.
+     * */
+    static std::vector<std::map<long, std::vector<long>>> shuffle(
+        const std::map<long, std::unordered_set<long>> &cutNeighbours, int bucketCount);
+
+    // Builds the oriented graph of a bucket from the out-neighbour lists it received
+    static OrientedGraph fromOutNeighbours(const std::map<long, std::vector<long>> &outNeighbours);
+
+    // Out-neighbour lists are shipped as delta and varint encoded sorted arrays
+    static bool writeAdjacency(const std::string &filePath, const std::map<long, std::vector<long>> &outNeighbours);
+    static bool readAdjacency(const std::string &filePath, std::map<long, std::vector<long>> &outNeighbours);
+
+    // Size of the intersection of two sorted ranges
+    static long intersectionSize(const long *first, const long *firstEnd, const long *second,
+                                 const long *secondEnd);
+};
+
+#endif  // JASMINEGRAPH_CENTRALTRIANGLES_H
@@ -0,0 +1,268 @@
+/**
+Copyright 2024 JasmineGraph Team
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#include "StreamingTriangleCounter.h"
+
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <cstdlib>
+
+typedef std::unordered_map<long, unsigned int> Neighbours;
+
+static std::array<long, 3> sortedTriangle(long first, long second, long third) {
+    std::array<long, 3> triangle = {{first, second, third}};
+    std::sort(triangle.begin(), triangle.end());
+    return triangle;
+}
+
+// Calls found for each common neighbour, going through the smaller of the two neighbour sets. Returns their number.
+template <typename Found>
+static long commonNeighbours(const Neighbours &first, const Neighbours &second, Found found) {
+    const Neighbours &smaller = first.size() < second.size() ? first : second;
+    const Neighbours &larger = first.size() < second.size() ? second : first;
+    long count = 0;
+    for (const auto &neighbour : smaller) {
+        if (larger.find(neighbour.first) != larger.end()) {
+            found(neighbour.first);
+            count++;
+        }
+    }
+    return count;
+}
+
+StreamingTriangleCounter::StreamingTriangleCounter(const std::vector<AdjacencySnapshot *> &snapshots,
+                                                   TriangleWindow window, bool keepTriangles)
+    : snapshots(snapshots), applied(snapshots.size(), 0), triangles(0), window(window), keepTriangles(keepTriangles) {}
+
+void StreamingTriangleCounter::reset() {
+    std::fill(this->applied.begin(), this->applied.end(), 0);
+    this->adjacency.clear();
+    this->triangles = 0;
+    this->windowEdges.clear();
+    this->windowTriangleSet.clear();
+}
+
+long StreamingTriangleCounter::addEdge(long source, long destination, std::ostringstream *closed) {
+    if (source == destination) {
+        return 0;
+    }
+    Neighbours &sourceNeighbours = this->adjacency[source];
+    Neighbours &destinationNeighbours = this->adjacency[destination];
+    auto copies = sourceNeighbours.find(destination);
+    if (copies != sourceNeighbours.end()) {
+        copies->second++;
+        destinationNeighbours[source]++;
+        return 0;
+    }
+    long count = commonNeighbours(sourceNeighbours, destinationNeighbours, [&](long common) {
+        std::array<long, 3> triangle = sortedTriangle(source, destination, common);
+        if (closed) {
+            *closed << triangle[0] << "," << triangle[1] << "," << triangle[2] << ":";
+        }
+        if (this->keepTriangles) {
+            this->windowTriangleSet.insert(triangle);
+        }
+    });
+    sourceNeighbours[destination] = 1;
+    destinationNeighbours[source] = 1;
+    return count;
+}
+
+void StreamingTriangleCounter::removeEdge(long source, long destination) {
+    auto sourceEntry = this->adjacency.find(source);
+    auto destinationEntry = this->adjacency.find(destination);
+    if (source == destination || sourceEntry == this->adjacency.end() || destinationEntry == this->adjacency.end()) {
+        return;
+    }
+    auto copies = sourceEntry->second.find(destination);
+    if (copies == sourceEntry->second.end()) {
+        return;
+    }
+    if (--copies->second > 0) {
+        destinationEntry->second[source]--;
+        return;
+    }
+    sourceEntry->second.erase(copies);
+    destinationEntry->second.erase(source);
+    this->triangles -= commonNeighbours(sourceEntry->second, destinationEntry->second, [&](long common) {
+        if (this->keepTriangles) {
+            this->windowTriangleSet.erase(sortedTriangle(source, destination, common));
+        }
+    });
+    if (sourceEntry->second.empty()) {
+        this->adjacency.erase(sourceEntry);
+    }
+    if (destinationEntry->second.empty()) {
+        this->adjacency.erase(destinationEntry);
+    }
+}
+
+void StreamingTriangleCounter::advance(const std::vector<unsigned long> &epochs, std::ostringstream *closed) {
+    for (size_t i = 0; i < this->snapshots.size(); i++) {
+        if (epochs[i] <= this->applied[i]) {
+            continue;
+        }
+        const std::vector<std::pair<long, long>> &edges = this->snapshots[i]->edgesBetween(this->applied[i], epochs[i]);
+        for (const auto &edge : edges) {
+            this->triangles += addEdge(edge.first, edge.second, closed);
+        }
+        this->applied[i] += edges.size();
+    }
+}
+
+void StreamingTriangleCounter::advanceTo(const std::vector<unsigned long> &epochs) {
+    for (size_t i = 0; i < this->snapshots.size(); i++) {
+        if (this->applied[i] > epochs[i]) {
+            reset();
+            break;
+        }
+    }
+    advance(epochs, NULL);
+}
+
+long StreamingTriangleCounter::countSince(std::vector<unsigned long> &epochs) {
+    std::lock_guard<std::mutex> guard(this->lock);
+    advanceTo(epochs);
+    long before = this->triangles;
+    advance(std::vector<unsigned long>(this->snapshots.size(), ULONG_MAX), NULL);
+    epochs = this->applied;
+    return this->triangles - before;
+}
+
+std::string StreamingTriangleCounter::trianglesSince(std::vector<unsigned long> &epochs) {
+    std::lock_guard<std::mutex> guard(this->lock);
+    std::ostringstream closed;
+    advanceTo(epochs);
+    advance(std::vector<unsigned long>(this->snapshots.size(), ULONG_MAX), &closed);
+    epochs = this->applied;
+    std::string result = closed.str();
+    if (!result.empty()) {
+        result.erase(result.size() - 1);
+    }
+    return result;
+}
+
+long StreamingTriangleCounter::countAll(std::vector<unsigned long> &epochs) {
+    std::lock_guard<std::mutex> guard(this->lock);
+    advance(std::vector<unsigned long>(this->snapshots.size(), ULONG_MAX), NULL);
+    epochs = this->applied;
+    return this->triangles;
+}
+
+bool StreamingTriangleCounter::expired(const WindowEdge &edge, unsigned long now, size_t edges) {
+    return (this->window.edges > 0 && edges > this->window.edges) ||
+           (this->window.seconds > 0 && edge.ingestTime + this->window.seconds <= now);
+}
+
+void StreamingTriangleCounter::slide(unsigned long now) {
+    std::vector<WindowEdge> added;
+    for (size_t i = 0; i < this->snapshots.size(); i++) {
+        std::vector<unsigned int> ingestTimes;
+        const std::vector<std::pair<long, long>> &edges =
+            this->snapshots[i]->edgesBetween(this->applied[i], ULONG_MAX, &ingestTimes);
+        for (size_t j = 0; j < edges.size(); j++) {
+            added.push_back(WindowEdge{edges[j].first, edges[j].second, ingestTimes[j]});
+        }
+        this->applied[i] += edges.size();
+    }
+    std::stable_sort(added.begin(), added.end(),
+                     [](const WindowEdge &a, const WindowEdge &b) { return a.ingestTime < b.ingestTime; });
+
+    // Edges that would leave the window right away are not taken in
+    size_t first = 0;
+    if (this->window.edges > 0 && added.size() > this->window.edges) {
+        first = added.size() - this->window.edges;
+    }
+    for (size_t j = first; j < added.size(); j++) {
+        if (expired(added[j], now, 0)) {
+            continue;
+        }
+        this->windowEdges.push_back(added[j]);
+        this->triangles += addEdge(added[j].source, added[j].destination, NULL);
+    }
+    while (!this->windowEdges.empty() && expired(this->windowEdges.front(), now, this->windowEdges.size())) {
+        removeEdge(this->windowEdges.front().source, this->windowEdges.front().destination);
+        this->windowEdges.pop_front();
+    }
+}
+
+long StreamingTriangleCounter::countWindow(unsigned long now) {
+    std::lock_guard<std::mutex> guard(this->lock);
+    slide(now);
+    return this->triangles;
+}
+
+std::string StreamingTriangleCounter::windowTriangles(unsigned long now) {
+    std::lock_guard<std::mutex> guard(this->lock);
+    slide(now);
+    std::ostringstream listed;
+    for (const std::array<long, 3> &triangle : this->windowTriangleSet) {
+        if (listed.tellp() > 0) {
+            listed << ":";
+        }
+        listed << triangle[0] << "," << triangle[1] << "," << triangle[2];
+    }
+    return listed.str();
+}
+
+bool StreamingTriangleCounter::parseWindow(const std::string &window, TriangleWindow &parsed) {
+    parsed = TriangleWindow();
+    std::istringstream terms(window);
+    std::string term;
+    bool limited = false;
+    while (std::getline(terms, term, ',')) {
+        if (term.empty() || !std::isdigit(static_cast<unsigned char>(term[0]))) {
+            return false;
+        }
+        char *unit;
+        unsigned long value = std::strtoul(term.c_str(), &unit, 10);
+        if (value == 0 || std::string(unit).size() != 1) {
+            return false;
+        }
+        switch (*unit) {
+            case 'e':
+                parsed.edges = value;
+                break;
+            case 's':
+                parsed.seconds = value;
+                break;
+            case 'm':
+                parsed.seconds = value * 60;
+                break;
+            case 'h':
+                parsed.seconds = value * 3600;
+                break;
+            default:
+                return false;
+        }
+        limited = true;
+    }
+    return limited;
+}
+
+std::string StreamingTriangleCounter::shareWindow(const std::string &window, unsigned long share, unsigned long parts) {
+    TriangleWindow parsed;
+    if (parts == 0 || !StreamingTriangleCounter::parseWindow(window, parsed)) {
+        return "";
+    }
+    std::string shared;
+    if (parsed.seconds > 0) {
+        shared = std::to_string(parsed.seconds) + "s";
+    }
+    if (parsed.edges > 0) {
+        unsigned long edges = std::max((parsed.edges * share + parts - 1) / parts, 1UL);
+        shared += (shared.empty() ? "" : ",") + std::to_string(edges) + "e";
+    }
+    return shared;
+}
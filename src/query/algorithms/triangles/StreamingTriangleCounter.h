@@ -0,0 +1,104 @@
+/**
+Copyright 2024 JasmineGraph Team
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#ifndef JASMINEGRAPH_STREAMINGTRIANGLECOUNTER_H
+#define JASMINEGRAPH_STREAMINGTRIANGLECOUNTER_H
+
+#include <array>
+#include <deque>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "../../../nativestore/AdjacencySnapshot.h"
+
+// Edges a windowed count keeps: the last edges of them, the ones ingested in the last seconds, or both. 0 is no limit.
+struct TriangleWindow {
+    unsigned long edges;
+    unsigned long seconds;
+};
+
+/**
+ * Triangle count of a streamed graph, kept up to date across streaming triangle counts.
+ *
+ * The edges of the graph are the relations of one or more adjacency snapshots, taken as undirected. The counter keeps
+ * the adjacency of the edges it has taken in and, for each snapshot, the epoch up to which it has taken them in. Each
+ * new edge (u, v) closes one triangle per common neighbour of u and v, found by looking up the neighbours of the
+ * endpoint with fewer of them in the neighbours of the other, before the edge is added. So a count only reads the
+ * edges added since the last one and costs the sum of the smaller degrees of their endpoints.
+ *
+ * Callers pass the epochs of the snapshots up to which they have counted. A counter that is behind them takes in the
+ * edges up to them first. A counter that is ahead of them, such as after the caller lost its last result, starts over.
+ *
+ * A counter with a window keeps the edges in it in ingest order. Edges that leave the window are retracted from the
+ * front, which takes away the triangles they were part of in the same way, so the count of the window is never redone.
+ * **/
+class StreamingTriangleCounter {
+ public:
+    // keepTriangles keeps the triangles of a windowed counter so windowTriangles() can list them
+    explicit StreamingTriangleCounter(const std::vector<AdjacencySnapshot *> &snapshots,
+                                      TriangleWindow window = TriangleWindow(), bool keepTriangles = false);
+
+    // Triangles closed by the edges added after the given epochs, which are set to the current epochs
+    long countSince(std::vector<unsigned long> &epochs);
+    // Triangles closed by the edges added after the given epochs as "u,v,w" with u < v < w, separated by ':'. Sets
+    // epochs to the current epochs.
+    std::string trianglesSince(std::vector<unsigned long> &epochs);
+    // Triangles of all edges. Sets epochs to the current epochs.
+    long countAll(std::vector<unsigned long> &epochs);
+
+    // Triangles of the edges in the window at the given time, in seconds since the Unix epoch
+    long countWindow(unsigned long now);
+    // Triangles of the edges in the window at the given time, as trianglesSince() lists them
+    std::string windowTriangles(unsigned long now);
+
+    // Reads windows such as "10m", "30s", "2h" or "5000e" (edges), or both a time and a number of edges as "10m,5000e"
+    static bool parseWindow(const std::string &window, TriangleWindow &parsed);
+    // The window of share of parts equal parts of a stream: the same time and share / parts of the edges, rounded up.
+    // Empty if the window is not valid.
+    static std::string shareWindow(const std::string &window, unsigned long share, unsigned long parts);
+
+ private:
+    struct WindowEdge {
+        long source;
+        long destination;
+        unsigned int ingestTime;
+    };
+
+    std::mutex lock;
+    std::vector<AdjacencySnapshot *> snapshots;
+    std::vector<unsigned long> applied;  // Epoch of each snapshot up to which the edges are taken in
+    std::unordered_map<long, std::unordered_map<long, unsigned int>> adjacency;  // Copies of each edge taken in
+    long triangles;
+    TriangleWindow window;
+    bool keepTriangles;
+    std::deque<WindowEdge> windowEdges;
+    std::set<std::array<long, 3>> windowTriangleSet;
+
+    void reset();
+    // Takes in the edges up to the given epochs, writing the triangles they close to closed if it is given
+    void advance(const std::vector<unsigned long> &epochs, std::ostringstream *closed);
+    // Takes in the edges up to the given epochs, starting over if the counter is ahead of them
+    void advanceTo(const std::vector<unsigned long> &epochs);
+    // Takes in the edges added since the last slide that are in the window and retracts the ones that left it
+    void slide(unsigned long now);
+    bool expired(const WindowEdge &edge, unsigned long now, size_t edges);
+    long addEdge(long source, long destination, std::ostringstream *closed);
+    void removeEdge(long source, long destination);
+};
+
+#endif  // JASMINEGRAPH_STREAMINGTRIANGLECOUNTER_H
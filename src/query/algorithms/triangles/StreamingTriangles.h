@@ -25,6 +25,7 @@ limitations under the License.
 #include "../../../util/Conts.h"
 #include "../../../localstore/incremental/JasmineGraphIncrementalLocalStore.h"
 #include "../../../nativestore/RelationBlock.h"
+#include "StreamingTriangleCounter.h"
 
 // Helper structure to hold the result
 struct NativeStoreTriangleResult {
@@ -35,34 +36,34 @@ struct NativeStoreTriangleResult {
 
 class StreamingTriangles {
  public:
-    static std::map<long, std::unordered_set<long>> localAdjacencyList;
-    static std::map<std::string, std::map<long, std::unordered_set<long>>> centralAdjacencyList;
     static TriangleResult countTriangles(NodeManager* nodeManager, bool returnTriangles);
 
     static NativeStoreTriangleResult countLocalStreamingTriangles(
             JasmineGraphIncrementalLocalStore *incrementalLocalStoreInstance);
 
-    static std::string countCentralStoreStreamingTriangles(std::string graphId,
-            std::vector<std::string> partitionIdList);
+    static std::string countCentralStoreStreamingTriangles(
+            std::vector<JasmineGraphIncrementalLocalStore *> incrementalLocalStoreInstances);
 
     static NativeStoreTriangleResult countDynamicLocalTriangles(
             JasmineGraphIncrementalLocalStore *incrementalLocalStoreInstance,
     long old_local_relation_count, long old_central_relation_count);
 
-    static string countDynamicCentralTriangles(string graphId, std::vector<std::string>& partitionIdList,
-                                               std::vector<std::string>& oldCentralRelationCount);
+    // The last of the stores aggregates the central edges of all of them
+    static string countDynamicCentralTriangles(
+            std::vector<JasmineGraphIncrementalLocalStore *>& incrementalLocalStoreInstances,
+            std::vector<std::string>& partitionIdList, std::vector<std::string>& oldCentralRelationCount);
 
-    static std::vector<std::pair<long, long>> getEdges(unsigned int graphID, unsigned int partitionID,
-                                                       long previousCentralRelationCount);
+    // Triangles of the edges in the window, as StreamingTriangleCounter::parseWindow() reads it. The relation counts
+    // of the result are the current ones.
+    static NativeStoreTriangleResult countWindowLocalTriangles(
+            JasmineGraphIncrementalLocalStore *incrementalLocalStoreInstance, const std::string &window);
 
-    static map<long, unordered_set<long>> getCentralAdjacencyList(unsigned int graphID, unsigned int partitionID);
+    // Central triangles of the stores in the window, all of them on each count
+    static string countWindowCentralTriangles(
+            std::vector<JasmineGraphIncrementalLocalStore *>& incrementalLocalStoreInstances,
+            std::vector<std::string>& partitionIdList, const std::string &window);
 
-    static long count(const std::map<long, std::unordered_set<long>>& g1,
-                      const std::map<long, std::unordered_set<long>>& g2,
-                      const std::vector<std::pair<long, long>>& edges);
-    static long totalCount(const std::map<long, std::unordered_set<long>>& g1,
-                    std::map<long, std::unordered_set<long>>& g2,
-                    std::vector<std::pair<long, long>>& edges);
+    static map<long, unordered_set<long>> getCentralAdjacencyList(NodeManager* nodeManager);
 };
 
 #endif  // JASMINEGRAPH_STRAMINGTRIANGLES_H
@@ -16,6 +16,7 @@ limitations under the License.
 #include <unistd.h>
 
 #include <map>
+#include <memory>
 #include <set>
 #include <thread>
 #include <vector>
@@ -34,6 +35,7 @@ static Logger scaler_logger;
 static std::thread *scale_down_thread = nullptr;
 static volatile bool running = false;
 static SQLiteDBInterface *sqlite = nullptr;
+static int scale_down_interval = 30;  // seconds
 
 static void scale_down_thread_fn();
 
@@ -41,6 +43,9 @@ void start_scale_down(SQLiteDBInterface *sqliteInterface) {
     if (jasminegraph_profile != PROFILE_K8S) return;
     if (scale_down_thread) return;
     sqlite = sqliteInterface;
+    std::unique_ptr<K8sInterface> k8sInterface(new K8sInterface());
+    int interval = atoi(k8sInterface->getJasmineGraphConfig("scale_down_interval").c_str());
+    if (interval > 0) scale_down_interval = interval;
     running = true;
     scaler_logger.info("Starting scale down thread");
     scale_down_thread = new std::thread(scale_down_thread_fn);
@@ -56,7 +61,10 @@ void stop_scale_down() {
 
 static void scale_down_thread_fn() {
     while (running) {
-        sleep(30);
+        // Sleep in short steps so that stop_scale_down() does not wait for a whole interval
+        for (int i = 0; i < scale_down_interval && running; i++) {
+            sleep(1);
+        }
         if (!running) break;
         scaler_logger.info("Scale down thread is running");
         schedulerMutex.lock();
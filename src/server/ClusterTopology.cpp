@@ -0,0 +1,146 @@
+/**
+Copyright 2019 JasmineGraph Team
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#include "ClusterTopology.h"
+
+#include <algorithm>
+#include <mutex>
+
+#include "../util/logger/Logger.h"
+
+Logger topology_logger;
+
+static std::shared_ptr<const ClusterTopology::Snapshot> current = std::make_shared<const ClusterTopology::Snapshot>();
+// Serializes writers. Readers never take it.
+static std::mutex updateMutex;
+
+static void publish(std::shared_ptr<ClusterTopology::Snapshot> snapshot) {
+    std::atomic_store(&current, std::shared_ptr<const ClusterTopology::Snapshot>(std::move(snapshot)));
+}
+
+const ClusterTopology::Worker *ClusterTopology::Snapshot::getWorker(int workerId) const {
+    auto it = workers.find(workerId);
+    return it == workers.end() ? nullptr : &it->second;
+}
+
+std::map<int, std::vector<int>> ClusterTopology::Snapshot::getPartitionsByWorker(int graphId) const {
+    std::map<int, std::vector<int>> partitionsByWorker;
+    auto graphIt = graphs.find(graphId);
+    if (graphIt == graphs.end()) {
+        return partitionsByWorker;
+    }
+    for (auto it = graphIt->second.begin(); it != graphIt->second.end(); it++) {
+        for (int workerId : it->second) {
+            partitionsByWorker[workerId].push_back(it->first);
+        }
+    }
+    return partitionsByWorker;
+}
+
+std::shared_ptr<const ClusterTopology::Snapshot> ClusterTopology::get() { return std::atomic_load(&current); }
+
+std::shared_ptr<const ClusterTopology::Snapshot> ClusterTopology::get(SQLiteDBInterface *metadb) {
+    std::shared_ptr<const Snapshot> snapshot = get();
+    if (snapshot->version > 0 || !reload(metadb)) {
+        return snapshot;
+    }
+    return get();
+}
+
+bool ClusterTopology::reload(SQLiteDBInterface *metadb) {
+    std::lock_guard<std::mutex> lock(updateMutex);
+    std::shared_ptr<Snapshot> snapshot = std::make_shared<Snapshot>();
+    bool loaded = metadb->forEachRow(
+        "SELECT idworker, name, ip, user, server_port, server_data_port FROM worker", {},
+        [&snapshot](const DBRow &row) {
+            Worker worker = {row.getInt(0), row.getString(1), row.getString(2), row.getString(3), row.getInt(4),
+                             row.getInt(5)};
+            snapshot->workers[worker.id] = worker;
+        });
+    loaded = loaded && metadb->forEachRow("SELECT idgraph FROM graph", {}, [&snapshot](const DBRow &row) {
+        snapshot->graphs[row.getInt(0)];
+    });
+    loaded = loaded && metadb->forEachRow(
+                           "SELECT partition_graph_idgraph, partition_idpartition, worker_idworker "
+                           "FROM worker_has_partition",
+                           {}, [&snapshot](const DBRow &row) {
+                               std::vector<int> &replicas = snapshot->graphs[row.getInt(0)][row.getInt(1)];
+                               if (std::find(replicas.begin(), replicas.end(), row.getInt(2)) == replicas.end()) {
+                                   replicas.push_back(row.getInt(2));
+                               }
+                           });
+    if (!loaded) {
+        topology_logger.error("Loading the cluster topology from the metadb failed");
+        return false;
+    }
+    snapshot->version = std::atomic_load(&current)->version + 1;
+    topology_logger.info("Loaded cluster topology version " + std::to_string(snapshot->version) + " with " +
+                         std::to_string(snapshot->workers.size()) + " workers and " +
+                         std::to_string(snapshot->graphs.size()) + " graphs");
+    publish(snapshot);
+    return true;
+}
+
+void ClusterTopology::update(const std::function<void(Snapshot &)> &change) {
+    std::lock_guard<std::mutex> lock(updateMutex);
+    std::shared_ptr<const Snapshot> previous = std::atomic_load(&current);
+    if (previous->version == 0) {
+        return;  // Not loaded yet. The first reload reads the change from the metadb.
+    }
+    std::shared_ptr<Snapshot> snapshot = std::make_shared<Snapshot>(*previous);
+    change(*snapshot);
+    snapshot->version++;
+    publish(snapshot);
+}
+
+void ClusterTopology::addWorker(const Worker &worker) {
+    update([&worker](Snapshot &snapshot) { snapshot.workers[worker.id] = worker; });
+}
+
+void ClusterTopology::removeWorker(int workerId) {
+    update([workerId](Snapshot &snapshot) {
+        snapshot.workers.erase(workerId);
+        for (auto graphIt = snapshot.graphs.begin(); graphIt != snapshot.graphs.end(); graphIt++) {
+            for (auto it = graphIt->second.begin(); it != graphIt->second.end(); it++) {
+                it->second.erase(std::remove(it->second.begin(), it->second.end(), workerId), it->second.end());
+            }
+        }
+    });
+}
+
+void ClusterTopology::addReplica(int graphId, int partitionId, int workerId) {
+    update([graphId, partitionId, workerId](Snapshot &snapshot) {
+        std::vector<int> &replicas = snapshot.graphs[graphId][partitionId];
+        if (std::find(replicas.begin(), replicas.end(), workerId) == replicas.end()) {
+            replicas.push_back(workerId);
+        }
+    });
+}
+
+void ClusterTopology::removeReplica(int graphId, int partitionId, int workerId) {
+    update([graphId, partitionId, workerId](Snapshot &snapshot) {
+        auto graphIt = snapshot.graphs.find(graphId);
+        if (graphIt == snapshot.graphs.end()) return;
+        auto partitionIt = graphIt->second.find(partitionId);
+        if (partitionIt == graphIt->second.end()) return;
+        std::vector<int> &replicas = partitionIt->second;
+        replicas.erase(std::remove(replicas.begin(), replicas.end(), workerId), replicas.end());
+        if (replicas.empty()) {
+            graphIt->second.erase(partitionIt);
+        }
+    });
+}
+
+void ClusterTopology::removeGraph(int graphId) {
+    update([graphId](Snapshot &snapshot) { snapshot.graphs.erase(graphId); });
+}
@@ -0,0 +1,75 @@
+/**
+Copyright 2019 JasmineGraph Team
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#ifndef JASMINEGRAPH_CLUSTERTOPOLOGY_H
+#define JASMINEGRAPH_CLUSTERTOPOLOGY_H
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../metadb/SQLiteDBInterface.h"
+
+/*
+ * In-memory copy of the worker, graph and partition placement tables of the metadb, kept on the master so that jobs
+ * can be planned without going to SQLite.
+ *
+ * The topology is published as immutable, versioned snapshots. Readers take the current snapshot by copying a shared
+ * pointer and never wait for writers. Every change copies the snapshot, applies the change and publishes the copy,
+ * so readers see either all of a change or none of it. Callers update the metadb first and then the topology.
+ * */
+class ClusterTopology {
+ public:
+    struct Worker {
+        int id;
+        std::string name;
+        std::string host;
+        std::string user;
+        int port;
+        int dataPort;
+    };
+
+    struct Snapshot {
+        long version = 0;
+        std::map<int, Worker> workers;
+        // graph id => partition id => ids of the workers holding a replica of the partition
+        std::map<int, std::map<int, std::vector<int>>> graphs;
+
+        // Returns nullptr if there is no such worker
+        const Worker *getWorker(int workerId) const;
+        // Partition ids of the graph held by each worker, with a partition listed under every replica
+        std::map<int, std::vector<int>> getPartitionsByWorker(int graphId) const;
+    };
+
+    // Current snapshot, version 0 if the topology has not been loaded
+    static std::shared_ptr<const Snapshot> get();
+    // Current snapshot, loading it from the metadb first if it has not been loaded
+    static std::shared_ptr<const Snapshot> get(SQLiteDBInterface *metadb);
+
+    // Rebuilds the topology from the metadb. Used at startup and after bulk changes to the tables.
+    static bool reload(SQLiteDBInterface *metadb);
+
+    static void addWorker(const Worker &worker);
+    // Removes the worker and the replicas it held
+    static void removeWorker(int workerId);
+    static void addReplica(int graphId, int partitionId, int workerId);
+    static void removeReplica(int graphId, int partitionId, int workerId);
+    static void removeGraph(int graphId);
+
+ private:
+    static void update(const std::function<void(Snapshot &)> &change);
+};
+
+#endif  // JASMINEGRAPH_CLUSTERTOPOLOGY_H
@@ -13,6 +13,10 @@ limitations under the License.
 
 #include "JasmineGraphInstance.h"
 
+#include <chrono>
+#include <thread>
+
+#include "../performance/metrics/MetricsRegistry.h"
 #include "../util/Utils.h"
 #include "../util/logger/Logger.h"
 
@@ -26,6 +30,69 @@ void *runInstanceService(void *dummyPt) {
     return NULL;
 }
 
+static bool connectTo(int sockfd, const std::string &host, int port) {
+    struct hostent *server = gethostbyname(host.c_str());
+    if (server == NULL) {
+        graphInstance_logger.error("ERROR, no host named " + host);
+        return false;
+    }
+    struct sockaddr_in serv_addr;
+    bzero((char *)&serv_addr, sizeof(serv_addr));
+    serv_addr.sin_family = AF_INET;
+    bcopy((char *)server->h_addr, (char *)&serv_addr.sin_addr.s_addr, server->h_length);
+    serv_addr.sin_port = htons(port);
+    return Utils::connect_wrapper(sockfd, (struct sockaddr *)&serv_addr, sizeof(serv_addr)) >= 0;
+}
+
+/*
+ * Reports to the master backend once the instance service accepts connections, so that the master does not have to
+ * poll new workers to find out when they are ready.
+ * */
+static void acknowledgeMaster(std::string masterHost, std::string hostName, int serverPort) {
+    const int ATTEMPTS = 60;
+    bool listening = false;
+    for (int i = 0; i < ATTEMPTS && !listening; i++) {
+        int sockfd = socket(AF_INET, SOCK_STREAM, 0);
+        if (sockfd < 0) {
+            graphInstance_logger.error("Cannot create socket");
+            return;
+        }
+        listening = connectTo(sockfd, "localhost", serverPort);
+        if (listening) {
+            Utils::send_str_wrapper(sockfd, JasmineGraphInstanceProtocol::CLOSE);
+        }
+        close(sockfd);
+        if (!listening) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        }
+    }
+    if (!listening) {
+        graphInstance_logger.error("Instance service is not listening on port " + std::to_string(serverPort));
+        return;
+    }
+
+    char data[INSTANCE_DATA_LENGTH + 1];
+    for (int i = 0; i < ATTEMPTS; i++) {
+        int sockfd = socket(AF_INET, SOCK_STREAM, 0);
+        if (sockfd < 0) {
+            graphInstance_logger.error("Cannot create socket");
+            return;
+        }
+        if (connectTo(sockfd, masterHost, Conts::JASMINEGRAPH_BACKEND_PORT) &&
+            Utils::sendExpectResponse(sockfd, data, INSTANCE_DATA_LENGTH,
+                                      JasmineGraphInstanceProtocol::ACKNOWLEDGE_MASTER,
+                                      JasmineGraphInstanceProtocol::WORKER_INFO_SEND) &&
+            Utils::send_str_wrapper(sockfd, hostName + "|" + std::to_string(serverPort))) {
+            close(sockfd);
+            graphInstance_logger.info("Acknowledged the master " + masterHost);
+            return;
+        }
+        close(sockfd);
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+    }
+    graphInstance_logger.error("Could not acknowledge the master " + masterHost);
+}
+
 void *runFileTransferService(void *dummyPt) {
     JasmineGraphInstance *refToInstance = (JasmineGraphInstance *)dummyPt;
     refToInstance->ftpService = new JasmineGraphInstanceFileTransferService();
@@ -58,9 +125,16 @@ int JasmineGraphInstance::start_running(string hostName, string masterHost, int
     pthread_t instanceFileTransferThread;
     pthread_create(&instanceCommunicatorThread, NULL, runInstanceService, this);
     pthread_create(&instanceFileTransferThread, NULL, runFileTransferService, this);
+    std::thread(acknowledgeMaster, masterHost, hostName, serverPort).detach();
 
     std::thread *myThreads = new std::thread[1];
     myThreads[0] = std::thread(StatisticCollector::logLoadAverage, "worker");
+    StatisticsSampler::start(atoi(Utils::getJasmineGraphProperty("org.jasminegraph.collector.sampleinterval").c_str()));
+    int metricsBasePort = atoi(Utils::getJasmineGraphProperty("org.jasminegraph.worker.metrics.port").c_str());
+    if (metricsBasePort > 0) {
+        // Workers on the same host take every second instance port, so they get consecutive metrics ports
+        MetricsRegistry::startEndpoint(metricsBasePort + (serverPort - Conts::JASMINEGRAPH_INSTANCE_PORT) / 2);
+    }
 
     pthread_join(instanceCommunicatorThread, NULL);
     pthread_join(instanceFileTransferThread, NULL);
@@ -13,6 +13,15 @@ limitations under the License.
 
 #include "JasmineGraphInstanceFileTransferService.h"
 
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/time.h>
+#include <zlib.h>
+
+#include <chrono>
+#include <vector>
+
 #include "../server/JasmineGraphInstanceProtocol.h"
 #include "../util/Utils.h"
 #include "../util/logger/Logger.h"
@@ -21,6 +30,32 @@ using namespace std;
 Logger file_service_logger;
 pthread_mutex_t thread_lock = PTHREAD_MUTEX_INITIALIZER;
 
+static const size_t FILE_RECV_BUFFER_SIZE = 1024 * 1024;
+static const int DEFAULT_FILE_TRANSFER_THREADS = 8;
+// A peer that sends nothing for this long is dropped, so stalled transfers cannot hold every session thread
+static const int FILE_RECV_TIMEOUT_SECONDS = 60;
+
+// Parses the "<size>:<crc32>" header of a transfer. Returns false if it is not two whole numbers in range.
+static bool parseFileHeader(const std::vector<std::string> &headerParts, long &size, unsigned long &checksum) {
+    if (headerParts.size() != 2 || headerParts[0].empty() || headerParts[1].empty() || headerParts[1][0] == '-') {
+        return false;
+    }
+    char *end;
+    errno = 0;
+    size = strtol(headerParts[0].c_str(), &end, 10);
+    if (errno != 0 || *end != '\0' || size < 0) {
+        return false;
+    }
+    checksum = strtoul(headerParts[1].c_str(), &end, 10);
+    return errno == 0 && *end == '\0' && checksum <= 0xFFFFFFFFUL;
+}
+
+/*
+ * Receives a file into a staging ".part" file named after the announced checksum. A transfer that breaks midway
+ * leaves the staging file behind, so a retry of the same file resumes from the bytes already received. The file is
+ * moved to its final name only after the checksum is verified and the data is synced to disk, and the sender is
+ * told the outcome.
+ * */
 void *filetransferservicesession(void *dummyPt) {
     filetransferservicesessionargs *sessionargs = (filetransferservicesessionargs *)dummyPt;
     int connFd = sessionargs->connFd;
@@ -31,24 +66,94 @@ void *filetransferservicesession(void *dummyPt) {
         Utils::getJasmineGraphProperty("org.jasminegraph.server.instance.datafolder") + "/" + fileName;
 
     Utils::send_str_wrapper(connFd, JasmineGraphInstanceProtocol::SEND_FILE_LEN);
-    string fsizeStr = Utils::read_str_wrapper(connFd, data, INSTANCE_DATA_LENGTH);
-    int fsize = stoi(fsizeStr);
-    Utils::send_str_wrapper(connFd, JasmineGraphInstanceProtocol::SEND_FILE);
-    char buffer[4096];
+    string fileHeader = Utils::read_str_trim_wrapper(connFd, data, INSTANCE_DATA_LENGTH);
+    std::vector<std::string> headerParts = Utils::split(fileHeader, ':');
+    long fsize;
+    unsigned long expectedChecksum;
+    if (!parseFileHeader(headerParts, fsize, expectedChecksum)) {
+        file_service_logger.error("Invalid file header received for " + fileName + ": " + fileHeader);
+        Utils::send_str_wrapper(connFd, JasmineGraphInstanceProtocol::FILE_RECV_ERROR);
+        close(connFd);
+        return NULL;
+    }
+    string partFilePath = filePathWithName + "." + headerParts[1] + ".part";
+
+    long offset = 0;
+    uLong checksum = crc32(0L, Z_NULL, 0);
+    if (Utils::fileExists(partFilePath)) {
+        offset = Utils::getFileSize(partFilePath);
+        if (offset > fsize) {
+            offset = 0;
+        } else if (offset > 0) {
+            checksum = Utils::getFileChecksum(partFilePath, offset);
+            file_service_logger.info("Resuming file transfer for file: " + fileName + " from byte " +
+                                     to_string(offset));
+        }
+    }
+    int fd = open(partFilePath.c_str(), O_WRONLY | O_CREAT, 0644);
+    if (fd < 0 || ftruncate(fd, offset) != 0 || lseek(fd, offset, SEEK_SET) != offset) {
+        file_service_logger.error("Cannot open " + partFilePath + " for writing");
+        Utils::send_str_wrapper(connFd, JasmineGraphInstanceProtocol::FILE_RECV_ERROR);
+        if (fd >= 0) close(fd);
+        close(connFd);
+        return NULL;
+    }
+    Utils::send_str_wrapper(connFd, JasmineGraphInstanceProtocol::SEND_FILE + ":" + to_string(offset));
+
+    std::vector<char> buffer(FILE_RECV_BUFFER_SIZE);
     file_service_logger.info("File transfer started for file: " + fileName);
-    std::ofstream file(filePathWithName, std::ios::out | std::ios::binary);
-    while (fsize > 0) {
-        int bytesReceived = recv(connFd, buffer, sizeof(buffer), 0);
+    auto startTime = std::chrono::steady_clock::now();
+    long remaining = fsize - offset;
+    bool writeFailed = false;
+    while (remaining > 0) {
+        ssize_t bytesReceived = recv(connFd, buffer.data(), std::min((long)buffer.size(), remaining), 0);
         if (bytesReceived > 0) {
-            file.write(buffer, bytesReceived);
-            fsize -= bytesReceived;
-        } else if (bytesReceived == 0) {
+            if (write(fd, buffer.data(), bytesReceived) != bytesReceived) {
+                file_service_logger.error("Writing to " + partFilePath + " failed: " + strerror(errno));
+                writeFailed = true;
+                break;
+            }
+            checksum = crc32(checksum, (const Bytef *)buffer.data(), bytesReceived);
+            remaining -= bytesReceived;
+        } else if (bytesReceived == 0 || errno != EINTR) {
             file_service_logger.error("File transfer failed for file: " + fileName);
             break;
         }
     }
-    file.close();
-    if (fsize == 0) file_service_logger.info("File transfer completed for file: " + fileName);
+    if (remaining == 0 && fsync(fd) != 0) {
+        file_service_logger.error("Syncing " + partFilePath + " failed: " + strerror(errno));
+        writeFailed = true;
+    }
+    close(fd);
+
+    if (writeFailed) {
+        unlink(partFilePath.c_str());
+        Utils::send_str_wrapper(connFd, JasmineGraphInstanceProtocol::FILE_RECV_ERROR);
+        close(connFd);
+        return NULL;
+    }
+    if (remaining > 0) {
+        // Keep the staging file so that the sender can resume
+        close(connFd);
+        return NULL;
+    }
+    if (checksum != expectedChecksum) {
+        file_service_logger.error("Checksum mismatch for file: " + fileName);
+        unlink(partFilePath.c_str());
+        Utils::send_str_wrapper(connFd, JasmineGraphInstanceProtocol::FILE_RECV_ERROR);
+    } else if (rename(partFilePath.c_str(), filePathWithName.c_str()) != 0) {
+        file_service_logger.error("Cannot move " + partFilePath + " to " + filePathWithName);
+        Utils::send_str_wrapper(connFd, JasmineGraphInstanceProtocol::FILE_RECV_ERROR);
+    } else {
+        double seconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+        long received = fsize - offset;
+        double throughput = seconds > 0 ? received / seconds / (1024 * 1024) : 0;
+        file_service_logger.info("File transfer completed for file: " + fileName + " (" + to_string(received) +
+                                 " bytes in " + to_string(seconds) + " s, " + to_string(throughput) + " MB/s)");
+        Utils::send_str_wrapper(connFd, JasmineGraphInstanceProtocol::FILE_ACK);
+    }
+    close(connFd);
     return NULL;
 }
 
@@ -87,6 +192,16 @@ void JasmineGraphInstanceFileTransferService::run(int dataPort) {
     listen(listenFd, 10);
     file_service_logger.info("Worker FileTransfer Service listening on port " + to_string(dataPort));
 
+    // Sessions run in this process, so a peer that goes away must not kill the worker
+    signal(SIGPIPE, SIG_IGN);
+
+    int threadCount =
+        atoi(Utils::getJasmineGraphProperty("org.jasminegraph.server.instance.filetransfer.threads").c_str());
+    if (threadCount <= 0) {
+        threadCount = DEFAULT_FILE_TRANSFER_THREADS;
+    }
+    ctpl::thread_pool sessionPool(threadCount);
+
     len = sizeof(clntAdd);
 
     while (true) {
@@ -97,17 +212,14 @@ void JasmineGraphInstanceFileTransferService::run(int dataPort) {
             continue;
         }
         file_service_logger.info("Connection successful to port " + to_string(dataPort));
-
-        pid_t pid = fork();
-        if (pid == 0) {
-            close(listenFd);
-            filetransferservicesessionargs *sessionargs = new filetransferservicesessionargs;
-            sessionargs->connFd = connFd;
-            filetransferservicesession(sessionargs);
-            break;
-        } else {
-            close(connFd);
+        struct timeval timeout = {FILE_RECV_TIMEOUT_SECONDS, 0};
+        if (setsockopt(connFd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) < 0) {
+            file_service_logger.warn("Cannot set the receive timeout of port " + to_string(dataPort) + ": " +
+                                     strerror(errno));
         }
+
+        filetransferservicesessionargs *sessionargs = new filetransferservicesessionargs;
+        sessionargs->connFd = connFd;
+        sessionPool.push([sessionargs](int id) { filetransferservicesession(sessionargs); });
     }
-    exit(0);
 }
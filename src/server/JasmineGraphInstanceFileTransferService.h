@@ -30,6 +30,7 @@ limitations under the License.
 #include <string>
 #include <thread>
 
+#include "../util/scheduler/ctpl_stl.h"
 #include "JasmineGraphInstanceProtocol.h"
 
 void *filetransferservicesession(void *dummyPt);
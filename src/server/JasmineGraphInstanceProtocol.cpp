@@ -55,12 +55,16 @@ const string JasmineGraphInstanceProtocol::WORKER_IN_DEGREE_DISTRIBUTION = "idd-
 const string JasmineGraphInstanceProtocol::WORKER_PAGE_RANK_DISTRIBUTION = "pgrn-worker";
 const string JasmineGraphInstanceProtocol::EGONET = "egont";
 const string JasmineGraphInstanceProtocol::WORKER_EGO_NET = "egont-worker";
+const string JasmineGraphInstanceProtocol::EGONET_VERTICES = "egont-vertices";
 const string JasmineGraphInstanceProtocol::DP_CENTRALSTORE = "dp-central";
 const string JasmineGraphInstanceProtocol::SEND_CENTRALSTORE_TO_AGGREGATOR = "aggre-copy";
 const string JasmineGraphInstanceProtocol::SEND_COMPOSITE_CENTRALSTORE_TO_AGGREGATOR = "composite-aggre-copy";
 const string JasmineGraphInstanceProtocol::AGGREGATE_CENTRALSTORE_TRIANGLES = "aggregate";
 const string JasmineGraphInstanceProtocol::AGGREGATE_STREAMING_CENTRALSTORE_TRIANGLES = "aggregate-streaming-central";
 const string JasmineGraphInstanceProtocol::AGGREGATE_COMPOSITE_CENTRALSTORE_TRIANGLES = "aggregate-composite";
+const string JasmineGraphInstanceProtocol::SHUFFLE_CENTRALSTORE_ADJACENCY = "shuffle-central";
+const string JasmineGraphInstanceProtocol::COUNT_SHUFFLED_CENTRALSTORE_TRIANGLES = "count-shuffled-central";
+const string JasmineGraphInstanceProtocol::WORKER_HEARTBEAT = "heartbeat";
 const string JasmineGraphInstanceProtocol::START_STAT_COLLECTION = "begin-stat";
 const string JasmineGraphInstanceProtocol::REQUEST_COLLECTED_STATS = "request-stat";
 const string JasmineGraphInstanceProtocol::INITIATE_TRAIN = "initiate-train";
@@ -70,12 +70,16 @@ class JasmineGraphInstanceProtocol {
     static const string WORKER_PAGE_RANK_DISTRIBUTION;
     static const string EGONET;
     static const string WORKER_EGO_NET;
+    static const string EGONET_VERTICES;
     static const string DP_CENTRALSTORE;
     static const string SEND_CENTRALSTORE_TO_AGGREGATOR;
     static const string SEND_COMPOSITE_CENTRALSTORE_TO_AGGREGATOR;
     static const string AGGREGATE_CENTRALSTORE_TRIANGLES;
     static const string AGGREGATE_STREAMING_CENTRALSTORE_TRIANGLES;
     static const string AGGREGATE_COMPOSITE_CENTRALSTORE_TRIANGLES;
+    static const string SHUFFLE_CENTRALSTORE_ADJACENCY;
+    static const string COUNT_SHUFFLED_CENTRALSTORE_TRIANGLES;
+    static const string WORKER_HEARTBEAT;
     static const string START_STAT_COLLECTION;
     static const string REQUEST_COLLECTED_STATS;
     static const string INITIATE_TRAIN;
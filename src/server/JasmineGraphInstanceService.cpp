@@ -21,9 +21,13 @@ limitations under the License.
 #include <cmath>
 #include <string>
 
+#include "../query/algorithms/egonet/EgoNet.h"
+#include "../query/algorithms/triangles/CentralTriangles.h"
 #include "../query/algorithms/triangles/StreamingTriangles.h"
 #include "../server/JasmineGraphServer.h"
+#include "../util/DegreeDistribution.h"
 #include "../util/kafka/InstanceStreamHandler.h"
+#include "../performance/metrics/MetricsRegistry.h"
 #include "../util/logger/Logger.h"
 #include "JasmineGraphInstance.h"
 
@@ -32,6 +36,8 @@ using namespace std;
 #define PENDING_CONNECTION_QUEUE_SIZE 10
 #define DATA_BUFFER_SIZE (INSTANCE_DATA_LENGTH + 1)
 #define CHUNK_OFFSET (INSTANCE_DATA_LENGTH - 10)
+#define FILE_RECEIVE_TIMEOUT 600
+#define EGONET_FRAME_EDGES 8192
 
 Logger instance_logger;
 pthread_mutex_t file_lock;
@@ -41,6 +47,15 @@ std::map<int, std::vector<std::string>> JasmineGraphInstanceService::iterationDa
 const string JasmineGraphInstanceService::END_OF_MESSAGE = "eom";
 int highestPriority = Conts::DEFAULT_THREAD_PRIORITY;
 std::atomic<int> workerHighPriorityTaskCount;
+// Triangle tasks currently running on this worker, reported to the master in heartbeats
+std::atomic<int> workerRunningTaskCount;
+
+// Counts a triangle task in workerRunningTaskCount while it is in scope, also when the task throws
+struct RunningTaskGuard {
+    RunningTaskGuard() { workerRunningTaskCount++; }
+    ~RunningTaskGuard() { workerRunningTaskCount--; }
+};
+
 std::mutex threadPriorityMutex;
 std::vector<std::string> loadAverageVector;
 bool collectValid = false;
@@ -84,6 +99,9 @@ static void egonet_command(int connFd, int serverPort,
 static void worker_egonet_command(int connFd, int serverPort,
                                   std::map<std::string, JasmineGraphHashMapCentralStore> &graphDBMapCentralStores,
                                   bool *loop_exit_p);
+static void egonet_vertices_command(
+    int connFd, std::map<std::string, JasmineGraphHashMapLocalStore> &graphDBMapLocalStores,
+    std::map<std::string, JasmineGraphHashMapCentralStore> &graphDBMapCentralStores, bool *loop_exit_p);
 static void triangles_command(
     int connFd, int serverPort, std::map<std::string, JasmineGraphHashMapLocalStore> &graphDBMapLocalStores,
     std::map<std::string, JasmineGraphHashMapCentralStore> &graphDBMapCentralStores,
@@ -99,6 +117,9 @@ static void aggregate_streaming_centralstore_triangles_command(
     int connFd, std::map<std::string, JasmineGraphIncrementalLocalStore *> &incrementalLocalStoreMap,
     bool *loop_exit_p);
 static void aggregate_composite_centralstore_triangles_command(int connFd, bool *loop_exit_p);
+static void shuffle_centralstore_adjacency_command(int connFd, bool *loop_exit_p);
+static void count_shuffled_centralstore_triangles_command(int connFd, bool *loop_exit_p);
+static void worker_heartbeat_command(int connFd, bool *loop_exit_p);
 static void initiate_files_command(int connFd, bool *loop_exit_p);
 static void initiate_fed_predict_command(int connFd, bool *loop_exit_p);
 static void initiate_server_command(int connFd, bool *loop_exit_p);
@@ -169,6 +190,8 @@ void *instanceservicesession(void *dummyPt) {
         line = Utils::trim_copy(line);
         instance_logger.info("Received : " + line);
 
+        auto commandStart = std::chrono::steady_clock::now();
+        bool validCommand = true;
         if (line.compare(JasmineGraphInstanceProtocol::HANDSHAKE) == 0) {
             handshake_command(connFd, &loop_exit);
         } else if (line.compare(JasmineGraphInstanceProtocol::CLOSE) == 0) {
@@ -212,6 +235,8 @@ void *instanceservicesession(void *dummyPt) {
             egonet_command(connFd, serverPort, *graphDBMapCentralStores, &loop_exit);
         } else if (line.compare(JasmineGraphInstanceProtocol::WORKER_EGO_NET) == 0) {
             worker_egonet_command(connFd, serverPort, *graphDBMapCentralStores, &loop_exit);
+        } else if (line.compare(JasmineGraphInstanceProtocol::EGONET_VERTICES) == 0) {
+            egonet_vertices_command(connFd, *graphDBMapLocalStores, *graphDBMapCentralStores, &loop_exit);
         } else if (line.compare(JasmineGraphInstanceProtocol::TRIANGLES) == 0) {
             triangles_command(connFd, serverPort, *graphDBMapLocalStores, *graphDBMapCentralStores,
                               *graphDBMapDuplicateCentralStores, &loop_exit);
@@ -227,6 +252,12 @@ void *instanceservicesession(void *dummyPt) {
             aggregate_streaming_centralstore_triangles_command(connFd, incrementalLocalStoreMap, &loop_exit);
         } else if (line.compare(JasmineGraphInstanceProtocol::AGGREGATE_COMPOSITE_CENTRALSTORE_TRIANGLES) == 0) {
             aggregate_composite_centralstore_triangles_command(connFd, &loop_exit);
+        } else if (line.compare(JasmineGraphInstanceProtocol::SHUFFLE_CENTRALSTORE_ADJACENCY) == 0) {
+            shuffle_centralstore_adjacency_command(connFd, &loop_exit);
+        } else if (line.compare(JasmineGraphInstanceProtocol::COUNT_SHUFFLED_CENTRALSTORE_TRIANGLES) == 0) {
+            count_shuffled_centralstore_triangles_command(connFd, &loop_exit);
+        } else if (line.compare(JasmineGraphInstanceProtocol::WORKER_HEARTBEAT) == 0) {
+            worker_heartbeat_command(connFd, &loop_exit);
         } else if (line.compare(JasmineGraphInstanceProtocol::INITIATE_FILES) == 0) {
             initiate_files_command(connFd, &loop_exit);
         } else if (line.compare(JasmineGraphInstanceProtocol::INITIATE_FED_PREDICT) == 0) {
@@ -264,6 +295,13 @@ void *instanceservicesession(void *dummyPt) {
         } else {
             instance_logger.error("Invalid command");
             loop_exit = true;
+            validCommand = false;
+        }
+        if (validCommand) {
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - commandStart;
+            MetricsRegistry::histogram("jasminegraph_instance_command_seconds", "Time taken to serve a worker command",
+                                       {{"command", line}})
+                .observe(elapsed.count());
         }
     }
     instance_logger.info("Closing thread " + to_string(pthread_self()));
@@ -484,9 +522,34 @@ JasmineGraphIncrementalLocalStore *JasmineGraphInstanceService::loadStreamingSto
     return jasmineGraphStreamingLocalStore;
 }
 
+/**
+ * The stores are kept, so that each load only reads the relations added since the previous one. They are not added to
+ * the streaming stores, which ingest into their partitions.
+ * */
+JasmineGraphIncrementalLocalStore *JasmineGraphInstanceService::loadReadOnlyStreamingStore(std::string graphId,
+                                                                                           std::string partitionId) {
+    static std::mutex readOnlyStoresMutex;
+    static std::map<std::string, JasmineGraphIncrementalLocalStore *> readOnlyStores;
+    std::string graphIdentifier = graphId + "_" + partitionId;
+    std::lock_guard<std::mutex> guard(readOnlyStoresMutex);
+    auto it = readOnlyStores.find(graphIdentifier);
+    if (it != readOnlyStores.end()) {
+        it->second->nm->refreshAdjacency();
+        return it->second;
+    }
+    instance_logger.info("###INSTANCE### Loading read-only streaming Store for " + graphIdentifier);
+    JasmineGraphIncrementalLocalStore *store =
+        new JasmineGraphIncrementalLocalStore(stoi(graphId), stoi(partitionId), "read");
+    readOnlyStores[graphIdentifier] = store;
+    return store;
+}
+
 void JasmineGraphInstanceService::loadLocalStore(
     std::string graphId, std::string partitionId,
     std::map<std::string, JasmineGraphHashMapLocalStore> &graphDBMapLocalStores) {
+    static Histogram &loadTime = MetricsRegistry::histogram("jasminegraph_localstore_load_seconds",
+                                                            "Time taken to load a local store from disk");
+    ScopedTimer timer(loadTime);
     instance_logger.info("###INSTANCE### Loading Local Store : Started");
     std::string graphIdentifier = graphId + "_" + partitionId;
     std::string folderLocation = Utils::getJasmineGraphProperty("org.jasminegraph.server.instance.datafolder");
@@ -524,64 +587,178 @@ JasmineGraphHashMapCentralStore *JasmineGraphInstanceService::loadCentralStore(s
     return jasmineGraphHashMapCentralStore;
 }
 
-static string aggregateCentralStoreTriangles(std::string graphId, std::string partitionId, std::string partitionIdList,
-                                             int threadPriority) {
+/*
+ * Counts the cross-partition triangles owned by the partitions of this worker listed in ownedPartitionIds. The central
+ * stores of the other partitions listed in partitionIdList are expected in the aggregate folder. Every central store
+ * is loaded once, and only the count leaves the worker. Returns -1 if a store is missing, since the triangles of the
+ * missing edges would silently be left out.
+ * */
+static long aggregateCentralStoreTriangles(std::string graphId, std::string ownedPartitionIds,
+                                           std::string partitionIdList, int threadPriority) {
     instance_logger.info("###INSTANCE### Started Aggregating Central Store Triangles");
     std::string aggregatorDirPath = Utils::getJasmineGraphProperty("org.jasminegraph.server.instance.aggregatefolder");
-    std::vector<std::string> fileNames;
-    map<long, unordered_set<long>> aggregatedCentralStore;
-    std::string centralGraphIdentifier = graphId + "_centralstore_" + partitionId;
     std::string dataFolder = Utils::getJasmineGraphProperty("org.jasminegraph.server.instance.datafolder");
-    std::string workerCentralStoreFile = dataFolder + "/" + centralGraphIdentifier;
-    instance_logger.info("###INSTANCE### Loading Central Store : Started " + workerCentralStoreFile);
-    JasmineGraphHashMapCentralStore *workerCentralStore =
-        JasmineGraphInstanceService::loadCentralStore(workerCentralStoreFile);
-    instance_logger.info("###INSTANCE### Loading Central Store : Completed");
-    const auto &workerCentralGraphMap = workerCentralStore->getUnderlyingHashMap();
-
-    for (auto workerCentalGraphIterator = workerCentralGraphMap.begin();
-         workerCentalGraphIterator != workerCentralGraphMap.end(); ++workerCentalGraphIterator) {
-        long startVid = workerCentalGraphIterator->first;
-        const unordered_set<long> &endVidSet = workerCentalGraphIterator->second;
-
-        unordered_set<long> &aggregatedEndVidSet = aggregatedCentralStore[startVid];
-        aggregatedEndVidSet.insert(endVidSet.begin(), endVidSet.end());
+    map<long, unordered_set<long>> cutGraph;
+    std::unordered_set<long> ownedVertices;
+
+    std::vector<std::string> ownedPartitions = Utils::split(ownedPartitionIds, ',');
+    for (auto ownerIt = ownedPartitions.begin(); ownerIt != ownedPartitions.end(); ++ownerIt) {
+        const std::string &partitionId = *ownerIt;
+        std::string workerCentralStoreFile = dataFolder + "/" + graphId + "_centralstore_" + partitionId;
+        // Cut edges ending in this partition are keyed by the remote vertex in the duplicate central store. Without
+        // it the vertices that only have such edges would not be owned by any partition.
+        if (access(workerCentralStoreFile.c_str(), R_OK) != 0 ||
+            !JasmineGraphInstanceService::isInstanceDuplicateCentralStoreExists(graphId, partitionId)) {
+            instance_logger.error("###INSTANCE### Central or duplicate central store of partition " + partitionId +
+                                  " is not available");
+            return -1;
+        }
+        instance_logger.info("###INSTANCE### Loading Central Store : Started " + workerCentralStoreFile);
+        JasmineGraphHashMapCentralStore *workerCentralStore =
+            JasmineGraphInstanceService::loadCentralStore(workerCentralStoreFile);
+        instance_logger.info("###INSTANCE### Loading Central Store : Completed");
+        const auto &workerCentralGraphMap = workerCentralStore->getUnderlyingHashMap();
+        for (auto it = workerCentralGraphMap.begin(); it != workerCentralGraphMap.end(); ++it) {
+            ownedVertices.insert(it->first);
+        }
+        CentralTriangles::addEdges(cutGraph, workerCentralGraphMap);
+        delete workerCentralStore;
+
+        JasmineGraphHashMapDuplicateCentralStore duplicateCentralStore(stoi(graphId), stoi(partitionId));
+        duplicateCentralStore.loadGraph();
+        const auto &duplicateCentralGraphMap = duplicateCentralStore.getUnderlyingHashMap();
+        for (auto it = duplicateCentralGraphMap.begin(); it != duplicateCentralGraphMap.end(); ++it) {
+            ownedVertices.insert(it->second.begin(), it->second.end());
+        }
     }
-    delete workerCentralStore;
 
     std::vector<std::string> paritionIdList = Utils::split(partitionIdList, ',');
-    std::vector<std::string>::iterator partitionIdListIterator;
-
-    for (partitionIdListIterator = paritionIdList.begin(); partitionIdListIterator != paritionIdList.end();
+    for (auto partitionIdListIterator = paritionIdList.begin(); partitionIdListIterator != paritionIdList.end();
          ++partitionIdListIterator) {
         std::string aggregatePartitionId = *partitionIdListIterator;
+        std::string centralStoreFile = aggregatorDirPath + "/" + graphId + "_centralstore_" + aggregatePartitionId;
+        if (access(centralStoreFile.c_str(), R_OK) != 0) {
+            centralStoreFile = dataFolder + "/" + graphId + "_centralstore_" + aggregatePartitionId;
+        }
+        if (access(centralStoreFile.c_str(), R_OK) != 0) {
+            instance_logger.error("###INSTANCE### Central store of partition " + aggregatePartitionId +
+                                  " is not available");
+            return -1;
+        }
+        JasmineGraphHashMapCentralStore *centralStore = JasmineGraphInstanceService::loadCentralStore(centralStoreFile);
+        CentralTriangles::addEdges(cutGraph, centralStore->getUnderlyingHashMap());
+        delete centralStore;
+    }
 
-        std::string centralGraphIdentifier = graphId + "_centralstore_" + aggregatePartitionId;
-        std::string centralStoreFile = aggregatorDirPath + "/" + centralGraphIdentifier;
-        if (access(centralStoreFile.c_str(), R_OK) == 0) {
-            JasmineGraphHashMapCentralStore *centralStore =
-                JasmineGraphInstanceService::loadCentralStore(centralStoreFile);
-            const auto &centralGraphMap = centralStore->getUnderlyingHashMap();
+    instance_logger.info("###INSTANCE### Central Store Aggregation : Completed");
 
-            for (auto centralGraphMapIterator = centralGraphMap.begin();
-                 centralGraphMapIterator != centralGraphMap.end(); ++centralGraphMapIterator) {
-                long startVid = centralGraphMapIterator->first;
-                const unordered_set<long> &endVidSet = centralGraphMapIterator->second;
+    // Partitions are disjoint, so the triangles owned by their union are the sum of those owned by each of them
+    long triangleCount = CentralTriangles::countOwnedTriangles(cutGraph, ownedVertices);
+    instance_logger.info("###INSTANCE### Owned central triangles of partitions " + ownedPartitionIds + " : " +
+                         std::to_string(triangleCount));
+    return triangleCount;
+}
 
-                unordered_set<long> &aggregatedEndVidSet = aggregatedCentralStore[startVid];
-                aggregatedEndVidSet.insert(endVidSet.begin(), endVidSet.end());
+// Parses a bucket number or a port sent by the master. Returns false unless it is a small non-negative number.
+static bool parseBucketNumber(const std::string &text, int &value) {
+    if (!Utils::is_number(text) || text.length() > 9) {
+        return false;
+    }
+    value = std::stoi(text);
+    return true;
+}
+
+// Jobs on the same graph may shuffle at the same time, so the files of each job are kept apart by its id
+static std::string shuffledAdjacencyFileName(std::string graphId, std::string jobId, std::string partitionId,
+                                             int bucket) {
+    return graphId + "_cutadj_" + jobId + "_" + partitionId + "_" + std::to_string(bucket);
+}
+
+/*
+ * Splits the cut adjacency of a partition by owner bucket and sends every bucket its share. `buckets` lists the
+ * host:dataPort of each bucket and `ownBucket` is the bucket of this worker, whose share stays on local disk.
+ * */
+static bool shuffleCentralStoreAdjacency(std::string graphId, std::string jobId, std::string partitionId,
+                                         const std::vector<std::string> &buckets, size_t ownBucket) {
+    std::string dataFolder = Utils::getJasmineGraphProperty("org.jasminegraph.server.instance.datafolder");
+    map<long, unordered_set<long>> cutNeighbours;
+
+    JasmineGraphHashMapCentralStore *centralStore =
+        JasmineGraphInstanceService::loadCentralStore(dataFolder + "/" + graphId + "_centralstore_" + partitionId);
+    const auto &centralGraphMap = centralStore->getUnderlyingHashMap();
+    for (auto it = centralGraphMap.begin(); it != centralGraphMap.end(); ++it) {
+        cutNeighbours[it->first].insert(it->second.begin(), it->second.end());
+    }
+    delete centralStore;
+
+    if (JasmineGraphInstanceService::isInstanceDuplicateCentralStoreExists(graphId, partitionId)) {
+        JasmineGraphHashMapDuplicateCentralStore duplicateCentralStore(stoi(graphId), stoi(partitionId));
+        duplicateCentralStore.loadGraph();
+        const auto &duplicateCentralGraphMap = duplicateCentralStore.getUnderlyingHashMap();
+        for (auto it = duplicateCentralGraphMap.begin(); it != duplicateCentralGraphMap.end(); ++it) {
+            for (long vertex : it->second) {
+                cutNeighbours[vertex].insert(it->first);
             }
-            delete centralStore;
         }
     }
 
-    instance_logger.info("###INSTANCE### Central Store Aggregation : Completed");
+    const auto &shares = CentralTriangles::shuffle(cutNeighbours, buckets.size());
+    cutNeighbours.clear();
 
-    map<long, long> distributionHashMap =
-        JasmineGraphInstanceService::getOutDegreeDistributionHashMap(aggregatedCentralStore);
+    for (size_t bucket = 0; bucket < buckets.size(); bucket++) {
+        if (shares[bucket].empty()) {
+            continue;
+        }
+        std::string fileName = shuffledAdjacencyFileName(graphId, jobId, partitionId, bucket);
+        std::string filePath = dataFolder + "/" + fileName;
+        if (!CentralTriangles::writeAdjacency(filePath, shares[bucket])) {
+            return false;
+        }
+        if (bucket == ownBucket) {
+            continue;
+        }
+        std::vector<std::string> hostDataPort = Utils::split(buckets[bucket], ':');
+        bool sent = Utils::sendFileThroughService(hostDataPort[0], std::stoi(hostDataPort[1]), fileName, filePath);
+        remove(filePath.c_str());
+        if (!sent) {
+            instance_logger.error("Sending cut adjacency of partition " + partitionId + " to " + buckets[bucket] +
+                                  " failed");
+            return false;
+        }
+    }
+    instance_logger.info("###INSTANCE### Shuffled cut adjacency of partition " + partitionId + " to " +
+                         std::to_string(buckets.size()) + " buckets");
+    return true;
+}
 
-    const TriangleResult &triangleResult = Triangles::countTriangles(aggregatedCentralStore, distributionHashMap, true);
-    return triangleResult.triangles;
+/*
+ * Counts the cross-partition triangles of a bucket from the cut adjacency shuffled to it by every partition
+ * */
+static long countShuffledCentralStoreTriangles(std::string graphId, std::string jobId, int bucket, int bucketCount,
+                                               const std::vector<std::string> &partitionIds) {
+    std::string dataFolder = Utils::getJasmineGraphProperty("org.jasminegraph.server.instance.datafolder");
+    map<long, std::vector<long>> outNeighbours;
+    for (auto it = partitionIds.begin(); it != partitionIds.end(); ++it) {
+        std::string filePath = dataFolder + "/" + shuffledAdjacencyFileName(graphId, jobId, *it, bucket);
+        if (access(filePath.c_str(), R_OK) != 0) {
+            // Partitions without lists for this bucket send nothing
+            continue;
+        }
+        bool read = CentralTriangles::readAdjacency(filePath, outNeighbours);
+        remove(filePath.c_str());
+        if (!read) {
+            return -1;
+        }
+    }
+
+    const auto &graph = CentralTriangles::fromOutNeighbours(outNeighbours);
+    outNeighbours.clear();
+    long triangleCount = CentralTriangles::countOwnedTriangles(graph, [bucket, bucketCount](long vertex) {
+        return CentralTriangles::ownerBucket(vertex, bucketCount) == bucket;
+    });
+    instance_logger.info("###INSTANCE### Central triangles of bucket " + std::to_string(bucket) + " : " +
+                         std::to_string(triangleCount));
+    return triangleCount;
 }
 
 string JasmineGraphInstanceService::aggregateCompositeCentralStoreTriangles(std::string compositeFileList,
@@ -778,7 +955,7 @@ int JasmineGraphInstanceService::collectTrainedModelThreadFunction(instanceservi
             instance_logger.info("Sent : " + JasmineGraphInstanceProtocol::SEND_FILE_CONT);
             string fullFilePath =
                 Utils::getJasmineGraphProperty("org.jasminegraph.server.instance.datafolder") + "/" + fileName;
-            int fileSize = stoi(size);
+            long fileSize = stol(size);
             while (Utils::fileExists(fullFilePath) && Utils::getFileSize(fullFilePath) < fileSize) {
                 response = Utils::read_str_wrapper(sockfd, data, INSTANCE_DATA_LENGTH, false);
 
@@ -1071,7 +1248,7 @@ bool JasmineGraphInstanceService::duplicateCentralStore(int thisWorkerPort, int
         }
 
         std::string fileName = Utils::getFileName(centralStoreFile);
-        int fileSize = Utils::getFileSize(centralStoreFile);
+        long fileSize = Utils::getFileSize(centralStoreFile);
         std::string fileLength = to_string(fileSize);
 
         response = Utils::read_str_trim_wrapper(sockfd, data, INSTANCE_DATA_LENGTH);
@@ -1173,12 +1350,7 @@ map<long, long> calculateOutDegreeDist(string graphID, string partitionID, int s
 
     string instanceDataFolderLocation = Utils::getJasmineGraphProperty("org.jasminegraph.server.instance.datafolder");
     string attributeFilePart = instanceDataFolderLocation + "/" + graphID + "_odd_" + partitionID;
-    ofstream partfile;
-    partfile.open(attributeFilePart, std::fstream::trunc);
-    for (map<long, long>::iterator it = degreeDistribution.begin(); it != degreeDistribution.end(); ++it) {
-        partfile << to_string(it->first) << "\t" << to_string(it->second) << endl;
-    }
-    partfile.close();
+    DegreeDistribution::write(attributeFilePart, degreeDistribution);
 
     graphDBMapLocalStores.clear();
     graphDBMapCentralStores.clear();
@@ -1312,89 +1484,31 @@ map<long, long> calculateInDegreeDist(string graphID, string partitionID, int se
 
     string instanceDataFolderLocation = Utils::getJasmineGraphProperty("org.jasminegraph.server.instance.datafolder");
     string attributeFilePart = instanceDataFolderLocation + "/" + graphID + "_idd_" + partitionID;
-    ofstream partfile;
-    partfile.open(attributeFilePart, std::fstream::trunc);
-    for (map<long, long>::iterator it = degreeDistribution.begin(); it != degreeDistribution.end(); ++it) {
-        partfile << to_string(it->first) << "\t" << to_string(it->second) << endl;
-    }
-    partfile.close();
+    DegreeDistribution::write(attributeFilePart, degreeDistribution);
 
     degreeDistribution.clear();
     return degreeDistribution;
 }
 
-map<long, map<long, unordered_set<long>>> calculateLocalEgoNet(string graphID, string partitionID, int serverPort,
-                                                               JasmineGraphHashMapLocalStore localDB,
-                                                               JasmineGraphHashMapCentralStore centralDB,
-                                                               std::vector<string> &workerSockets) {
-    std::map<long, map<long, unordered_set<long>>> egonetMap;
-
-    map<long, unordered_set<long>> centralGraphMap = centralDB.getUnderlyingHashMap();
-    map<long, unordered_set<long>> localGraphMap = localDB.getUnderlyingHashMap();
-
-    for (map<long, unordered_set<long>>::iterator it = localGraphMap.begin(); it != localGraphMap.end(); ++it) {
-        unordered_set<long> neighbours = it->second;
-
-        map<long, unordered_set<long>> individualEgoNet;
-        individualEgoNet[it->first] = neighbours;
-
-        for (unordered_set<long>::iterator neighbour = neighbours.begin(); neighbour != neighbours.end(); ++neighbour) {
-            unordered_set<long> neighboursOfNeighboursInSameEgoNet;
-
-            map<long, unordered_set<long>>::iterator localGraphMapItr = localGraphMap.find(*neighbour);
-            if (localGraphMapItr != localGraphMap.end()) {
-                unordered_set<long> neighboursOfNeighbour = localGraphMapItr->second;
-
-                for (auto neighboursOfNeighbourItr = neighboursOfNeighbour.begin();
-                     neighboursOfNeighbourItr != neighboursOfNeighbour.end(); ++neighboursOfNeighbourItr) {
-                    unordered_set<long>::iterator neighboursItr = neighbours.find(*neighboursOfNeighbourItr);
-                    if (neighboursItr != neighbours.end()) {
-                        neighboursOfNeighboursInSameEgoNet.insert(*neighboursItr);
-                    }
-                }
-            }
-            individualEgoNet[*neighbour] = neighboursOfNeighboursInSameEgoNet;
-        }
-
-        egonetMap[it->first] = individualEgoNet;
-    }
-
-    for (map<long, unordered_set<long>>::iterator it = centralGraphMap.begin(); it != centralGraphMap.end(); ++it) {
-        unordered_set<long> distribution = it->second;
-
-        map<long, map<long, unordered_set<long>>>::iterator egonetMapItr = egonetMap.find(it->first);
-
-        if (egonetMapItr == egonetMap.end()) {
-            map<long, unordered_set<long>> vertexMapFromCentralStore;
-            vertexMapFromCentralStore.insert(
-                std::make_pair(it->first,
-                               distribution));  // Here we do not have the relation information among neighbours
-            egonetMap[it->first] = vertexMapFromCentralStore;
-
-        } else {
-            map<long, unordered_set<long>> egonetSubGraph = egonetMapItr->second;
-
-            map<long, unordered_set<long>>::iterator egonetSubGraphItr = egonetSubGraph.find(it->first);
-            if (egonetSubGraphItr != egonetSubGraph.end()) {
-                unordered_set<long> egonetSubGraphNeighbours = egonetSubGraphItr->second;
-                egonetSubGraphNeighbours.insert(distribution.begin(), distribution.end());
-                egonetSubGraphItr->second = egonetSubGraphNeighbours;
-            }
-        }
-    }
+/*
+ * Writes the ego networks of the vertices of the partition to <graph>_egonet_<partition> in the data folder, one ego
+ * at a time. Neighbours come from the local and central stores of the partition and, in reverse, from the central
+ * stores of the partitions in the worker list found in the data folder.
+ * */
+long writeLocalEgoNets(string graphID, string partitionID, JasmineGraphHashMapLocalStore &localDB,
+                       JasmineGraphHashMapCentralStore &centralDB, std::vector<string> &workerSockets) {
+    EgoNet egoNet;
+    egoNet.addStore(localDB.getUnderlyingHashMap());
+    egoNet.addStore(centralDB.getUnderlyingHashMap());
+    egoNet.setCacheNeighbours(true);
 
+    std::string dataDirPath = Utils::getJasmineGraphProperty("org.jasminegraph.server.instance.datafolder");
     for (vector<string>::iterator workerIt = workerSockets.begin(); workerIt != workerSockets.end(); ++workerIt) {
-        std::vector<string> workerSocketPair;
-        stringstream wl(*workerIt);
-        string intermediate;
-        while (getline(wl, intermediate, ':')) {
-            workerSocketPair.push_back(intermediate);
+        std::vector<string> workerSocketPair = Utils::split(*workerIt, ':');
+        if (workerSocketPair.size() < 3) {
+            continue;
         }
-
-        std::string dataDirPath = Utils::getJasmineGraphProperty("org.jasminegraph.server.instance.datafolder");
-        std::string centralGraphIdentifier = graphID + "_centralstore_" + workerSocketPair[2];
-
-        std::string centralStoreFile = dataDirPath + "/" + centralGraphIdentifier;
+        std::string centralStoreFile = dataDirPath + "/" + graphID + "_centralstore_" + workerSocketPair[2];
         instance_logger.info("###INSTANCE### centralstore " + centralStoreFile);
 
         struct stat centralStoreFileStat;
@@ -1407,58 +1521,25 @@ map<long, map<long, unordered_set<long>>> calculateLocalEgoNet(string graphID, s
             continue;
         }
         JasmineGraphHashMapCentralStore *centralStore = JasmineGraphInstanceService::loadCentralStore(centralStoreFile);
-        const auto &centralGraphMap = centralStore->getUnderlyingHashMap();
-
-        for (auto centralGraphMapIterator = centralGraphMap.begin(); centralGraphMapIterator != centralGraphMap.end();
-             ++centralGraphMapIterator) {
-            long startVid = centralGraphMapIterator->first;
-            const unordered_set<long> &endVidSet = centralGraphMapIterator->second;
-
-            for (auto itr = endVidSet.begin(); itr != endVidSet.end(); ++itr) {
-                auto egonetMapItr = egonetMap.find(*itr);
-                if (egonetMapItr != egonetMap.end()) {
-                    map<long, unordered_set<long>> &egonetSubGraph = egonetMapItr->second;
-                    auto egonetSubGraphItr = egonetSubGraph.find(*itr);
-                    if (egonetSubGraphItr != egonetSubGraph.end()) {
-                        unordered_set<long> &egonetSubGraphNeighbours = egonetSubGraphItr->second;
-                        egonetSubGraphNeighbours.insert(startVid);
-                    }
-                }
-            }
-        }
+        egoNet.addReverseStore(centralStore->getUnderlyingHashMap());
         delete centralStore;
     }
 
-    return egonetMap;
+    string egoNetFile = dataDirPath + "/" + graphID + "_egonet_" + partitionID;
+    long edges = egoNet.writeAll(egoNetFile);
+    instance_logger.info("###INSTANCE### Wrote " + to_string(edges) + " ego network edges to " + egoNetFile);
+    return edges;
 }
 
-void calculateEgoNet(string graphID, string partitionID, int serverPort, JasmineGraphHashMapLocalStore localDB,
-                     JasmineGraphHashMapCentralStore centralDB, string workerList) {
+void calculateEgoNet(string graphID, string partitionID, int serverPort, JasmineGraphHashMapLocalStore &localDB,
+                     JasmineGraphHashMapCentralStore &centralDB, string workerList) {
     std::vector<string> workerSockets;
     stringstream wl(workerList);
     string intermediate;
     while (getline(wl, intermediate, ',')) {
         workerSockets.push_back(intermediate);
     }
-    map<long, map<long, unordered_set<long>>> egonetMap =
-        calculateLocalEgoNet(graphID, partitionID, serverPort, localDB, centralDB, workerSockets);
-
-    string instanceDataFolderLocation = Utils::getJasmineGraphProperty("org.jasminegraph.server.instance.datafolder");
-    string attributeFilePart = instanceDataFolderLocation + "/" + graphID + "_egonet_" + partitionID;
-    ofstream partfile;
-    partfile.open(attributeFilePart, std::fstream::trunc);
-    for (map<long, map<long, unordered_set<long>>>::iterator it = egonetMap.begin(); it != egonetMap.end(); ++it) {
-        map<long, unordered_set<long>> egonetInternalMap = it->second;
-        for (map<long, unordered_set<long>>::iterator itm = egonetInternalMap.begin(); itm != egonetInternalMap.end();
-             ++itm) {
-            unordered_set<long> egonetInternalMapEdges = itm->second;
-            for (unordered_set<long>::iterator ite = egonetInternalMapEdges.begin();
-                 ite != egonetInternalMapEdges.end(); ++ite) {
-                partfile << to_string(it->first) << "\t" << to_string(itm->first) << "\t" << to_string(*ite) << endl;
-            }
-        }
-    }
-    partfile.close();
+    writeLocalEgoNets(graphID, partitionID, localDB, centralDB, workerSockets);
 
     // todo  invoke other workers asynchronously
     for (vector<string>::iterator workerIt = workerSockets.begin(); workerIt != workerSockets.end(); ++workerIt) {
@@ -1624,58 +1705,38 @@ map<long, double> calculateLocalPageRank(string graphID, double alpha, string pa
     // calculating local pagerank
     map<long, double> rankMap;
 
-    std::map<long, long> inDegreeDistribution;
-
     std::string dataDirPath = Utils::getJasmineGraphProperty("org.jasminegraph.server.instance.datafolder");
 
     std::string partitionCount = Utils::getJasmineGraphProperty("org.jasminegraph.server.npartitions");
     int parCount = std::stoi(partitionCount);
 
+    // Every partition run holds the in-degrees it knows of, so the runs are merged taking the maximum per vertex.
+    // The merged run comes out in vertex order, which lets it be joined with the ordered local graph in one pass.
+    std::vector<DegreeDistributionReader *> iddRuns;
     for (int partitionID = 0; partitionID < parCount; ++partitionID) {
         std::string iddFilePath = dataDirPath + "/" + graphID + "_idd_" + std::to_string(partitionID);
-        std::ifstream dataFile;
-        dataFile.open(iddFilePath);
-
-        while (!dataFile.eof()) {
-            std::string line;
-            std::getline(dataFile, line);
-            std::stringstream buffer(line);
-            std::string temp;
-            std::vector<long> values;
-
-            while (getline(buffer, temp, '\t')) {
-                values.push_back(::strtod(temp.c_str(), nullptr));
-            }
-
-            if (values.size() == 2) {
-                long nodeID = values[0];
-                long iddValue = values[1];
-
-                inDegreeDistribution[nodeID] = std::max(inDegreeDistribution[nodeID], iddValue);
-            }
+        if (Utils::fileExists(iddFilePath)) {
+            iddRuns.push_back(new DegreeDistributionReader(iddFilePath));
         }
-
-        dataFile.close();
-    }
-
-    string instanceDataFolderLocation = Utils::getJasmineGraphProperty("org.jasminegraph.server.instance.datafolder");
-    string attributeFilePart = instanceDataFolderLocation + "/" + graphID + "_idd_combine";
-    ofstream partfile;
-    partfile.open(attributeFilePart, std::fstream::trunc);
-    for (map<long, long>::iterator it = inDegreeDistribution.begin(); it != inDegreeDistribution.end(); ++it) {
-        partfile << to_string(it->first) << "\t" << to_string(it->second) << endl;
     }
-    partfile.close();
-
-    for (localGraphMapIterator = localGraphMap.begin(); localGraphMapIterator != localGraphMap.end();
-         ++localGraphMapIterator) {
-        auto inDegreeDistributionItr = inDegreeDistribution.find(localGraphMapIterator->first);
 
-        if (inDegreeDistributionItr != inDegreeDistribution.end()) {
-            long inDegree = inDegreeDistributionItr->second;
+    string attributeFilePart = dataDirPath + "/" + graphID + "_idd_combine";
+    DegreeDistributionWriter combinedRun;
+    combinedRun.open(attributeFilePart);
+    localGraphMapIterator = localGraphMap.begin();
+    DegreeDistribution::merge(iddRuns, DegreeDistribution::MAX, [&](long nodeID, long inDegree) {
+        combinedRun.append(nodeID, inDegree);
+        while (localGraphMapIterator != localGraphMap.end() && localGraphMapIterator->first < nodeID) {
+            ++localGraphMapIterator;
+        }
+        if (localGraphMapIterator != localGraphMap.end() && localGraphMapIterator->first == nodeID) {
             double authorityScore = (alpha * 1 + mu) * inDegree;
-            rankMap[inDegreeDistributionItr->first] = authorityScore;
+            rankMap[nodeID] = authorityScore;
         }
+    });
+    combinedRun.close();
+    for (auto run : iddRuns) {
+        delete run;
     }
 
     int count = 0;
@@ -1734,7 +1795,6 @@ map<long, double> calculateLocalPageRank(string graphID, double alpha, string pa
     centralGraphMap.clear();
     localGraphMap.clear();
     resultTreeMap.clear();
-    inDegreeDistribution.clear();
     rankMap.clear();
     rankMapResults.clear();
     instance_logger.info("Elapsed time for calculating PageRank (in ms) -----: " + to_string(elapsed_time_ms));
@@ -2027,26 +2087,8 @@ static void batch_upload_common(int connFd, bool *loop_exit_p, bool batch_upload
     string fullFilePath =
         Utils::getJasmineGraphProperty("org.jasminegraph.server.instance.datafolder") + "/" + fileName;
 
-    int fileSize = stoi(size);
-    while (!Utils::fileExists(fullFilePath)) {
-        instance_logger.info("Instance data file " + fullFilePath + " does not exist");
-        sleep(1);
-    }
-    while (Utils::getFileSize(fullFilePath) < fileSize) {
-        line = Utils::read_str_wrapper(connFd, data, INSTANCE_DATA_LENGTH, false);
-        if (line.compare(JasmineGraphInstanceProtocol::FILE_RECV_CHK) != 0) {
-            instance_logger.error("Incorrect response. Expected: " + JasmineGraphInstanceProtocol::FILE_RECV_CHK +
-                                  " ; Received: " + line);
-            close(connFd);
-            return;
-        }
-        if (!Utils::send_str_wrapper(connFd, JasmineGraphInstanceProtocol::FILE_RECV_WAIT)) {
-            *loop_exit_p = true;
-            return;
-        }
-        instance_logger.info("Waiting for file to be received to " + fullFilePath);
-    }
-
+    long fileSize = stol(size);
+    // The master checks for the file only after the file transfer service acknowledged the verified file
     line = Utils::read_str_wrapper(connFd, data, INSTANCE_DATA_LENGTH, false);
     if (line.compare(JasmineGraphInstanceProtocol::FILE_RECV_CHK) != 0) {
         instance_logger.error("Incorrect response. Expected: " + JasmineGraphInstanceProtocol::FILE_RECV_CHK +
@@ -2056,6 +2098,12 @@ static void batch_upload_common(int connFd, bool *loop_exit_p, bool batch_upload
     }
     instance_logger.info("Received : " + line);
 
+    if (!Utils::waitForFile(fullFilePath, fileSize, FILE_RECEIVE_TIMEOUT)) {
+        Utils::send_str_wrapper(connFd, JasmineGraphInstanceProtocol::FILE_RECV_ERROR);
+        *loop_exit_p = true;
+        return;
+    }
+
     if (!Utils::send_str_wrapper(connFd, JasmineGraphInstanceProtocol::FILE_ACK)) {
         *loop_exit_p = true;
         return;
@@ -2065,38 +2113,32 @@ static void batch_upload_common(int connFd, bool *loop_exit_p, bool batch_upload
     instance_logger.info("File received and saved to " + fullFilePath);
     *loop_exit_p = true;
 
+    bool stored = true;
     string rawname = fileName;
     if (fullFilePath.compare(fullFilePath.size() - 3, 3, ".gz") == 0) {
-        Utils::unzipFile(fullFilePath);
+        if (Utils::unzipFile(fullFilePath) != 0) {
+            instance_logger.error("Unzipping " + fullFilePath + " failed");
+            stored = false;
+        }
         size_t lastindex = fileName.find_last_of(".");
         rawname = fileName.substr(0, lastindex);
     }
 
     fullFilePath = Utils::getJasmineGraphProperty("org.jasminegraph.server.instance.datafolder") + "/" + rawname;
 
-    if (batch_upload) {
+    if (stored && !Utils::fileExists(fullFilePath)) {
+        instance_logger.error("Instance data file " + fullFilePath + " does not exist");
+        stored = false;
+    }
+
+    // A partition is only recorded in the catalog, and acknowledged to the master, once its file is in place
+    if (stored && batch_upload) {
         string partitionID = rawname.substr(rawname.find_last_of("_") + 1);
         pthread_mutex_lock(&file_lock);
         writeCatalogRecord(graphID + ":" + partitionID);
         pthread_mutex_unlock(&file_lock);
     }
 
-    while (!Utils::fileExists(fullFilePath)) {
-        line = Utils::read_str_trim_wrapper(connFd, data, INSTANCE_DATA_LENGTH);
-        if (line.compare(JasmineGraphInstanceProtocol::BATCH_UPLOAD_CHK) != 0) {
-            instance_logger.error("Incorrect response. Expected: " + JasmineGraphInstanceProtocol::BATCH_UPLOAD_CHK +
-                                  " ; Received: " + line);
-            close(connFd);
-            return;
-        }
-        instance_logger.info("Received : " + line);
-        if (!Utils::send_str_wrapper(connFd, JasmineGraphInstanceProtocol::BATCH_UPLOAD_WAIT)) {
-            *loop_exit_p = true;
-            return;
-        }
-        instance_logger.info("Sent : " + JasmineGraphInstanceProtocol::BATCH_UPLOAD_WAIT);
-    }
-
     line = Utils::read_str_wrapper(connFd, data, INSTANCE_DATA_LENGTH, false);
     if (line.compare(JasmineGraphInstanceProtocol::BATCH_UPLOAD_CHK) != 0) {
         instance_logger.error("Incorrect response. Expected: " + JasmineGraphInstanceProtocol::BATCH_UPLOAD_CHK +
@@ -2105,11 +2147,13 @@ static void batch_upload_common(int connFd, bool *loop_exit_p, bool batch_upload
         return;
     }
     instance_logger.info("Received : " + line);
-    if (!Utils::send_str_wrapper(connFd, JasmineGraphInstanceProtocol::BATCH_UPLOAD_ACK)) {
+    const string &reply =
+        stored ? JasmineGraphInstanceProtocol::BATCH_UPLOAD_ACK : JasmineGraphInstanceProtocol::ERROR;
+    if (!Utils::send_str_wrapper(connFd, reply)) {
         *loop_exit_p = true;
         return;
     }
-    instance_logger.info("Sent : " + JasmineGraphInstanceProtocol::BATCH_UPLOAD_ACK);
+    instance_logger.info("Sent : " + reply);
 }
 
 static void batch_upload_command(int connFd, bool *loop_exit_p) { batch_upload_common(connFd, loop_exit_p, true); }
@@ -2312,12 +2356,7 @@ static void worker_in_degree_distribution_command(
 
     string instanceDataFolderLocation = Utils::getJasmineGraphProperty("org.jasminegraph.server.instance.datafolder");
     string attributeFilePart = instanceDataFolderLocation + "/" + graphID + "_idd_" + partitionID;
-    ofstream partfile;
-    partfile.open(attributeFilePart, std::fstream::trunc);
-    for (map<long, long>::iterator it = degreeDistribution.begin(); it != degreeDistribution.end(); ++it) {
-        partfile << to_string(it->first) << "\t" << to_string(it->second) << endl;
-    }
-    partfile.close();
+    DegreeDistribution::write(attributeFilePart, degreeDistribution);
 
     *loop_exit_p = true;
 }
@@ -2372,6 +2411,23 @@ static void degree_distribution_common(int connFd, int serverPort,
     }
     degreeDistribution.clear();
     *loop_exit_p = true;
+
+    // Stream the binary run back so that the master can merge the partitions without parsing text
+    string runFile = Utils::getJasmineGraphProperty("org.jasminegraph.server.instance.datafolder") + "/" + graphID +
+                     (in ? "_idd_" : "_odd_") + partitionID;
+    long runSize = Utils::getFileSize(runFile);
+    if (runSize < 0) {
+        instance_logger.error("Degree distribution run " + runFile + " was not written");
+        Utils::send_str_wrapper(connFd, JasmineGraphInstanceProtocol::ERROR);
+        return;
+    }
+    if (!Utils::sendExpectResponse(connFd, data, INSTANCE_DATA_LENGTH, to_string(runSize),
+                                   JasmineGraphInstanceProtocol::OK)) {
+        return;
+    }
+    if (!Utils::sendFileContent(connFd, runFile, 0, runSize)) {
+        instance_logger.error("Sending degree distribution run " + runFile + " failed");
+    }
 }
 
 static void in_degree_distribution_command(
@@ -2408,12 +2464,7 @@ static void worker_out_degree_distribution_command(
 
     string instanceDataFolderLocation = Utils::getJasmineGraphProperty("org.jasminegraph.server.instance.datafolder");
     string attributeFilePart = instanceDataFolderLocation + "/" + graphID + "_odd_" + partitionID;
-    ofstream partfile;
-    partfile.open(attributeFilePart, std::fstream::trunc);
-    for (map<long, long>::iterator it = degreeDistribution.begin(); it != degreeDistribution.end(); ++it) {
-        partfile << to_string(it->first) << "\t" << to_string(it->second) << endl;
-    }
-    partfile.close();
+    DegreeDistribution::write(attributeFilePart, degreeDistribution);
 }
 
 static void out_degree_distribution_command(
@@ -2734,9 +2785,6 @@ static void egonet_command(int connFd, int serverPort,
         instance_logger.info("Sent : " + JasmineGraphInstanceProtocol::OK);
     }
 
-    JasmineGraphHashMapLocalStore graphDB;
-    JasmineGraphHashMapCentralStore centralDB;
-
     std::map<std::string, JasmineGraphHashMapLocalStore> graphDBMapLocalStoresPgrnk;
     if (JasmineGraphInstanceService::isGraphDBExists(graphID, partitionID)) {
         JasmineGraphInstanceService::loadLocalStore(graphID, partitionID, graphDBMapLocalStoresPgrnk);
@@ -2746,8 +2794,8 @@ static void egonet_command(int connFd, int serverPort,
         JasmineGraphInstanceService::loadInstanceCentralStore(graphID, partitionID, graphDBMapCentralStores);
     }
 
-    graphDB = graphDBMapLocalStoresPgrnk[graphID + "_" + partitionID];
-    centralDB = graphDBMapCentralStores[graphID + "_centralstore_" + partitionID];
+    JasmineGraphHashMapLocalStore &graphDB = graphDBMapLocalStoresPgrnk[graphID + "_" + partitionID];
+    JasmineGraphHashMapCentralStore &centralDB = graphDBMapCentralStores[graphID + "_centralstore_" + partitionID];
 
     calculateEgoNet(graphID, partitionID, serverPort, graphDB, centralDB, workerList);
 }
@@ -2796,9 +2844,6 @@ static void worker_egonet_command(int connFd, int serverPort,
     }
     instance_logger.info("Sent : " + JasmineGraphInstanceProtocol::OK);
 
-    JasmineGraphHashMapLocalStore graphDB;
-    JasmineGraphHashMapCentralStore centralDB;
-
     std::map<std::string, JasmineGraphHashMapLocalStore> graphDBMapLocalStoresPgrnk;
     if (JasmineGraphInstanceService::isGraphDBExists(graphID, partitionID)) {
         JasmineGraphInstanceService::loadLocalStore(graphID, partitionID, graphDBMapLocalStoresPgrnk);
@@ -2808,30 +2853,118 @@ static void worker_egonet_command(int connFd, int serverPort,
         JasmineGraphInstanceService::loadInstanceCentralStore(graphID, partitionID, graphDBMapCentralStores);
     }
 
-    graphDB = graphDBMapLocalStoresPgrnk[graphID + "_" + partitionID];
-    centralDB = graphDBMapCentralStores[graphID + "_centralstore_" + partitionID];
+    JasmineGraphHashMapLocalStore &graphDB = graphDBMapLocalStoresPgrnk[graphID + "_" + partitionID];
+    JasmineGraphHashMapCentralStore &centralDB = graphDBMapCentralStores[graphID + "_centralstore_" + partitionID];
 
-    map<long, map<long, unordered_set<long>>> egonetMap =
-        calculateLocalEgoNet(graphID, partitionID, serverPort, graphDB, centralDB, workerSockets);
+    writeLocalEgoNets(graphID, partitionID, graphDB, centralDB, workerSockets);
 
-    string instanceDataFolderLocation = Utils::getJasmineGraphProperty("org.jasminegraph.server.instance.datafolder");
-    string attributeFilePart = instanceDataFolderLocation + "/" + graphID + "_egonet_" + partitionID;
-    ofstream partfile;
-    partfile.open(attributeFilePart, std::fstream::trunc);
-    for (map<long, map<long, unordered_set<long>>>::iterator it = egonetMap.begin(); it != egonetMap.end(); ++it) {
-        map<long, unordered_set<long>> egonetInternalMap = it->second;
-        for (map<long, unordered_set<long>>::iterator itm = egonetInternalMap.begin(); itm != egonetInternalMap.end();
-             ++itm) {
-            unordered_set<long> egonetInternalMapEdges = itm->second;
-            for (unordered_set<long>::iterator ite = egonetInternalMapEdges.begin();
-                 ite != egonetInternalMapEdges.end(); ++ite) {
-                partfile << to_string(it->first) << "\t" << to_string(itm->first) << "\t" << to_string(*ite) << endl;
+    instance_logger.info("Egonet calculation completed");
+}
+
+/*
+ * Streams the ego networks of the requested vertices of the partition as they are computed. The vertices arrive as
+ * a count followed by comma separated chunks. The edges go back in frames of (ego, from, to) triples of 64 bit
+ * integers, each announced by its size in bytes and acknowledged by the master. A frame size of 0 ends the stream.
+ * */
+static void egonet_vertices_command(
+    int connFd, std::map<std::string, JasmineGraphHashMapLocalStore> &graphDBMapLocalStores,
+    std::map<std::string, JasmineGraphHashMapCentralStore> &graphDBMapCentralStores, bool *loop_exit_p) {
+    if (!Utils::send_str_wrapper(connFd, JasmineGraphInstanceProtocol::OK)) {
+        *loop_exit_p = true;
+        return;
+    }
+    instance_logger.info("Sent : " + JasmineGraphInstanceProtocol::OK);
+
+    char data[DATA_BUFFER_SIZE];
+    string graphID = Utils::read_str_trim_wrapper(connFd, data, INSTANCE_DATA_LENGTH);
+    instance_logger.info("Received Graph ID: " + graphID);
+    if (!Utils::send_str_wrapper(connFd, JasmineGraphInstanceProtocol::OK)) {
+        *loop_exit_p = true;
+        return;
+    }
+
+    string partitionID = Utils::read_str_trim_wrapper(connFd, data, INSTANCE_DATA_LENGTH);
+    instance_logger.info("Received Partition ID: " + partitionID);
+    if (!Utils::send_str_wrapper(connFd, JasmineGraphInstanceProtocol::OK)) {
+        *loop_exit_p = true;
+        return;
+    }
+
+    long vertexCount = atol(Utils::read_str_trim_wrapper(connFd, data, INSTANCE_DATA_LENGTH).c_str());
+    if (!Utils::send_str_wrapper(connFd, JasmineGraphInstanceProtocol::OK)) {
+        *loop_exit_p = true;
+        return;
+    }
+    std::vector<long> vertices;
+    while ((long)vertices.size() < vertexCount) {
+        string chunk = Utils::read_str_trim_wrapper(connFd, data, INSTANCE_DATA_LENGTH);
+        if (chunk.empty()) {
+            *loop_exit_p = true;
+            return;
+        }
+        for (const auto &vertex : Utils::split(chunk, ',')) {
+            if (!vertex.empty()) {
+                vertices.push_back(atol(vertex.c_str()));
             }
         }
+        if (!Utils::send_str_wrapper(connFd, JasmineGraphInstanceProtocol::OK)) {
+            *loop_exit_p = true;
+            return;
+        }
     }
-    partfile.close();
+    instance_logger.info("Received " + to_string(vertices.size()) + " ego vertices");
 
-    instance_logger.info("Egonet calculation completed");
+    std::string graphIdentifier = graphID + "_" + partitionID;
+    std::string centralGraphIdentifier = graphID + "_centralstore_" + partitionID;
+    if (graphDBMapLocalStores.find(graphIdentifier) == graphDBMapLocalStores.end() &&
+        JasmineGraphInstanceService::isGraphDBExists(graphID, partitionID)) {
+        JasmineGraphInstanceService::loadLocalStore(graphID, partitionID, graphDBMapLocalStores);
+    }
+    if (graphDBMapCentralStores.find(centralGraphIdentifier) == graphDBMapCentralStores.end() &&
+        JasmineGraphInstanceService::isInstanceCentralStoreExists(graphID, partitionID)) {
+        JasmineGraphInstanceService::loadInstanceCentralStore(graphID, partitionID, graphDBMapCentralStores);
+    }
+
+    EgoNet egoNet;
+    egoNet.addStore(graphDBMapLocalStores[graphIdentifier].getUnderlyingHashMap());
+    egoNet.addStore(graphDBMapCentralStores[centralGraphIdentifier].getUnderlyingHashMap());
+
+    std::vector<int64_t> frame;
+    frame.reserve(3 * EGONET_FRAME_EDGES);
+    auto sendFrame = [connFd, &data, &frame]() {
+        size_t bytes = frame.size() * sizeof(int64_t);
+        bool sent = Utils::sendExpectResponse(connFd, data, INSTANCE_DATA_LENGTH, to_string(bytes),
+                                              JasmineGraphInstanceProtocol::OK) &&
+                    (bytes == 0 || Utils::send_wrapper(connFd, reinterpret_cast<const char *>(frame.data()), bytes));
+        frame.clear();
+        return sent;
+    };
+    bool failed = false;
+    long edges = 0;
+    for (long vertex : vertices) {
+        edges += egoNet.stream(vertex, [&frame, &failed, &sendFrame](long ego, long from, long to) {
+            if (failed) {
+                return;
+            }
+            frame.push_back(ego);
+            frame.push_back(from);
+            frame.push_back(to);
+            if (frame.size() >= 3 * EGONET_FRAME_EDGES) {
+                failed = !sendFrame();
+            }
+        });
+        if (failed) {
+            break;
+        }
+    }
+    // The last frame, if any, and the empty frame that ends the stream
+    if (failed || (!frame.empty() && !sendFrame()) || !sendFrame()) {
+        instance_logger.error("Streaming ego networks of graph " + graphID + " partition " + partitionID + " failed");
+        *loop_exit_p = true;
+        return;
+    }
+    instance_logger.info("Streamed " + to_string(edges) + " ego network edges of " + to_string(vertices.size()) +
+                         " vertices");
 }
 
 static void triangles_command(
@@ -2876,8 +3009,12 @@ static void triangles_command(
 
     std::thread perfThread = std::thread(&PerformanceUtil::collectPerformanceStatistics);
     perfThread.detach();
-    long localCount = countLocalTriangles(graphID, partitionId, graphDBMapLocalStores, graphDBMapCentralStores,
-                                          graphDBMapDuplicateCentralStores, threadPriority);
+    long localCount;
+    {
+        RunningTaskGuard runningTask;
+        localCount = countLocalTriangles(graphID, partitionId, graphDBMapLocalStores, graphDBMapCentralStores,
+                                         graphDBMapDuplicateCentralStores, threadPriority);
+    }
 
     if (threadPriority > Conts::DEFAULT_THREAD_PRIORITY) {
         threadPriorityMutex.lock();
@@ -2940,6 +3077,17 @@ static void streaming_triangles_command(
     string mode = Utils::read_str_trim_wrapper(connFd, data, INSTANCE_DATA_LENGTH);
     instance_logger.info("Received mode: " + mode);
 
+    // Windowed counts are followed by the window
+    string window;
+    if (mode == "2") {
+        if (!Utils::send_str_wrapper(connFd, JasmineGraphInstanceProtocol::OK)) {
+            *loop_exit_p = true;
+            return;
+        }
+        window = Utils::read_str_trim_wrapper(connFd, data, INSTANCE_DATA_LENGTH);
+        instance_logger.info("Received window: " + window);
+    }
+
     std::string graphIdentifier = graphID + "_" + partitionId;
     JasmineGraphIncrementalLocalStore *incrementalLocalStoreInstance;
 
@@ -2953,6 +3101,8 @@ static void streaming_triangles_command(
     NativeStoreTriangleResult localCount;
     if (mode == "0") {
         localCount = StreamingTriangles::countLocalStreamingTriangles(incrementalLocalStoreInstance);
+    } else if (mode == "2") {
+        localCount = StreamingTriangles::countWindowLocalTriangles(incrementalLocalStoreInstance, window);
     } else {
         localCount = StreamingTriangles::countDynamicLocalTriangles(
             incrementalLocalStoreInstance, std::stol(oldLocalRelationCount), std::stol(oldCentralRelationCount));
@@ -3027,27 +3177,21 @@ static void send_centralstore_to_aggregator_command(int connFd, bool *loop_exit_
     string fullFilePath =
         Utils::getJasmineGraphProperty("org.jasminegraph.server.instance.datafolder") + "/" + fileName;
     string line;
-    int fileSize = stoi(size);
-    while (!Utils::fileExists(fullFilePath)) {
-        sleep(1);
-    }
-    while (Utils::getFileSize(fullFilePath) < fileSize) {
-        line = Utils::read_str_wrapper(connFd, data, INSTANCE_DATA_LENGTH, false);
-        if (line.compare(JasmineGraphInstanceProtocol::FILE_RECV_CHK) != 0) {
-            *loop_exit_p = true;
-            return;
-        }
-        if (!Utils::send_str_wrapper(connFd, JasmineGraphInstanceProtocol::FILE_RECV_WAIT)) {
-            *loop_exit_p = true;
-            return;
-        }
-    }
+    long fileSize = stol(size);
+    bool received = Utils::waitForFile(fullFilePath, fileSize, FILE_RECEIVE_TIMEOUT);
 
     line = Utils::read_str_wrapper(connFd, data, INSTANCE_DATA_LENGTH, false);
     if (line.compare(JasmineGraphInstanceProtocol::FILE_RECV_CHK) != 0) {
         instance_logger.error("Received : " + line);
     }
     instance_logger.info("Received : " + line);
+    if (!received) {
+        instance_logger.error("File " + fullFilePath + " was not received within " +
+                              to_string(FILE_RECEIVE_TIMEOUT) + " seconds");
+        Utils::send_str_wrapper(connFd, JasmineGraphInstanceProtocol::FILE_RECV_ERROR);
+        *loop_exit_p = true;
+        return;
+    }
     if (!Utils::send_str_wrapper(connFd, JasmineGraphInstanceProtocol::FILE_ACK)) {
         *loop_exit_p = true;
         return;
@@ -3057,24 +3201,31 @@ static void send_centralstore_to_aggregator_command(int connFd, bool *loop_exit_
     instance_logger.info("File received and saved to " + fullFilePath);
     *loop_exit_p = true;
 
-    Utils::unzipFile(fullFilePath);
+    bool stored = true;
+    if (Utils::unzipFile(fullFilePath) != 0) {
+        instance_logger.error("Unzipping " + fullFilePath + " failed");
+        stored = false;
+    }
     size_t lastindex = fileName.find_last_of(".");
     string rawname = fileName.substr(0, lastindex);
     fullFilePath = Utils::getJasmineGraphProperty("org.jasminegraph.server.instance.datafolder") + "/" + rawname;
     std::string aggregatorDirPath = Utils::getJasmineGraphProperty("org.jasminegraph.server.instance.aggregatefolder");
 
-    if (Utils::copyToDirectory(fullFilePath, aggregatorDirPath)) {
+    if (stored && Utils::copyToDirectory(fullFilePath, aggregatorDirPath)) {
         instance_logger.error("Copying " + fullFilePath + " into " + aggregatorDirPath + " failed");
+        stored = false;
     }
 
     line = Utils::read_str_wrapper(connFd, data, INSTANCE_DATA_LENGTH, false);
     if (line.compare(JasmineGraphInstanceProtocol::BATCH_UPLOAD_CHK) == 0) {
         instance_logger.info("Received : " + JasmineGraphInstanceProtocol::BATCH_UPLOAD_CHK);
-        if (!Utils::send_str_wrapper(connFd, JasmineGraphInstanceProtocol::BATCH_UPLOAD_ACK)) {
+        const string &reply =
+            stored ? JasmineGraphInstanceProtocol::BATCH_UPLOAD_ACK : JasmineGraphInstanceProtocol::ERROR;
+        if (!Utils::send_str_wrapper(connFd, reply)) {
             *loop_exit_p = true;
             return;
         }
-        instance_logger.info("Sent : " + JasmineGraphInstanceProtocol::BATCH_UPLOAD_ACK);
+        instance_logger.info("Sent : " + reply);
     }
 }
 
@@ -3107,27 +3258,21 @@ static void send_composite_centralstore_to_aggregator_command(int connFd, bool *
     string fullFilePath =
         Utils::getJasmineGraphProperty("org.jasminegraph.server.instance.datafolder") + "/" + fileName;
     string line;
-    int fileSize = stoi(size);
-    while (!Utils::fileExists(fullFilePath)) {
-        sleep(1);
-    }
-    while (Utils::getFileSize(fullFilePath) < fileSize) {
-        line = Utils::read_str_wrapper(connFd, data, INSTANCE_DATA_LENGTH, false);
-        if (line.compare(JasmineGraphInstanceProtocol::FILE_RECV_CHK) != 0) {
-            *loop_exit_p = true;
-            return;
-        }
-        if (!Utils::send_str_wrapper(connFd, JasmineGraphInstanceProtocol::FILE_RECV_WAIT)) {
-            *loop_exit_p = true;
-            return;
-        }
-    }
+    long fileSize = stol(size);
+    bool received = Utils::waitForFile(fullFilePath, fileSize, FILE_RECEIVE_TIMEOUT);
 
     line = Utils::read_str_wrapper(connFd, data, INSTANCE_DATA_LENGTH, false);
     if (line.compare(JasmineGraphInstanceProtocol::FILE_RECV_CHK) != 0) {
         instance_logger.error("Received : " + line);
     }
     instance_logger.info("Received : " + line);
+    if (!received) {
+        instance_logger.error("File " + fullFilePath + " was not received within " +
+                              to_string(FILE_RECEIVE_TIMEOUT) + " seconds");
+        Utils::send_str_wrapper(connFd, JasmineGraphInstanceProtocol::FILE_RECV_ERROR);
+        *loop_exit_p = true;
+        return;
+    }
     if (!Utils::send_str_wrapper(connFd, JasmineGraphInstanceProtocol::FILE_ACK)) {
         *loop_exit_p = true;
         return;
@@ -3137,24 +3282,31 @@ static void send_composite_centralstore_to_aggregator_command(int connFd, bool *
     instance_logger.info("File received and saved to " + fullFilePath);
     *loop_exit_p = true;
 
-    Utils::unzipFile(fullFilePath);
+    bool stored = true;
+    if (Utils::unzipFile(fullFilePath) != 0) {
+        instance_logger.error("Unzipping " + fullFilePath + " failed");
+        stored = false;
+    }
     size_t lastindex = fileName.find_last_of(".");
     string rawname = fileName.substr(0, lastindex);
     fullFilePath = Utils::getJasmineGraphProperty("org.jasminegraph.server.instance.datafolder") + "/" + rawname;
     std::string aggregatorDirPath = Utils::getJasmineGraphProperty("org.jasminegraph.server.instance.aggregatefolder");
 
-    if (Utils::copyToDirectory(fullFilePath, aggregatorDirPath)) {
+    if (stored && Utils::copyToDirectory(fullFilePath, aggregatorDirPath)) {
         instance_logger.error("Copying " + fullFilePath + " into " + aggregatorDirPath + " failed");
+        stored = false;
     }
 
     line = Utils::read_str_wrapper(connFd, data, INSTANCE_DATA_LENGTH, false);
     if (line.compare(JasmineGraphInstanceProtocol::BATCH_UPLOAD_CHK) == 0) {
         instance_logger.info("Received : " + JasmineGraphInstanceProtocol::BATCH_UPLOAD_CHK);
-        if (!Utils::send_str_wrapper(connFd, JasmineGraphInstanceProtocol::BATCH_UPLOAD_ACK)) {
+        const string &reply =
+            stored ? JasmineGraphInstanceProtocol::BATCH_UPLOAD_ACK : JasmineGraphInstanceProtocol::ERROR;
+        if (!Utils::send_str_wrapper(connFd, reply)) {
             *loop_exit_p = true;
             return;
         }
-        instance_logger.info("Sent : " + JasmineGraphInstanceProtocol::BATCH_UPLOAD_ACK);
+        instance_logger.info("Sent : " + reply);
     }
 }
 
@@ -3174,8 +3326,8 @@ static void aggregate_centralstore_triangles_command(int connFd, bool *loop_exit
         return;
     }
 
-    string partitionId = Utils::read_str_trim_wrapper(connFd, data, INSTANCE_DATA_LENGTH);
-    instance_logger.info("Received Partition ID: " + partitionId);
+    string ownedPartitionIds = Utils::read_str_trim_wrapper(connFd, data, INSTANCE_DATA_LENGTH);
+    instance_logger.info("Received Owned Partition IDs: " + ownedPartitionIds);
 
     if (!Utils::send_str_wrapper(connFd, JasmineGraphInstanceProtocol::OK)) {
         *loop_exit_p = true;
@@ -3202,8 +3354,12 @@ static void aggregate_centralstore_triangles_command(int connFd, bool *loop_exit
         threadPriorityMutex.unlock();
     }
 
-    const std::string &aggregatedTriangles =
-        aggregateCentralStoreTriangles(graphId, partitionId, partitionIdList, threadPriority);
+    long aggregatedTriangles;
+    {
+        RunningTaskGuard runningTask;
+        aggregatedTriangles =
+            aggregateCentralStoreTriangles(graphId, ownedPartitionIds, partitionIdList, threadPriority);
+    }
 
     if (threadPriority > Conts::DEFAULT_THREAD_PRIORITY) {
         threadPriorityMutex.lock();
@@ -3215,35 +3371,9 @@ static void aggregate_centralstore_triangles_command(int connFd, bool *loop_exit
         threadPriorityMutex.unlock();
     }
 
-    std::vector<std::string> chunksVector;
-
-    for (unsigned i = 0; i < aggregatedTriangles.length(); i += CHUNK_OFFSET) {
-        std::string chunk = aggregatedTriangles.substr(i, CHUNK_OFFSET);
-        if (i + CHUNK_OFFSET < aggregatedTriangles.length()) {
-            chunk += "/SEND";
-        } else {
-            chunk += "/CMPT";
-        }
-        chunksVector.push_back(chunk);
-    }
-
-    for (int loopCount = 0; loopCount < chunksVector.size(); loopCount++) {
-        if (loopCount == 0) {
-            std::string chunk = chunksVector.at(loopCount);
-            if (!Utils::send_str_wrapper(connFd, chunk)) {
-                *loop_exit_p = true;
-                break;
-            }
-        } else {
-            string chunkStatus = Utils::read_str_wrapper(connFd, data, INSTANCE_DATA_LENGTH, false);
-            std::string chunk = chunksVector.at(loopCount);
-            if (!Utils::send_str_wrapper(connFd, chunk)) {
-                *loop_exit_p = true;
-            }
-        }
+    if (!Utils::send_str_wrapper(connFd, std::to_string(aggregatedTriangles))) {
+        *loop_exit_p = true;
     }
-    chunksVector.clear();
-    chunksVector.shrink_to_fit();
 }
 
 static void aggregate_streaming_centralstore_triangles_command(
@@ -3299,6 +3429,16 @@ static void aggregate_streaming_centralstore_triangles_command(
     string mode = Utils::read_str_trim_wrapper(connFd, data, INSTANCE_DATA_LENGTH);
     instance_logger.info("Received mode: " + mode);
 
+    string window;
+    if (mode == "2") {
+        if (!Utils::send_str_wrapper(connFd, JasmineGraphInstanceProtocol::OK)) {
+            *loop_exit_p = true;
+            return;
+        }
+        window = Utils::read_str_trim_wrapper(connFd, data, INSTANCE_DATA_LENGTH);
+        instance_logger.info("Received window: " + window);
+    }
+
     int threadPriority = stoi(priority);
 
     if (threadPriority > Conts::DEFAULT_THREAD_PRIORITY) {
@@ -3309,7 +3449,8 @@ static void aggregate_streaming_centralstore_triangles_command(
     }
 
     std::string aggregatedTriangles = JasmineGraphInstanceService::aggregateStreamingCentralStoreTriangles(
-        graphId, partitionId, partitionIdList, centralCountList, threadPriority, incrementalLocalStoreMap, mode);
+        graphId, partitionId, partitionIdList, centralCountList, threadPriority, incrementalLocalStoreMap, mode,
+        window);
 
     if (threadPriority > Conts::DEFAULT_THREAD_PRIORITY) {
         threadPriorityMutex.lock();
@@ -3453,6 +3594,129 @@ static void aggregate_composite_centralstore_triangles_command(int connFd, bool
     chunksVector.shrink_to_fit();
 }
 
+static void shuffle_centralstore_adjacency_command(int connFd, bool *loop_exit_p) {
+    if (!Utils::send_str_wrapper(connFd, JasmineGraphInstanceProtocol::OK)) {
+        *loop_exit_p = true;
+        return;
+    }
+    instance_logger.info("Sent : " + JasmineGraphInstanceProtocol::OK);
+
+    char data[DATA_BUFFER_SIZE];
+    string graphId = Utils::read_str_trim_wrapper(connFd, data, INSTANCE_DATA_LENGTH);
+    instance_logger.info("Received Graph ID: " + graphId);
+    if (!Utils::send_str_wrapper(connFd, JasmineGraphInstanceProtocol::OK)) {
+        *loop_exit_p = true;
+        return;
+    }
+
+    string partitionId = Utils::read_str_trim_wrapper(connFd, data, INSTANCE_DATA_LENGTH);
+    instance_logger.info("Received Partition ID: " + partitionId);
+    if (!Utils::send_str_wrapper(connFd, JasmineGraphInstanceProtocol::OK)) {
+        *loop_exit_p = true;
+        return;
+    }
+
+    // <job id>|<own bucket>|<host:dataPort>,<host:dataPort>,... which grows with the workers, so it comes in chunks
+    string bucketList;
+    if (!Utils::readChunkedString(connFd, data, INSTANCE_DATA_LENGTH, bucketList)) {
+        Utils::send_str_wrapper(connFd, JasmineGraphInstanceProtocol::ERROR);
+        *loop_exit_p = true;
+        return;
+    }
+    instance_logger.info("Received Buckets: " + bucketList);
+    std::vector<std::string> bucketParts = Utils::split(bucketList, '|');
+    std::vector<std::string> buckets;
+    int ownBucket = -1;
+    if (bucketParts.size() == 3 && Utils::is_number(bucketParts[0])) {
+        buckets = Utils::split(bucketParts[2], ',');
+        parseBucketNumber(bucketParts[1], ownBucket);
+    }
+    bool valid = ownBucket >= 0 && (size_t)ownBucket < buckets.size();
+    for (auto it = buckets.begin(); valid && it != buckets.end(); it++) {
+        std::vector<std::string> hostDataPort = Utils::split(*it, ':');
+        int dataPort;
+        valid = hostDataPort.size() == 2 && !hostDataPort[0].empty() &&
+                parseBucketNumber(hostDataPort[1], dataPort) && dataPort > 0 && dataPort <= 65535;
+    }
+    if (!valid) {
+        instance_logger.error("Invalid bucket list: " + bucketList);
+        if (!Utils::send_str_wrapper(connFd, JasmineGraphInstanceProtocol::ERROR)) {
+            *loop_exit_p = true;
+        }
+        return;
+    }
+
+    bool shuffled = shuffleCentralStoreAdjacency(graphId, bucketParts[0], partitionId, buckets, ownBucket);
+    if (!Utils::send_str_wrapper(connFd,
+                                 shuffled ? JasmineGraphInstanceProtocol::OK : JasmineGraphInstanceProtocol::ERROR)) {
+        *loop_exit_p = true;
+    }
+}
+
+static void count_shuffled_centralstore_triangles_command(int connFd, bool *loop_exit_p) {
+    if (!Utils::send_str_wrapper(connFd, JasmineGraphInstanceProtocol::OK)) {
+        *loop_exit_p = true;
+        return;
+    }
+    instance_logger.info("Sent : " + JasmineGraphInstanceProtocol::OK);
+
+    char data[DATA_BUFFER_SIZE];
+    string graphId = Utils::read_str_trim_wrapper(connFd, data, INSTANCE_DATA_LENGTH);
+    instance_logger.info("Received Graph ID: " + graphId);
+    if (!Utils::send_str_wrapper(connFd, JasmineGraphInstanceProtocol::OK)) {
+        *loop_exit_p = true;
+        return;
+    }
+
+    // <job id>|<bucket>|<bucket count>
+    string bucketInfo = Utils::read_str_trim_wrapper(connFd, data, INSTANCE_DATA_LENGTH);
+    instance_logger.info("Received Bucket: " + bucketInfo);
+    if (!Utils::send_str_wrapper(connFd, JasmineGraphInstanceProtocol::OK)) {
+        *loop_exit_p = true;
+        return;
+    }
+
+    // Grows with the partitions of the graph, so it comes in chunks
+    string partitionIdList;
+    if (!Utils::readChunkedString(connFd, data, INSTANCE_DATA_LENGTH, partitionIdList)) {
+        Utils::send_str_wrapper(connFd, "-1");
+        *loop_exit_p = true;
+        return;
+    }
+    instance_logger.info("Received Partition ID List : " + partitionIdList);
+
+    std::vector<std::string> bucketParts = Utils::split(bucketInfo, '|');
+    std::vector<std::string> partitionIds = Utils::split(partitionIdList, ',');
+    int bucket;
+    int bucketCount;
+    bool valid = bucketParts.size() == 3 && Utils::is_number(bucketParts[0]) &&
+                 parseBucketNumber(bucketParts[1], bucket) && parseBucketNumber(bucketParts[2], bucketCount) &&
+                 bucket < bucketCount && !partitionIds.empty();
+    for (auto it = partitionIds.begin(); valid && it != partitionIds.end(); it++) {
+        valid = Utils::is_number(*it);
+    }
+    long triangleCount = -1;
+    if (valid) {
+        triangleCount = countShuffledCentralStoreTriangles(graphId, bucketParts[0], bucket, bucketCount, partitionIds);
+    } else {
+        instance_logger.error("Invalid bucket " + bucketInfo + " or partition list " + partitionIdList);
+    }
+    if (!Utils::send_str_wrapper(connFd, std::to_string(triangleCount))) {
+        *loop_exit_p = true;
+    }
+}
+
+static void worker_heartbeat_command(int connFd, bool *loop_exit_p) {
+    const StatisticsSampler::Snapshot &snapshot = StatisticsSampler::latest();
+    // <running tasks>|<high priority tasks>|<cpu usage>|<used memory KB>|<total memory KB>
+    string heartbeat = to_string(workerRunningTaskCount.load()) + "|" + to_string(workerHighPriorityTaskCount.load()) +
+                       "|" + to_string(snapshot.cpuUsage) + "|" + to_string(snapshot.totalMemoryUsage) + "|" +
+                       to_string(snapshot.totalMemory);
+    if (!Utils::send_str_wrapper(connFd, heartbeat)) {
+        *loop_exit_p = true;
+    }
+}
+
 static void initiate_files_command(int connFd, bool *loop_exit_p) {
     if (!Utils::send_str_wrapper(connFd, JasmineGraphInstanceProtocol::OK)) {
         *loop_exit_p = true;
@@ -3719,7 +3983,7 @@ static void initiate_predict_command(int connFd, instanceservicesessionargs *ses
 
     string fullFilePath =
         Utils::getJasmineGraphProperty("org.jasminegraph.server.instance.datafolder") + "/" + fileName;
-    int fileSize = stoi(size);
+    long fileSize = stol(size);
     string line;
     while (!Utils::fileExists(fullFilePath) || Utils::getFileSize(fullFilePath) < fileSize) {
         line = Utils::read_str_wrapper(connFd, data, INSTANCE_DATA_LENGTH, false);
@@ -3801,7 +4065,7 @@ static void initiate_model_collection_command(int connFd, bool *loop_exit_p) {
     fileName = fileName + ".tar.gz";
     filePath = filePath + ".tar.gz";
 
-    int fileSize = Utils::getFileSize(filePath);
+    long fileSize = Utils::getFileSize(filePath);
     std::string fileLength = to_string(fileSize);
     // send file name
     string line = Utils::read_str_wrapper(connFd, data, INSTANCE_DATA_LENGTH, false);
@@ -4142,19 +4406,34 @@ static void push_partition_command(int connFd, bool *loop_exit_p) {
 string JasmineGraphInstanceService::aggregateStreamingCentralStoreTriangles(
     std::string graphId, std::string partitionId, std::string partitionIdString, std::string centralCountString,
     int threadPriority, std::map<std::string, JasmineGraphIncrementalLocalStore *> &incrementalLocalStores,
-    std::string mode) {
+    std::string mode, std::string window) {
     instance_logger.info("###INSTANCE### Started Aggregating Central Store Triangles");
     std::vector<JasmineGraphIncrementalLocalStore *> incrementalLocalStoreInstances;
     std::vector<std::string> centralCountList = Utils::split(centralCountString, ',');
     std::vector<std::string> partitionIdList = Utils::split(partitionIdString, ',');
     partitionIdList.push_back(partitionId);
 
+    // The adjacency of the central relations is kept by the streaming stores. Partitions that this worker does not
+    // ingest are read through read-only stores, which leave their DBs to the stores that ingest them.
+    for (const std::string &aggregatePartitionId : partitionIdList) {
+        std::string graphIdentifier = graphId + "_" + aggregatePartitionId;
+        if (incrementalLocalStores.find(graphIdentifier) == incrementalLocalStores.end()) {
+            incrementalLocalStoreInstances.push_back(
+                JasmineGraphInstanceService::loadReadOnlyStreamingStore(graphId, aggregatePartitionId));
+        } else {
+            incrementalLocalStoreInstances.push_back(incrementalLocalStores[graphIdentifier]);
+        }
+    }
+
     std::string triangles;
     if (mode == "0") {
-        triangles = StreamingTriangles::countCentralStoreStreamingTriangles(graphId, partitionIdList);
+        triangles = StreamingTriangles::countCentralStoreStreamingTriangles(incrementalLocalStoreInstances);
+    } else if (mode == "2") {
+        triangles =
+            StreamingTriangles::countWindowCentralTriangles(incrementalLocalStoreInstances, partitionIdList, window);
     } else {
         triangles = StreamingTriangles::countDynamicCentralTriangles(
-                graphId, partitionIdList, centralCountList);
+                incrementalLocalStoreInstances, partitionIdList, centralCountList);
     }
 
     instance_logger.info("###INSTANCE### Central Store Aggregation : Completed");
@@ -69,13 +69,11 @@ map<long, long> calculateLocalInDegreeDist(
     string graphID, string partitionID, std::map<std::string, JasmineGraphHashMapLocalStore> &graphDBMapLocalStores,
     std::map<std::string, JasmineGraphHashMapCentralStore> &graphDBMapCentralStores);
 
-map<long, map<long, unordered_set<long>>> calculateLocalEgoNet(string graphID, string partitionID, int serverPort,
-                                                               JasmineGraphHashMapLocalStore localDB,
-                                                               JasmineGraphHashMapCentralStore centralDB,
-                                                               std::vector<string> &workerSockets);
+long writeLocalEgoNets(string graphID, string partitionID, JasmineGraphHashMapLocalStore &localDB,
+                       JasmineGraphHashMapCentralStore &centralDB, std::vector<string> &workerSockets);
 
-void calculateEgoNet(string graphID, string partitionID, int serverPort, JasmineGraphHashMapLocalStore localDB,
-                     JasmineGraphHashMapCentralStore centralDB, string workerList);
+void calculateEgoNet(string graphID, string partitionID, int serverPort, JasmineGraphHashMapLocalStore &localDB,
+                     JasmineGraphHashMapCentralStore &centralDB, string workerList);
 
 map<long, double> calculateLocalPageRank(string graphID, double alpha, string partitionID, int serverPort,
                                          int top_k_page_rank_value, string graphVertexCount,
@@ -123,6 +121,9 @@ class JasmineGraphInstanceService {
     static JasmineGraphIncrementalLocalStore *loadStreamingStore(
         std::string graphId, std::string partitionId,
         std::map<std::string, JasmineGraphIncrementalLocalStore *> &graphDBMapStreamingStores, std::string openMode);
+    // A read-only store of a partition that this worker does not ingest, with the relations added since it was last
+    // loaded
+    static JasmineGraphIncrementalLocalStore *loadReadOnlyStreamingStore(std::string graphId, std::string partitionId);
     static void loadInstanceCentralStore(
         std::string graphId, std::string partitionId,
         std::map<std::string, JasmineGraphHashMapCentralStore> &graphDBMapCentralStores);
@@ -178,7 +179,7 @@ class JasmineGraphInstanceService {
     static string aggregateStreamingCentralStoreTriangles(
         std::string graphId, std::string partitionId, std::string partitionIdString, std::string centralCountString,
         int threadPriority, std::map<std::string, JasmineGraphIncrementalLocalStore *> &incrementalLocalStores,
-        std::string mode);
+        std::string mode, std::string window = "");
 
     static int partitionCounter;
 
@@ -17,16 +17,22 @@ limitations under the License.
 #include <stdlib.h>
 #include <sys/stat.h>
 
+#include <future>
 #include <iostream>
 #include <map>
+#include <set>
 #include <string>
 
 #include "../../globals.h"
 #include "../k8s/K8sWorkerController.h"
 #include "../ml/trainer/JasmineGraphTrainingSchedular.h"
+#include "../performance/metrics/MetricsRegistry.h"
 #include "../scale/scaler.h"
+#include "../util/DegreeDistribution.h"
+#include "ClusterTopology.h"
 #include "JasmineGraphInstance.h"
 #include "JasmineGraphInstanceProtocol.h"
+#include "ReplicaManager.h"
 
 Logger server_logger;
 
@@ -47,7 +53,6 @@ static bool batchUploadCentralAttributeFile(std::string host, int port, int data
 static bool batchUploadCompositeCentralstoreFile(std::string host, int port, int dataPort, int graphID,
                                                  std::string filePath, std::string masterIP);
 static bool removeFragmentThroughService(string host, int port, string graphID, string masterIP);
-static bool removePartitionThroughService(string host, int port, string graphID, string partitionID, string masterIP);
 static bool initiateCommon(std::string host, int port, std::string trainingArgs, int iteration, std::string masterIP,
                            std::string initType);
 static bool initiateTrain(std::string host, int port, std::string trainingArgs, int iteration, std::string masterIP);
@@ -58,7 +63,7 @@ static bool initiateAggregator(std::string host, int port, std::string trainingA
                                std::string masterIP);
 static bool initiateOrgServer(std::string host, int port, std::string trainingArgs, int iteration,
                               std::string masterIP);
-static void degreeDistributionCommon(std::string graphID, std::string command);
+static std::string degreeDistributionCommon(std::string graphID, std::string command, int topN);
 static int getPortByHost(const std::string &host);
 static int getDataPortByHost(const std::string &host);
 static size_t getWorkerCount();
@@ -68,6 +73,7 @@ static unordered_map<string, pair<int, int>> hostPortMap;
 std::map<int, int> aggregateWeightMap;
 
 static int graphUploadWorkerTracker = 0;
+static const int DEFAULT_UPLOAD_CONCURRENCY_PER_WORKER = 2;
 
 void *runfrontend(void *dummyPt) {
     JasmineGraphServer *refToServer = (JasmineGraphServer *)dummyPt;
@@ -130,6 +136,7 @@ int JasmineGraphServer::run(std::string masterIp, int numberofWorkers, std::stri
     this->enableNmon = enableNmon;
     masterPortVector.push_back(Conts::JASMINEGRAPH_FRONTEND_PORT);
     updateOperationalGraphList();
+    startBackend();
 
     if (jasminegraph_profile == PROFILE_K8S) {
         // Create K8s worker controller
@@ -140,10 +147,17 @@ int JasmineGraphServer::run(std::string masterIp, int numberofWorkers, std::stri
         start_workers();
         addInstanceDetailsToPerformanceDB(masterHost, masterPortVector, "true");
     }
+    ClusterTopology::reload(this->sqlite);
+    ReplicaManager::start(this->sqlite, this->masterHost);
 
     init();
     std::thread *myThreads = new std::thread[1];
     myThreads[0] = std::thread(StatisticCollector::logLoadAverage, "Load Average");
+    StatisticsSampler::start(atoi(Utils::getJasmineGraphProperty("org.jasminegraph.collector.sampleinterval").c_str()));
+    int metricsPort = atoi(Utils::getJasmineGraphProperty("org.jasminegraph.server.metrics.port").c_str());
+    if (metricsPort > 0) {
+        MetricsRegistry::startEndpoint(metricsPort);
+    }
     sleep(1);
     waitForAcknowledgement(numberofWorkers);
     resolveOperationalGraphs();
@@ -153,9 +167,13 @@ int JasmineGraphServer::run(std::string masterIp, int numberofWorkers, std::stri
 
 void JasmineGraphServer::init() {
     pthread_t frontendthread;
-    pthread_t backendthread;
     pthread_create(&frontendthread, NULL, runfrontend, this);
     pthread_detach(frontendthread);
+}
+
+// The backend is started before the workers so that they can report to the master as soon as they are up
+void JasmineGraphServer::startBackend() {
+    pthread_t backendthread;
     pthread_create(&backendthread, NULL, runbackend, this);
     pthread_detach(backendthread);
 }
@@ -517,7 +535,9 @@ bool JasmineGraphServer::spawnNewWorker(string host, string port, string dataPor
         to_string(maxWorkerId) + "','" + idHost + "','" + host + "','" + host + "','','false','" + port + "','" +
         dataPort + "')";
 
-    refToSqlite->runInsert(workerInsertSqlStatement);
+    if (refToSqlite->runInsert(workerInsertSqlStatement) != -1) {
+        ClusterTopology::addWorker({maxWorkerId, host, host, "", atoi(port.c_str()), atoi(dataPort.c_str())});
+    }
     refToSqlite->finalize();
     delete refToSqlite;
 
@@ -744,6 +764,7 @@ void JasmineGraphServer::deleteNonOperationalGraphFragment(int graphID) {
 
 void JasmineGraphServer::shutdown_workers() {
     server_logger.info("Shutting down workers");
+    ReplicaManager::stop();
     auto *server = JasmineGraphServer::getInstance();
 
     if (jasminegraph_profile == PROFILE_K8S) {
@@ -870,6 +891,50 @@ static std::vector<JasmineGraphServer::worker> getWorkers(size_t npart) {
     return workerList;
 }
 
+typedef bool (*UploadFunction)(std::string host, int port, int dataPort, int graphID, std::string filePath,
+                               std::string masterIP);
+
+struct UploadTask {
+    UploadFunction upload;
+    std::string filePath;
+};
+
+/*
+ * Uploads the files queued for a single worker. At most `concurrency` uploads run against the worker at a time so
+ * that a worker receiving many files is not flooded with parallel transfers.
+ * */
+static bool uploadFilesToWorker(JasmineGraphServer::worker worker, std::vector<UploadTask> tasks, int graphID,
+                                std::string masterHost, int concurrency) {
+    std::mutex taskMutex;
+    size_t nextTask = 0;
+    std::atomic<bool> success(true);
+    auto uploader = [&]() {
+        while (true) {
+            size_t taskIndex;
+            {
+                std::lock_guard<std::mutex> lock(taskMutex);
+                if (nextTask >= tasks.size()) return;
+                taskIndex = nextTask++;
+            }
+            const UploadTask &task = tasks[taskIndex];
+            if (!task.upload(worker.hostname, worker.port, worker.dataPort, graphID, task.filePath, masterHost)) {
+                server_logger.error("Uploading " + task.filePath + " to " + worker.hostname + ":" +
+                                    to_string(worker.port) + " failed");
+                success = false;
+            }
+        }
+    };
+    int threadCount = std::min((size_t)concurrency, tasks.size());
+    std::vector<std::thread> uploaders;
+    for (int i = 0; i < threadCount; i++) {
+        uploaders.push_back(std::thread(uploader));
+    }
+    for (auto &uploaderThread : uploaders) {
+        uploaderThread.join();
+    }
+    return success;
+}
+
 void JasmineGraphServer::uploadGraphLocally(int graphID, const string graphType,
                                             vector<std::map<int, string>> fullFileList, std::string masterIP) {
     server_logger.info("Uploading the graph locally..");
@@ -882,60 +947,58 @@ void JasmineGraphServer::uploadGraphLocally(int graphID, const string graphType,
     if (masterHost.empty()) {
         masterHost = Utils::getJasmineGraphProperty("org.jasminegraph.server.host");
     }
-    int total_threads = partitionFileMap.size() + centralStoreFileMap.size() + centralStoreDuplFileMap.size() +
-                        compositeCentralStoreFileMap.size();
     if (graphType == Conts::GRAPH_WITH_ATTRIBUTES) {
         attributeFileMap = fullFileList[3];
-        total_threads += attributeFileMap.size();
         centralStoreAttributeFileMap = fullFileList[4];
-        total_threads += centralStoreAttributeFileMap.size();
     }
-    int count = 0;
-    int file_count = 0;
-    std::thread *workerThreads = new std::thread[total_threads];
-    while (count < total_threads) {
-        const auto &workerList = getWorkers(partitionFileMap.size());
-        while (true) {
-            if (count >= total_threads) {
-                break;
-            }
-            worker worker = workerList[graphUploadWorkerTracker];
-            std::string partitionFileName = partitionFileMap[file_count];
-            workerThreads[count++] = std::thread(batchUploadFile, worker.hostname, worker.port, worker.dataPort,
-                                                 graphID, partitionFileName, masterHost);
-            copyCentralStoreToAggregateLocation(centralStoreFileMap[file_count]);
-            workerThreads[count++] = std::thread(batchUploadCentralStore, worker.hostname, worker.port, worker.dataPort,
-                                                 graphID, centralStoreFileMap[file_count], masterHost);
-
-            if (compositeCentralStoreFileMap.find(file_count) != compositeCentralStoreFileMap.end()) {
-                copyCentralStoreToAggregateLocation(compositeCentralStoreFileMap[file_count]);
-                workerThreads[count++] =
-                    std::thread(batchUploadCompositeCentralstoreFile, worker.hostname, worker.port, worker.dataPort,
-                                graphID, compositeCentralStoreFileMap[file_count], masterHost);
-            }
-
-            workerThreads[count++] = std::thread(batchUploadCentralStore, worker.hostname, worker.port, worker.dataPort,
-                                                 graphID, centralStoreDuplFileMap[file_count], masterHost);
-            if (graphType == Conts::GRAPH_WITH_ATTRIBUTES) {
-                workerThreads[count++] =
-                    std::thread(batchUploadAttributeFile, worker.hostname, worker.port, worker.dataPort, graphID,
-                                attributeFileMap[file_count], masterHost);
-                workerThreads[count++] =
-                    std::thread(batchUploadCentralAttributeFile, worker.hostname, worker.port, worker.dataPort, graphID,
-                                centralStoreAttributeFileMap[file_count], masterHost);
-            }
-            assignPartitionToWorker(partitionFileName, graphID, worker.hostname, worker.port);
-            file_count++;
+    int concurrency = atoi(Utils::getJasmineGraphProperty("org.jasminegraph.server.upload.concurrency").c_str());
+    if (concurrency <= 0) {
+        concurrency = DEFAULT_UPLOAD_CONCURRENCY_PER_WORKER;
+    }
+
+    // Group the files by the worker that receives them
+    std::map<std::string, JasmineGraphServer::worker> uploadWorkers;
+    std::map<std::string, std::vector<UploadTask>> uploadTasks;
+    const auto &workerList = getWorkers(partitionFileMap.size());
+    for (int file_count = 0; file_count < partitionFileMap.size(); file_count++) {
+        worker worker = workerList[graphUploadWorkerTracker];
+        std::string workerKey = worker.hostname + ":" + to_string(worker.port);
+        uploadWorkers[workerKey] = worker;
+        std::vector<UploadTask> &tasks = uploadTasks[workerKey];
+
+        std::string partitionFileName = partitionFileMap[file_count];
+        tasks.push_back({batchUploadFile, partitionFileName});
+        copyCentralStoreToAggregateLocation(centralStoreFileMap[file_count]);
+        tasks.push_back({batchUploadCentralStore, centralStoreFileMap[file_count]});
+
+        if (compositeCentralStoreFileMap.find(file_count) != compositeCentralStoreFileMap.end()) {
+            copyCentralStoreToAggregateLocation(compositeCentralStoreFileMap[file_count]);
+            tasks.push_back({batchUploadCompositeCentralstoreFile, compositeCentralStoreFileMap[file_count]});
+        }
 
-            graphUploadWorkerTracker++;
-            graphUploadWorkerTracker %= workerList.size();
+        tasks.push_back({batchUploadCentralStore, centralStoreDuplFileMap[file_count]});
+        if (graphType == Conts::GRAPH_WITH_ATTRIBUTES) {
+            tasks.push_back({batchUploadAttributeFile, attributeFileMap[file_count]});
+            tasks.push_back({batchUploadCentralAttributeFile, centralStoreAttributeFileMap[file_count]});
         }
+        assignPartitionToWorker(partitionFileName, graphID, worker.hostname, worker.port);
+
+        graphUploadWorkerTracker++;
+        graphUploadWorkerTracker %= workerList.size();
     }
 
-    server_logger.info("Total number of threads to join : " + to_string(count));
-    for (int threadCount = 0; threadCount < count; threadCount++) {
-        workerThreads[threadCount].join();
-        server_logger.info("Thread " + to_string(threadCount) + " joined");
+    // Workers receive their files in parallel with each other
+    std::vector<std::future<bool>> workerUploads;
+    for (auto it = uploadTasks.begin(); it != uploadTasks.end(); it++) {
+        workerUploads.push_back(std::async(std::launch::async, uploadFilesToWorker, uploadWorkers[it->first],
+                                           it->second, graphID, masterHost, concurrency));
+    }
+    bool uploadSucceeded = true;
+    for (auto &workerUpload : workerUploads) {
+        uploadSucceeded &= workerUpload.get();
+    }
+    if (!uploadSucceeded) {
+        server_logger.error("Some files of graph " + to_string(graphID) + " could not be uploaded");
     }
 
     std::time_t time = chrono::system_clock::to_time_t(chrono::system_clock::now());
@@ -944,7 +1007,6 @@ void JasmineGraphServer::uploadGraphLocally(int graphID, const string graphType,
     // The following function updates the 'worker_has_partition' table and 'graph' table only
     updateMetaDB(graphID, uploadEndTime);
     server_logger.info("Upload Graph Locally done");
-    delete[] workerThreads;
 }
 
 static void assignPartitionToWorker(std::string fileName, int graphId, std::string workerHost, int workerPort) {
@@ -958,19 +1020,23 @@ static void assignPartitionToWorker(std::string fileName, int graphId, std::stri
         workerHost = Utils::split(workerHost, '@')[1];
     }
 
-    std::string workerSearchQuery = "SELECT idworker FROM worker WHERE ip='" + workerHost + "' AND server_port='" +
-                                    std::to_string(workerPort) + "'";
-
-    std::vector<vector<pair<string, string>>> results = refToSqlite->runSelect(workerSearchQuery);
+    std::vector<vector<pair<string, string>>> results = refToSqlite->runSelect(
+        "SELECT idworker FROM worker WHERE ip = ? AND server_port = ?", {workerHost, std::to_string(workerPort)});
+    if (results.empty()) {
+        server_logger.error("Worker " + workerHost + ":" + std::to_string(workerPort) + " is not in the metadb");
+        refToSqlite->finalize();
+        delete refToSqlite;
+        return;
+    }
 
     std::string workerID = results[0][0].second;
 
-    std::string partitionToWorkerQuery =
-        "INSERT INTO worker_has_partition (partition_idpartition, partition_graph_idgraph, worker_idworker) VALUES "
-        "('" +
-        partitionID + "','" + std::to_string(graphId) + "','" + workerID + "')";
-
-    refToSqlite->runInsert(partitionToWorkerQuery);
+    if (refToSqlite->runInsert(
+            "INSERT INTO worker_has_partition (partition_idpartition, partition_graph_idgraph, worker_idworker) "
+            "VALUES (?, ?, ?)",
+            {partitionID, std::to_string(graphId), workerID}) != -1) {
+        ClusterTopology::addReplica(graphId, atoi(partitionID.c_str()), atoi(workerID.c_str()));
+    }
     refToSqlite->finalize();
     delete refToSqlite;
 }
@@ -1084,7 +1150,6 @@ static void createLogFilePath(const std::string &workerHost, const std::string &
 void JasmineGraphServer::addHostsToMetaDB(std::string host, std::vector<int> portVector,
                                           std::vector<int> dataPortVector) {
     string name = host;
-    string sqlStatement = "";
     string ip_address = "";
     string user = "";
     if (host.find('@') != std::string::npos) {
@@ -1095,28 +1160,44 @@ void JasmineGraphServer::addHostsToMetaDB(std::string host, std::vector<int> por
         ip_address = host;
     }
 
-    for (int i = 0; i < portVector.size(); i++) {
-        int workerPort = portVector.at(i);
-        int workerDataPort = dataPortVector.at(i);
+    // Look up the workers already registered on the host once instead of once per port
+    std::set<string> registeredPorts;
+    this->sqlite->forEachRow("SELECT server_port FROM worker WHERE name LIKE ? AND ip LIKE ?;", {name, ip_address},
+                             [&registeredPorts](const DBRow &row) { registeredPorts.insert(row.getString(0)); });
 
-        if (!Utils::hostExists(name, ip_address, std::to_string(workerPort), this->sqlite)) {
-            string hostID = Utils::getHostID(name, this->sqlite);
-            sqlStatement =
-                ("INSERT INTO worker (host_idhost,name,ip,user,is_public,server_port,server_data_port) VALUES (\"" +
-                 hostID + "\", \"" + name + "\", \"" + ip_address + "\",\"" + user + "\", \"\",\"" +
-                 std::to_string(workerPort) + "\", \"" + std::to_string(workerDataPort) + "\")");
-            this->sqlite->runInsert(sqlStatement);
+    std::vector<std::vector<string>> newWorkers;
+    string hostID;
+    for (int i = 0; i < portVector.size(); i++) {
+        string workerPort = std::to_string(portVector.at(i));
+        if (registeredPorts.find(workerPort) != registeredPorts.end()) {
+            continue;
         }
+        if (hostID.empty()) {
+            std::vector<vector<pair<string, string>>> v =
+                this->sqlite->runSelect("SELECT idhost FROM host WHERE name LIKE ?;", {name});
+            if (v.empty()) {
+                server_logger.error("Host " + name + " is not in the metadb");
+                return;
+            }
+            hostID = v[0][0].second;
+        }
+        newWorkers.push_back({hostID, name, ip_address, user, "", workerPort, std::to_string(dataPortVector.at(i))});
+    }
+
+    if (!this->sqlite->runBatch(
+            "INSERT INTO worker (host_idhost,name,ip,user,is_public,server_port,server_data_port) "
+            "VALUES (?, ?, ?, ?, ?, ?, ?)",
+            newWorkers)) {
+        server_logger.error("Adding the workers of " + name + " to the metadb failed");
     }
 }
 
 static void updateMetaDB(int graphID, string uploadEndTime) {
     std::unique_ptr<SQLiteDBInterface> sqliteDBInterface(new SQLiteDBInterface());
     sqliteDBInterface->init();
-    string sqlStatement = "UPDATE graph SET upload_end_time = '" + uploadEndTime +
-                          "' ,graph_status_idgraph_status = '" + to_string(Conts::GRAPH_STATUS::OPERATIONAL) +
-                          "' WHERE idgraph = '" + to_string(graphID) + "'";
-    sqliteDBInterface->runUpdate(sqlStatement);
+    sqliteDBInterface->runUpdate(
+        "UPDATE graph SET upload_end_time = ?, graph_status_idgraph_status = ? WHERE idgraph = ?",
+        {uploadEndTime, to_string(Conts::GRAPH_STATUS::OPERATIONAL), to_string(graphID)});
 }
 
 void JasmineGraphServer::removeGraph(vector<pair<string, string>> hostHasPartition, string graphID,
@@ -1201,7 +1282,8 @@ static bool removeFragmentThroughService(string host, int port, string graphID,
     return true;
 }
 
-static bool removePartitionThroughService(string host, int port, string graphID, string partitionID, string masterIP) {
+bool JasmineGraphServer::removePartitionThroughService(string host, int port, string graphID, string partitionID,
+                                                       string masterIP) {
     server_logger.info("Host:" + host + " Port:" + to_string(port));
     int sockfd;
     char data[FED_DATA_LENGTH + 1];
@@ -1305,28 +1387,27 @@ void JasmineGraphServer::updateOperationalGraphList() {
     this->sqlite->runUpdate(sqlStatement2);
 }
 
-std::map<string, JasmineGraphServer::workerPartitions> JasmineGraphServer::getGraphPartitionedHosts(string graphID) {
+std::map<string, JasmineGraphServer::workerPartitions> JasmineGraphServer::getGraphPartitionedHosts(string graphID,
+                                                                                                  ReplicaLease *lease) {
     vector<pair<string, string>> hostHasPartition;
-    auto *refToSqlite = new SQLiteDBInterface();
-    refToSqlite->init();
-    vector<vector<pair<string, string>>> hostPartitionResults = refToSqlite->runSelect(
-        "SELECT name, partition_idpartition FROM worker_has_partition INNER JOIN worker ON "
-        "worker_idworker = idworker WHERE partition_graph_idgraph = '" +
-        graphID + "'");
-    refToSqlite->finalize();
-    delete refToSqlite;
-    for (auto i = hostPartitionResults.begin(); i != hostPartitionResults.end(); ++i) {
-        int count = 0;
-        string hostname;
-        string partitionID;
-        for (std::vector<pair<string, string>>::iterator j = (i->begin()); j != i->end(); ++j) {
-            if (count == 0) {
-                hostname = j->second;
-            } else {
-                partitionID = j->second;
-                hostHasPartition.push_back(pair<string, string>(hostname, partitionID));
-            }
-            count++;
+    std::shared_ptr<const ClusterTopology::Snapshot> topology = ClusterTopology::get();
+    if (topology->version == 0) {
+        SQLiteDBInterface refToSqlite;
+        refToSqlite.init();
+        topology = ClusterTopology::get(&refToSqlite);
+    }
+    // Every partition goes to one of its replicas, the one on the worker with the fewest running tasks
+    std::map<int, int> loads;
+    schedulerMutex.lock();
+    for (auto it = used_workers.begin(); it != used_workers.end(); it++) {
+        loads[atoi(it->first.c_str())] = it->second;
+    }
+    schedulerMutex.unlock();
+    const auto &partitionsByWorker = ReplicaManager::route(*topology, atoi(graphID.c_str()), loads, lease);
+    for (auto i = partitionsByWorker.begin(); i != partitionsByWorker.end(); ++i) {
+        const ClusterTopology::Worker *worker = topology->getWorker(i->first);
+        for (auto j = i->second.begin(); j != i->second.end(); ++j) {
+            hostHasPartition.push_back(pair<string, string>(worker->name, to_string(*j)));
         }
     }
 
@@ -1454,9 +1535,14 @@ void JasmineGraphServer::addInstanceDetailsToPerformanceDB(std::string host, std
     this->performanceSqlite->runInsert(insertPlaceQuery);
 }
 
-static void degreeDistributionCommon(std::string graphID, std::string command) {
+/*
+ * Asks every partition to compute its degree distribution and merges the sorted binary runs streamed back by the
+ * workers. The merge holds one entry per partition at a time, so only the summary is built up on the master.
+ * */
+static std::string degreeDistributionCommon(std::string graphID, std::string command, int topN) {
+    ReplicaLease replicaLease;
     std::map<std::string, JasmineGraphServer::workerPartitions> graphPartitionedHosts =
-        JasmineGraphServer::getGraphPartitionedHosts(graphID);
+        JasmineGraphServer::getGraphPartitionedHosts(graphID, &replicaLease);
     std::string workerList;
     std::map<std::string, JasmineGraphServer::workerPartitions>::iterator workerit;
     for (workerit = graphPartitionedHosts.begin(); workerit != graphPartitionedHosts.end(); workerit++) {
@@ -1471,26 +1557,24 @@ static void degreeDistributionCommon(std::string graphID, std::string command) {
         }
     }
 
+    DegreeDistributionSummary summary(topN);
+    if (workerList.empty()) {
+        server_logger.error("No partitions found for graph " + graphID);
+        return summary.toJson();
+    }
     workerList.pop_back();
 
-    int sockfd;
     char data[FED_DATA_LENGTH + 1];
-    bool loop = false;
-    socklen_t len;
     struct sockaddr_in serv_addr;
     struct hostent *server;
 
+    // Start the calculation on every partition before collecting any result so that the workers run in parallel
+    std::vector<int> partitionSockets;
     for (workerit = graphPartitionedHosts.begin(); workerit != graphPartitionedHosts.end(); workerit++) {
         JasmineGraphServer::workerPartitions workerPartition = workerit->second;
         string host = workerit->first;
         int port = workerPartition.port;
 
-        sockfd = socket(AF_INET, SOCK_STREAM, 0);
-        if (sockfd < 0) {
-            server_logger.error("Cannot create socket");
-            continue;
-        }
-
         server = gethostbyname(host.c_str());
         if (server == NULL) {
             server_logger.error("ERROR, no host named " + host);
@@ -1500,11 +1584,17 @@ static void degreeDistributionCommon(std::string graphID, std::string command) {
         for (std::vector<std::string>::iterator partitionit = workerPartition.partitionID.begin();
              partitionit != workerPartition.partitionID.end(); partitionit++) {
             std::string partition = *partitionit;
+            int sockfd = socket(AF_INET, SOCK_STREAM, 0);
+            if (sockfd < 0) {
+                server_logger.error("Cannot create socket");
+                continue;
+            }
             bzero((char *)&serv_addr, sizeof(serv_addr));
             serv_addr.sin_family = AF_INET;
             bcopy((char *)server->h_addr, (char *)&serv_addr.sin_addr.s_addr, server->h_length);
             serv_addr.sin_port = htons(port);
             if (Utils::connect_wrapper(sockfd, (struct sockaddr *)&serv_addr, sizeof(serv_addr)) < 0) {
+                close(sockfd);
                 continue;
             }
 
@@ -1534,25 +1624,53 @@ static void degreeDistributionCommon(std::string graphID, std::string command) {
                 close(sockfd);
                 continue;
             }
-            Utils::send_str_wrapper(sockfd, JasmineGraphInstanceProtocol::CLOSE);
-            close(sockfd);
+            partitionSockets.push_back(sockfd);
+        }
+    }
+
+    std::vector<DegreeDistributionReader *> runs;
+    for (int sockfd : partitionSockets) {
+        string response = Utils::read_str_trim_wrapper(sockfd, data, INSTANCE_DATA_LENGTH);
+        char *end;
+        long runSize = strtol(response.c_str(), &end, 10);
+        if (response.empty() || *end != '\0' || runSize < 0) {
+            server_logger.error("Degree distribution failed on a partition of graph " + graphID + ": " + response);
+            continue;
+        }
+        if (!Utils::send_str_wrapper(sockfd, JasmineGraphInstanceProtocol::OK)) {
+            continue;
         }
+        runs.push_back(new DegreeDistributionReader(sockfd, runSize));
+    }
+
+    // Out-degree runs are disjoint. In-degree runs overlap on vertices with cut edges and agree on their value.
+    if (!DegreeDistribution::merge(runs, DegreeDistribution::MAX,
+                                   [&summary](long vertex, long degree) { summary.add(vertex, degree); })) {
+        server_logger.error("Some degree distribution runs of graph " + graphID + " were incomplete");
+    }
+
+    for (auto run : runs) {
+        delete run;
     }
+    for (int sockfd : partitionSockets) {
+        close(sockfd);
+    }
+    return summary.toJson();
 }
 
-void JasmineGraphServer::inDegreeDistribution(std::string graphID) {
-    degreeDistributionCommon(graphID, JasmineGraphInstanceProtocol::IN_DEGREE_DISTRIBUTION);
+std::string JasmineGraphServer::inDegreeDistribution(std::string graphID, int topN) {
+    return degreeDistributionCommon(graphID, JasmineGraphInstanceProtocol::IN_DEGREE_DISTRIBUTION, topN);
 }
 
-void JasmineGraphServer::outDegreeDistribution(std::string graphID) {
-    degreeDistributionCommon(graphID, JasmineGraphInstanceProtocol::OUT_DEGREE_DISTRIBUTION);
+std::string JasmineGraphServer::outDegreeDistribution(std::string graphID, int topN) {
+    return degreeDistributionCommon(graphID, JasmineGraphInstanceProtocol::OUT_DEGREE_DISTRIBUTION, topN);
 }
 
 long JasmineGraphServer::getGraphVertexCount(std::string graphID) {
     auto *refToSqlite = new SQLiteDBInterface();
     refToSqlite->init();
     vector<vector<pair<string, string>>> output =
-        refToSqlite->runSelect("SELECT vertexcount FROM graph WHERE idgraph = '" + graphID + "'");
+        refToSqlite->runSelect("SELECT vertexcount FROM graph WHERE idgraph = ?", {graphID});
     refToSqlite->finalize();
     delete refToSqlite;
 
@@ -1561,8 +1679,9 @@ long JasmineGraphServer::getGraphVertexCount(std::string graphID) {
 }
 
 void JasmineGraphServer::duplicateCentralStore(std::string graphID) {
+    ReplicaLease replicaLease;
     std::map<std::string, JasmineGraphServer::workerPartitions> graphPartitionedHosts =
-        JasmineGraphServer::getGraphPartitionedHosts(graphID);
+        JasmineGraphServer::getGraphPartitionedHosts(graphID, &replicaLease);
     std::string workerList;
     std::map<std::string, JasmineGraphServer::workerPartitions>::iterator workerit;
     for (workerit = graphPartitionedHosts.begin(); workerit != graphPartitionedHosts.end(); workerit++) {
@@ -1654,8 +1773,9 @@ void JasmineGraphServer::duplicateCentralStore(std::string graphID) {
 void JasmineGraphServer::initiateFiles(std::string graphID, std::string trainingArgs) {
     int count = 0;
     map<string, map<int, int>> scheduleForAllHosts = JasmineGraphTrainingSchedular::schedulePartitionTraining(graphID);
+    ReplicaLease replicaLease;
     std::map<std::string, JasmineGraphServer::workerPartitions> graphPartitionedHosts =
-        this->getGraphPartitionedHosts(graphID);
+        this->getGraphPartitionedHosts(graphID, &replicaLease);
     int partition_count = 0;
     std::map<std::string, JasmineGraphServer::workerPartitions>::iterator mapIterator;
     for (mapIterator = graphPartitionedHosts.begin(); mapIterator != graphPartitionedHosts.end(); mapIterator++) {
@@ -1794,8 +1914,9 @@ void JasmineGraphServer::initiateOrgCommunication(std::string graphID, std::stri
 
 void JasmineGraphServer::initiateMerge(std::string graphID, std::string trainingArgs, SQLiteDBInterface *sqlite) {
     map<string, map<int, int>> scheduleForAllHosts = JasmineGraphTrainingSchedular::schedulePartitionTraining(graphID);
+    ReplicaLease replicaLease;
     std::map<std::string, JasmineGraphServer::workerPartitions> graphPartitionedHosts =
-        this->getGraphPartitionedHosts(graphID);
+        this->getGraphPartitionedHosts(graphID, &replicaLease);
     int partition_count = 0;
     std::map<std::string, JasmineGraphServer::workerPartitions>::iterator mapIterator;
     for (mapIterator = graphPartitionedHosts.begin(); mapIterator != graphPartitionedHosts.end(); mapIterator++) {
@@ -2126,8 +2247,9 @@ bool JasmineGraphServer::sendTrainCommand(std::string host, int port, std::strin
 }
 
 void JasmineGraphServer::egoNet(std::string graphID) {
+    ReplicaLease replicaLease;
     std::map<std::string, JasmineGraphServer::workerPartitions> graphPartitionedHosts =
-        JasmineGraphServer::getGraphPartitionedHosts(graphID);
+        JasmineGraphServer::getGraphPartitionedHosts(graphID, &replicaLease);
     std::string workerList;
 
     for (auto workerit = graphPartitionedHosts.begin(); workerit != graphPartitionedHosts.end(); workerit++) {
@@ -2211,3 +2333,122 @@ void JasmineGraphServer::egoNet(std::string graphID) {
         }
     }
 }
+
+// Reads exactly `length` bytes from the socket
+static bool readFully(int sockfd, char *buffer, size_t length) {
+    while (length > 0) {
+        ssize_t received = recv(sockfd, buffer, length, 0);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            return false;
+        }
+        buffer += received;
+        length -= received;
+    }
+    return true;
+}
+
+/*
+ * Queries the partitions one after another so that the sink is called from this thread only. A vertex is answered
+ * by the partition that holds its adjacency, the other partitions report nothing for it.
+ * */
+bool JasmineGraphServer::egoNet(std::string graphID, const std::vector<long> &vertices,
+                                const std::function<void(long, long, long)> &sink) {
+    ReplicaLease replicaLease;
+    std::map<std::string, JasmineGraphServer::workerPartitions> graphPartitionedHosts =
+        JasmineGraphServer::getGraphPartitionedHosts(graphID, &replicaLease);
+    // Comma separated vertex lists that fit in a protocol message
+    std::vector<std::string> vertexChunks;
+    std::string chunk;
+    for (long vertex : vertices) {
+        std::string vertexString = std::to_string(vertex);
+        if (!chunk.empty() && chunk.length() + vertexString.length() + 1 > INSTANCE_DATA_LENGTH) {
+            vertexChunks.push_back(chunk);
+            chunk.clear();
+        }
+        chunk += (chunk.empty() ? "" : ",") + vertexString;
+    }
+    if (!chunk.empty()) {
+        vertexChunks.push_back(chunk);
+    }
+
+    char data[FED_DATA_LENGTH + 1];
+    std::vector<int64_t> frame;
+    bool complete = true;
+    for (auto workerit = graphPartitionedHosts.begin(); workerit != graphPartitionedHosts.end(); workerit++) {
+        string host = workerit->first;
+        int port = workerit->second.port;
+        struct hostent *server = gethostbyname(host.c_str());
+        if (server == NULL) {
+            server_logger.error("ERROR, no host named " + host);
+            complete = false;
+            continue;
+        }
+
+        for (auto partitionit = workerit->second.partitionID.begin(); partitionit != workerit->second.partitionID.end();
+             partitionit++) {
+            int sockfd = socket(AF_INET, SOCK_STREAM, 0);
+            if (sockfd < 0) {
+                server_logger.error("Cannot create socket");
+                complete = false;
+                continue;
+            }
+            struct sockaddr_in serv_addr;
+            bzero((char *)&serv_addr, sizeof(serv_addr));
+            serv_addr.sin_family = AF_INET;
+            bcopy((char *)server->h_addr, (char *)&serv_addr.sin_addr.s_addr, server->h_length);
+            serv_addr.sin_port = htons(port);
+            if (Utils::connect_wrapper(sockfd, (struct sockaddr *)&serv_addr, sizeof(serv_addr)) < 0) {
+                close(sockfd);
+                complete = false;
+                continue;
+            }
+
+            bool sent = Utils::sendExpectResponse(sockfd, data, INSTANCE_DATA_LENGTH,
+                                                  JasmineGraphInstanceProtocol::EGONET_VERTICES,
+                                                  JasmineGraphInstanceProtocol::OK) &&
+                        Utils::sendExpectResponse(sockfd, data, INSTANCE_DATA_LENGTH, graphID,
+                                                  JasmineGraphInstanceProtocol::OK) &&
+                        Utils::sendExpectResponse(sockfd, data, INSTANCE_DATA_LENGTH, *partitionit,
+                                                  JasmineGraphInstanceProtocol::OK) &&
+                        Utils::sendExpectResponse(sockfd, data, INSTANCE_DATA_LENGTH, to_string(vertices.size()),
+                                                  JasmineGraphInstanceProtocol::OK);
+            for (auto chunkIt = vertexChunks.begin(); sent && chunkIt != vertexChunks.end(); chunkIt++) {
+                sent = Utils::sendExpectResponse(sockfd, data, INSTANCE_DATA_LENGTH, *chunkIt,
+                                                 JasmineGraphInstanceProtocol::OK);
+            }
+
+            bool received = false;
+            while (sent) {
+                string response = Utils::read_str_trim_wrapper(sockfd, data, INSTANCE_DATA_LENGTH);
+                char *end;
+                long frameSize = strtol(response.c_str(), &end, 10);
+                if (response.empty() || *end != '\0' || frameSize < 0 || frameSize % (3 * sizeof(int64_t)) != 0 ||
+                    !Utils::send_str_wrapper(sockfd, JasmineGraphInstanceProtocol::OK)) {
+                    break;
+                }
+                if (frameSize == 0) {
+                    received = true;
+                    break;
+                }
+                frame.resize(frameSize / sizeof(int64_t));
+                if (!readFully(sockfd, reinterpret_cast<char *>(frame.data()), frameSize)) {
+                    break;
+                }
+                for (size_t i = 0; i < frame.size(); i += 3) {
+                    sink(frame[i], frame[i + 1], frame[i + 2]);
+                }
+            }
+            if (!received) {
+                server_logger.error("Ego networks of graph " + graphID + " partition " + *partitionit +
+                                    " were incomplete");
+                complete = false;
+            }
+            Utils::send_str_wrapper(sockfd, JasmineGraphInstanceProtocol::CLOSE);
+            close(sockfd);
+        }
+    }
+    return complete;
+}
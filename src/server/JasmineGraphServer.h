@@ -17,10 +17,12 @@ limitations under the License.
 #include <stdio.h>
 #include <stdlib.h>
 
+#include <functional>
 #include <iostream>
 #include <map>
 #include <string>
 #include <thread>
+#include <vector>
 
 #include "../backend/JasmineGraphBackend.h"
 #include "../frontend/JasmineGraphFrontEnd.h"
@@ -30,6 +32,7 @@ limitations under the License.
 #include "../performancedb/PerformanceSQLiteDBInterface.h"
 #include "../util/Conts.h"
 #include "../util/Utils.h"
+#include "ReplicaManager.h"
 
 class K8sWorkerController;
 
@@ -65,6 +68,8 @@ class JasmineGraphServer {
 
     void init();
 
+    void startBackend();
+
     void start_workers();
 
     void waitForAcknowledgement(int numberOfWorkers);
@@ -91,6 +96,10 @@ class JasmineGraphServer {
     static void removeGraph(std::vector<std::pair<std::string, std::string>> hostHasPartition, std::string graphID,
                             std::string masterIP);
 
+    // Deletes the files of one partition of the graph from the worker
+    static bool removePartitionThroughService(std::string host, int port, std::string graphID,
+                                              std::string partitionID, std::string masterIP);
+
     void assignPartitionsToWorkers(int numberOfWorkers);
 
     static void copyCentralStoreToAggregateLocation(std::string filePath);
@@ -126,11 +135,15 @@ class JasmineGraphServer {
                              // partiton ID.
     };
 
-    static std::map<std::string, workerPartitions> getGraphPartitionedHosts(std::string graphID);
+    // Hosts to send the partition tasks of the graph to, one replica per partition. Callers that run tasks on the
+    // hosts pass a lease that they keep until the tasks finish.
+    static std::map<std::string, workerPartitions> getGraphPartitionedHosts(std::string graphID,
+                                                                            ReplicaLease *lease = nullptr);
 
-    static void inDegreeDistribution(std::string graphID);
+    // Returns a JSON summary with a degree histogram and the topN highest degree vertices
+    static std::string inDegreeDistribution(std::string graphID, int topN);
 
-    static void outDegreeDistribution(std::string graphID);
+    static std::string outDegreeDistribution(std::string graphID, int topN);
 
     static void duplicateCentralStore(std::string graphID);
 
@@ -138,6 +151,11 @@ class JasmineGraphServer {
 
     static void egoNet(std::string graphID);
 
+    // Streams the ego networks of the vertices to the sink as the workers compute them, as (ego, from, to) edges.
+    // Returns false if some partition could not be queried completely.
+    static bool egoNet(std::string graphID, const std::vector<long> &vertices,
+                       const std::function<void(long, long, long)> &sink);
+
     void initiateFiles(std::string graphID, std::string trainingArgs);
 
     static void initiateCommunication(std::string graphID, std::string trainingArgs, SQLiteDBInterface *sqlite,
@@ -0,0 +1,455 @@
+/**
+Copyright 2024 JasmineGraph Team
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#include "ReplicaManager.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <thread>
+
+#include "../scale/scaler.h"
+#include "../util/Utils.h"
+#include "../util/logger/Logger.h"
+#include "JasmineGraphServer.h"
+
+Logger replica_logger;
+
+struct GraphHeat {
+    double heat;
+    std::chrono::steady_clock::time_point updated;
+};
+
+static std::mutex heatMutex;
+static std::map<int, GraphHeat> heats;
+
+static ReplicaManager::Policy policy;
+static SQLiteDBInterface *metadb = nullptr;
+static std::string masterIP;
+static int interval = 0;  // seconds
+static std::chrono::steady_clock::time_point startTime;
+
+// Leases held by jobs on each replica. Leases are taken and replicas reclaimed under the mutex, against the current
+// topology.
+static std::mutex leaseMutex;
+static std::map<ReplicaManager::Replica, int> leases;
+
+static std::mutex runMutex;
+static std::condition_variable runCondition;
+static std::thread managerThread;
+static bool running = false;
+
+static double decayed(const GraphHeat &graphHeat, std::chrono::steady_clock::time_point now) {
+    std::chrono::duration<double> elapsed = now - graphHeat.updated;
+    return graphHeat.heat * pow(0.5, elapsed.count() / policy.halfLife);
+}
+
+static double getDoubleProperty(const std::string &key, double defaultValue) {
+    std::string value = Utils::getJasmineGraphProperty(key);
+    return value.empty() ? defaultValue : atof(value.c_str());
+}
+
+void ReplicaManager::start(SQLiteDBInterface *sqlite, std::string masterHost) {
+    std::lock_guard<std::mutex> lock(runMutex);
+    if (running) {
+        return;
+    }
+    interval = (int)getDoubleProperty("org.jasminegraph.replication.interval", 60);
+    if (interval <= 0) {
+        replica_logger.info("Partition replication is disabled");
+        return;
+    }
+    policy.hotReplicas = (int)getDoubleProperty("org.jasminegraph.replication.factor", policy.hotReplicas);
+    policy.hotHeat = getDoubleProperty("org.jasminegraph.replication.hotjobs", policy.hotHeat);
+    policy.halfLife = getDoubleProperty("org.jasminegraph.replication.halflife", policy.halfLife);
+    policy.minFreeMemory = getDoubleProperty("org.jasminegraph.replication.minfreememory", policy.minFreeMemory);
+    if (policy.halfLife <= 0) {
+        policy.halfLife = 600;
+    }
+
+    metadb = sqlite;
+    masterIP = masterHost;
+    // Databases created before replicas were tracked do not have the table
+    metadb->runSqlNoCallback(
+        "CREATE TABLE IF NOT EXISTS partition_replica (partition_idpartition VARCHAR, partition_graph_idgraph VARCHAR, "
+        "worker_idworker INTEGER, created_time TIME)");
+    startTime = std::chrono::steady_clock::now();
+    running = true;
+    managerThread = std::thread(&ReplicaManager::run);
+    replica_logger.info("Managing partition replicas every " + std::to_string(interval) + " seconds");
+}
+
+void ReplicaManager::stop() {
+    {
+        std::lock_guard<std::mutex> lock(runMutex);
+        if (!running) {
+            return;
+        }
+        running = false;
+    }
+    runCondition.notify_all();
+    if (managerThread.joinable()) {
+        managerThread.join();
+    }
+}
+
+void ReplicaManager::run() {
+    std::unique_lock<std::mutex> lock(runMutex);
+    while (running) {
+        runCondition.wait_for(lock, std::chrono::seconds(interval), [] { return !running; });
+        if (!running) break;
+        lock.unlock();
+        rebalance();
+        lock.lock();
+    }
+}
+
+void ReplicaManager::recordAccess(int graphId) {
+    auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(heatMutex);
+    auto it = heats.find(graphId);
+    if (it == heats.end()) {
+        heats[graphId] = {1, now};
+    } else {
+        it->second = {decayed(it->second, now) + 1, now};
+    }
+}
+
+double ReplicaManager::getHeat(int graphId) {
+    std::lock_guard<std::mutex> lock(heatMutex);
+    auto it = heats.find(graphId);
+    return it == heats.end() ? 0 : decayed(it->second, std::chrono::steady_clock::now());
+}
+
+void ReplicaManager::removeGraph(int graphId, SQLiteDBInterface *sqlite) {
+    {
+        std::lock_guard<std::mutex> lock(heatMutex);
+        heats.erase(graphId);
+    }
+    sqlite->runUpdate("DELETE FROM partition_replica WHERE partition_graph_idgraph = ?", {std::to_string(graphId)});
+}
+
+// Whether the worker holds the partition in the snapshot. A snapshot that was never loaded holds everything, as no
+// replica has been reclaimed yet.
+static bool holds(const ClusterTopology::Snapshot &snapshot, int graphId, int partitionId, int workerId) {
+    if (snapshot.version == 0) {
+        return true;
+    }
+    auto graphIt = snapshot.graphs.find(graphId);
+    if (graphIt == snapshot.graphs.end()) {
+        return false;
+    }
+    auto partitionIt = graphIt->second.find(partitionId);
+    return partitionIt != graphIt->second.end() &&
+           std::find(partitionIt->second.begin(), partitionIt->second.end(), workerId) != partitionIt->second.end();
+}
+
+void ReplicaLease::add(int graphId, const std::map<int, std::vector<int>> &assignment) {
+    for (auto it = assignment.begin(); it != assignment.end(); it++) {
+        for (int partitionId : it->second) {
+            ReplicaManager::Replica replica(graphId, partitionId, it->first);
+            leases[replica]++;
+            replicas.push_back(replica);
+        }
+    }
+}
+
+bool ReplicaLease::acquire(int graphId, const std::map<int, std::vector<int>> &assignment) {
+    std::lock_guard<std::mutex> lock(leaseMutex);
+    std::shared_ptr<const ClusterTopology::Snapshot> current = ClusterTopology::get();
+    for (auto it = assignment.begin(); it != assignment.end(); it++) {
+        for (int partitionId : it->second) {
+            if (!holds(*current, graphId, partitionId, it->first)) {
+                return false;
+            }
+        }
+    }
+    add(graphId, assignment);
+    return true;
+}
+
+void ReplicaLease::release() {
+    std::lock_guard<std::mutex> lock(leaseMutex);
+    for (const auto &replica : replicas) {
+        auto it = leases.find(replica);
+        if (it != leases.end() && --it->second <= 0) {
+            leases.erase(it);
+        }
+    }
+    replicas.clear();
+}
+
+int ReplicaManager::getLeaseCount(const Replica &replica) {
+    std::lock_guard<std::mutex> lock(leaseMutex);
+    auto it = leases.find(replica);
+    return it == leases.end() ? 0 : it->second;
+}
+
+std::map<int, std::vector<int>> ReplicaManager::route(const ClusterTopology::Snapshot &topology, int graphId,
+                                                      std::map<int, int> &loads, ReplicaLease *lease) {
+    std::map<int, std::vector<int>> assignment;  // worker id => partition ids
+    auto graphIt = topology.graphs.find(graphId);
+    if (graphIt == topology.graphs.end()) {
+        return assignment;
+    }
+    std::unique_lock<std::mutex> lock(leaseMutex, std::defer_lock);
+    std::shared_ptr<const ClusterTopology::Snapshot> current;
+    if (lease) {
+        lock.lock();
+        current = ClusterTopology::get();
+    }
+    for (auto it = graphIt->second.begin(); it != graphIt->second.end(); it++) {
+        int best = -1;
+        for (int worker : it->second) {
+            if (!topology.getWorker(worker) || (current && !holds(*current, graphId, it->first, worker))) {
+                continue;
+            }
+            if (best == -1) {
+                best = worker;
+                continue;
+            }
+            int load = loads[worker];
+            int bestLoad = loads[best];
+            bool local = assignment.count(worker) > 0;
+            bool bestLocal = assignment.count(best) > 0;
+            if (load < bestLoad || (load == bestLoad && local && !bestLocal)) {
+                best = worker;
+            }
+        }
+        if (best == -1) {
+            continue;
+        }
+        assignment[best].push_back(it->first);
+        loads[best]++;
+    }
+    if (lease) {
+        lease->add(graphId, assignment);
+    }
+    return assignment;
+}
+
+std::vector<ReplicaManager::Action> ReplicaManager::plan(const ClusterTopology::Snapshot &topology,
+                                                         const std::set<Replica> &secondaries,
+                                                         const std::map<int, double> &heats,
+                                                         const std::map<int, WorkerState> &workers,
+                                                         const Policy &policy, bool reclaim) {
+    std::vector<Action> actions;
+    std::map<int, int> loads;
+    for (auto it = workers.begin(); it != workers.end(); it++) {
+        if (it->second.alive) {
+            loads[it->first] = it->second.load;
+        }
+    }
+    auto isAlive = [&workers](int worker) {
+        auto it = workers.find(worker);
+        return it != workers.end() && it->second.alive;
+    };
+    auto canTake = [&workers, &loads, &policy](int worker) {
+        auto it = workers.find(worker);
+        if (it == workers.end() || !it->second.alive || it->second.totalMemory <= 0) return false;
+        const WorkerState &state = it->second;
+        double freeMemory = (state.totalMemory - state.usedMemory) / (double)state.totalMemory;
+        return loads[worker] < policy.maxLoad && freeMemory >= policy.minFreeMemory;
+    };
+
+    int copies = 0;
+    for (auto graphIt = topology.graphs.begin(); graphIt != topology.graphs.end(); graphIt++) {
+        int graphId = graphIt->first;
+        auto heatIt = heats.find(graphId);
+        double heat = heatIt == heats.end() ? 0 : heatIt->second;
+        bool hot = heat >= policy.hotHeat;
+        bool cold = heat < policy.hotHeat / 2;
+
+        for (auto it = graphIt->second.begin(); it != graphIt->second.end(); it++) {
+            int partitionId = it->first;
+            std::vector<int> holders;
+            for (int worker : it->second) {
+                if (topology.getWorker(worker)) holders.push_back(worker);
+            }
+
+            if (hot) {
+                while ((int)holders.size() < policy.hotReplicas && copies < policy.maxCopies) {
+                    int source = -1;
+                    for (int worker : holders) {
+                        if (isAlive(worker) && (source == -1 || loads[worker] < loads[source])) source = worker;
+                    }
+                    int target = -1;
+                    for (auto workerIt = topology.workers.begin(); workerIt != topology.workers.end(); workerIt++) {
+                        int worker = workerIt->first;
+                        if (std::find(holders.begin(), holders.end(), worker) != holders.end() || !canTake(worker)) {
+                            continue;
+                        }
+                        if (target == -1 || loads[worker] < loads[target]) target = worker;
+                    }
+                    if (source == -1 || target == -1) break;
+                    actions.push_back({graphId, partitionId, source, target});
+                    loads[source]++;
+                    loads[target]++;
+                    holders.push_back(target);
+                    copies++;
+                }
+            }
+
+            if (!reclaim || !(hot || cold)) continue;
+            size_t keep = hot ? std::max(policy.hotReplicas, 1) : 1;
+            while (holders.size() > keep) {
+                // Reclaim the secondary on the most loaded worker that is not running a task
+                int victim = -1;
+                for (int worker : holders) {
+                    if (!secondaries.count(Replica(graphId, partitionId, worker)) || !isAlive(worker) ||
+                        workers.find(worker)->second.tasks > 0) {
+                        continue;
+                    }
+                    if (victim == -1 || loads[worker] > loads[victim]) victim = worker;
+                }
+                if (victim == -1) break;
+                actions.push_back({graphId, partitionId, -1, victim});
+                holders.erase(std::remove(holders.begin(), holders.end(), victim), holders.end());
+            }
+        }
+    }
+    return actions;
+}
+
+static bool copyReplica(const ClusterTopology::Snapshot &topology, const ReplicaManager::Action &action) {
+    const ClusterTopology::Worker *source = topology.getWorker(action.source);
+    const ClusterTopology::Worker *target = topology.getWorker(action.worker);
+    return Utils::transferPartition(source->host, source->port, target->host, target->dataPort,
+                                    std::to_string(action.graphId), std::to_string(action.partitionId),
+                                    std::to_string(action.worker), metadb);
+}
+
+static bool removeReplica(const ClusterTopology::Snapshot &topology, const ReplicaManager::Action &action) {
+    std::vector<std::string> replica = {std::to_string(action.graphId), std::to_string(action.partitionId),
+                                        std::to_string(action.worker)};
+    {
+        // Jobs lease replicas under the same lock and only while they are in the current topology. So a replica
+        // without leases that is out of the topology is not read by any job, even one routed from an older snapshot.
+        std::lock_guard<std::mutex> lock(leaseMutex);
+        if (leases.count(ReplicaManager::Replica(action.graphId, action.partitionId, action.worker)) > 0) {
+            return false;
+        }
+        if (!metadb->runBatch({{"DELETE FROM worker_has_partition WHERE partition_graph_idgraph = ? AND "
+                                "partition_idpartition = ? AND worker_idworker = ?",
+                                replica},
+                               {"DELETE FROM partition_replica WHERE partition_graph_idgraph = ? AND "
+                                "partition_idpartition = ? AND worker_idworker = ?",
+                                replica}})) {
+            replica_logger.error("Could not remove replica of partition " + replica[1] + " of graph " + replica[0] +
+                                 " from worker " + replica[2]);
+            return false;
+        }
+        ClusterTopology::removeReplica(action.graphId, action.partitionId, action.worker);
+    }
+    const ClusterTopology::Worker *worker = topology.getWorker(action.worker);
+    JasmineGraphServer::removePartitionThroughService(worker->host, worker->port, replica[0], replica[1], masterIP);
+    return true;
+}
+
+void ReplicaManager::rebalance() {
+    std::shared_ptr<const ClusterTopology::Snapshot> topology = ClusterTopology::get(metadb);
+
+    std::set<Replica> secondaries;
+    std::vector<Replica> orphans;
+    metadb->forEachRow(
+        "SELECT partition_graph_idgraph, partition_idpartition, worker_idworker FROM partition_replica", {},
+        [&](const DBRow &row) {
+            Replica replica(row.getInt(0), row.getInt(1), row.getInt(2));
+            auto graphIt = topology->graphs.find(row.getInt(0));
+            bool held = false;
+            if (graphIt != topology->graphs.end()) {
+                auto partitionIt = graphIt->second.find(row.getInt(1));
+                held = partitionIt != graphIt->second.end() &&
+                       std::find(partitionIt->second.begin(), partitionIt->second.end(), row.getInt(2)) !=
+                           partitionIt->second.end();
+            }
+            if (held) {
+                secondaries.insert(replica);
+            } else {
+                orphans.push_back(replica);
+            }
+        });
+    // Records of replicas whose worker or graph is gone
+    for (const auto &orphan : orphans) {
+        metadb->runUpdate(
+            "DELETE FROM partition_replica WHERE partition_graph_idgraph = ? AND partition_idpartition = ? AND "
+            "worker_idworker = ?",
+            {std::to_string(std::get<0>(orphan)), std::to_string(std::get<1>(orphan)),
+             std::to_string(std::get<2>(orphan))});
+    }
+
+    std::map<int, double> graphHeats;
+    {
+        auto now = std::chrono::steady_clock::now();
+        std::lock_guard<std::mutex> lock(heatMutex);
+        for (auto it = heats.begin(); it != heats.end(); it++) {
+            graphHeats[it->first] = decayed(it->second, now);
+        }
+    }
+
+    std::map<int, std::future<bool>> heartbeatResponses;
+    std::map<int, Utils::WorkerHeartbeat> heartbeats;
+    for (auto it = topology->workers.begin(); it != topology->workers.end(); it++) {
+        heartbeatResponses[it->first] =
+            std::async(std::launch::async, Utils::requestWorkerHeartbeat,
+                       it->second.host + ":" + std::to_string(it->second.port), masterIP, &heartbeats[it->first]);
+    }
+    std::map<int, WorkerState> workers;
+    for (auto it = heartbeatResponses.begin(); it != heartbeatResponses.end(); it++) {
+        WorkerState &state = workers[it->first];
+        state.alive = it->second.get();
+        if (!state.alive) continue;
+        const Utils::WorkerHeartbeat &heartbeat = heartbeats[it->first];
+        state.load = std::min(std::max((int)(4 * heartbeat.cpuUsage), heartbeat.runningTasks), policy.maxLoad);
+        state.usedMemory = heartbeat.usedMemory;
+        state.totalMemory = heartbeat.totalMemory;
+    }
+    {
+        std::lock_guard<std::mutex> lock(schedulerMutex);
+        for (auto it = used_workers.begin(); it != used_workers.end(); it++) {
+            auto workerIt = workers.find(atoi(it->first.c_str()));
+            if (workerIt != workers.end()) {
+                workerIt->second.tasks = it->second;
+                workerIt->second.load = std::max(workerIt->second.load, it->second);
+            }
+        }
+    }
+
+    // Heats are lost on restart, so nothing is reclaimed until they have built up again
+    std::chrono::duration<double> uptime = std::chrono::steady_clock::now() - startTime;
+    const auto &actions = plan(*topology, secondaries, graphHeats, workers, policy, uptime.count() >= policy.halfLife);
+    if (actions.empty()) {
+        return;
+    }
+
+    std::vector<std::future<bool>> copies;
+    int removed = 0;
+    for (const auto &action : actions) {
+        if (action.source == -1) {
+            if (removeReplica(*topology, action)) removed++;
+        } else {
+            copies.push_back(std::async(std::launch::async, copyReplica, std::cref(*topology), action));
+        }
+    }
+    int copied = 0;
+    for (auto &copy : copies) {
+        if (copy.get()) copied++;
+    }
+    replica_logger.info("Replica round copied " + std::to_string(copied) + " of " + std::to_string(copies.size()) +
+                        " partitions and reclaimed " + std::to_string(removed));
+}
@@ -0,0 +1,124 @@
+/**
+Copyright 2024 JasmineGraph Team
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#ifndef JASMINEGRAPH_REPLICAMANAGER_H
+#define JASMINEGRAPH_REPLICAMANAGER_H
+
+#include <map>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "../metadb/SQLiteDBInterface.h"
+#include "ClusterTopology.h"
+
+/*
+ * Keeps extra replicas of the partitions of hot graphs on the master's behalf.
+ *
+ * Every job on a graph heats it up and the heat halves every half-life. A background round places replicas of hot
+ * graphs on lightly loaded workers with free memory, copying from the least loaded holder, and reclaims the secondary
+ * replicas of graphs that went cold. Partitions placed at upload time are primaries and are never reclaimed; copies,
+ * whether made here or by a job, are recorded in the partition_replica table as secondaries.
+ *
+ * Jobs use route() to send each partition task to one holder of the partition instead of to all of them, and hold a
+ * ReplicaLease on the picked replicas so that the rounds do not reclaim them while the job reads them.
+ * */
+class ReplicaLease;
+
+class ReplicaManager {
+ public:
+    struct Policy {
+        int hotReplicas = 2;         // replicas of each partition of a hot graph
+        double hotHeat = 3;          // heat at which a graph becomes hot. Graphs below half of it are cold.
+        double halfLife = 600;       // seconds
+        double minFreeMemory = 0.2;  // fraction of its memory a worker must have free to take a replica
+        int maxLoad = 3;             // workers at this load or above take no replicas, on the scheduler's 4 core scale
+        int maxCopies = 4;           // copies per round, to bound the background traffic
+    };
+
+    struct WorkerState {
+        bool alive = false;
+        int load = 0;
+        int tasks = 0;  // tasks routed to the worker that have not finished
+        long usedMemory = 0;
+        long totalMemory = 0;
+    };
+
+    // Copies the partition from `source` to `worker`, or removes it from `worker` when `source` is -1
+    struct Action {
+        int graphId;
+        int partitionId;
+        int source;
+        int worker;
+    };
+
+    // (graph id, partition id, worker id)
+    typedef std::tuple<int, int, int> Replica;
+
+    // Starts the background rounds. Does nothing if org.jasminegraph.replication.interval is 0.
+    static void start(SQLiteDBInterface *metadb, std::string masterIP);
+    static void stop();
+
+    // Records that a job was submitted on the graph
+    static void recordAccess(int graphId);
+    static double getHeat(int graphId);
+    // Forgets the graph and its secondary replicas. The caller removes the graph from the metadb.
+    static void removeGraph(int graphId, SQLiteDBInterface *metadb);
+
+    // Assigns every partition of the graph to its least loaded holder, preferring holders already picked for the
+    // job. `loads` is the number of tasks on each worker id and is updated with the assigned partitions. With a
+    // lease, holders that left the current topology since `topology` was taken are skipped and the picked replicas
+    // are added to the lease.
+    static std::map<int, std::vector<int>> route(const ClusterTopology::Snapshot &topology, int graphId,
+                                                 std::map<int, int> &loads, ReplicaLease *lease = nullptr);
+
+    // Number of leases held on the replica
+    static int getLeaseCount(const Replica &replica);
+
+    // Copies and removals that bring the replicas to the targets of the policy
+    static std::vector<Action> plan(const ClusterTopology::Snapshot &topology, const std::set<Replica> &secondaries,
+                                    const std::map<int, double> &heats, const std::map<int, WorkerState> &workers,
+                                    const Policy &policy, bool reclaim);
+
+ private:
+    static void run();
+    static void rebalance();
+};
+
+/*
+ * Replicas a job sends tasks to. A leased replica is not reclaimed, and a replica that is out of the current
+ * topology cannot be leased, so a job never reads a replica whose files are being removed. The leases are released
+ * when the object goes out of scope, which is after the tasks of the job have finished.
+ * */
+class ReplicaLease {
+ public:
+    ReplicaLease() {}
+    ~ReplicaLease() { release(); }
+    ReplicaLease(const ReplicaLease &) = delete;
+    ReplicaLease &operator=(const ReplicaLease &) = delete;
+
+    // Leases the replicas of the graph in `assignment` (worker id => partition ids). Returns false, leasing none of
+    // them, if one is no longer in the current topology.
+    bool acquire(int graphId, const std::map<int, std::vector<int>> &assignment);
+    void release();
+
+ private:
+    friend class ReplicaManager;
+    std::vector<ReplicaManager::Replica> replicas;
+
+    // Callers hold the lease mutex
+    void add(int graphId, const std::map<int, std::vector<int>> &assignment);
+};
+
+#endif  // JASMINEGRAPH_REPLICAMANAGER_H
@@ -29,9 +29,9 @@ int StreamingSQLiteDBInterface::init() {
         }
     }
 
-    int rc = sqlite3_open(this->databaseLocation.c_str(), &database);
+    int rc = openPool();
     if (rc) {
-        streamdb_logger.error("Cannot open database: " + string(sqlite3_errmsg(database)));
+        streamdb_logger.error("Cannot open database: " + databaseLocation);
         return (-1);
     } else {
         streamdb_logger.info("Database opened successfully : " + databaseLocation);
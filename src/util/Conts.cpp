@@ -49,6 +49,7 @@ int Conts::JASMINEGRAPH_RUNTIME_PROFILE_WORKER = 2;
 
 int Conts::RDF_NUM_OF_ATTRIBUTES = 7;
 int Conts::MAX_FE_SESSIONS = 20;
+int Conts::MAX_FE_EXECUTORS = 16;
 int Conts::DEFAULT_THREAD_PRIORITY = 1;
 int Conts::HIGH_PRIORITY_DEFAULT_VALUE = 5;
 int Conts::THREAD_SLEEP_TIME = 30000;
@@ -77,10 +78,14 @@ const std::string Conts::FLAGS::EPOCHS = "epochs";
 
 const std::string Conts::SLA_CATEGORY::LATENCY = "latency";
 
+const std::string Conts::CENTRAL_TRIANGLE_PLAN::OWNER = "owner";
+const std::string Conts::CENTRAL_TRIANGLE_PLAN::SHUFFLE = "shuffle";
+
 const std::string Conts::PARAM_KEYS::ERROR_MESSAGE = "errorResponse";
 const std::string Conts::PARAM_KEYS::MASTER_IP = "masterIP";
 const std::string Conts::PARAM_KEYS::GRAPH_ID = "graphID";
 const std::string Conts::PARAM_KEYS::MODE = "mode";
+const std::string Conts::PARAM_KEYS::WINDOW = "window";
 const std::string Conts::PARAM_KEYS::PARTITION = "partition";
 const std::string Conts::PARAM_KEYS::PRIORITY = "priority";
 const std::string Conts::PARAM_KEYS::ALPHA = "alpha";
@@ -93,5 +98,6 @@ const std::string Conts::PARAM_KEYS::CATEGORY = "category";
 const std::string Conts::PARAM_KEYS::QUEUE_TIME = "queueTime";
 const std::string Conts::PARAM_KEYS::GRAPH_SLA = "graphSLA";
 const std::string Conts::PARAM_KEYS::AUTO_CALIBRATION = "autoCalibration";
+const std::string Conts::PARAM_KEYS::CENTRAL_TRIANGLE_PLAN = "centralTrianglePlan";
 
 const std::string Conts::FLAGS::MODEL_ID = "model_id";
@@ -97,6 +97,7 @@ class Conts {
     static int GRAPH_TYPE_TEXT;
 
     static int MAX_FE_SESSIONS;
+    static int MAX_FE_EXECUTORS;  // Frontend commands running concurrently
 
     static int DEFAULT_THREAD_PRIORITY;
     static int HIGH_PRIORITY_DEFAULT_VALUE;
@@ -135,11 +136,18 @@ class Conts {
         static const std::string LATENCY;
     };
 
+    // How triangles spanning three partitions are counted
+    struct CENTRAL_TRIANGLE_PLAN {
+        static const std::string OWNER;    // Every worker loads all central stores and counts its own vertices
+        static const std::string SHUFFLE;  // Cut adjacency is hash partitioned so each worker gets only its share
+    };
+
     struct PARAM_KEYS {
         static const std::string ERROR_MESSAGE;
         static const std::string MASTER_IP;
         static const std::string GRAPH_ID;
         static const std::string MODE;
+        static const std::string WINDOW;
         static const std::string PARTITION;
         static const std::string PRIORITY;
         static const std::string ALPHA;
@@ -153,6 +161,7 @@ class Conts {
         static const std::string GRAPH_SLA;
         static const std::string IS_CALIBRATING;
         static const std::string AUTO_CALIBRATION;
+        static const std::string CENTRAL_TRIANGLE_PLAN;
     };
 };
 
@@ -0,0 +1,318 @@
+/**
+Copyright 2024 JasmineGraph Team
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#include "DegreeDistribution.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <nlohmann/json.hpp>
+#include <queue>
+
+#include "logger/Logger.h"
+
+Logger degree_distribution_logger;
+
+static const char DEGREE_RUN_MAGIC[4] = {'J', 'G', 'D', 'D'};
+static const size_t DEGREE_RUN_BUFFER_SIZE = 256 * 1024;
+
+static inline uint64_t zigzagEncode(long value) { return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63); }
+
+static inline long zigzagDecode(uint64_t value) { return (long)(value >> 1) ^ -(long)(value & 1); }
+
+static inline bool writeVarint(FILE *file, uint64_t value) {
+    uint8_t bytes[10];
+    int count = 0;
+    while (value >= 0x80) {
+        bytes[count++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    bytes[count++] = (uint8_t)value;
+    return fwrite(bytes, 1, count, file) == (size_t)count;
+}
+
+DegreeDistributionWriter::DegreeDistributionWriter() : file(NULL), lastVertex(0), failed(false) {}
+
+DegreeDistributionWriter::~DegreeDistributionWriter() {
+    if (file) {
+        fclose(file);
+    }
+}
+
+bool DegreeDistributionWriter::open(const std::string &filePath) {
+    file = fopen(filePath.c_str(), "wb");
+    if (!file) {
+        degree_distribution_logger.error("Cannot open " + filePath + " for writing");
+        return false;
+    }
+    setvbuf(file, NULL, _IOFBF, DEGREE_RUN_BUFFER_SIZE);
+    lastVertex = 0;
+    failed = fwrite(DEGREE_RUN_MAGIC, 1, sizeof(DEGREE_RUN_MAGIC), file) != sizeof(DEGREE_RUN_MAGIC);
+    return !failed;
+}
+
+bool DegreeDistributionWriter::append(long vertex, long degree) {
+    if (!file || failed) {
+        return false;
+    }
+    failed = !writeVarint(file, zigzagEncode(vertex - lastVertex)) || !writeVarint(file, zigzagEncode(degree));
+    lastVertex = vertex;
+    return !failed;
+}
+
+bool DegreeDistributionWriter::close() {
+    if (!file) {
+        return false;
+    }
+    bool closed = fclose(file) == 0;
+    file = NULL;
+    return closed && !failed;
+}
+
+DegreeDistributionReader::DegreeDistributionReader(const std::string &filePath)
+    : fd(::open(filePath.c_str(), O_RDONLY)),
+      ownsFd(true),
+      remaining(-1),
+      buffer(DEGREE_RUN_BUFFER_SIZE),
+      position(0),
+      limit(0),
+      lastVertex(0),
+      headerRead(false),
+      failed(false) {
+    if (fd < 0) {
+        degree_distribution_logger.error("Cannot open " + filePath + " for reading");
+        failed = true;
+    }
+}
+
+DegreeDistributionReader::DegreeDistributionReader(int fd, long length)
+    : fd(fd),
+      ownsFd(false),
+      remaining(length),
+      buffer(DEGREE_RUN_BUFFER_SIZE),
+      position(0),
+      limit(0),
+      lastVertex(0),
+      headerRead(false),
+      failed(false) {}
+
+DegreeDistributionReader::~DegreeDistributionReader() {
+    if (ownsFd && fd >= 0) {
+        ::close(fd);
+    }
+}
+
+bool DegreeDistributionReader::readByte(uint8_t &byte) {
+    if (position == limit) {
+        if (failed || remaining == 0) {
+            return false;
+        }
+        size_t toRead = buffer.size();
+        if (remaining > 0 && (size_t)remaining < toRead) {
+            toRead = remaining;
+        }
+        ssize_t bytesRead;
+        do {
+            bytesRead = ::read(fd, buffer.data(), toRead);
+        } while (bytesRead < 0 && errno == EINTR);
+        if (bytesRead < 0) {
+            degree_distribution_logger.error("Reading degree distribution failed: " + std::string(strerror(errno)));
+            failed = true;
+            return false;
+        }
+        if (bytesRead == 0) {
+            // A sized run must deliver every byte it announced
+            if (remaining > 0) {
+                failed = true;
+            }
+            return false;
+        }
+        if (remaining > 0) {
+            remaining -= bytesRead;
+        }
+        position = 0;
+        limit = bytesRead;
+    }
+    byte = buffer[position++];
+    return true;
+}
+
+bool DegreeDistributionReader::readVarint(uint64_t &value) {
+    value = 0;
+    uint8_t byte;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (!readByte(byte)) {
+            if (shift > 0) {
+                failed = true;
+            }
+            return false;
+        }
+        value |= (uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    failed = true;
+    return false;
+}
+
+bool DegreeDistributionReader::next(long &vertex, long &degree) {
+    if (failed) {
+        return false;
+    }
+    if (!headerRead) {
+        char magic[sizeof(DEGREE_RUN_MAGIC)];
+        for (size_t i = 0; i < sizeof(magic); i++) {
+            uint8_t byte;
+            if (!readByte(byte)) {
+                failed = true;
+                return false;
+            }
+            magic[i] = byte;
+        }
+        if (memcmp(magic, DEGREE_RUN_MAGIC, sizeof(magic)) != 0) {
+            degree_distribution_logger.error("Not a degree distribution run");
+            failed = true;
+            return false;
+        }
+        headerRead = true;
+    }
+    uint64_t gap;
+    if (!readVarint(gap)) {
+        // Running out of bytes between entries is the normal end of a run
+        return false;
+    }
+    uint64_t encodedDegree;
+    if (!readVarint(encodedDegree)) {
+        failed = true;
+        return false;
+    }
+    lastVertex += zigzagDecode(gap);
+    vertex = lastVertex;
+    degree = zigzagDecode(encodedDegree);
+    return true;
+}
+
+DegreeDistributionSummary::DegreeDistributionSummary(size_t topN)
+    : vertexCount(0), degreeSum(0), maxDegree(0), topN(topN) {}
+
+void DegreeDistributionSummary::add(long vertex, long degree) {
+    vertexCount++;
+    degreeSum += degree;
+    maxDegree = std::max(maxDegree, degree);
+    int bucket = degree <= 0 ? 0 : 64 - __builtin_clzl((unsigned long)degree);
+    histogram[bucket]++;
+
+    if (topN == 0) {
+        return;
+    }
+    // `top` is kept as a min-heap on degree so the smallest of the current top-N is evicted first
+    if (top.size() < topN) {
+        top.push_back(std::make_pair(degree, vertex));
+        std::push_heap(top.begin(), top.end(), std::greater<std::pair<long, long>>());
+    } else if (degree > top.front().first) {
+        std::pop_heap(top.begin(), top.end(), std::greater<std::pair<long, long>>());
+        top.back() = std::make_pair(degree, vertex);
+        std::push_heap(top.begin(), top.end(), std::greater<std::pair<long, long>>());
+    }
+}
+
+std::string DegreeDistributionSummary::toJson() const {
+    nlohmann::json summary;
+    summary["vertices"] = vertexCount;
+    summary["degreeSum"] = degreeSum;
+    summary["maxDegree"] = maxDegree;
+
+    nlohmann::json buckets = nlohmann::json::array();
+    for (auto it = histogram.begin(); it != histogram.end(); it++) {
+        long low = it->first == 0 ? 0 : 1L << (it->first - 1);
+        long high = it->first == 0 ? 0 : (1L << it->first) - 1;
+        buckets.push_back({{"min", low}, {"max", high}, {"count", it->second}});
+    }
+    summary["histogram"] = buckets;
+
+    std::vector<std::pair<long, long>> sortedTop(top);
+    std::sort(sortedTop.begin(), sortedTop.end(), std::greater<std::pair<long, long>>());
+    nlohmann::json topVertices = nlohmann::json::array();
+    for (auto &entry : sortedTop) {
+        topVertices.push_back({{"vertex", entry.second}, {"degree", entry.first}});
+    }
+    summary["top"] = topVertices;
+    return summary.dump();
+}
+
+bool DegreeDistribution::write(const std::string &filePath, const std::map<long, long> &distribution) {
+    DegreeDistributionWriter writer;
+    if (!writer.open(filePath)) {
+        return false;
+    }
+    for (auto it = distribution.begin(); it != distribution.end(); it++) {
+        if (!writer.append(it->first, it->second)) {
+            break;
+        }
+    }
+    if (!writer.close()) {
+        degree_distribution_logger.error("Writing degree distribution to " + filePath + " failed");
+        return false;
+    }
+    return true;
+}
+
+bool DegreeDistribution::merge(std::vector<DegreeDistributionReader *> &runs, Combine combine,
+                               const std::function<void(long, long)> &sink) {
+    // Min-heap of (vertex, run index) holding the head entry of every run that is not exhausted
+    std::priority_queue<std::pair<long, size_t>, std::vector<std::pair<long, size_t>>,
+                        std::greater<std::pair<long, size_t>>>
+        heads;
+    std::vector<long> headDegrees(runs.size());
+    for (size_t i = 0; i < runs.size(); i++) {
+        long vertex;
+        if (runs[i]->next(vertex, headDegrees[i])) {
+            heads.push(std::make_pair(vertex, i));
+        }
+    }
+
+    while (!heads.empty()) {
+        long vertex = heads.top().first;
+        long degree = 0;
+        bool first = true;
+        while (!heads.empty() && heads.top().first == vertex) {
+            size_t run = heads.top().second;
+            heads.pop();
+            long runDegree = headDegrees[run];
+            if (first) {
+                degree = runDegree;
+                first = false;
+            } else if (combine == SUM) {
+                degree += runDegree;
+            } else {
+                degree = std::max(degree, runDegree);
+            }
+            long nextVertex;
+            if (runs[run]->next(nextVertex, headDegrees[run])) {
+                heads.push(std::make_pair(nextVertex, run));
+            }
+        }
+        sink(vertex, degree);
+    }
+
+    for (auto run : runs) {
+        if (!run->good()) {
+            return false;
+        }
+    }
+    return true;
+}
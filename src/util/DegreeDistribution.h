@@ -0,0 +1,111 @@
+/**
+Copyright 2024 JasmineGraph Team
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#ifndef JASMINEGRAPH_DEGREEDISTRIBUTION_H
+#define JASMINEGRAPH_DEGREEDISTRIBUTION_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <functional>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+ * Degree distributions are stored and shipped as sorted binary runs. A run starts with a magic header followed by
+ * one entry per vertex in ascending vertex order. Each entry is the zigzag varint encoded gap to the previous vertex
+ * followed by the zigzag varint encoded degree, so dense vertex ranges take two to three bytes per vertex.
+ * */
+class DegreeDistributionWriter {
+ public:
+    DegreeDistributionWriter();
+    ~DegreeDistributionWriter();
+
+    bool open(const std::string &filePath);
+    // Vertices must be appended in ascending order
+    bool append(long vertex, long degree);
+    bool close();
+
+ private:
+    FILE *file;
+    long lastVertex;
+    bool failed;
+};
+
+class DegreeDistributionReader {
+ public:
+    // Reads a run from a file
+    explicit DegreeDistributionReader(const std::string &filePath);
+    // Reads a run of `length` bytes from a socket or an already open file. The descriptor is not closed.
+    DegreeDistributionReader(int fd, long length);
+    ~DegreeDistributionReader();
+
+    // Returns false at the end of the run or on a read error
+    bool next(long &vertex, long &degree);
+    bool good() const { return !failed; }
+
+ private:
+    int fd;
+    bool ownsFd;
+    long remaining;
+    std::vector<uint8_t> buffer;
+    size_t position;
+    size_t limit;
+    long lastVertex;
+    bool headerRead;
+    bool failed;
+
+    bool readByte(uint8_t &byte);
+    bool readVarint(uint64_t &value);
+};
+
+/*
+ * Streaming summary of a degree distribution. Degrees are counted in power of two buckets, where bucket 0 holds
+ * degree 0 and bucket b holds degrees in [2^(b-1), 2^b). The top-N vertices by degree are kept in a bounded heap.
+ * */
+class DegreeDistributionSummary {
+ public:
+    explicit DegreeDistributionSummary(size_t topN);
+
+    void add(long vertex, long degree);
+    std::string toJson() const;
+
+    long vertexCount;
+    long degreeSum;
+    long maxDegree;
+    std::map<int, long> histogram;
+    // (degree, vertex) pairs of the highest degree vertices seen so far
+    std::vector<std::pair<long, long>> top;
+
+ private:
+    size_t topN;
+};
+
+class DegreeDistribution {
+ public:
+    enum Combine { SUM, MAX };
+
+    static bool write(const std::string &filePath, const std::map<long, long> &distribution);
+
+    /*
+     * K-way merge of sorted runs. Entries of the same vertex coming from different runs are combined with `combine`
+     * and handed to `sink` in ascending vertex order. Only one entry per run is held in memory.
+     * Returns false if any of the runs could not be read completely.
+     * */
+    static bool merge(std::vector<DegreeDistributionReader *> &runs, Combine combine,
+                      const std::function<void(long, long)> &sink);
+};
+
+#endif  // JASMINEGRAPH_DEGREEDISTRIBUTION_H
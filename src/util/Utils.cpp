@@ -17,10 +17,16 @@ limitations under the License.
 #include <dirent.h>
 #include <jsoncpp/json/json.h>
 #include <netdb.h>
+#include <fcntl.h>
+#include <poll.h>
 #include <pwd.h>
+#include <sys/inotify.h>
+#include <sys/sendfile.h>
 #include <sys/stat.h>
 #include <unistd.h>
+#include <zlib.h>
 
+#include <cerrno>
 #include <chrono>
 #include <ctime>
 #include <iomanip>
@@ -29,6 +35,7 @@ limitations under the License.
 
 #include "../../globals.h"
 #include "../k8s/K8sInterface.h"
+#include "../server/ClusterTopology.h"
 #include "../server/JasmineGraphInstanceProtocol.h"
 #include "../server/JasmineGraphServer.h"
 #include "Conts.h"
@@ -129,6 +136,16 @@ std::string Utils::getJasmineGraphProperty(std::string key) {
 
 std::vector<Utils::worker> Utils::getWorkerList(SQLiteDBInterface *sqlite) {
     vector<Utils::worker> workerVector;
+    std::shared_ptr<const ClusterTopology::Snapshot> topology = ClusterTopology::get();
+    if (topology->version > 0) {
+        for (auto it = topology->workers.begin(); it != topology->workers.end(); it++) {
+            const ClusterTopology::Worker &cached = it->second;
+            workerVector.push_back({to_string(cached.id), cached.host, cached.user, to_string(cached.port),
+                                    to_string(cached.dataPort)});
+        }
+        return workerVector;
+    }
+
     std::vector<vector<pair<string, string>>> v =
         sqlite->runSelect("SELECT idworker,user,ip,server_port,server_data_port FROM worker;");
     for (int i = 0; i < v.size(); i++) {
@@ -316,53 +333,168 @@ int Utils::copyFile(const std::string sourceFilePath, const std::string destinat
  * @param filePath
  * @return
  */
-int Utils::getFileSize(std::string filePath) {
-    ifstream file(filePath.c_str(), ifstream::in | ifstream::binary);
-    if (!file.is_open()) {
+long Utils::getFileSize(std::string filePath) {
+    struct stat fileStat;
+    if (stat(filePath.c_str(), &fileStat) != 0) {
         return -1;
     }
-    file.seekg(0, ios::end);
-    int fileSize = file.tellg();
-    file.close();
-    return fileSize;
+    return fileStat.st_size;
 }
 
+static const size_t FILE_IO_BUFFER_SIZE = 256 * 1024;
+
 /**
- * This method compresses files using gzip
+ * This method compresses files using gzip. Compression is done in-process with zlib, streaming the file through a
+ * fixed size buffer instead of forking gzip/pigz.
  * @param filePath
  */
-int Utils::compressFile(const std::string filePath, std::string mode) {
-    if (mode == "pigz") {
-        if (access("/usr/bin/pigz", X_OK) != 0) {
-            util_logger.info("pigz not found. Compressing using gzip");
-            mode = "gzip";
+int Utils::compressFile(const std::string filePath) {
+    std::string compressedFilePath = filePath + ".gz";
+    FILE *in = fopen(filePath.c_str(), "rb");
+    if (!in) {
+        util_logger.error("File compression failed. Cannot open " + filePath);
+        return -1;
+    }
+    // Level 1 is several times faster than the gzip default and the files are only shipped over the LAN.
+    gzFile out = gzopen(compressedFilePath.c_str(), "wb1");
+    if (!out) {
+        util_logger.error("File compression failed. Cannot open " + compressedFilePath);
+        fclose(in);
+        return -1;
+    }
+    gzbuffer(out, FILE_IO_BUFFER_SIZE);
+
+    std::vector<char> buffer(FILE_IO_BUFFER_SIZE);
+    int status = 0;
+    size_t nread;
+    while ((nread = fread(buffer.data(), 1, buffer.size(), in)) > 0) {
+        if (gzwrite(out, buffer.data(), (unsigned)nread) != (int)nread) {
+            status = -1;
+            break;
         }
     }
-    std::string command = mode + " -f " + filePath + " 2>&1";
-    int status = system(command.c_str());
+    if (ferror(in)) status = -1;
+    fclose(in);
+    if (gzclose(out) != Z_OK) status = -1;
+
     if (status != 0) {
-        util_logger.error("File compression failed with code " + std::to_string(status));
+        util_logger.error("File compression failed for " + filePath);
+        unlink(compressedFilePath.c_str());
+        return status;
     }
-    return status;
+    unlink(filePath.c_str());
+    return 0;
 }
 
 /**
- * this method extracts a gzip file
+ * this method extracts a gzip file in-process with zlib
  * @param filePath
  */
-int Utils::unzipFile(std::string filePath, std::string mode) {
-    if (mode == "pigz") {
-        if (access("/usr/bin/pigz", X_OK) != 0) {
-            util_logger.info("pigz not found. Decompressing using gzip");
-            mode = "gzip";
+int Utils::unzipFile(std::string filePath) {
+    if (filePath.size() < 3 || filePath.compare(filePath.size() - 3, 3, ".gz") != 0) {
+        util_logger.error("File decompression failed. Not a .gz file: " + filePath);
+        return -1;
+    }
+    std::string rawFilePath = filePath.substr(0, filePath.size() - 3);
+    gzFile in = gzopen(filePath.c_str(), "rb");
+    if (!in) {
+        util_logger.error("File decompression failed. Cannot open " + filePath);
+        return -1;
+    }
+    gzbuffer(in, FILE_IO_BUFFER_SIZE);
+    FILE *out = fopen(rawFilePath.c_str(), "wb");
+    if (!out) {
+        util_logger.error("File decompression failed. Cannot open " + rawFilePath);
+        gzclose(in);
+        return -1;
+    }
+
+    std::vector<char> buffer(FILE_IO_BUFFER_SIZE);
+    int status = 0;
+    int nread;
+    while ((nread = gzread(in, buffer.data(), (unsigned)buffer.size())) > 0) {
+        if (fwrite(buffer.data(), 1, nread, out) != (size_t)nread) {
+            status = -1;
+            break;
         }
     }
-    std::string command = mode + " -f -d " + filePath + " 2>&1";
-    int status = system(command.c_str());
+    if (nread < 0) status = -1;
+    gzclose(in);
+    if (fclose(out) != 0) status = -1;
+
     if (status != 0) {
-        util_logger.error("File decompression failed with code " + std::to_string(status));
+        util_logger.error("File decompression failed for " + filePath);
+        unlink(rawFilePath.c_str());
+        return status;
     }
-    return status;
+    unlink(filePath.c_str());
+    return 0;
+}
+
+unsigned long Utils::getFileChecksum(const std::string &filePath, long length) {
+    FILE *fp = fopen(filePath.c_str(), "rb");
+    if (!fp) {
+        util_logger.error("Cannot open " + filePath + " to calculate checksum");
+        return 0;
+    }
+    uLong crc = crc32(0L, Z_NULL, 0);
+    std::vector<unsigned char> buffer(FILE_IO_BUFFER_SIZE);
+    long remaining = length;
+    while (length < 0 || remaining > 0) {
+        size_t toRead = buffer.size();
+        if (length >= 0 && remaining < (long)toRead) toRead = remaining;
+        size_t nread = fread(buffer.data(), 1, toRead, fp);
+        if (nread == 0) break;
+        crc = crc32(crc, buffer.data(), (uInt)nread);
+        remaining -= nread;
+    }
+    fclose(fp);
+    return crc;
+}
+
+bool Utils::waitForFile(const std::string &filePath, long fileSize, int timeoutSeconds) {
+    if (fileExists(filePath) && getFileSize(filePath) >= fileSize) {
+        return true;
+    }
+    std::string dirName = ".";
+    size_t slash = filePath.find_last_of('/');
+    if (slash != std::string::npos) {
+        dirName = filePath.substr(0, slash);
+    }
+    int notifyFd = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+    if (notifyFd < 0) {
+        util_logger.error("inotify_init1 failed while waiting for " + filePath);
+        return false;
+    }
+    if (inotify_add_watch(notifyFd, dirName.c_str(), IN_MOVED_TO | IN_CLOSE_WRITE | IN_CREATE) < 0) {
+        util_logger.error("Cannot watch " + dirName + " while waiting for " + filePath);
+        close(notifyFd);
+        return false;
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(timeoutSeconds);
+    char events[4096];
+    bool available = false;
+    while (true) {
+        // Check after the watch is in place so that a file moved in before the watch is not missed
+        if (fileExists(filePath) && getFileSize(filePath) >= fileSize) {
+            available = true;
+            break;
+        }
+        auto remaining =
+            std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+        if (remaining <= 0) break;
+        struct pollfd pfd = {notifyFd, POLLIN, 0};
+        if (poll(&pfd, 1, (int)remaining) > 0) {
+            while (read(notifyFd, events, sizeof(events)) > 0) {
+            }
+        }
+    }
+    close(notifyFd);
+    if (!available) {
+        util_logger.error("Timed out waiting for file " + filePath);
+    }
+    return available;
 }
 
 /**
@@ -626,6 +758,47 @@ bool Utils::sendExpectResponse(int sockfd, char *data, size_t data_length, std::
     return true;
 }
 
+bool Utils::sendChunkedString(int connFd, char *buf, size_t len, const std::string &str) {
+    const size_t chunkSize = len - 10;
+    size_t offset = 0;
+    do {
+        if (offset > 0 && Utils::read_str_trim_wrapper(connFd, buf, len) != "/SEND") {
+            util_logger.error("Chunk at " + std::to_string(offset) + " of a string was not acknowledged");
+            return false;
+        }
+        bool last = offset + chunkSize >= str.length();
+        if (!Utils::send_str_wrapper(connFd, str.substr(offset, chunkSize) + (last ? "/CMPT" : "/SEND"))) {
+            return false;
+        }
+        offset += chunkSize;
+    } while (offset < str.length());
+    return true;
+}
+
+bool Utils::readChunkedString(int connFd, char *buf, size_t len, std::string &str) {
+    static const size_t suffixLength = 5;
+    str.clear();
+    while (true) {
+        std::string chunk = Utils::read_str_wrapper(connFd, buf, len);
+        if (chunk.length() < suffixLength) {
+            util_logger.error("Invalid chunk of a string: " + chunk);
+            return false;
+        }
+        std::string status = chunk.substr(chunk.length() - suffixLength);
+        str += chunk.substr(0, chunk.length() - suffixLength);
+        if (status == "/CMPT") {
+            return true;
+        }
+        if (status != "/SEND") {
+            util_logger.error("Invalid chunk of a string: " + chunk);
+            return false;
+        }
+        if (!Utils::send_str_wrapper(connFd, status)) {
+            return false;
+        }
+    }
+}
+
 bool Utils::performHandshake(int sockfd, char *data, size_t data_length, std::string masterIP) {
     if (!Utils::sendExpectResponse(sockfd, data, data_length, JasmineGraphInstanceProtocol::HANDSHAKE,
                                    JasmineGraphInstanceProtocol::HANDSHAKE_OK)) {
@@ -730,6 +903,11 @@ static size_t write_callback(void *contents, size_t size, size_t nmemb, std::str
     return totalSize;
 }
 std::string Utils::send_job(std::string job_group_name, std::string metric_name, std::string metric_value) {
+    return send_jobs(job_group_name, {std::make_pair(metric_name, metric_value)});
+}
+
+std::string Utils::send_jobs(std::string job_group_name,
+                             const std::vector<std::pair<std::string, std::string>> &metrics) {
     CURL *curl;
     CURLcode res;
     std::string pushGatewayJobAddr;
@@ -761,7 +939,10 @@ std::string Utils::send_job(std::string job_group_name, std::string metric_name,
         // Set the callback function to handle the response data
         curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
         curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response_string);
-        std::string job_data = metric_name + " " + metric_value + "\n";
+        std::string job_data;
+        for (auto it = metrics.begin(); it != metrics.end(); it++) {
+            job_data += it->first + " " + it->second + "\n";
+        }
         const char *data = job_data.c_str();
 
         curl_slist *headers = NULL;
@@ -890,7 +1071,7 @@ bool Utils::uploadFileToWorker(std::string host, int port, int dataPort, int gra
     }
 
     std::string fileName = Utils::getFileName(filePath);
-    int fileSize = Utils::getFileSize(filePath);
+    long fileSize = Utils::getFileSize(filePath);
     std::string fileLength = to_string(fileSize);
 
     if (!Utils::sendExpectResponse(sockfd, data, INSTANCE_DATA_LENGTH, std::to_string(graphID),
@@ -915,8 +1096,14 @@ bool Utils::uploadFileToWorker(std::string host, int port, int dataPort, int gra
     }
 
     util_logger.info("Going to send file" + filePath + "/" + fileName + "through file transfer service to worker");
-    Utils::sendFileThroughService(host, dataPort, fileName, filePath);
+    if (!Utils::sendFileThroughService(host, dataPort, fileName, filePath)) {
+        Utils::send_str_wrapper(sockfd, JasmineGraphInstanceProtocol::CLOSE);
+        close(sockfd);
+        return false;
+    }
 
+    // The file transfer service has already verified the file and moved it into place, so the worker answers the
+    // first check without waiting.
     string response;
     int count = 0;
     while (true) {
@@ -933,12 +1120,16 @@ bool Utils::uploadFileToWorker(std::string host, int port, int dataPort, int gra
             util_logger.info("Received: " + JasmineGraphInstanceProtocol::FILE_RECV_WAIT);
             util_logger.info("Checking file status : " + to_string(count));
             count++;
-            sleep(1);
             continue;
         } else if (response.compare(JasmineGraphInstanceProtocol::FILE_ACK) == 0) {
             util_logger.info("Received: " + JasmineGraphInstanceProtocol::FILE_ACK);
             util_logger.info("File transfer completed for file : " + filePath);
             break;
+        } else {
+            util_logger.error("File transfer failed for file : " + filePath + " ; Received: " + response);
+            Utils::send_str_wrapper(sockfd, JasmineGraphInstanceProtocol::CLOSE);
+            close(sockfd);
+            return false;
         }
     }
     // Next we wait till the batch upload completes
@@ -953,12 +1144,16 @@ bool Utils::uploadFileToWorker(std::string host, int port, int dataPort, int gra
         response = Utils::read_str_trim_wrapper(sockfd, data, FED_DATA_LENGTH);
         if (response.compare(JasmineGraphInstanceProtocol::BATCH_UPLOAD_WAIT) == 0) {
             util_logger.info("Received: " + JasmineGraphInstanceProtocol::BATCH_UPLOAD_WAIT);
-            sleep(1);
             continue;
         } else if (response.compare(JasmineGraphInstanceProtocol::BATCH_UPLOAD_ACK) == 0) {
             util_logger.info("Received: " + JasmineGraphInstanceProtocol::BATCH_UPLOAD_ACK);
             util_logger.info("Batch upload completed: " + fileName);
             break;
+        } else {
+            util_logger.error("Batch upload failed for file : " + filePath + " ; Received: " + response);
+            Utils::send_str_wrapper(sockfd, JasmineGraphInstanceProtocol::CLOSE);
+            close(sockfd);
+            return false;
         }
     }
     Utils::send_str_wrapper(sockfd, JasmineGraphInstanceProtocol::CLOSE);
@@ -966,19 +1161,46 @@ bool Utils::uploadFileToWorker(std::string host, int port, int dataPort, int gra
     return true;
 }
 
-bool Utils::sendFileThroughService(std::string host, int dataPort, std::string fileName, std::string filePath) {
+static const int FILE_TRANSFER_ATTEMPTS = 3;
+
+/*
+ * Writes bytes [offset, fileSize) of a file to a connected socket with sendfile(), without copying them through user
+ * space.
+ * */
+bool Utils::sendFileContent(int sockfd, const std::string &filePath, long offset, long fileSize) {
+    int fd = open(filePath.c_str(), O_RDONLY);
+    if (fd < 0) {
+        util_logger.error("Error opening file: " + filePath);
+        return false;
+    }
+    off_t position = offset;
+    bool status = true;
+    while (position < fileSize) {
+        ssize_t sent = sendfile(sockfd, fd, &position, fileSize - position);
+        if (sent < 0 && (errno == EINTR || errno == EAGAIN)) continue;
+        if (sent <= 0) {
+            util_logger.error("sendfile failed for " + filePath + " at byte " + to_string(position));
+            status = false;
+            break;
+        }
+    }
+    close(fd);
+    return status;
+}
+
+/*
+ * Sends the file to the file transfer service of a worker. The service answers the file header
+ * "<size>:<crc32>" with "file:<offset>", where offset is the number of bytes it already holds from an interrupted
+ * transfer of the same file. Only the remaining bytes are sent with sendfile(2) and the service acknowledges with
+ * FILE_ACK once the checksum is verified and the file is moved into place, or with FILE_RECV_ERROR otherwise.
+ * */
+static bool sendFileAttempt(const std::string &host, int dataPort, const std::string &fileName,
+                            const std::string &filePath, long fsize, unsigned long checksum) {
     int sockfd;
     char data[FED_DATA_LENGTH + 1];
-    socklen_t len;
     struct sockaddr_in serv_addr;
     struct hostent *server;
 
-    util_logger.info("Sending file " + filePath + " through port " + std::to_string(dataPort));
-    FILE *fp = fopen(filePath.c_str(), "r");
-    if (fp == NULL) {
-        return false;
-    }
-
     sockfd = socket(AF_INET, SOCK_STREAM, 0);
     if (sockfd < 0) {
         util_logger.error("Cannot create socket");
@@ -988,6 +1210,7 @@ bool Utils::sendFileThroughService(std::string host, int dataPort, std::string f
     server = gethostbyname(host.c_str());
     if (server == NULL) {
         util_logger.error("ERROR, no host named " + host);
+        close(sockfd);
         return false;
     }
 
@@ -996,6 +1219,7 @@ bool Utils::sendFileThroughService(std::string host, int dataPort, std::string f
     bcopy((char *)server->h_addr, (char *)&serv_addr.sin_addr.s_addr, server->h_length);
     serv_addr.sin_port = htons(dataPort);
     if (Utils::connect_wrapper(sockfd, (struct sockaddr *)&serv_addr, sizeof(serv_addr)) < 0) {
+        close(sockfd);
         return false;
     }
 
@@ -1005,36 +1229,62 @@ bool Utils::sendFileThroughService(std::string host, int dataPort, std::string f
         return false;
     }
 
-    int fsize = Utils::getFileSize(filePath);
-    if (!Utils::sendExpectResponse(sockfd, data, INSTANCE_DATA_LENGTH, to_string(fsize),
-                                   JasmineGraphInstanceProtocol::SEND_FILE)) {
+    if (!Utils::send_str_wrapper(sockfd, to_string(fsize) + ":" + to_string(checksum))) {
         close(sockfd);
         return false;
     }
+    std::string response = Utils::read_str_trim_wrapper(sockfd, data, INSTANCE_DATA_LENGTH);
+    std::string expected = JasmineGraphInstanceProtocol::SEND_FILE + ":";
+    if (response.compare(0, expected.length(), expected) != 0) {
+        util_logger.error("Incorrect response. Expected: " + expected + "<offset> ; Received: " + response);
+        close(sockfd);
+        return false;
+    }
+    off_t offset = std::stol(response.substr(expected.length()));
+    if (offset > 0) {
+        util_logger.info("Resuming transfer of " + fileName + " from byte " + to_string(offset));
+    }
 
-    bool status = true;
-    while (true) {
-        unsigned char buff[1024];
-        int nread = fread(buff, 1, sizeof(buff), fp);
+    off_t startOffset = offset;
+    auto startTime = std::chrono::steady_clock::now();
+    bool status = Utils::sendFileContent(sockfd, filePath, offset, fsize);
 
-        /* If read was success, send data. */
-        if (nread > 0) {
-            write(sockfd, buff, nread);
+    if (status) {
+        response = Utils::read_str_trim_wrapper(sockfd, data, INSTANCE_DATA_LENGTH);
+        if (response.compare(JasmineGraphInstanceProtocol::FILE_ACK) != 0) {
+            util_logger.error("File transfer of " + fileName + " was not acknowledged. Received: " + response);
+            status = false;
         } else {
-            if (feof(fp)) util_logger.info("End of file");
-            if (ferror(fp)) {
-                status = false;
-                util_logger.error("Error reading file: " + filePath);
-            }
-            break;
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+            long sent = fsize - startOffset;
+            double throughput = seconds > 0 ? sent / seconds / (1024 * 1024) : 0;
+            util_logger.info("Sent " + to_string(sent) + " bytes of " + fileName + " in " + to_string(seconds) +
+                             " s (" + to_string(throughput) + " MB/s)");
         }
     }
-
-    fclose(fp);
     close(sockfd);
     return status;
 }
 
+bool Utils::sendFileThroughService(std::string host, int dataPort, std::string fileName, std::string filePath) {
+    util_logger.info("Sending file " + filePath + " through port " + std::to_string(dataPort));
+    long fsize = Utils::getFileSize(filePath);
+    if (fsize < 0) {
+        util_logger.error("Cannot read file: " + filePath);
+        return false;
+    }
+    unsigned long checksum = Utils::getFileChecksum(filePath);
+
+    for (int attempt = 1; attempt <= FILE_TRANSFER_ATTEMPTS; attempt++) {
+        if (sendFileAttempt(host, dataPort, fileName, filePath, fsize, checksum)) {
+            util_logger.info("File transfer completed for file: " + filePath);
+            return true;
+        }
+        util_logger.warn("File transfer attempt " + to_string(attempt) + " failed for file: " + filePath);
+    }
+    return false;
+}
+
 /*
  * Function to transfer a partition from one worker to another
  * Caller should ensure that the partition exists in the source worker
@@ -1100,12 +1350,97 @@ bool Utils::transferPartition(std::string sourceWorker, int sourceWorkerPort, st
     }
 
     util_logger.info("### Transfer partition completed");
-    sqlite->runInsert(
-        "INSERT INTO worker_has_partition "
-        "(partition_idpartition, partition_graph_idgraph, worker_idworker) VALUES ('" +
-        partitionID + "', '" + graphID + "', '" + workerID + "')");
+    // Copies are recorded as secondary replicas so that the replica manager can reclaim them
+    std::vector<std::string> replica = {partitionID, graphID, workerID};
+    if (sqlite->runBatch({{"INSERT INTO worker_has_partition "
+                           "(partition_idpartition, partition_graph_idgraph, worker_idworker) VALUES (?, ?, ?)",
+                           replica},
+                          {"INSERT INTO partition_replica "
+                           "(partition_idpartition, partition_graph_idgraph, worker_idworker, created_time) "
+                           "VALUES (?, ?, ?, datetime('now'))",
+                           replica}})) {
+        ClusterTopology::addReplica(atoi(graphID.c_str()), atoi(partitionID.c_str()), atoi(workerID.c_str()));
+    }
 
     Utils::send_str_wrapper(sockfd, JasmineGraphInstanceProtocol::CLOSE);
     close(sockfd);
     return true;
 }
+
+static bool parseHeartbeatField(const std::string &field, long *value) {
+    char *end;
+    errno = 0;
+    *value = strtol(field.c_str(), &end, 10);
+    return !field.empty() && *end == '\0' && errno == 0 && *value >= 0;
+}
+
+bool Utils::parseWorkerHeartbeat(const std::string &reply, WorkerHeartbeat *heartbeat) {
+    // <running tasks>|<high priority tasks>|<cpu usage>|<used memory KB>|<total memory KB>
+    const auto &fields = Utils::split(reply, '|');
+    if (fields.size() != 5) {
+        return false;
+    }
+    long runningTasks, highPriorityTasks, usedMemory, totalMemory;
+    if (!parseHeartbeatField(fields[0], &runningTasks) || !parseHeartbeatField(fields[1], &highPriorityTasks) ||
+        !parseHeartbeatField(fields[3], &usedMemory) || !parseHeartbeatField(fields[4], &totalMemory)) {
+        return false;
+    }
+    char *end;
+    errno = 0;
+    double cpuUsage = strtod(fields[2].c_str(), &end);
+    if (fields[2].empty() || *end != '\0' || errno != 0 || cpuUsage < 0) {
+        return false;
+    }
+    heartbeat->runningTasks = runningTasks;
+    heartbeat->highPriorityTasks = highPriorityTasks;
+    heartbeat->cpuUsage = cpuUsage;
+    heartbeat->usedMemory = usedMemory;
+    heartbeat->totalMemory = totalMemory;
+    return true;
+}
+
+bool Utils::requestWorkerHeartbeat(std::string hostPort, std::string masterIP, WorkerHeartbeat *heartbeat) {
+    const auto &hostAndPort = Utils::split(hostPort, ':');
+    if (hostAndPort.size() != 2) {
+        return false;
+    }
+    std::string host = hostAndPort[0];
+    if (host.find('@') != std::string::npos) {
+        host = Utils::split(host, '@')[1];
+    }
+
+    int sockfd = socket(AF_INET, SOCK_STREAM, 0);
+    if (sockfd < 0) {
+        util_logger.error("Cannot create socket");
+        return false;
+    }
+    struct hostent *server = gethostbyname(host.c_str());
+    if (server == NULL) {
+        util_logger.error("ERROR, no host named " + host);
+        close(sockfd);
+        return false;
+    }
+    struct sockaddr_in serv_addr;
+    bzero((char *)&serv_addr, sizeof(serv_addr));
+    serv_addr.sin_family = AF_INET;
+    bcopy((char *)server->h_addr, (char *)&serv_addr.sin_addr.s_addr, server->h_length);
+    serv_addr.sin_port = htons(atoi(hostAndPort[1].c_str()));
+    if (Utils::connect_wrapper(sockfd, (struct sockaddr *)&serv_addr, sizeof(serv_addr)) < 0) {
+        util_logger.error("ERROR connecting to " + hostPort);
+        close(sockfd);
+        return false;
+    }
+
+    char data[INSTANCE_DATA_LENGTH + 1];
+    bool received = false;
+    if (Utils::performHandshake(sockfd, data, INSTANCE_DATA_LENGTH, masterIP) &&
+        Utils::send_str_wrapper(sockfd, JasmineGraphInstanceProtocol::WORKER_HEARTBEAT)) {
+        received = parseWorkerHeartbeat(Utils::read_str_trim_wrapper(sockfd, data, INSTANCE_DATA_LENGTH), heartbeat);
+    }
+    Utils::send_str_wrapper(sockfd, JasmineGraphInstanceProtocol::CLOSE);
+    close(sockfd);
+    if (!received) {
+        util_logger.warn("No heartbeat from worker " + hostPort);
+    }
+    return received;
+}
@@ -46,6 +46,14 @@ class Utils {
         std::string dataPort;
     };
 
+    struct WorkerHeartbeat {
+        int runningTasks;
+        int highPriorityTasks;
+        double cpuUsage;
+        long usedMemory;   // KB
+        long totalMemory;  // KB
+    };
+
     static std::string getJasmineGraphProperty(std::string key);
 
     static std::vector<worker> getWorkerList(SQLiteDBInterface *sqlite);
@@ -72,7 +80,14 @@ class Utils {
 
     static std::fstream *openFile(const std::string &path, std::ios_base::openmode mode);
 
-    static int compressFile(const std::string filePath, std::string mode = "pigz");
+    /**
+     * Compresses the file in-process into gzip format. Like `gzip -f`, the original file is replaced by
+     * `filePath`.gz on success.
+     *
+     * @param filePath path of the file to compress
+     * @return 0 on success or -1 on failure.
+     */
+    static int compressFile(const std::string filePath);
 
     static bool is_number(const std::string &compareString);
 
@@ -84,7 +99,7 @@ class Utils {
 
     static std::string getFileName(std::string filePath);
 
-    static int getFileSize(std::string filePath);
+    static long getFileSize(std::string filePath);
 
     static std::string getJasmineGraphHome();
 
@@ -92,7 +107,33 @@ class Utils {
 
     static int copyFile(const std::string sourceFilePath, const std::string destinationFilePath);
 
-    static int unzipFile(std::string filePath, std::string mode = "pigz");
+    /**
+     * Decompresses a gzip file in-process. Like `gzip -d -f`, the .gz file is replaced by the decompressed file.
+     *
+     * @param filePath path of the .gz file
+     * @return 0 on success or -1 on failure.
+     */
+    static int unzipFile(std::string filePath);
+
+    /**
+     * Calculates the CRC32 checksum of the first `length` bytes of a file.
+     *
+     * @param filePath path of the file
+     * @param length number of bytes to include or -1 to include the whole file
+     * @return the checksum, or 0 if the file cannot be read.
+     */
+    static unsigned long getFileChecksum(const std::string &filePath, long length = -1);
+
+    /**
+     * Blocks until the file exists with at least `fileSize` bytes. Uses inotify on the parent directory instead of
+     * polling, so it returns as soon as the file transfer service moves the received file into place.
+     *
+     * @param filePath path of the file to wait for
+     * @param fileSize expected minimum size of the file in bytes
+     * @param timeoutSeconds maximum time to wait
+     * @return true if the file became available within the timeout.
+     */
+    static bool waitForFile(const std::string &filePath, long fileSize, int timeoutSeconds);
 
     static bool hostExists(std::string name, std::string ip, std::string workerPort, SQLiteDBInterface *sqlite);
 
@@ -162,6 +203,20 @@ class Utils {
     static bool sendExpectResponse(int sockfd, char *data, size_t data_length, std::string sendMsg,
                                    std::string expectMsg);
 
+    /**
+     * Sends a string that may not fit in one read of `len` bytes, such as a list of workers. It goes in chunks that
+     * end with /SEND, or /CMPT for the last one, and the receiver acks each /SEND chunk with /SEND.
+     *
+     * @param buf writable buffer of size at least len+1, for the acks
+     * @return true on success or false if a send failed or a chunk was not acked
+     */
+    static bool sendChunkedString(int connFd, char *buf, size_t len, const std::string &str);
+
+    /**
+     * Reads a string sent by sendChunkedString(). Returns false if a chunk is malformed or the connection failed.
+     */
+    static bool readChunkedString(int connFd, char *buf, size_t len, std::string &str);
+
     static bool performHandshake(int sockfd, char *data, size_t data_length, std::string masterIP);
 
     static std::string getCurrentTimestamp();
@@ -172,6 +227,10 @@ class Utils {
 
     static std::string send_job(std::string job_group_name, std::string metric_name, std::string metric_value);
 
+    // Pushes several metrics to the pushgateway in one request
+    static std::string send_jobs(std::string job_group_name,
+                                 const std::vector<std::pair<std::string, std::string>> &metrics);
+
     static map<string, string> getMetricMap(string metricName);
 
     static bool uploadFileToWorker(std::string host, int port, int dataPort, int graphID, std::string filePath,
@@ -179,9 +238,17 @@ class Utils {
 
     static bool sendFileThroughService(std::string host, int dataPort, std::string fileName, std::string filePath);
 
+    static bool sendFileContent(int sockfd, const std::string &filePath, long offset, long fileSize);
+
     static bool transferPartition(std::string sourceWorker, int sourceWorkerPort, std::string destinationWorker,
                                   int destinationWorkerDataPort, std::string graphID, std::string partitionID,
                                   std::string workerID, SQLiteDBInterface *sqlite);
+
+    // Asks the worker at "host:port" for its load. Returns false if the worker does not answer.
+    static bool requestWorkerHeartbeat(std::string hostPort, std::string masterIP, WorkerHeartbeat *heartbeat);
+
+    // Parses a heartbeat reply. Returns false, leaving heartbeat untouched, if the reply is malformed or partial.
+    static bool parseWorkerHeartbeat(const std::string &reply, WorkerHeartbeat *heartbeat);
 };
 
 #endif  // JASMINEGRAPH_UTILS_H
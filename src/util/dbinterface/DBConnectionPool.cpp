@@ -0,0 +1,127 @@
+/**
+Copyright 2024 JasmineGraph Team
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#include "DBConnectionPool.h"
+
+#include <stdlib.h>
+
+#include "../Utils.h"
+#include "../logger/Logger.h"
+
+Logger pool_logger;
+
+static const size_t DEFAULT_POOL_SIZE = 4;
+static const int BUSY_TIMEOUT_MS = 5000;
+
+static std::mutex poolsMutex;
+static std::map<std::string, DBConnectionPool *> pools;
+
+DBConnection::DBConnection(sqlite3 *handle) : handle(handle) {}
+
+DBConnection::~DBConnection() {
+    for (auto it = statements.begin(); it != statements.end(); it++) {
+        sqlite3_finalize(it->second);
+    }
+    sqlite3_close(handle);
+}
+
+sqlite3_stmt *DBConnection::prepare(const std::string &sql) {
+    auto it = statements.find(sql);
+    if (it != statements.end()) {
+        sqlite3_reset(it->second);
+        sqlite3_clear_bindings(it->second);
+        return it->second;
+    }
+    sqlite3_stmt *statement = NULL;
+    if (sqlite3_prepare_v2(handle, sql.c_str(), -1, &statement, NULL) != SQLITE_OK) {
+        pool_logger.error("SQL Error: " + std::string(sqlite3_errmsg(handle)) + " " + sql);
+        sqlite3_finalize(statement);
+        return NULL;
+    }
+    statements[sql] = statement;
+    return statement;
+}
+
+DBConnectionPool::DBConnectionPool(const std::string &databaseLocation)
+    : databaseLocation(databaseLocation), maxIdle(DEFAULT_POOL_SIZE), users(0) {
+    int poolSize = atoi(Utils::getJasmineGraphProperty("org.jasminegraph.db.poolsize").c_str());
+    if (poolSize > 0) {
+        maxIdle = poolSize;
+    }
+}
+
+DBConnectionPool *DBConnectionPool::attach(const std::string &databaseLocation) {
+    std::lock_guard<std::mutex> lock(poolsMutex);
+    auto it = pools.find(databaseLocation);
+    if (it != pools.end()) {
+        it->second->users++;
+        return it->second;
+    }
+    DBConnectionPool *pool = new DBConnectionPool(databaseLocation);
+    // Open the first connection eagerly so that a database that cannot be opened fails the caller's init()
+    std::unique_ptr<DBConnection> connection = pool->open();
+    if (!connection) {
+        delete pool;
+        return nullptr;
+    }
+    pool->idle.push_back(std::move(connection));
+    pool->users = 1;
+    pools[databaseLocation] = pool;
+    return pool;
+}
+
+void DBConnectionPool::detach(DBConnectionPool *pool) {
+    std::lock_guard<std::mutex> lock(poolsMutex);
+    if (--pool->users > 0) {
+        return;
+    }
+    pools.erase(pool->databaseLocation);
+    delete pool;
+}
+
+std::unique_ptr<DBConnection> DBConnectionPool::open() {
+    sqlite3 *handle = NULL;
+    if (sqlite3_open_v2(databaseLocation.c_str(), &handle, SQLITE_OPEN_READWRITE | SQLITE_OPEN_NOMUTEX, NULL) !=
+        SQLITE_OK) {
+        pool_logger.error("Cannot open database " + databaseLocation + ": " + std::string(sqlite3_errmsg(handle)));
+        sqlite3_close(handle);
+        return nullptr;
+    }
+    sqlite3_busy_timeout(handle, BUSY_TIMEOUT_MS);
+    char *errorMessage = NULL;
+    if (sqlite3_exec(handle, "PRAGMA journal_mode=WAL; PRAGMA synchronous=NORMAL;", NULL, NULL, &errorMessage) !=
+        SQLITE_OK) {
+        pool_logger.warn("Cannot enable WAL on " + databaseLocation + ": " + std::string(errorMessage));
+        sqlite3_free(errorMessage);
+    }
+    return std::unique_ptr<DBConnection>(new DBConnection(handle));
+}
+
+std::unique_ptr<DBConnection> DBConnectionPool::acquire() {
+    {
+        std::lock_guard<std::mutex> lock(idleMutex);
+        if (!idle.empty()) {
+            std::unique_ptr<DBConnection> connection = std::move(idle.back());
+            idle.pop_back();
+            return connection;
+        }
+    }
+    return open();
+}
+
+void DBConnectionPool::release(std::unique_ptr<DBConnection> connection) {
+    std::lock_guard<std::mutex> lock(idleMutex);
+    if (idle.size() < maxIdle) {
+        idle.push_back(std::move(connection));
+    }
+}
@@ -0,0 +1,95 @@
+/**
+Copyright 2024 JasmineGraph Team
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#ifndef JASMINEGRAPH_SRC_UTIL_DBCONNECTIONPOOL_H_
+#define JASMINEGRAPH_SRC_UTIL_DBCONNECTIONPOOL_H_
+
+#include <sqlite3.h>
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// One SQLite connection with the statements prepared on it
+class DBConnection {
+ public:
+    explicit DBConnection(sqlite3 *handle);
+    ~DBConnection();
+
+    sqlite3 *getHandle() { return handle; }
+
+    // Returns a reset statement for `sql`, prepared on first use and cached for the life of the connection
+    sqlite3_stmt *prepare(const std::string &sql);
+
+ private:
+    sqlite3 *handle;
+    std::map<std::string, sqlite3_stmt *> statements;
+};
+
+/*
+ * Connections to one database file, shared by every DBInterface opened on it.
+ *
+ * Connections are opened in WAL mode so that readers do not block the writer, and are handed out one operation at
+ * a time. A connection is never shared between two threads, so cached statements can be reused without locking.
+ * When all connections are busy a new one is opened rather than waiting, which keeps nested lookups from
+ * deadlocking; connections beyond the pool size are closed when they are returned.
+ * */
+class DBConnectionPool {
+ public:
+    // Returns the pool of the database, opening it if this is the first user. Returns nullptr if it cannot be opened.
+    static DBConnectionPool *attach(const std::string &databaseLocation);
+
+    // Closes the pool when its last user detaches
+    static void detach(DBConnectionPool *pool);
+
+    std::unique_ptr<DBConnection> acquire();
+    void release(std::unique_ptr<DBConnection> connection);
+
+ private:
+    explicit DBConnectionPool(const std::string &databaseLocation);
+    std::unique_ptr<DBConnection> open();
+
+    std::string databaseLocation;
+    size_t maxIdle;
+    int users;
+    std::mutex idleMutex;
+    std::vector<std::unique_ptr<DBConnection>> idle;
+};
+
+// Connection borrowed from a pool for the lifetime of the object. The pool is null when the interface was never
+// initialized or failed to open, and the connection is then invalid.
+class PooledConnection {
+ public:
+    explicit PooledConnection(DBConnectionPool *pool)
+        : pool(pool), connection(pool ? pool->acquire() : std::unique_ptr<DBConnection>()) {}
+    ~PooledConnection() {
+        if (connection) {
+            pool->release(std::move(connection));
+        }
+    }
+    PooledConnection(const PooledConnection &) = delete;
+    PooledConnection &operator=(const PooledConnection &) = delete;
+
+    bool valid() const { return connection != nullptr; }
+    // SQLite result code explaining why the connection is not valid
+    int error() const { return connection ? SQLITE_OK : (pool ? SQLITE_CANTOPEN : SQLITE_MISUSE); }
+    DBConnection *operator->() { return connection.get(); }
+
+ private:
+    DBConnectionPool *pool;
+    std::unique_ptr<DBConnection> connection;
+};
+
+#endif  // JASMINEGRAPH_SRC_UTIL_DBCONNECTIONPOOL_H_
@@ -16,107 +16,238 @@ limitations under the License.
 
 Logger interface_logger;
 
+typedef vector<vector<pair<string, string>>> table_type;
+
+int DBInterface::openPool() {
+    pool = DBConnectionPool::attach(databaseLocation);
+    return pool ? SQLITE_OK : SQLITE_CANTOPEN;
+}
+
+DBInterface::DBInterface(const DBInterface &other) : databaseLocation(other.databaseLocation) {
+    if (other.pool) {
+        openPool();
+    }
+}
+
+DBInterface &DBInterface::operator=(const DBInterface &other) {
+    if (this != &other) {
+        finalize();
+        databaseLocation = other.databaseLocation;
+        if (other.pool) {
+            openPool();
+        }
+    }
+    return *this;
+}
+
+DBInterface::~DBInterface() { finalize(); }
+
 int DBInterface::finalize() {
-    return sqlite3_close(database);
+    if (pool) {
+        DBConnectionPool::detach(pool);
+        pool = nullptr;
+    }
+    return SQLITE_OK;
 }
 
-typedef vector<vector<pair<string, string>>> table_type;
+static bool bindParams(sqlite3_stmt *statement, const std::vector<std::string> &params) {
+    for (size_t i = 0; i < params.size(); i++) {
+        if (sqlite3_bind_text(statement, i + 1, params[i].c_str(), params[i].size(), SQLITE_TRANSIENT) != SQLITE_OK) {
+            return false;
+        }
+    }
+    return true;
+}
 
-static int callback(void *ptr, int argc, char **argv, char **columnName) {
-    table_type *dbResults = static_cast<table_type *>(ptr);
-    vector<pair<string, string>> results;
+// Steps through a statement and collects the rows in the name and value form of runSelect()
+static bool collectRows(sqlite3_stmt *statement, table_type &dbResults) {
+    int rc;
+    while ((rc = sqlite3_step(statement)) == SQLITE_ROW) {
+        int columnCount = sqlite3_column_count(statement);
+        vector<pair<string, string>> results;
+        results.reserve(columnCount);
+        for (int i = 0; i < columnCount; i++) {
+            const unsigned char *value = sqlite3_column_text(statement, i);
+            results.push_back(make_pair(sqlite3_column_name(statement, i),
+                                        value ? reinterpret_cast<const char *>(value) : "NULL"));
+        }
+        dbResults.push_back(std::move(results));
+    }
+    return rc == SQLITE_DONE;
+}
 
-    for (int i = 0; i < argc; i++) {
-        results.push_back(make_pair(columnName[i], argv[i] ? argv[i] : "NULL"));
+// Runs SQL that is not worth caching, which may contain several statements
+static bool execute(DBConnection *connection, const std::string &query, table_type *dbResults) {
+    sqlite3 *handle = connection->getHandle();
+    const char *tail = query.c_str();
+    while (tail && *tail) {
+        sqlite3_stmt *statement = NULL;
+        if (sqlite3_prepare_v2(handle, tail, -1, &statement, &tail) != SQLITE_OK) {
+            interface_logger.error("SQL Error: " + string(sqlite3_errmsg(handle)) + " " + query);
+            return false;
+        }
+        if (!statement) {
+            continue;  // whitespace or comment
+        }
+        table_type ignored;
+        bool done = collectRows(statement, dbResults ? *dbResults : ignored);
+        if (!done) {
+            interface_logger.error("SQL Error: " + string(sqlite3_errmsg(handle)) + " " + query);
+        }
+        sqlite3_finalize(statement);
+        if (!done) {
+            return false;
+        }
     }
-    dbResults->push_back(results);
-    return 0;
+    return true;
+}
+
+// Runs a cached statement with parameters
+static bool executePrepared(DBConnection *connection, const std::string &query, const std::vector<std::string> &params,
+                            table_type *dbResults) {
+    sqlite3_stmt *statement = connection->prepare(query);
+    if (!statement) {
+        return false;
+    }
+    table_type ignored;
+    bool done = bindParams(statement, params) && collectRows(statement, dbResults ? *dbResults : ignored);
+    if (!done) {
+        interface_logger.error("SQL Error: " + string(sqlite3_errmsg(connection->getHandle())) + " " + query);
+    }
+    sqlite3_reset(statement);
+    return done;
 }
 
 vector<vector<pair<string, string>>> DBInterface::runSelect(string query) {
-    char *errorMessage = 0;
     vector<vector<pair<string, string>>> dbResults;
+    PooledConnection connection(pool);
+    if (connection.valid()) {
+        execute(connection.operator->(), query, &dbResults);
+    }
+    return dbResults;
+}
 
-    if (sqlite3_exec(database, query.c_str(), callback, &dbResults, &errorMessage) != SQLITE_OK) {
-        interface_logger.error("SQL Error: " + string(errorMessage) + " " + query);
-        sqlite3_free(errorMessage);
+vector<vector<pair<string, string>>> DBInterface::runSelect(const std::string &query,
+                                                            const std::vector<std::string> &params) {
+    vector<vector<pair<string, string>>> dbResults;
+    PooledConnection connection(pool);
+    if (connection.valid()) {
+        executePrepared(connection.operator->(), query, params, &dbResults);
     }
     return dbResults;
 }
 
+bool DBInterface::forEachRow(const std::string &query, const std::vector<std::string> &params,
+                             std::function<void(const DBRow &)> handler) {
+    PooledConnection connection(pool);
+    if (!connection.valid()) {
+        return false;
+    }
+    sqlite3_stmt *statement = connection->prepare(query);
+    if (!statement || !bindParams(statement, params)) {
+        return false;
+    }
+    DBRow row(statement);
+    int rc;
+    while ((rc = sqlite3_step(statement)) == SQLITE_ROW) {
+        handler(row);
+    }
+    if (rc != SQLITE_DONE) {
+        interface_logger.error("SQL Error: " + string(sqlite3_errmsg(connection->getHandle())) + " " + query);
+    }
+    sqlite3_reset(statement);
+    return rc == SQLITE_DONE;
+}
+
 // This function inserts a new row to the DB and returns the last inserted row id
 // returns -1 on error
 int DBInterface::runInsert(std::string query) {
-    char *errorMessage = 0;
-    int rc = sqlite3_exec(database, query.c_str(), NULL, NULL, &errorMessage);
-    if (rc != SQLITE_OK) {
-        interface_logger.error("SQL Error: " + string(errorMessage) + " " + query);
-        sqlite3_free(errorMessage);
-        return -1;
-    }
-    vector<vector<pair<string, string>>> dbResults;
-    string q2 = "SELECT last_insert_rowid();";
-
-    int rc2 = sqlite3_exec(database, q2.c_str(), callback, &dbResults, &errorMessage);
-
-    if (rc2 != SQLITE_OK) {
-        interface_logger.error("SQL Error: " + string(errorMessage) + " " + query);
-        sqlite3_free(errorMessage);
+    PooledConnection connection(pool);
+    if (!connection.valid() || !execute(connection.operator->(), query, NULL)) {
         return -1;
     }
+    return sqlite3_last_insert_rowid(connection->getHandle());
+}
 
-    if (dbResults.empty() || dbResults[0].empty()) {
+int DBInterface::runInsert(const std::string &query, const std::vector<std::string> &params) {
+    PooledConnection connection(pool);
+    if (!connection.valid() || !executePrepared(connection.operator->(), query, params, NULL)) {
         return -1;
     }
-    return std::stoi(dbResults[0][0].second);
+    return sqlite3_last_insert_rowid(connection->getHandle());
 }
 
 // This function inserts one or more rows of the DB and nothing is returned
 // This is used for inserting tables which do not have primary IDs
 void DBInterface::runInsertNoIDReturn(std::string query) {
-    char *errorMessage = 0;
-    int rc = sqlite3_exec(database, query.c_str(), NULL, NULL, &errorMessage);
-    if (rc != SQLITE_OK) {
-        interface_logger.error("SQL Error: " + string(errorMessage) + " " + query);
-        sqlite3_free(errorMessage);
+    PooledConnection connection(pool);
+    if (connection.valid()) {
+        execute(connection.operator->(), query, NULL);
     }
 }
 
 // This function updates one or more rows of the DB
 void DBInterface::runUpdate(std::string query) {
-    char *errorMessage = 0;
+    PooledConnection connection(pool);
+    if (connection.valid()) {
+        execute(connection.operator->(), query, NULL);
+    }
+}
+
+void DBInterface::runUpdate(const std::string &query, const std::vector<std::string> &params) {
+    PooledConnection connection(pool);
+    if (connection.valid()) {
+        executePrepared(connection.operator->(), query, params, NULL);
+    }
+}
 
-    int rc = sqlite3_exec(database, query.c_str(), NULL, NULL, &errorMessage);
+bool DBInterface::runBatch(const std::string &query, const std::vector<std::vector<std::string>> &rows) {
+    if (rows.empty()) {
+        return true;
+    }
+    PooledConnection connection(pool);
+    if (!connection.valid() || !execute(connection.operator->(), "BEGIN IMMEDIATE;", NULL)) {
+        return false;
+    }
+    for (auto it = rows.begin(); it != rows.end(); it++) {
+        if (!executePrepared(connection.operator->(), query, *it, NULL)) {
+            execute(connection.operator->(), "ROLLBACK;", NULL);
+            return false;
+        }
+    }
+    return execute(connection.operator->(), "COMMIT;", NULL);
+}
 
-    if (rc != SQLITE_OK) {
-        interface_logger.error("SQL Error: " + string(errorMessage) + " " + query);
-        sqlite3_free(errorMessage);
+bool DBInterface::runBatch(const std::vector<std::pair<std::string, std::vector<std::string>>> &statements) {
+    if (statements.empty()) {
+        return true;
     }
+    PooledConnection connection(pool);
+    if (!connection.valid() || !execute(connection.operator->(), "BEGIN IMMEDIATE;", NULL)) {
+        return false;
+    }
+    for (auto it = statements.begin(); it != statements.end(); it++) {
+        if (!executePrepared(connection.operator->(), it->first, it->second, NULL)) {
+            execute(connection.operator->(), "ROLLBACK;", NULL);
+            return false;
+        }
+    }
+    return execute(connection.operator->(), "COMMIT;", NULL);
 }
 
 int DBInterface::runSqlNoCallback(const char *zSql) {
+    PooledConnection connection(pool);
+    if (!connection.valid()) return connection.error();
     sqlite3_stmt *stmt = NULL;
-    int rc = sqlite3_prepare_v2(database, zSql, -1, &stmt, NULL);
+    int rc = sqlite3_prepare_v2(connection->getHandle(), zSql, -1, &stmt, NULL);
     if (rc != SQLITE_OK) return rc;
 
     int rowCount = 0;
     rc = sqlite3_step(stmt);
-    while (rc != SQLITE_DONE && rc != SQLITE_OK) {
+    while (rc == SQLITE_ROW) {
         rowCount++;
-        int colCount = sqlite3_column_count(stmt);
-        for (int colIndex = 0; colIndex < colCount; colIndex++) {
-            int type = sqlite3_column_type(stmt, colIndex);
-            const char *columnName = sqlite3_column_name(stmt, colIndex);
-            if (type == SQLITE_INTEGER) {
-                int valInt = sqlite3_column_int(stmt, colIndex);
-            } else if (type == SQLITE_FLOAT) {
-                double valDouble = sqlite3_column_double(stmt, colIndex);
-            } else if (type == SQLITE_TEXT) {
-                const unsigned char *valChar = sqlite3_column_text(stmt, colIndex);
-            }
-        }
-        interface_logger.info("Line " + std::to_string(rowCount) + ", rowCount " + std::to_string(colCount));
-
+        interface_logger.info("Line " + std::to_string(rowCount) + ", rowCount " +
+                              std::to_string(sqlite3_column_count(stmt)));
         rc = sqlite3_step(stmt);
     }
 
@@ -14,30 +14,85 @@ limitations under the License.
 #ifndef JASMINEGRAPH_SRC_UTIL_DBINTERFACE_H_
 #define JASMINEGRAPH_SRC_UTIL_DBINTERFACE_H_
 
+#include <functional>
 #include <string>
+#include <utility>
 #include <vector>
 #include <sqlite3.h>
 
+#include "DBConnectionPool.h"
+
 using namespace std;
 
+// Typed view of the current row of a query. Only valid inside the row handler.
+class DBRow {
+ public:
+    explicit DBRow(sqlite3_stmt *statement) : statement(statement) {}
+
+    int columnCount() const { return sqlite3_column_count(statement); }
+    bool isNull(int column) const { return sqlite3_column_type(statement, column) == SQLITE_NULL; }
+    int getInt(int column) const { return sqlite3_column_int(statement, column); }
+    long getLong(int column) const { return sqlite3_column_int64(statement, column); }
+    double getDouble(int column) const { return sqlite3_column_double(statement, column); }
+    std::string getString(int column) const {
+        const unsigned char *text = sqlite3_column_text(statement, column);
+        return text ? std::string(reinterpret_cast<const char *>(text)) : std::string();
+    }
+
+ private:
+    sqlite3_stmt *statement;
+};
+
+/*
+ * Runs SQL on a database through the connection pool of its file.
+ *
+ * The overloads taking `params` bind them to the `?` placeholders of the statement and reuse a prepared statement
+ * cached on the connection, so they should be preferred over building SQL strings on hot paths.
+ * */
 class DBInterface {
  protected:
-    sqlite3 *database;
+    DBConnectionPool *pool = nullptr;
     std::string databaseLocation;
 
+    // Attaches to the pool of databaseLocation. Returns 0 on success like sqlite3_open.
+    int openPool();
+
  public:
     virtual int init() = 0;
 
+    DBInterface() = default;
+    // Copies attach to the pool of the original and detach on their own
+    DBInterface(const DBInterface &other);
+    DBInterface &operator=(const DBInterface &other);
+    virtual ~DBInterface();
+
     int finalize();
 
     std::vector<std::vector<std::pair<std::string, std::string>>> runSelect(std::string);
 
+    std::vector<std::vector<std::pair<std::string, std::string>>> runSelect(const std::string &query,
+                                                                            const std::vector<std::string> &params);
+
+    // Calls `handler` for every row of the result. Returns false on error.
+    bool forEachRow(const std::string &query, const std::vector<std::string> &params,
+                    std::function<void(const DBRow &)> handler);
+
     int runInsert(std::string);
 
+    int runInsert(const std::string &query, const std::vector<std::string> &params);
+
     void runUpdate(std::string);
 
+    void runUpdate(const std::string &query, const std::vector<std::string> &params);
+
     void runInsertNoIDReturn(std::string);
 
+    // Runs the statement once for each set of parameters in a single transaction. Nothing is written on error.
+    bool runBatch(const std::string &query, const std::vector<std::vector<std::string>> &rows);
+
+    // Runs each statement with its parameters in a single transaction. Nothing is written on error.
+    bool runBatch(const std::vector<std::pair<std::string, std::vector<std::string>>> &statements);
+
     int runSqlNoCallback(const char *zSql);
 };
 
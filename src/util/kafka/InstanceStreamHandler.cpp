@@ -12,14 +12,23 @@
  */
 
 #include "InstanceStreamHandler.h"
+
+#include <algorithm>
+
 #include "../../localstore/incremental/JasmineGraphIncrementalLocalStore.h"
 #include "../Utils.h"
 #include "../logger/Logger.h"
 
 Logger instance_stream_logger;
+// Edges a thread takes from the queue at once, so that threads of a busy partition rarely meet on the queue lock
+#define INGEST_BATCH_SIZE 256
+
 InstanceStreamHandler::InstanceStreamHandler(std::map<std::string,
                                              JasmineGraphIncrementalLocalStore*>& incrementalLocalStoreMap)
-        : incrementalLocalStoreMap(incrementalLocalStoreMap) { }
+        : incrementalLocalStoreMap(incrementalLocalStoreMap) {
+    std::string threads = Utils::getJasmineGraphProperty("org.jasminegraph.stream.ingest.threads");
+    ingestThreads = threads.empty() ? 1 : std::max(1, atoi(threads.c_str()));
+}
 
 InstanceStreamHandler::~InstanceStreamHandler() { }
 
@@ -31,9 +40,11 @@ void InstanceStreamHandler::handleRequest(const std::string& nodeString) {
             cv.second.notify_all();
         }
 
-         for (auto& thread : threads) {
-             if (thread.second.joinable()) {
-                 thread.second.join();
+         for (auto& partitionThreads : threads) {
+             for (auto& thread : partitionThreads.second) {
+                 if (thread.joinable()) {
+                     thread.join();
+                 }
              }
          }
 
@@ -43,28 +54,46 @@ void InstanceStreamHandler::handleRequest(const std::string& nodeString) {
 
     std::unique_lock<std::mutex> lock(queue_mutexes[graphIdentifier]);  // Use specific mutex for the queue
     if (threads.find(graphIdentifier) == threads.end()) {
-        threads[graphIdentifier] = std::thread(&InstanceStreamHandler::threadFunction, this, nodeString);
+        queue_depths[graphIdentifier] = &MetricsRegistry::gauge(
+            "jasminegraph_stream_queue_depth", "Streamed edges waiting to be added to the store",
+            {{"graph", graphIdentifier}});
         queues[graphIdentifier] = std::queue<std::string>();
+        for (int i = 0; i < ingestThreads; i++) {
+            threads[graphIdentifier].push_back(std::thread(&InstanceStreamHandler::threadFunction, this, nodeString));
+        }
     }
 
     queues[graphIdentifier].push(nodeString);
+    queue_depths[graphIdentifier]->add(1);
     cond_vars[graphIdentifier].notify_one();
     instance_stream_logger.debug("Pushed into the Queue");
 }
 
 void InstanceStreamHandler::threadFunction(const std::string& nodeString) {
     std::string graphIdentifier = extractGraphIdentifier(nodeString);
-    if (incrementalLocalStoreMap.find(graphIdentifier) == incrementalLocalStoreMap.end()) {
-        auto graphIdPartitionId = JasmineGraphIncrementalLocalStore::getIDs(nodeString);
-        std::string graphId = graphIdPartitionId.first;
-        std::string partitionId = std::to_string(graphIdPartitionId.second);
-        loadStreamingStore(graphId, partitionId, incrementalLocalStoreMap);
+    JasmineGraphIncrementalLocalStore* localStore;
+    {
+        std::unique_lock<std::mutex> lock(storeMutex);
+        if (incrementalLocalStoreMap.find(graphIdentifier) == incrementalLocalStoreMap.end()) {
+            auto graphIdPartitionId = JasmineGraphIncrementalLocalStore::getIDs(nodeString);
+            std::string graphId = graphIdPartitionId.first;
+            std::string partitionId = std::to_string(graphIdPartitionId.second);
+            loadStreamingStore(graphId, partitionId, incrementalLocalStoreMap);
+        }
+        localStore = incrementalLocalStoreMap[graphIdentifier];
+    }
+    // The threads of a partition write to its store concurrently, each through its own file handles
+    localStore->nm->attachThread();
+    Gauge* queueDepth;
+    {
+        std::unique_lock<std::mutex> lock(queue_mutexes[graphIdentifier]);
+        queueDepth = queue_depths[graphIdentifier];
     }
-    JasmineGraphIncrementalLocalStore* localStore = incrementalLocalStoreMap[graphIdentifier];
     instance_stream_logger.info("Thread Function");
 
+    std::vector<std::string> batch;
+    batch.reserve(INGEST_BATCH_SIZE);
     while (!terminateThreads) {
-        std::string nodeString;
         {
             std::unique_lock<std::mutex> lock(queue_mutexes[graphIdentifier]);
             cond_vars[graphIdentifier].wait(lock, [&]{
@@ -74,10 +103,17 @@ void InstanceStreamHandler::threadFunction(const std::string& nodeString) {
             if (terminateThreads) {
                 break;
             }
-            nodeString = queues[graphIdentifier].front();
-            queues[graphIdentifier].pop();
+            std::queue<std::string>& queue = queues[graphIdentifier];
+            while (!queue.empty() && batch.size() < INGEST_BATCH_SIZE) {
+                batch.push_back(std::move(queue.front()));
+                queue.pop();
+            }
+        }
+        queueDepth->add(-static_cast<double>(batch.size()));
+        for (const std::string& edgeString : batch) {
+            localStore->addEdgeFromString(edgeString);
         }
-        localStore->addEdgeFromString(nodeString);
+        batch.clear();
     }
 }
 
@@ -20,8 +20,10 @@
 #include <queue>
 #include <map>
 #include <string>
+#include <vector>
 #include <atomic>
 #include "../../localstore/incremental/JasmineGraphIncrementalLocalStore.h"
+#include "../../performance/metrics/MetricsRegistry.h"
 
 class InstanceStreamHandler {
  public:
@@ -32,11 +34,14 @@ class InstanceStreamHandler {
 
  private:
     std::map<std::string, JasmineGraphIncrementalLocalStore*>& incrementalLocalStoreMap;
-    std::map<std::string, std::thread> threads;
+    std::map<std::string, std::vector<std::thread>> threads;
     std::map<std::string, std::queue<std::string>> queues;
     std::map<std::string, std::condition_variable> cond_vars;
     std::map<std::string, std::mutex> queue_mutexes;
+    std::map<std::string, Gauge*> queue_depths;
     std::atomic<bool> terminateThreads{false};
+    std::mutex storeMutex;  // Guards loading the stores, which the threads of a partition share
+    int ingestThreads;
 
         void threadFunction(const std::string& nodeString);
         static std::string extractGraphIdentifier(const std::string& nodeString);
@@ -56,8 +56,10 @@ bool StreamHandler::isEndOfStream(const cppkafka::Message &msg) {
     return false;
 }
 
+void StreamHandler::stop() { this->stopped = true; }
+
 void StreamHandler::listen_to_kafka_topic() {
-    while (true) {
+    while (!this->stopped) {
         cppkafka::Message msg = this->pollMessage();
 
         if (this->isEndOfStream(msg)) {
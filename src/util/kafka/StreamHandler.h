@@ -13,6 +13,7 @@ limitations under the License.
 
 #include <cppkafka/cppkafka.h>
 
+#include <atomic>
 #include <string>
 #include <vector>
 
@@ -25,6 +26,8 @@ class StreamHandler {
  public:
     StreamHandler(KafkaConnector *kstream, int numberOfPartitions, std::vector<DataPublisher *> &workerClients);
     void listen_to_kafka_topic();
+    // Ends listen_to_kafka_topic() once the message being polled is handled
+    void stop();
     cppkafka::Message pollMessage();
     bool isErrorInMessage(const cppkafka::Message &msg);
     bool isEndOfStream(const cppkafka::Message &msg);
@@ -35,4 +38,5 @@ class StreamHandler {
     Logger frontend_logger;
     std::string stream_topic_name;
     std::vector<DataPublisher *> &workerClients;
+    std::atomic<bool> stopped{false};
 };
@@ -0,0 +1,58 @@
+/**
+Copyright 2024 JasmineGraph Team
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#include "../../../src/frontend/JasmineGraphFrontEnd.h"
+
+#include <atomic>
+#include <future>
+
+#include "../../../src/frontend/JasmineGraphFrontEndProtocol.h"
+#include "gtest/gtest.h"
+
+TEST(JasmineGraphFrontEndTest, TestControlCommands) {
+    ASSERT_TRUE(JasmineGraphFrontEnd::isControlCommand(STOP_STRIAN));
+    ASSERT_TRUE(JasmineGraphFrontEnd::isControlCommand(STOP_STREAM_KAFKA));
+    ASSERT_TRUE(JasmineGraphFrontEnd::isControlCommand(EXIT));
+    ASSERT_FALSE(JasmineGraphFrontEnd::isControlCommand(STREAMING_TRIANGLES));
+    ASSERT_FALSE(JasmineGraphFrontEnd::isControlCommand(TRIANGLES));
+}
+
+TEST(JasmineGraphFrontEndTest, TestControlCommandRunsWhileExecutorsAreBusy) {
+    ctpl::thread_pool executors(2);
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    std::atomic<int> running(0);
+
+    // Occupy every executor with a long-running command
+    for (int i = 0; i < 2; i++) {
+        JasmineGraphFrontEnd::dispatchCommand(STREAMING_TRIANGLES, executors, [&running, released]() {
+            running++;
+            released.wait();
+        });
+    }
+    while (running < 2) {
+        std::this_thread::yield();
+    }
+
+    bool stopped = false;
+    JasmineGraphFrontEnd::dispatchCommand(STOP_STRIAN, executors, [&stopped]() { stopped = true; });
+    ASSERT_TRUE(stopped);
+
+    std::atomic<bool> queued(false);
+    JasmineGraphFrontEnd::dispatchCommand(TRIANGLES, executors, [&queued]() { queued = true; });
+    ASSERT_FALSE(queued);
+
+    release.set_value();
+    executors.stop(true);
+    ASSERT_TRUE(queued);
+}
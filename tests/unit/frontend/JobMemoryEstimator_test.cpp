@@ -0,0 +1,59 @@
+/**
+Copyright 2024 JasmineGraph Team
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#include "../../../src/frontend/core/scheduler/JobMemoryEstimator.h"
+
+#include "../../../src/frontend/JasmineGraphFrontEndProtocol.h"
+#include "gtest/gtest.h"
+
+class JobMemoryEstimatorTest : public ::testing::Test {
+ protected:
+    SQLiteDBInterface *metadb = nullptr;
+
+    void SetUp() override {
+        metadb = new SQLiteDBInterface(TEST_RESOURCE_DIR "temp/jasminegraph_meta.db");
+        metadb->init();
+        metadb->runInsert(
+            "INSERT INTO partition (idpartition, graph_idgraph, vertexcount, central_vertexcount, edgecount, "
+            "central_edgecount, central_edgecount_with_dups) VALUES (0, 1, 1000, 100, 5000, 200, 400), "
+            "(1, 1, 2000, 100, 10000, 200, 400), (0, 2, 10, 0, 10, 0, 0)");
+    }
+
+    void TearDown() override {
+        metadb->finalize();
+        delete metadb;
+        remove(TEST_RESOURCE_DIR "temp/jasminegraph_meta.db");
+    }
+};
+
+TEST_F(JobMemoryEstimatorTest, TestEstimateGrowsWithSize) {
+    JobMemoryEstimator::PartitionSize small = {1000, 5000};
+    JobMemoryEstimator::PartitionSize large = {2000, 10000};
+    ASSERT_GT(JobMemoryEstimator::estimate(TRIANGLES, large), JobMemoryEstimator::estimate(TRIANGLES, small));
+    // Triangle counting keeps more copies of a partition than the other algorithms
+    ASSERT_GT(JobMemoryEstimator::estimate(TRIANGLES, small), JobMemoryEstimator::estimate(PAGE_RANK, small));
+    ASSERT_GT(JobMemoryEstimator::estimate(EGONET, {0, 0}), 0);
+}
+
+TEST_F(JobMemoryEstimatorTest, TestEstimateJob) {
+    const auto &sizes = JobMemoryEstimator::getPartitionSizes(metadb, "1");
+    ASSERT_EQ(sizes.size(), 2);
+    ASSERT_EQ(sizes.at(1).vertices, 2100);
+    ASSERT_EQ(sizes.at(1).edges, 10400);
+
+    const auto &memory = JobMemoryEstimator::estimateJob(TRIANGLES, sizes, {{"w1", {"0", "1"}}, {"w2", {"1", "7"}}});
+    ASSERT_EQ(memory.at("w1"), JobMemoryEstimator::estimate(TRIANGLES, sizes.at(0)) +
+                                   JobMemoryEstimator::estimate(TRIANGLES, sizes.at(1)));
+    ASSERT_EQ(memory.at("w2"), JobMemoryEstimator::estimate(TRIANGLES, sizes.at(1)) +
+                                   JobMemoryEstimator::estimate(TRIANGLES, {0, 0}));
+}
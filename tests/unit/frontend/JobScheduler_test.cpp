@@ -0,0 +1,174 @@
+/**
+Copyright 2024 JasmineGraph Team
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#include "../../../src/frontend/core/scheduler/JobScheduler.h"
+
+#include <set>
+
+#include "gtest/gtest.h"
+
+/*
+ * Runs no analytics. Each job records that it started and then blocks until the test finishes it, and the workers of
+ * a graph are given by the test instead of the metadb.
+ * */
+class FakeJobScheduler : public JobScheduler {
+ public:
+    std::map<std::string, std::vector<std::string>> graphWorkers;
+    std::set<std::thread::id> locatingThreads;
+
+    FakeJobScheduler(int maxJobs, int jobsPerGraph, int jobsPerWorker, int queuedJobs = 256) {
+        maxRunningJobs = maxJobs;
+        maxJobsPerGraph = jobsPerGraph;
+        maxJobsPerWorker = jobsPerWorker;
+        maxQueuedJobs = queuedJobs;
+        memoryBudgetFraction = 0;
+        start();
+    }
+
+    ~FakeJobScheduler() {
+        {
+            std::lock_guard<std::mutex> lock(jobsMutex);
+            finishAll = true;
+        }
+        jobsCondition.notify_all();
+        stop();
+    }
+
+    void push(std::string jobId, std::string graphId, int priority) {
+        JobRequest request;
+        request.setJobId(jobId);
+        request.setPriority(priority);
+        request.addParameter(Conts::PARAM_KEYS::GRAPH_ID, graphId);
+        pushJob(request);
+    }
+
+    std::vector<std::string> waitForStarted(size_t count) {
+        std::unique_lock<std::mutex> lock(jobsMutex);
+        jobsCondition.wait_for(lock, std::chrono::seconds(10), [this, count] { return started.size() >= count; });
+        return started;
+    }
+
+    // Gives the dispatcher time to start jobs that should not start
+    std::vector<std::string> settle() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        std::lock_guard<std::mutex> lock(jobsMutex);
+        return started;
+    }
+
+    void finish(std::string jobId) {
+        {
+            std::lock_guard<std::mutex> lock(jobsMutex);
+            finished.insert(jobId);
+        }
+        jobsCondition.notify_all();
+    }
+
+ protected:
+    void locateJob(QueuedJob &job) override {
+        {
+            std::lock_guard<std::mutex> lock(jobsMutex);
+            locatingThreads.insert(std::this_thread::get_id());
+        }
+        job.workers = graphWorkers[job.graphId];
+    }
+
+    void runJob(const JobRequest &request) override {
+        std::string jobId = JobRequest(request).getJobId();
+        std::unique_lock<std::mutex> lock(jobsMutex);
+        started.push_back(jobId);
+        jobsCondition.notify_all();
+        jobsCondition.wait(lock, [this, &jobId] { return finishAll || finished.count(jobId) > 0; });
+    }
+
+ private:
+    std::mutex jobsMutex;
+    std::condition_variable jobsCondition;
+    std::vector<std::string> started;
+    std::set<std::string> finished;
+    bool finishAll = false;
+};
+
+TEST(JobSchedulerTest, TestHigherPriorityStartsFirst) {
+    FakeJobScheduler scheduler(1, 8, 8);
+    scheduler.push("a", "1", 1);
+    ASSERT_EQ(scheduler.waitForStarted(1), std::vector<std::string>({"a"}));
+
+    scheduler.push("b", "2", 1);
+    scheduler.push("c", "3", 5);
+    scheduler.push("d", "4", 1);
+    ASSERT_EQ(scheduler.settle().size(), 1);
+
+    scheduler.finish("a");
+    ASSERT_EQ(scheduler.waitForStarted(2), std::vector<std::string>({"a", "c"}));
+    scheduler.finish("c");
+    ASSERT_EQ(scheduler.waitForStarted(3), std::vector<std::string>({"a", "c", "b"}));
+    scheduler.finish("b");
+    ASSERT_EQ(scheduler.waitForStarted(4), std::vector<std::string>({"a", "c", "b", "d"}));
+}
+
+TEST(JobSchedulerTest, TestGraphLimitSkipsToOtherGraphs) {
+    FakeJobScheduler scheduler(4, 1, 8);
+    scheduler.push("g1-a", "1", 1);
+    scheduler.push("g1-b", "1", 1);
+    scheduler.push("g2-a", "2", 1);
+
+    std::vector<std::string> started = scheduler.waitForStarted(2);
+    ASSERT_EQ(std::set<std::string>(started.begin(), started.end()), std::set<std::string>({"g1-a", "g2-a"}));
+    ASSERT_EQ(scheduler.settle().size(), 2);
+
+    scheduler.finish("g1-a");
+    ASSERT_EQ(scheduler.waitForStarted(3).back(), "g1-b");
+}
+
+TEST(JobSchedulerTest, TestWorkerLimit) {
+    FakeJobScheduler scheduler(4, 8, 1);
+    scheduler.graphWorkers["1"] = {"w1"};
+    scheduler.graphWorkers["2"] = {"w1", "w2"};
+    scheduler.graphWorkers["3"] = {"w2"};
+    scheduler.push("g1", "1", 1);
+    scheduler.push("g2", "2", 1);
+    scheduler.push("g3", "3", 1);
+
+    std::vector<std::string> started = scheduler.waitForStarted(2);
+    ASSERT_EQ(std::set<std::string>(started.begin(), started.end()), std::set<std::string>({"g1", "g3"}));
+
+    // g2 still waits for w2
+    scheduler.finish("g1");
+    ASSERT_EQ(scheduler.settle().size(), 2);
+
+    scheduler.finish("g3");
+    ASSERT_EQ(scheduler.waitForStarted(3).back(), "g2");
+}
+
+TEST(JobSchedulerTest, TestJobsAreLocatedOnTheDispatcher) {
+    FakeJobScheduler scheduler(2, 8, 8);
+    scheduler.push("a", "1", 1);
+    scheduler.push("b", "2", 1);
+    scheduler.waitForStarted(2);
+
+    ASSERT_EQ(scheduler.locatingThreads.size(), 1);
+    ASSERT_EQ(scheduler.locatingThreads.count(std::this_thread::get_id()), 0);
+}
+
+TEST(JobSchedulerTest, TestFullQueueRejectsJobs) {
+    FakeJobScheduler scheduler(1, 8, 8, 1);
+    scheduler.push("a", "1", 1);
+    scheduler.waitForStarted(1);
+    scheduler.push("b", "1", 1);
+    scheduler.push("c", "1", 1);
+
+    JobRequest rejected;
+    rejected.setJobId("c");
+    JobResponse response = scheduler.getResult(rejected);
+    ASSERT_FALSE(response.getParameter(Conts::PARAM_KEYS::ERROR_MESSAGE).empty());
+}
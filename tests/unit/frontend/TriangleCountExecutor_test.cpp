@@ -0,0 +1,65 @@
+/**
+Copyright 2024 JasmineGraph Team
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#include "../../../src/frontend/core/executor/impl/TriangleCountExecutor.h"
+
+#include "gtest/gtest.h"
+
+TEST(TriangleCountExecutorTest, TestWorkerLoadFromHeartbeat) {
+    Utils::WorkerHeartbeat idle = {0, 0, 0.1, 0, 0};
+    ASSERT_EQ(TriangleCountExecutor::getWorkerLoad(&idle, 0.9, 0), 0);
+
+    Utils::WorkerHeartbeat busyCpu = {0, 0, 0.6, 0, 0};
+    ASSERT_EQ(TriangleCountExecutor::getWorkerLoad(&busyCpu, 0, 0), 2);
+
+    Utils::WorkerHeartbeat running = {2, 0, 0.1, 0, 0};
+    ASSERT_EQ(TriangleCountExecutor::getWorkerLoad(&running, 0, 1), 2);
+    ASSERT_EQ(TriangleCountExecutor::getWorkerLoad(&running, 0, 3), 3);
+
+    Utils::WorkerHeartbeat overloaded = {7, 0, 1.0, 0, 0};
+    ASSERT_EQ(TriangleCountExecutor::getWorkerLoad(&overloaded, 0, 0), 3);
+}
+
+TEST(TriangleCountExecutorTest, TestWorkerLoadWithoutHeartbeat) {
+    ASSERT_EQ(TriangleCountExecutor::getWorkerLoad(NULL, 0.3, 0), 1);
+    ASSERT_EQ(TriangleCountExecutor::getWorkerLoad(NULL, 0.3, 2), 2);
+    ASSERT_EQ(TriangleCountExecutor::getWorkerLoad(NULL, -1, 0), 0);
+    ASSERT_EQ(TriangleCountExecutor::getWorkerLoad(NULL, 5, 0), 3);
+}
+
+TEST(TriangleCountExecutorTest, TestSaturatedWorkersAreSkipped) {
+    std::map<std::string, std::vector<std::string>> partitionMap;
+    partitionMap["1"] = {"0", "1"};
+    partitionMap["2"] = {"0", "1"};
+    std::map<std::string, int> loads = {{"1", 3}, {"2", 0}};
+    std::map<int, std::string> alloc;
+    std::set<int> remain;
+
+    ASSERT_EQ(TriangleCountExecutor::allocatePartitions(partitionMap, loads, alloc, remain), 0);
+    ASSERT_EQ(alloc, (std::map<int, std::string>{{0, "2"}, {1, "2"}}));
+    ASSERT_TRUE(remain.empty());
+    ASSERT_EQ(loads["2"], 2);
+}
+
+TEST(TriangleCountExecutorTest, TestPartitionsOfSaturatedWorkersRemain) {
+    std::map<std::string, std::vector<std::string>> partitionMap;
+    partitionMap["1"] = {"0", "1"};
+    partitionMap["2"] = {"2"};
+    std::map<std::string, int> loads = {{"1", 3}, {"2", 1}};
+    std::map<int, std::string> alloc;
+    std::set<int> remain;
+
+    ASSERT_EQ(TriangleCountExecutor::allocatePartitions(partitionMap, loads, alloc, remain), 2);
+    ASSERT_EQ(alloc, (std::map<int, std::string>{{2, "2"}}));
+    ASSERT_EQ(remain, (std::set<int>{0, 1}));
+}
@@ -0,0 +1,155 @@
+/**
+Copyright 2024 JasmineGraph Team
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#ifndef JASMINEGRAPH_FAKEK8SINTERFACE_H
+#define JASMINEGRAPH_FAKEK8SINTERFACE_H
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../../../src/k8s/K8sInterface.h"
+#include "../../../src/k8s/K8sWorkerController.h"
+
+/*
+ * K8sInterface that keeps the cluster in memory. A worker reports ready to the controller shortly after its
+ * deployment is created, as a real worker does once its instance service is up.
+ * */
+class FakeK8sInterface : public K8sInterface {
+ public:
+    std::map<std::string, std::string> config;
+    int readyDelayMs = 50;
+
+    FakeK8sInterface() : K8sInterface(nullptr) {}
+
+    ~FakeK8sInterface() override {
+        for (auto &ready : readyThreads) {
+            ready.join();
+        }
+        for (void *allocation : allocations) {
+            free(allocation);
+        }
+    }
+
+    std::set<int> getDeployments() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return deployments;
+    }
+
+    int getCreatedDeploymentCount() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return createdDeployments;
+    }
+
+    std::string getJasmineGraphConfig(std::string key) override {
+        auto it = config.find(key);
+        return it == config.end() ? "" : it->second;
+    }
+
+    v1_deployment_list_t *getDeploymentList(char *) override { return nullptr; }
+
+    v1_service_list_t *getServiceList(char *) override { return nullptr; }
+
+    v1_service_t *createJasmineGraphWorkerService(int workerId) const override {
+        auto *service = allocate<v1_service_t>();
+        service->metadata = meta("jasminegraph-worker" + std::to_string(workerId) + "-service");
+        service->spec = allocate<v1_service_spec_t>();
+        service->spec->cluster_ip = copy(workerIp(workerId));
+        return service;
+    }
+
+    v1_deployment_t *createJasmineGraphWorkerDeployment(int workerId, const std::string &ip,
+                                                        const std::string &) const override {
+        std::lock_guard<std::mutex> lock(mutex);
+        deployments.insert(workerId);
+        createdDeployments++;
+        int delay = readyDelayMs;
+        readyThreads.emplace_back([ip, delay]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(delay));
+            K8sWorkerController::workerReady(ip);
+        });
+        auto *deployment = allocate<v1_deployment_t>();
+        deployment->metadata = meta("jasminegraph-worker" + std::to_string(workerId) + "-deployment");
+        return deployment;
+    }
+
+    v1_persistent_volume_t *createJasmineGraphPersistentVolume(int workerId) const override {
+        auto *volume = allocate<v1_persistent_volume_t>();
+        volume->metadata = meta("jasminegraph-worker" + std::to_string(workerId) + "-data");
+        return volume;
+    }
+
+    v1_persistent_volume_claim_t *createJasmineGraphPersistentVolumeClaim(int workerId) const override {
+        auto *claim = allocate<v1_persistent_volume_claim_t>();
+        claim->metadata = meta("jasminegraph-worker" + std::to_string(workerId) + "-data-claim");
+        return claim;
+    }
+
+    v1_status_t *deleteJasmineGraphWorkerDeployment(int workerId) const override {
+        std::lock_guard<std::mutex> lock(mutex);
+        deployments.erase(workerId);
+        return allocate<v1_status_t>();
+    }
+
+    v1_service_t *deleteJasmineGraphWorkerService(int workerId) const override {
+        return createJasmineGraphWorkerService(workerId);
+    }
+
+    v1_persistent_volume_t *deleteJasmineGraphPersistentVolume(int workerId) const override {
+        return createJasmineGraphPersistentVolume(workerId);
+    }
+
+    v1_persistent_volume_claim_t *deleteJasmineGraphPersistentVolumeClaim(int workerId) const override {
+        return createJasmineGraphPersistentVolumeClaim(workerId);
+    }
+
+    static std::string workerIp(int workerId) { return "127.0.1." + std::to_string(workerId + 1); }
+
+ private:
+    mutable std::mutex mutex;
+    mutable std::mutex allocationMutex;
+    mutable std::set<int> deployments;
+    mutable int createdDeployments = 0;
+    mutable std::vector<std::thread> readyThreads;
+    mutable std::vector<void *> allocations;
+
+    template <typename T>
+    T *allocate() const {
+        T *object = static_cast<T *>(calloc(1, sizeof(T)));
+        std::lock_guard<std::mutex> lock(allocationMutex);
+        allocations.push_back(object);
+        return object;
+    }
+
+    char *copy(const std::string &value) const {
+        char *copied = strdup(value.c_str());
+        std::lock_guard<std::mutex> lock(allocationMutex);
+        allocations.push_back(copied);
+        return copied;
+    }
+
+    v1_object_meta_t *meta(const std::string &name) const {
+        auto *metadata = allocate<v1_object_meta_t>();
+        metadata->name = copy(name);
+        return metadata;
+    }
+};
+
+#endif  // JASMINEGRAPH_FAKEK8SINTERFACE_H
@@ -0,0 +1,123 @@
+/**
+Copyright 2024 JasmineGraph Team
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#include <unistd.h>
+
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+#include "../../../src/k8s/K8sWorkerController.h"
+#include "FakeK8sInterface.h"
+#include "gtest/gtest.h"
+
+class K8sWorkerControllerWarmPoolTest : public ::testing::Test {
+ public:
+    static K8sWorkerController *controller;
+    static SQLiteDBInterface *metadb;
+    static FakeK8sInterface *interface;
+
+    static void SetUpTestSuite() {
+        metadb = new SQLiteDBInterface(TEST_RESOURCE_DIR "temp/jasminegraph_meta.db");
+        metadb->init();
+        interface = new FakeK8sInterface();
+        interface->config["max_worker_count"] = "4";
+        interface->config["warm_pool_size"] = "2";
+        // The controller owns the interface
+        controller = K8sWorkerController::getInstance("10.43.0.1", 1, metadb, interface);
+    }
+
+    static void TearDownTestSuite() {
+        delete controller;
+        delete metadb;
+        remove(TEST_RESOURCE_DIR "temp/jasminegraph_meta.db");
+    }
+
+    static bool waitForWarmWorkers(int count) {
+        for (int i = 0; i < 100; i++) {
+            if (controller->getWarmWorkerCount() == count) return true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+        return false;
+    }
+};
+
+K8sWorkerController *K8sWorkerControllerWarmPoolTest::controller = nullptr;
+SQLiteDBInterface *K8sWorkerControllerWarmPoolTest::metadb = nullptr;
+FakeK8sInterface *K8sWorkerControllerWarmPoolTest::interface = nullptr;
+
+TEST_F(K8sWorkerControllerWarmPoolTest, TestStartFillsWarmPool) {
+    ASSERT_EQ(controller->getNumberOfWorkers(), 1);
+    ASSERT_TRUE(waitForWarmWorkers(2));
+    // Warm workers are running but are not registered until they are taken
+    ASSERT_EQ(interface->getDeployments().size(), 3);
+    ASSERT_EQ(metadb->runSelect("SELECT idworker FROM worker").size(), 1);
+}
+
+TEST_F(K8sWorkerControllerWarmPoolTest, TestScaleUpTakesWarmWorkers) {
+    ASSERT_TRUE(waitForWarmWorkers(2));
+    int created = interface->getCreatedDeploymentCount();
+
+    std::mutex readyMutex;
+    std::vector<std::string> ready;
+    auto result = controller->scaleUp(2, [&](const std::string &workerId, const std::string &address) {
+        std::lock_guard<std::mutex> lock(readyMutex);
+        ready.push_back(workerId);
+    });
+    ASSERT_EQ(result.size(), 2);
+    ASSERT_EQ(ready.size(), 2);
+    ASSERT_EQ(controller->getNumberOfWorkers(), 3);
+    ASSERT_EQ(metadb->runSelect("SELECT idworker FROM worker WHERE status = 'started'").size(), 3);
+    for (auto it = result.begin(); it != result.end(); it++) {
+        ASSERT_EQ(it->second, FakeK8sInterface::workerIp(stoi(it->first)) + ":" +
+                                  std::to_string(Conts::JASMINEGRAPH_INSTANCE_PORT));
+    }
+
+    // Only one more worker fits under max_worker_count
+    ASSERT_TRUE(waitForWarmWorkers(1));
+    ASSERT_EQ(interface->getCreatedDeploymentCount(), created + 1);
+}
+
+TEST_F(K8sWorkerControllerWarmPoolTest, TestScaleUpBeyondLimit) {
+    ASSERT_TRUE(waitForWarmWorkers(1));
+    auto result = controller->scaleUp(2);
+    ASSERT_EQ(result.size(), 1);
+    ASSERT_EQ(controller->getNumberOfWorkers(), 4);
+    ASSERT_EQ(controller->getWarmWorkerCount(), 0);
+    ASSERT_EQ(interface->getDeployments().size(), 4);
+}
+
+TEST_F(K8sWorkerControllerWarmPoolTest, TestScaleDownRefillsWarmPool) {
+    auto workers = metadb->runSelect("SELECT idworker FROM worker");
+    ASSERT_EQ(workers.size(), 4);
+    controller->scaleDown({stoi(workers[0][0].second)});
+    ASSERT_EQ(controller->getNumberOfWorkers(), 3);
+    ASSERT_EQ(metadb->runSelect("SELECT idworker FROM worker").size(), 3);
+    ASSERT_TRUE(waitForWarmWorkers(1));
+}
+
+TEST_F(K8sWorkerControllerWarmPoolTest, TestScaleUpCountsStartingWarmWorkers) {
+    ASSERT_TRUE(waitForWarmWorkers(1));
+    interface->readyDelayMs = 1000;
+    auto workers = metadb->runSelect("SELECT idworker FROM worker");
+    // Frees a place under the limit that the warm pool starts to refill in the background
+    controller->scaleDown({stoi(workers[0][0].second)});
+    ASSERT_EQ(controller->getNumberOfWorkers(), 2);
+
+    auto result = controller->scaleUp(2);
+    ASSERT_EQ(result.size(), 1);
+    ASSERT_EQ(controller->getNumberOfWorkers(), 3);
+    ASSERT_TRUE(waitForWarmWorkers(1));
+    ASSERT_EQ(interface->getDeployments().size(), 4);
+    interface->readyDelayMs = 50;
+}
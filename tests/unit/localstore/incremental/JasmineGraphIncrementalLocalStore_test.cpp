@@ -0,0 +1,61 @@
+/**
+Copyright 2024 JasmineGraph Team
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#include "../../../../src/localstore/incremental/JasmineGraphIncrementalLocalStore.h"
+
+#include "../../../../src/util/Utils.h"
+#include "gtest/gtest.h"
+
+// A graph id that no test upload uses, as the partition is created in the instance data folder
+static const unsigned int TEST_GRAPH_ID = 9050;
+
+class JasmineGraphIncrementalLocalStoreTest : public ::testing::Test {
+ protected:
+    std::string dataFolder;
+
+    void SetUp() override {
+        dataFolder = Utils::getJasmineGraphProperty("org.jasminegraph.server.instance.datafolder");
+        Utils::createDirectory(dataFolder);
+    }
+
+    void TearDown() override {
+        std::string prefix = "g" + std::to_string(TEST_GRAPH_ID) + "_";
+        for (const std::string &file : Utils::getListOfFilesInDirectory(dataFolder)) {
+            if (file.compare(0, prefix.size(), prefix) == 0) {
+                remove((dataFolder + "/" + file).c_str());
+            }
+        }
+    }
+};
+
+TEST_F(JasmineGraphIncrementalLocalStoreTest, TestWindowCountersAreCapped) {
+    JasmineGraphIncrementalLocalStore store(TEST_GRAPH_ID, 0);
+    std::shared_ptr<StreamingTriangleCounter> counter = store.getTriangleCounter();
+    std::shared_ptr<StreamingTriangleCounter> first = store.getTriangleCounter("1e");
+    ASSERT_TRUE(first);
+    ASSERT_EQ(store.getTriangleCounter("1e"), first);
+    ASSERT_FALSE(store.getTriangleCounter("1x"));
+
+    std::shared_ptr<StreamingTriangleCounter> second = store.getTriangleCounter("2e");
+    for (size_t i = 3; i <= JasmineGraphIncrementalLocalStore::MAX_WINDOW_COUNTERS; i++) {
+        store.getTriangleCounter(std::to_string(i) + "e");
+    }
+    // Using the first window again keeps it, and the least recently used window is evicted instead
+    ASSERT_EQ(store.getTriangleCounter("1e"), first);
+    store.getTriangleCounter("100e");
+    ASSERT_EQ(store.getTriangleCounter("1e"), first);
+    ASSERT_NE(store.getTriangleCounter("2e"), second);
+
+    // The counter without a window is never evicted
+    ASSERT_EQ(store.getTriangleCounter(), counter);
+}
@@ -66,3 +66,38 @@ TEST_F(SQLiteDBInterfaceTest, TestRunInsertAndUpdate) {
     ASSERT_EQ(data[0][2].second, "127.0.0.1");
     ASSERT_EQ(data[0][3].second, "false");
 }
+
+TEST_F(SQLiteDBInterfaceTest, TestRunBatchAndForEachRow) {
+    ASSERT_TRUE(dbInterface->runBatch("INSERT INTO host('name', 'ip', 'is_public') VALUES(?, ?, 'false')",
+                                      {{"host1", "10.0.0.1"}, {"host2", "10.0.0.2"}, {"host3", "10.0.0.3"}}));
+
+    std::vector<std::string> names;
+    ASSERT_TRUE(dbInterface->forEachRow("SELECT idhost, name FROM host WHERE ip LIKE ? ORDER BY idhost", {"10.0.0.%"},
+                                        [&names](const DBRow &row) {
+                                            ASSERT_EQ(row.getInt(0), names.size() + 1);
+                                            names.push_back(row.getString(1));
+                                        }));
+    ASSERT_EQ(names, std::vector<std::string>({"host1", "host2", "host3"}));
+
+    // A failing row rolls back the rows before it
+    ASSERT_FALSE(dbInterface->runBatch("INSERT INTO host('idhost', 'name', 'ip', 'is_public') VALUES(?, ?, '', '')",
+                                       {{"10", "host10"}, {"1", "duplicate"}}));
+    auto data = dbInterface->runSelect("SELECT name FROM host WHERE idhost = ?", {"10"});
+    ASSERT_EQ(data.size(), 0);
+}
+
+TEST_F(SQLiteDBInterfaceTest, TestCopyOutlivesOriginal) {
+    SQLiteDBInterface *copy = new SQLiteDBInterface(*dbInterface);
+    dbInterface->finalize();
+    copy->runInsert("INSERT INTO host('name', 'ip', 'is_public') VALUES('localhost', '127.0.0.1', 'false')");
+    ASSERT_EQ(copy->runSelect("SELECT * FROM host").size(), 1);
+    delete copy;
+}
+
+TEST(SQLiteDBInterfaceUninitializedTest, TestQueriesFailWithoutInit) {
+    SQLiteDBInterface uninitialized(TEST_RESOURCE_DIR "temp/jasminegraph_meta_uninitialized.db");
+    ASSERT_EQ(uninitialized.runSelect("SELECT * FROM host").size(), 0);
+    ASSERT_EQ(uninitialized.runInsert("INSERT INTO host('name') VALUES('localhost')"), -1);
+    ASSERT_FALSE(uninitialized.runBatch("INSERT INTO host('name') VALUES(?)", {{"localhost"}}));
+    ASSERT_EQ(uninitialized.runSqlNoCallback("SELECT 1"), SQLITE_MISUSE);
+}
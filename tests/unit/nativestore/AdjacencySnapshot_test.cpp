@@ -0,0 +1,39 @@
+/**
+Copyright 2024 JasmineGraph Team
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#include "../../../src/nativestore/AdjacencySnapshot.h"
+
+#include "gtest/gtest.h"
+
+TEST(AdjacencySnapshotTest, TestEdgesSinceEpoch) {
+    AdjacencySnapshot snapshot;
+    snapshot.add(1, 2);
+    snapshot.add(1, 3);
+    unsigned long epoch = snapshot.epoch();
+    ASSERT_EQ(epoch, 2);
+    snapshot.add(2, 3);
+
+    unsigned long current;
+    std::vector<std::pair<long, long>> edges = snapshot.edgesSince(epoch, &current);
+    ASSERT_EQ(current, 3);
+    ASSERT_EQ(edges.size(), 1);
+    ASSERT_EQ(edges[0], std::make_pair(2L, 3L));
+    ASSERT_TRUE(snapshot.edgesSince(current, &current).empty());
+    // A cursor ahead of the snapshot gets no edges
+    ASSERT_TRUE(snapshot.edgesSince(10, &current).empty());
+
+    std::map<long, std::unordered_set<long>> adjacencyList = snapshot.adjacencyList();
+    ASSERT_EQ(adjacencyList.size(), 2);
+    ASSERT_EQ(adjacencyList[1], std::unordered_set<long>({2, 3}));
+    ASSERT_EQ(adjacencyList[2], std::unordered_set<long>({3}));
+}
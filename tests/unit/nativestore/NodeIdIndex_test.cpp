@@ -0,0 +1,45 @@
+/**
+Copyright 2024 JasmineGraph Team
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#include "../../../src/nativestore/NodeIdIndex.h"
+
+#include <algorithm>
+
+#include "gtest/gtest.h"
+
+TEST(NodeIdIndexTest, TestFindAfterGrowing) {
+    NodeIdIndex index;
+    const unsigned int count = 100000;
+    for (unsigned int i = 0; i < count; i++) {
+        ASSERT_TRUE(index.insert(i * 7919UL + (1UL << 40), i));
+    }
+    // The largest ID is kept outside the table
+    ASSERT_TRUE(index.insert(~0UL, count));
+    ASSERT_FALSE(index.insert(1UL << 40, 1));
+    ASSERT_EQ(index.size(), count + 1);
+
+    unsigned int nodeIndex;
+    for (unsigned int i = 0; i < count; i++) {
+        ASSERT_TRUE(index.find(i * 7919UL + (1UL << 40), nodeIndex));
+        ASSERT_EQ(nodeIndex, i);
+    }
+    ASSERT_TRUE(index.find(~0UL, nodeIndex));
+    ASSERT_EQ(nodeIndex, count);
+    ASSERT_FALSE(index.find(1, nodeIndex));
+
+    std::vector<std::pair<unsigned long, unsigned int>> entries = index.entries();
+    ASSERT_EQ(entries.size(), count + 1);
+    std::sort(entries.begin(), entries.end());
+    ASSERT_EQ(entries.front(), std::make_pair(1UL << 40, 0U));
+    ASSERT_EQ(entries.back(), std::make_pair(~0UL, count));
+}
@@ -0,0 +1,204 @@
+/**
+Copyright 2024 JasmineGraph Team
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#include "../../../src/nativestore/NodeManager.h"
+
+#include <random>
+#include <set>
+#include <thread>
+
+#include "../../../src/nativestore/RelationBlock.h"
+#include "../../../src/nativestore/RelationCompactor.h"
+#include "../../../src/util/Utils.h"
+#include "gtest/gtest.h"
+
+// A graph id that no test upload uses, as the partition is created in the instance data folder
+static const unsigned int TEST_GRAPH_ID = 9044;
+
+class NodeManagerTest : public ::testing::Test {
+ protected:
+    std::string dataFolder;
+
+    void SetUp() override {
+        dataFolder = Utils::getJasmineGraphProperty("org.jasminegraph.server.instance.datafolder");
+        Utils::createDirectory(dataFolder);
+    }
+
+    void TearDown() override {
+        std::string prefix = "g" + std::to_string(TEST_GRAPH_ID) + "_";
+        for (const std::string &file : Utils::getListOfFilesInDirectory(dataFolder)) {
+            if (file.compare(0, prefix.size(), prefix) == 0) {
+                remove((dataFolder + "/" + file).c_str());
+            }
+        }
+    }
+};
+
+TEST_F(NodeManagerTest, TestConcurrentLocalEdges) {
+    GraphConfig config;
+    config.maxLabelSize = 43;
+    config.graphID = TEST_GRAPH_ID;
+    config.partitionID = 0;
+    config.openMode = "trunk";
+    config.numericIds = false;
+    NodeManager nodeManager(config);
+
+    // Edges between few vertices, so that the threads keep adding to the same relation lists
+    const int threadCount = 4;
+    std::vector<std::vector<std::pair<long, long>>> edges(threadCount);
+    std::map<long, std::unordered_set<long>> expected;
+    std::mt19937 random(44);
+    for (int i = 0; i < 4000; i++) {
+        long source = random() % 300;
+        long destination = random() % 300;
+        if (source == destination) continue;
+        edges[i % threadCount].push_back({source, destination});
+        expected[source].insert(destination);
+        expected[destination].insert(source);
+    }
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadCount; t++) {
+        threads.emplace_back([&nodeManager, &edges, t]() {
+            nodeManager.attachThread();
+            for (const auto &edge : edges[t]) {
+                nodeManager.addLocalEdge({std::to_string(edge.first), std::to_string(edge.second)});
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    ASSERT_EQ(nodeManager.getAdjacencyList(), expected);
+    long relations = 0;
+    const auto &relationLists = nodeManager.getAdjacencyList(true);
+    for (auto it = relationLists.begin(); it != relationLists.end(); it++) {
+        relations += it->second.size();
+    }
+    long undirectedEdges = 0;
+    for (auto it = expected.begin(); it != expected.end(); it++) {
+        undirectedEdges += it->second.size();
+    }
+    // Every edge is stored once, whichever thread added it first
+    ASSERT_EQ(relations * 2, undirectedEdges);
+}
+
+TEST_F(NodeManagerTest, TestReadOnlyStoreFollowsTheOwner) {
+    GraphConfig config;
+    config.maxLabelSize = 43;
+    config.graphID = TEST_GRAPH_ID;
+    config.partitionID = 1;
+    config.openMode = "trunk";
+    config.numericIds = false;
+    NodeManager owner(config);
+    for (int i = 0; i < 150; i++) {
+        owner.addCentralEdge({std::to_string(i % 40), std::to_string((i * 7 + 1) % 40)});
+    }
+    ASSERT_TRUE(owner.getWriteAheadLog()->commit());
+
+    config.openMode = "read";
+    NodeManager reader(config);
+    ASSERT_FALSE(reader.getWriteAheadLog()->ownsLog());
+    ASSERT_EQ(reader.getAdjacencyList(false), owner.getAdjacencyList(false));
+
+    // The reader catches up with relations added before and after the owner compacts its DB
+    owner.attachThread();
+    for (int i = 150; i < 300; i++) {
+        owner.addCentralEdge({std::to_string(i % 40), std::to_string((i * 11 + 3) % 40)});
+    }
+    ASSERT_TRUE(RelationCompactor::compact(owner.getWriteAheadLog(), false));
+    for (int i = 300; i < 350; i++) {
+        owner.addCentralEdge({std::to_string(i % 50), std::to_string((i * 13 + 5) % 50)});
+    }
+    ASSERT_TRUE(owner.getWriteAheadLog()->commit());
+    reader.refreshAdjacency();
+    ASSERT_EQ(reader.getAdjacencySnapshot(false)->epoch(), owner.getAdjacencySnapshot(false)->epoch());
+    ASSERT_EQ(reader.getAdjacencyList(false), owner.getAdjacencyList(false));
+}
+
+TEST_F(NodeManagerTest, TestRelationDBsOfAnotherLayoutAreRefused) {
+    GraphConfig config;
+    config.maxLabelSize = 43;
+    config.graphID = TEST_GRAPH_ID;
+    config.partitionID = 2;
+    config.openMode = "trunk";
+    config.numericIds = false;
+    std::map<long, std::unordered_set<long>> expected;
+    {
+        NodeManager nodeManager(config);
+        for (int i = 0; i < 150; i++) {
+            nodeManager.addLocalEdge({std::to_string(i % 30), std::to_string((i * 7 + 1) % 30)});
+        }
+        // The layout is kept when the relation blocks are relocated
+        ASSERT_TRUE(RelationCompactor::compact(nodeManager.getWriteAheadLog(), true));
+        expected = nodeManager.getAdjacencyList(true);
+    }
+
+    config.openMode = "app";
+    {
+        NodeManager nodeManager(config);
+        ASSERT_EQ(nodeManager.getAdjacencyList(true), expected);
+        RelationBlock *relation = nodeManager.addLocalEdge({"100", "101"});
+        ASSERT_NE(relation, nullptr);
+        delete relation;
+    }
+
+    // A DB written before block 0 recorded the layout
+    std::string relationsDBPath = dataFolder + "/g" + std::to_string(TEST_GRAPH_ID) + "_p2_relations.db";
+    std::fstream relationsDB(relationsDBPath, std::ios::in | std::ios::out | std::ios::binary);
+    relationsDB.seekp(WriteAheadLog::BLOCK_MAP_HEADER_SIZE);
+    relationsDB.write(std::string(8, '\0').data(), 8);
+    relationsDB.close();
+    NodeManager nodeManager(config);
+    ASSERT_TRUE(nodeManager.getAdjacencyList(true).empty());
+    ASSERT_EQ(nodeManager.addLocalEdge({"100", "102"}), nullptr);
+}
+
+TEST_F(NodeManagerTest, TestNodeDBOfAnotherLayoutIsRefused) {
+    GraphConfig config;
+    config.maxLabelSize = 43;
+    config.graphID = TEST_GRAPH_ID;
+    config.partitionID = 3;
+    config.openMode = "trunk";
+    config.numericIds = true;
+    {
+        NodeManager nodeManager(config);
+        for (unsigned long i = 0; i < 20; i++) {
+            delete nodeManager.addLocalEdge(std::make_pair(i, (i + 1) % 20));
+        }
+    }
+
+    config.openMode = "app";
+    {
+        NodeManager nodeManager(config);
+        NodeBlock *node = nodeManager.get(5UL);
+        ASSERT_NE(node, nullptr);
+        ASSERT_EQ(node->nodeId, 5UL);
+        delete node;
+        RelationBlock *relation = nodeManager.addLocalEdge(std::make_pair(100UL, 101UL));
+        ASSERT_NE(relation, nullptr);
+        delete relation;
+    }
+
+    // A DB written before block 0 recorded the layout
+    std::string nodesDBPath = dataFolder + "/g" + std::to_string(TEST_GRAPH_ID) + "_p3_nodes.db";
+    std::fstream nodesDB(nodesDBPath, std::ios::in | std::ios::out | std::ios::binary);
+    nodesDB.seekp(sizeof(NodeBlock::usage));
+    nodesDB.write(std::string(8, '\0').data(), 8);
+    nodesDB.close();
+    NodeManager nodeManager(config);
+    ASSERT_EQ(nodeManager.get(5UL), nullptr);
+    ASSERT_TRUE(nodeManager.getGraph().empty());
+    ASSERT_EQ(nodeManager.addLocalEdge(std::make_pair(100UL, 102UL)), nullptr);
+}
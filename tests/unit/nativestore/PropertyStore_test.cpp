@@ -0,0 +1,113 @@
+/**
+Copyright 2024 JasmineGraph Team
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#include "../../../src/nativestore/PropertyStore.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#define KEYS_DB TEST_RESOURCE_DIR "temp/property_store_test_keys.db"
+#define PROPERTIES_DB TEST_RESOURCE_DIR "temp/property_store_test_props.db"
+
+class PropertyStoreTest : public ::testing::Test {
+ protected:
+    std::ios_base::openmode truncMode = std::ios::in | std::ios::out | std::ios::trunc;
+    std::ios_base::openmode appendMode = std::ios::in | std::ios::out;
+
+    void TearDown() override {
+        remove(KEYS_DB);
+        remove(PROPERTIES_DB);
+    }
+};
+
+TEST_F(PropertyStoreTest, TestVariableLengthValues) {
+    PropertyKeys keys(KEYS_DB, truncMode);
+    PropertyStore store(PROPERTIES_DB, truncMode, &keys);
+
+    std::string longValue(5000, 'x');
+    unsigned int first = store.putAll(0, {{"name", "a"}, {"description", longValue}});
+    unsigned int second = store.putAll(0, {{"name", "b"}});
+    ASSERT_GT(first, 0);
+    ASSERT_GT(second, first);
+
+    std::map<std::string, std::string> properties;
+    ASSERT_TRUE(store.readAll(first, properties));
+    ASSERT_EQ(properties.size(), 2);
+    ASSERT_EQ(properties["name"], "a");
+    ASSERT_EQ(properties["description"], longValue);  // Longer than the read ahead and not truncated
+    ASSERT_EQ(keys.size(), 2);
+
+    // A record is updated in place while it fits and moved when it grows
+    ASSERT_EQ(store.put(second, "name", "c"), second);
+    unsigned int moved = store.put(second, "description", longValue);
+    ASSERT_NE(moved, second);
+    std::string value;
+    ASSERT_TRUE(store.get(moved, "name", value));
+    ASSERT_EQ(value, "c");
+    ASSERT_FALSE(store.get(moved, "missing", value));
+    ASSERT_EQ(keys.size(), 2);
+}
+
+TEST_F(PropertyStoreTest, TestReopen) {
+    unsigned int address;
+    {
+        PropertyKeys keys(KEYS_DB, truncMode);
+        PropertyStore store(PROPERTIES_DB, truncMode, &keys);
+        address = store.putAll(0, {{"type", "follows"}, {"weight", "0.5"}});
+    }
+    PropertyKeys keys(KEYS_DB, appendMode);
+    ASSERT_EQ(keys.find("weight"), 2);
+    PropertyStore store(PROPERTIES_DB, appendMode, &keys);
+    std::map<std::string, std::string> properties;
+    ASSERT_TRUE(store.readAll(address, properties));
+    ASSERT_EQ(properties, (std::map<std::string, std::string>{{"type", "follows"}, {"weight", "0.5"}}));
+
+    // New records are appended after the existing ones
+    unsigned int next = store.put(0, "type", "likes");
+    ASSERT_GT(next, address);
+    properties.clear();
+    ASSERT_TRUE(store.readAll(address, properties));
+    ASSERT_EQ(properties["type"], "follows");
+}
+
+TEST_F(PropertyStoreTest, TestConcurrentReadersSeeWholeRecords) {
+    PropertyKeys keys(KEYS_DB, truncMode);
+    PropertyStore store(PROPERTIES_DB, truncMode, &keys);
+    unsigned int address = store.putAll(0, {{"a", "0"}, {"b", "0"}});
+    std::atomic<bool> done(false);
+    std::atomic<int> torn(0);
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; i++) {
+        readers.push_back(std::thread([&]() {
+            while (!done) {
+                std::map<std::string, std::string> properties;
+                if (!store.readAll(address, properties) || properties["a"] != properties["b"]) {
+                    torn++;
+                }
+            }
+        }));
+    }
+    // Both values are rewritten in place together, so a reader must never see them differ
+    for (int i = 0; i < 2000; i++) {
+        std::string value = std::to_string(i % 10);
+        EXPECT_EQ(store.putAll(address, {{"a", value}, {"b", value}}), address);
+    }
+    done = true;
+    for (auto &reader : readers) {
+        reader.join();
+    }
+    ASSERT_EQ(torn, 0);
+}
@@ -0,0 +1,232 @@
+/**
+Copyright 2024 JasmineGraph Team
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#include "../../../src/nativestore/WriteAheadLog.h"
+
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <memory>
+
+#include "gtest/gtest.h"
+
+#define WAL_TEST_DB(name) TEST_RESOURCE_DIR "temp/wal_test_" name
+
+static const std::vector<std::string> FILES = {WAL_TEST_DB("nodes.db"), WAL_TEST_DB("relations.db"),
+                                               WAL_TEST_DB("central_relations.db"), WAL_TEST_DB("index.db")};
+
+static long sizeOnDisk(const std::string &path) {
+    struct stat stat_buf;
+    return stat(path.c_str(), &stat_buf) == 0 ? stat_buf.st_size : -1;
+}
+
+static bool relocate(WriteAheadLog &wal, const std::vector<unsigned int> &order) {
+    wal.beginRelocation(WriteAheadLog::RELATIONS);
+    if (!wal.copyBlocks(WriteAheadLog::RELATIONS, order) ||
+        !wal.exclusive([&wal]() { return wal.finishRelocation(WriteAheadLog::RELATIONS); })) {
+        wal.cancelRelocation(WriteAheadLog::RELATIONS);
+        return false;
+    }
+    return true;
+}
+
+class WriteAheadLogTest : public ::testing::Test {
+ protected:
+    void TearDown() override {
+        remove(WAL_TEST_DB("store.wal"));
+        for (const std::string &file : FILES) {
+            remove(file.c_str());
+        }
+    }
+};
+
+TEST_F(WriteAheadLogTest, TestPendingWritesAreReadBeforeCommit) {
+    WriteAheadLog wal(WAL_TEST_DB("store.wal"), FILES);
+    ASSERT_TRUE(wal.open(true));
+    std::unique_ptr<std::fstream> writer(wal.openStream(WriteAheadLog::NODES));
+    std::unique_ptr<std::fstream> reader(wal.openStream(WriteAheadLog::NODES));
+
+    unsigned int first = 7, second = 9;
+    writer->seekp(24);
+    writer->write(reinterpret_cast<char *>(&first), sizeof(first));
+    writer->write(reinterpret_cast<char *>(&second), sizeof(second));
+    writer->flush();
+    writer->seekp(28);
+    second = 11;
+    writer->write(reinterpret_cast<char *>(&second), sizeof(second));
+    writer->flush();
+
+    unsigned int value;
+    reader->seekg(28);
+    ASSERT_TRUE(reader->read(reinterpret_cast<char *>(&value), sizeof(value)));
+    ASSERT_EQ(value, 11);
+    ASSERT_EQ(wal.size(WriteAheadLog::NODES), 32);
+    ASSERT_EQ(sizeOnDisk(FILES[WriteAheadLog::NODES]), 0);
+    // Reading past the end fails as it does on a file
+    ASSERT_FALSE(reader->read(reinterpret_cast<char *>(&value), sizeof(value)));
+
+    ASSERT_TRUE(wal.commit());
+    ASSERT_EQ(sizeOnDisk(FILES[WriteAheadLog::NODES]), 32);
+    reader->clear();
+    reader->seekg(24);
+    ASSERT_TRUE(reader->read(reinterpret_cast<char *>(&value), sizeof(value)));
+    ASSERT_EQ(value, 7);
+}
+
+TEST_F(WriteAheadLogTest, TestReplayAfterCrash) {
+    pid_t child = fork();
+    ASSERT_GE(child, 0);
+    if (child == 0) {
+        WriteAheadLog *wal = new WriteAheadLog(WAL_TEST_DB("store.wal"), FILES);
+        wal->open(true);
+        const char committed[] = "committed";
+        const char lost[] = "lost";
+        {
+            WriteAheadLog::Operation operation(wal);
+            wal->write(WriteAheadLog::RELATIONS, 52, committed, sizeof(committed));
+            wal->write(WriteAheadLog::NODE_INDEX, 0, committed, sizeof(committed));
+        }
+        wal->commit();
+        // As if the blocks had not reached the disk when the process died
+        truncate(FILES[WriteAheadLog::RELATIONS].c_str(), 0);
+        wal->write(WriteAheadLog::RELATIONS, 0, lost, sizeof(lost));
+        _exit(0);
+    }
+    int status;
+    waitpid(child, &status, 0);
+    ASSERT_EQ(sizeOnDisk(FILES[WriteAheadLog::RELATIONS]), 0);
+
+    WriteAheadLog wal(WAL_TEST_DB("store.wal"), FILES);
+    ASSERT_TRUE(wal.open(false));
+    char data[10];
+    ASSERT_EQ(wal.read(WriteAheadLog::RELATIONS, 52, data, sizeof(data)), sizeof(data));
+    ASSERT_STREQ(data, "committed");
+    ASSERT_EQ(wal.read(WriteAheadLog::RELATIONS, 0, data, 4), 4);
+    ASSERT_EQ(std::string(data, 4), std::string(4, '\0'));  // The uncommitted write is gone
+    ASSERT_EQ(sizeOnDisk(WAL_TEST_DB("store.wal")), WriteAheadLog::HEADER_SIZE);
+
+    // A second store of the same partition reads the DBs without the log
+    WriteAheadLog other(WAL_TEST_DB("store.wal"), FILES);
+    ASSERT_TRUE(other.open(false));
+    ASSERT_FALSE(other.ownsLog());
+    ASSERT_EQ(other.read(WriteAheadLog::RELATIONS, 52, data, sizeof(data)), sizeof(data));
+    ASSERT_STREQ(data, "committed");
+}
+
+TEST_F(WriteAheadLogTest, TestRelocatedBlocksKeepTheirAddresses) {
+    const unsigned long blockSize = 8;
+    std::vector<unsigned int> order = {3, 1, 2};
+    {
+        WriteAheadLog wal(WAL_TEST_DB("store.wal"), FILES);
+        ASSERT_TRUE(wal.open(true));
+        ASSERT_TRUE(wal.loadBlockMap(WriteAheadLog::RELATIONS, blockSize));
+        for (unsigned long block = 1; block <= 3; block++) {
+            wal.write(WriteAheadLog::RELATIONS, block * blockSize, reinterpret_cast<char *>(&block), blockSize);
+        }
+        ASSERT_TRUE(relocate(wal, order));
+        // Blocks added after the relocation go to the end
+        unsigned long block = 4;
+        wal.write(WriteAheadLog::RELATIONS, block * blockSize, reinterpret_cast<char *>(&block), blockSize);
+    }
+
+    // Block 3 is now stored first
+    std::ifstream file(FILES[WriteAheadLog::RELATIONS], std::ios::binary);
+    unsigned long stored;
+    file.seekg(blockSize);
+    file.read(reinterpret_cast<char *>(&stored), sizeof(stored));
+    ASSERT_EQ(stored, 3);
+
+    WriteAheadLog wal(WAL_TEST_DB("store.wal"), FILES);
+    ASSERT_TRUE(wal.open(false));
+    ASSERT_TRUE(wal.loadBlockMap(WriteAheadLog::RELATIONS, blockSize));
+    for (unsigned long block = 1; block <= 4; block++) {
+        unsigned long value = 0;
+        ASSERT_EQ(wal.read(WriteAheadLog::RELATIONS, block * blockSize, reinterpret_cast<char *>(&value), blockSize),
+                  blockSize);
+        ASSERT_EQ(value, block);
+    }
+    // The order must hold every block once
+    ASSERT_FALSE(relocate(wal, {1, 1, 2, 4}));
+    remove((FILES[WriteAheadLog::RELATIONS] + ".map.1").c_str());
+}
+
+TEST_F(WriteAheadLogTest, TestWritesDuringRelocationAreKept) {
+    const unsigned long blockSize = 8;
+    {
+        WriteAheadLog wal(WAL_TEST_DB("store.wal"), FILES);
+        ASSERT_TRUE(wal.open(true));
+        ASSERT_TRUE(wal.loadBlockMap(WriteAheadLog::RELATIONS, blockSize));
+        for (unsigned long block = 1; block <= 3; block++) {
+            wal.write(WriteAheadLog::RELATIONS, block * blockSize, reinterpret_cast<char *>(&block), blockSize);
+        }
+        ASSERT_EQ(wal.beginRelocation(WriteAheadLog::RELATIONS), 4);
+        ASSERT_TRUE(wal.copyBlocks(WriteAheadLog::RELATIONS, {3, 2, 1}));
+        // Written after the blocks were copied
+        unsigned long value = 20;
+        wal.write(WriteAheadLog::RELATIONS, 2 * blockSize, reinterpret_cast<char *>(&value), blockSize);
+        value = 4;
+        wal.write(WriteAheadLog::RELATIONS, 4 * blockSize, reinterpret_cast<char *>(&value), blockSize);
+        ASSERT_TRUE(wal.exclusive([&wal]() { return wal.finishRelocation(WriteAheadLog::RELATIONS); }));
+    }
+
+    WriteAheadLog wal(WAL_TEST_DB("store.wal"), FILES);
+    ASSERT_TRUE(wal.open(false));
+    ASSERT_TRUE(wal.loadBlockMap(WriteAheadLog::RELATIONS, blockSize));
+    std::vector<unsigned long> expected = {1, 20, 3, 4};
+    for (unsigned long block = 1; block <= 4; block++) {
+        unsigned long value = 0;
+        ASSERT_EQ(wal.read(WriteAheadLog::RELATIONS, block * blockSize, reinterpret_cast<char *>(&value), blockSize),
+                  blockSize);
+        ASSERT_EQ(value, expected[block - 1]);
+    }
+    remove((FILES[WriteAheadLog::RELATIONS] + ".map.1").c_str());
+}
+
+TEST_F(WriteAheadLogTest, TestRelocationKeepsBlockZero) {
+    const unsigned long blockSize = 16;
+    unsigned long format = 7;
+    {
+        WriteAheadLog wal(WAL_TEST_DB("store.wal"), FILES);
+        ASSERT_TRUE(wal.open(true));
+        ASSERT_TRUE(wal.loadBlockMap(WriteAheadLog::RELATIONS, blockSize));
+        for (unsigned long block = 1; block <= 3; block++) {
+            unsigned long data[2] = {block, block};
+            wal.write(WriteAheadLog::RELATIONS, block * blockSize, reinterpret_cast<char *>(data), blockSize);
+        }
+        wal.write(WriteAheadLog::RELATIONS, WriteAheadLog::BLOCK_MAP_HEADER_SIZE, reinterpret_cast<char *>(&format),
+                  sizeof(format));
+        ASSERT_TRUE(relocate(wal, {2, 3, 1}));
+
+        // Written while the blocks are relocated again
+        ASSERT_EQ(wal.beginRelocation(WriteAheadLog::RELATIONS), 4);
+        ASSERT_TRUE(wal.copyBlocks(WriteAheadLog::RELATIONS, {3, 1, 2}));
+        format = 8;
+        wal.write(WriteAheadLog::RELATIONS, WriteAheadLog::BLOCK_MAP_HEADER_SIZE, reinterpret_cast<char *>(&format),
+                  sizeof(format));
+        ASSERT_TRUE(wal.exclusive([&wal]() { return wal.finishRelocation(WriteAheadLog::RELATIONS); }));
+    }
+
+    WriteAheadLog wal(WAL_TEST_DB("store.wal"), FILES);
+    ASSERT_TRUE(wal.open(false));
+    ASSERT_TRUE(wal.loadBlockMap(WriteAheadLog::RELATIONS, blockSize));
+    unsigned long value = 0;
+    wal.read(WriteAheadLog::RELATIONS, WriteAheadLog::BLOCK_MAP_HEADER_SIZE, reinterpret_cast<char *>(&value),
+             sizeof(value));
+    ASSERT_EQ(value, 8);
+    for (unsigned long block = 1; block <= 3; block++) {
+        wal.read(WriteAheadLog::RELATIONS, block * blockSize, reinterpret_cast<char *>(&value), sizeof(value));
+        ASSERT_EQ(value, block);
+    }
+    remove((FILES[WriteAheadLog::RELATIONS] + ".map.2").c_str());
+}
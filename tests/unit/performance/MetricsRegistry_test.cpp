@@ -0,0 +1,53 @@
+/**
+Copyright 2024 JasmineGraph Team
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#include "../../../src/performance/metrics/MetricsRegistry.h"
+
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+TEST(MetricsRegistryTest, TestConcurrentCounter) {
+    Counter &counter = MetricsRegistry::counter("test_events_total", "Events", {{"kind", "a"}});
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 8; i++) {
+        threads.emplace_back([&counter] {
+            for (int j = 0; j < 10000; j++) {
+                counter.inc();
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    ASSERT_EQ(counter.value(), 80000);
+    ASSERT_EQ(&MetricsRegistry::counter("test_events_total", "Events", {{"kind", "a"}}), &counter);
+}
+
+TEST(MetricsRegistryTest, TestHistogramRender) {
+    Histogram &histogram = MetricsRegistry::histogram("test_latency_seconds", "Latency", {{"command", "x"}}, {1, 2, 4});
+    histogram.observe(0.5);
+    histogram.observe(2);
+    histogram.observe(3);
+    histogram.observe(10);
+    ASSERT_EQ(histogram.bucketCounts(), std::vector<long>({1, 1, 1, 1}));
+    ASSERT_EQ(histogram.count(), 4);
+    ASSERT_DOUBLE_EQ(histogram.sum(), 15.5);
+
+    std::string text = MetricsRegistry::render();
+    ASSERT_NE(text.find("# TYPE test_latency_seconds histogram\n"), std::string::npos);
+    ASSERT_NE(text.find("test_latency_seconds_bucket{command=\"x\",le=\"2\"} 2\n"), std::string::npos);
+    ASSERT_NE(text.find("test_latency_seconds_bucket{command=\"x\",le=\"+Inf\"} 4\n"), std::string::npos);
+    ASSERT_NE(text.find("test_latency_seconds_count{command=\"x\"} 4\n"), std::string::npos);
+}
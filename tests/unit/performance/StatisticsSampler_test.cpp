@@ -0,0 +1,59 @@
+/**
+Copyright 2024 JasmineGraph Team
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#include "../../../src/performance/metrics/StatisticsSampler.h"
+
+#include <thread>
+
+#include "gtest/gtest.h"
+
+TEST(SnapshotRingTest, TestLatestAndHistory) {
+    SnapshotRing<long, 4> ring;
+    long value;
+    ASSERT_FALSE(ring.latest(value));
+
+    for (long i = 1; i <= 6; i++) {
+        ring.push(i);
+    }
+    ASSERT_EQ(ring.size(), 4);
+    ASSERT_TRUE(ring.latest(value));
+    ASSERT_EQ(value, 6);
+    ASSERT_TRUE(ring.get(3, value));
+    ASSERT_EQ(value, 3);
+    ASSERT_FALSE(ring.get(4, value));
+}
+
+TEST(SnapshotRingTest, TestConcurrentReaders) {
+    struct Pair {
+        long first;
+        long second;
+    };
+    SnapshotRing<Pair, 8> ring;
+    const long writes = 200000;
+    std::thread writer([&ring] {
+        for (long i = 0; i < writes; i++) {
+            ring.push({i, -i});
+        }
+    });
+    long last = -1;
+    Pair pair;
+    while (last < writes - 1) {
+        if (ring.latest(pair)) {
+            // A torn copy would mix the halves of two snapshots
+            ASSERT_EQ(pair.first, -pair.second);
+            ASSERT_GE(pair.first, last);
+            last = pair.first;
+        }
+    }
+    writer.join();
+}
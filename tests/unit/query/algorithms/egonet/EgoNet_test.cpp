@@ -0,0 +1,116 @@
+/**
+Copyright 2024 JasmineGraph Team
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#include "../../../../../src/query/algorithms/egonet/EgoNet.h"
+
+#include <random>
+#include <set>
+#include <tuple>
+
+#include "gtest/gtest.h"
+
+typedef std::set<std::tuple<long, long, long>> EdgeSet;
+
+static EdgeSet bruteForceEgoNet(const EgoNet::AdjacencyMap &graph, long ego) {
+    EdgeSet edges;
+    auto egoIt = graph.find(ego);
+    if (egoIt == graph.end()) {
+        return edges;
+    }
+    for (long n : egoIt->second) {
+        edges.insert(std::make_tuple(ego, ego, n));
+        auto nIt = graph.find(n);
+        if (nIt == graph.end()) {
+            continue;
+        }
+        for (long m : nIt->second) {
+            if (m != ego && egoIt->second.count(m)) {
+                edges.insert(std::make_tuple(ego, n, m));
+            }
+        }
+    }
+    return edges;
+}
+
+TEST(EgoNetTest, TestIntersect) {
+    std::vector<long> small = {3, 500, 999, 5000};
+    std::vector<long> large;
+    for (long i = 0; i < 1000; i++) {
+        large.push_back(i);
+    }
+    std::vector<long> out;
+    EgoNet::intersect(small, large, out);
+    ASSERT_EQ(out, std::vector<long>({3, 500, 999}));
+    out.clear();
+    EgoNet::intersect({1, 2, 4, 8}, {2, 3, 4, 5}, out);
+    ASSERT_EQ(out, std::vector<long>({2, 4}));
+}
+
+TEST(EgoNetTest, TestStreamMatchesBruteForceAcrossStores) {
+    // A random undirected graph split into a local store and a store of the remaining edges
+    std::mt19937 random(7);
+    EgoNet::AdjacencyMap graph, local, central;
+    for (long from = 0; from < 40; from++) {
+        for (long to = from + 1; to < 40; to++) {
+            if (random() % 5 == 0) {
+                graph[from].insert(to);
+                graph[to].insert(from);
+                EgoNet::AdjacencyMap &store = random() % 3 == 0 ? central : local;
+                store[from].insert(to);
+                store[to].insert(from);
+            }
+        }
+    }
+
+    EgoNet egoNet;
+    egoNet.addStore(local);
+    egoNet.addStore(central);
+    for (long ego : {0L, 5L, 17L, 39L, 100L}) {
+        EdgeSet streamed;
+        long count = egoNet.stream(ego, [&streamed](long e, long from, long to) {
+            ASSERT_TRUE(streamed.insert(std::make_tuple(e, from, to)).second);
+        });
+        ASSERT_EQ(count, streamed.size());
+        ASSERT_EQ(streamed, bruteForceEgoNet(graph, ego));
+    }
+
+    // Bulk mode through the binary file gives the ego networks of every vertex
+    egoNet.setCacheNeighbours(true);
+    std::string file = TEST_RESOURCE_DIR "temp/egonet_test";
+    long written = egoNet.writeAll(file);
+    EdgeSet expected;
+    for (auto it = graph.begin(); it != graph.end(); it++) {
+        const EdgeSet &egoEdges = bruteForceEgoNet(graph, it->first);
+        expected.insert(egoEdges.begin(), egoEdges.end());
+    }
+    ASSERT_EQ(written, expected.size());
+    EgoNetReader reader(file);
+    EdgeSet read;
+    long ego, from, to;
+    while (reader.next(ego, from, to)) {
+        read.insert(std::make_tuple(ego, from, to));
+    }
+    ASSERT_TRUE(reader.good());
+    ASSERT_EQ(read, expected);
+    remove(file.c_str());
+}
+
+TEST(EgoNetTest, TestReverseStore) {
+    // Edge 2 -> 1 is only known to another partition
+    EgoNet::AdjacencyMap local = {{1, {3}}, {3, {1}}};
+    EgoNet::AdjacencyMap remote = {{2, {1}}};
+    EgoNet egoNet;
+    egoNet.addStore(local);
+    egoNet.addReverseStore(remote);
+    ASSERT_EQ(egoNet.getNeighbours(1), std::vector<long>({2, 3}));
+}
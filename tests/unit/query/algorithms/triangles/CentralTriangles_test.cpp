@@ -0,0 +1,126 @@
+/**
+Copyright 2024 JasmineGraph Team
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#include "../../../../../src/query/algorithms/triangles/CentralTriangles.h"
+
+#include <random>
+#include <set>
+
+#include "gtest/gtest.h"
+
+static const int vertexCount = 60;
+static const int partitionCount = 4;
+
+/*
+ * Builds a random partitioned graph. Central stores hold the cut edges keyed by the partition of the start vertex.
+ * Returns the number of triangles made of cut edges, counted by brute force.
+ * */
+static long makeCutGraph(std::vector<int> &partitionOf,
+                         std::vector<std::map<long, std::unordered_set<long>>> &centralStores) {
+    std::mt19937 random(42);
+    partitionOf.resize(vertexCount);
+    for (int v = 0; v < vertexCount; v++) {
+        partitionOf[v] = random() % partitionCount;
+    }
+
+    centralStores.resize(partitionCount);
+    std::set<std::pair<long, long>> cutEdges;
+    for (int from = 0; from < vertexCount; from++) {
+        for (int to = from + 1; to < vertexCount; to++) {
+            if (partitionOf[from] != partitionOf[to] && random() % 4 == 0) {
+                // Alternate the direction so that central stores are keyed by both ends
+                if (random() % 2 == 0) {
+                    centralStores[partitionOf[from]][from].insert(to);
+                } else {
+                    centralStores[partitionOf[to]][to].insert(from);
+                }
+                cutEdges.insert(std::make_pair(from, to));
+            }
+        }
+    }
+
+    long expected = 0;
+    for (int a = 0; a < vertexCount; a++) {
+        for (int b = a + 1; b < vertexCount; b++) {
+            for (int c = b + 1; c < vertexCount; c++) {
+                if (cutEdges.count({a, b}) && cutEdges.count({b, c}) && cutEdges.count({a, c})) {
+                    expected++;
+                }
+            }
+        }
+    }
+    return expected;
+}
+
+TEST(CentralTrianglesTest, TestOwnersCountEveryTriangleOnce) {
+    std::vector<int> partitionOf;
+    std::vector<std::map<long, std::unordered_set<long>>> centralStores;
+    long expected = makeCutGraph(partitionOf, centralStores);
+    ASSERT_GT(expected, 0);
+
+    std::map<long, std::unordered_set<long>> cutGraph;
+    for (auto &centralStore : centralStores) {
+        CentralTriangles::addEdges(cutGraph, centralStore);
+    }
+    long total = 0;
+    for (int partition = 0; partition < partitionCount; partition++) {
+        std::unordered_set<long> owned;
+        for (int v = 0; v < vertexCount; v++) {
+            if (partitionOf[v] == partition) {
+                owned.insert(v);
+            }
+        }
+        total += CentralTriangles::countOwnedTriangles(cutGraph, owned);
+    }
+    ASSERT_EQ(total, expected);
+}
+
+TEST(CentralTrianglesTest, TestShuffledBucketsCountEveryTriangleOnce) {
+    std::vector<int> partitionOf;
+    std::vector<std::map<long, std::unordered_set<long>>> centralStores;
+    long expected = makeCutGraph(partitionOf, centralStores);
+    const int bucketCount = 3;
+
+    // Every partition ships the lists of its own vertices through files, as the workers do
+    std::vector<std::map<long, std::vector<long>>> received(bucketCount);
+    for (int partition = 0; partition < partitionCount; partition++) {
+        std::map<long, std::unordered_set<long>> cutNeighbours;
+        for (auto &centralStore : centralStores) {
+            for (auto &entry : centralStore) {
+                for (long to : entry.second) {
+                    if (partitionOf[entry.first] == partition) {
+                        cutNeighbours[entry.first].insert(to);
+                    }
+                    if (partitionOf[to] == partition) {
+                        cutNeighbours[to].insert(entry.first);
+                    }
+                }
+            }
+        }
+        const auto &buckets = CentralTriangles::shuffle(cutNeighbours, bucketCount);
+        for (int bucket = 0; bucket < bucketCount; bucket++) {
+            std::string filePath = TEST_RESOURCE_DIR "temp/cut_adjacency";
+            ASSERT_TRUE(CentralTriangles::writeAdjacency(filePath, buckets[bucket]));
+            ASSERT_TRUE(CentralTriangles::readAdjacency(filePath, received[bucket]));
+        }
+    }
+
+    long total = 0;
+    for (int bucket = 0; bucket < bucketCount; bucket++) {
+        const auto &graph = CentralTriangles::fromOutNeighbours(received[bucket]);
+        total += CentralTriangles::countOwnedTriangles(graph, [bucket](long vertex) {
+            return CentralTriangles::ownerBucket(vertex, bucketCount) == bucket;
+        });
+    }
+    ASSERT_EQ(total, expected);
+}
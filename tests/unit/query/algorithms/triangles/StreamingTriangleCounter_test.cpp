@@ -0,0 +1,170 @@
+/**
+Copyright 2024 JasmineGraph Team
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#include "../../../../../src/query/algorithms/triangles/StreamingTriangleCounter.h"
+
+#include <random>
+#include <set>
+
+#include "gtest/gtest.h"
+
+static long bruteForceTriangles(const std::set<std::pair<long, long>> &edges, long vertexCount) {
+    long count = 0;
+    for (long u = 0; u < vertexCount; u++) {
+        for (long v = u + 1; v < vertexCount; v++) {
+            for (long w = v + 1; w < vertexCount; w++) {
+                if (edges.count({u, v}) && edges.count({v, w}) && edges.count({u, w})) {
+                    count++;
+                }
+            }
+        }
+    }
+    return count;
+}
+
+TEST(StreamingTriangleCounterTest, TestDeltasAddUpToTheTriangleCount) {
+    const long vertexCount = 40;
+    AdjacencySnapshot local, central;
+    StreamingTriangleCounter counter({&local, &central});
+    std::mt19937 random(7);
+    std::set<std::pair<long, long>> edges;
+    std::vector<unsigned long> epochs = {0, 0};
+    long total = 0;
+    for (int round = 0; round < 10; round++) {
+        for (int i = 0; i < 40; i++) {
+            long u = random() % vertexCount;
+            long v = random() % vertexCount;
+            // Edges come in either direction, more than once and in either snapshot
+            (random() % 2 ? local : central).add(u, v);
+            if (u != v) {
+                edges.insert({std::min(u, v), std::max(u, v)});
+            }
+        }
+        total += counter.countSince(epochs);
+        ASSERT_EQ(epochs[0], local.epoch());
+        ASSERT_EQ(epochs[1], central.epoch());
+        ASSERT_EQ(total, bruteForceTriangles(edges, vertexCount));
+    }
+
+    // A caller that lost its last result gets the triangles since the epochs it has
+    local.add(100, 101);
+    local.add(101, 102);
+    std::vector<unsigned long> old = {local.epoch() - 2, central.epoch()};
+    central.add(100, 102);
+    ASSERT_EQ(counter.countSince(old), 1);
+    ASSERT_EQ(counter.countSince(epochs), 1);
+    std::vector<unsigned long> all(2);
+    ASSERT_EQ(counter.countAll(all), total + 1);
+}
+
+TEST(StreamingTriangleCounterTest, TestTrianglesAreReportedOnce) {
+    AdjacencySnapshot first, second;
+    StreamingTriangleCounter counter({&first, &second});
+    std::vector<unsigned long> epochs = {0, 0};
+    first.add(1, 2);
+    second.add(3, 2);
+    ASSERT_EQ(counter.trianglesSince(epochs), "");
+    first.add(3, 1);
+    second.add(1, 3);
+    first.add(4, 1);
+    second.add(4, 3);
+    ASSERT_EQ(counter.trianglesSince(epochs), "1,2,3:1,3,4");
+
+    ASSERT_EQ(counter.trianglesSince(epochs), "");
+
+    // A caller that lost its last result gets the triangles since the epochs it has again
+    std::vector<unsigned long> old = {1, 1};
+    ASSERT_EQ(counter.trianglesSince(old), "1,2,3:1,3,4");
+    ASSERT_EQ(old, epochs);
+}
+
+TEST(StreamingTriangleCounterTest, TestWindowRetractsExpiredEdges) {
+    AdjacencySnapshot local, central;
+    StreamingTriangleCounter counter({&local, &central}, TriangleWindow{0, 60}, true);
+    local.add(1, 2, 1000);
+    local.add(2, 3, 1000);
+    central.add(3, 1, 1010);
+    central.add(1, 3, 1020);  // A second copy keeps the edge after the first one leaves
+    local.add(3, 4, 1030);
+    local.add(4, 1, 1030);
+    ASSERT_EQ(counter.countWindow(1040), 2);
+    ASSERT_EQ(counter.windowTriangles(1040), "1,2,3:1,3,4");
+
+    // Edges 1-2 and 2-3 leave the window, and 3-1 stays through its second copy
+    ASSERT_EQ(counter.countWindow(1075), 1);
+    ASSERT_EQ(counter.windowTriangles(1075), "1,3,4");
+    ASSERT_EQ(counter.countWindow(1085), 0);
+    ASSERT_EQ(counter.windowTriangles(1085), "");
+
+    // Edges that arrive already out of the window are not taken in
+    local.add(1, 3, 1000);
+    local.add(1, 5, 1086);
+    local.add(5, 4, 1086);
+    ASSERT_EQ(counter.countWindow(1086), 1);
+    ASSERT_EQ(counter.windowTriangles(1086), "1,4,5");
+}
+
+TEST(StreamingTriangleCounterTest, TestEdgeWindowMatchesRecount) {
+    const long vertexCount = 20;
+    const unsigned long windowEdges = 50;
+    AdjacencySnapshot local, central;
+    StreamingTriangleCounter counter({&local, &central}, TriangleWindow{windowEdges, 0});
+    std::mt19937 random(11);
+    std::vector<std::pair<long, long>> stream;
+    for (unsigned int time = 1; time <= 30; time++) {
+        for (int i = 0; i < 10; i++) {
+            long u = random() % vertexCount;
+            long v = random() % vertexCount;
+            (random() % 2 ? local : central).add(u, v, time);
+            stream.push_back({u, v});
+        }
+        // Edges of the same second are not taken in in stream order, so the window is checked when it holds whole
+        // seconds
+        if (stream.size() % windowEdges != 0) {
+            continue;
+        }
+        std::set<std::pair<long, long>> edges;
+        for (size_t j = stream.size() - windowEdges; j < stream.size(); j++) {
+            if (stream[j].first != stream[j].second) {
+                edges.insert(
+                    {std::min(stream[j].first, stream[j].second), std::max(stream[j].first, stream[j].second)});
+            }
+        }
+        ASSERT_EQ(counter.countWindow(time), bruteForceTriangles(edges, vertexCount));
+    }
+}
+
+TEST(StreamingTriangleCounterTest, TestParseWindow) {
+    TriangleWindow window;
+    ASSERT_TRUE(StreamingTriangleCounter::parseWindow("10m", window));
+    ASSERT_EQ(window.seconds, 600);
+    ASSERT_EQ(window.edges, 0);
+    ASSERT_TRUE(StreamingTriangleCounter::parseWindow("2h,5000e", window));
+    ASSERT_EQ(window.seconds, 7200);
+    ASSERT_EQ(window.edges, 5000);
+    ASSERT_FALSE(StreamingTriangleCounter::parseWindow("", window));
+    ASSERT_FALSE(StreamingTriangleCounter::parseWindow("0s", window));
+    ASSERT_FALSE(StreamingTriangleCounter::parseWindow("-5m", window));
+    ASSERT_FALSE(StreamingTriangleCounter::parseWindow("10", window));
+    ASSERT_FALSE(StreamingTriangleCounter::parseWindow("10 minutes", window));
+}
+
+TEST(StreamingTriangleCounterTest, TestShareWindow) {
+    ASSERT_EQ(StreamingTriangleCounter::shareWindow("5000e", 1, 4), "1250e");
+    ASSERT_EQ(StreamingTriangleCounter::shareWindow("5000e", 3, 4), "3750e");
+    ASSERT_EQ(StreamingTriangleCounter::shareWindow("10e", 1, 3), "4e");
+    ASSERT_EQ(StreamingTriangleCounter::shareWindow("2e", 1, 8), "1e");
+    ASSERT_EQ(StreamingTriangleCounter::shareWindow("10m,5000e", 1, 2), "600s,2500e");
+    ASSERT_EQ(StreamingTriangleCounter::shareWindow("10m", 1, 2), "600s");
+    ASSERT_EQ(StreamingTriangleCounter::shareWindow("10", 1, 2), "");
+}
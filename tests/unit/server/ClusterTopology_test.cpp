@@ -0,0 +1,74 @@
+/**
+Copyright 2024 JasmineGraph Team
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#include "../../../src/server/ClusterTopology.h"
+
+#include "gtest/gtest.h"
+
+class ClusterTopologyTest : public ::testing::Test {
+ protected:
+    SQLiteDBInterface *metadb = NULL;
+
+    void SetUp() override {
+        metadb = new SQLiteDBInterface(TEST_RESOURCE_DIR "temp/jasminegraph_meta.db");
+        metadb->init();
+        metadb->runInsert(
+            "INSERT INTO worker (idworker, host_idhost, name, ip, server_port, server_data_port) VALUES "
+            "(1, 1, 'worker-1', '10.0.0.1', '7780', '7781'), (2, 1, 'worker-2', '10.0.0.2', '7782', '7783')");
+        metadb->runInsert(
+            "INSERT INTO graph (idgraph, name, upload_path, upload_start_time, upload_end_time, "
+            "graph_status_idgraph_status) VALUES (5, 'g', '', '', '', 2)");
+        metadb->runInsert(
+            "INSERT INTO worker_has_partition (partition_idpartition, partition_graph_idgraph, worker_idworker) VALUES "
+            "('0', '5', 1), ('1', '5', 2), ('1', '5', 1)");
+        ASSERT_TRUE(ClusterTopology::reload(metadb));
+    }
+
+    void TearDown() override {
+        delete metadb;
+        remove(TEST_RESOURCE_DIR "temp/jasminegraph_meta.db");
+    }
+};
+
+TEST_F(ClusterTopologyTest, TestReload) {
+    auto topology = ClusterTopology::get();
+    ASSERT_GT(topology->version, 0);
+    ASSERT_EQ(topology->workers.size(), 2);
+    ASSERT_EQ(topology->getWorker(2)->host, "10.0.0.2");
+    ASSERT_EQ(topology->getWorker(2)->dataPort, 7783);
+    ASSERT_EQ(topology->getWorker(3), nullptr);
+
+    auto partitionsByWorker = topology->getPartitionsByWorker(5);
+    ASSERT_EQ(partitionsByWorker[1], std::vector<int>({0, 1}));
+    ASSERT_EQ(partitionsByWorker[2], std::vector<int>({1}));
+    ASSERT_TRUE(topology->getPartitionsByWorker(6).empty());
+}
+
+TEST_F(ClusterTopologyTest, TestUpdatesDoNotChangeTakenSnapshots) {
+    auto before = ClusterTopology::get();
+
+    ClusterTopology::addWorker({3, "worker-3", "10.0.0.3", "", 7784, 7785});
+    ClusterTopology::addReplica(5, 2, 3);
+    ClusterTopology::removeWorker(1);
+    auto after = ClusterTopology::get();
+    ASSERT_EQ(after->version, before->version + 3);
+    ASSERT_EQ(after->getWorker(1), nullptr);
+    ASSERT_EQ(after->graphs.at(5).at(2), std::vector<int>({3}));
+    ASSERT_EQ(after->graphs.at(5).at(1), std::vector<int>({2}));
+
+    ClusterTopology::removeGraph(5);
+    ASSERT_TRUE(ClusterTopology::get()->getPartitionsByWorker(5).empty());
+
+    ASSERT_EQ(before->workers.size(), 2);
+    ASSERT_EQ(before->getPartitionsByWorker(5)[1], std::vector<int>({0, 1}));
+}
@@ -0,0 +1,141 @@
+/**
+Copyright 2024 JasmineGraph Team
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#include "../../../src/server/ReplicaManager.h"
+
+#include "gtest/gtest.h"
+
+class ReplicaManagerTest : public ::testing::Test {
+ protected:
+    ClusterTopology::Snapshot topology;
+    std::map<int, ReplicaManager::WorkerState> workers;
+    ReplicaManager::Policy policy;
+
+    void SetUp() override {
+        topology.version = 1;
+        for (int id = 1; id <= 3; id++) {
+            topology.workers[id] = {id, "worker-" + std::to_string(id), "10.0.0." + std::to_string(id), "", 7780, 7781};
+            ReplicaManager::WorkerState &state = workers[id];
+            state.alive = true;
+            state.totalMemory = 1000;
+            state.usedMemory = 100;
+        }
+        // Graph 5 has partition 0 on worker 1 and partition 1 on workers 1 and 2
+        topology.graphs[5][0] = {1};
+        topology.graphs[5][1] = {1, 2};
+    }
+};
+
+TEST_F(ReplicaManagerTest, TestRouteAssignsEachPartitionOnce) {
+    std::map<int, int> loads = {{1, 2}};
+    auto routed = ReplicaManager::route(topology, 5, loads);
+    ASSERT_EQ(routed[1], std::vector<int>({0}));
+    ASSERT_EQ(routed[2], std::vector<int>({1}));
+    ASSERT_EQ(loads[1], 3);
+    ASSERT_EQ(loads[2], 1);
+    ASSERT_TRUE(ReplicaManager::route(topology, 6, loads).empty());
+}
+
+TEST_F(ReplicaManagerTest, TestRouteKeepsEqualLoadsOnOneWorker) {
+    std::map<int, int> loads = {{1, 0}, {2, 1}};
+    auto routed = ReplicaManager::route(topology, 5, loads);
+    ASSERT_EQ(routed.size(), 1);
+    ASSERT_EQ(routed[1], std::vector<int>({0, 1}));
+}
+
+TEST_F(ReplicaManagerTest, TestPlanReplicatesHotGraph) {
+    workers[2].load = 2;
+    workers[3].usedMemory = 900;  // no room on worker 3
+    auto actions = ReplicaManager::plan(topology, {}, {{5, 5}}, workers, policy, true);
+    ASSERT_EQ(actions.size(), 1);
+    ASSERT_EQ(actions[0].partitionId, 0);
+    ASSERT_EQ(actions[0].source, 1);
+    ASSERT_EQ(actions[0].worker, 2);
+
+    workers[2].load = policy.maxLoad;
+    ASSERT_TRUE(ReplicaManager::plan(topology, {}, {{5, 5}}, workers, policy, true).empty());
+}
+
+TEST_F(ReplicaManagerTest, TestPlanReclaimsSecondariesOfColdGraph) {
+    std::set<ReplicaManager::Replica> secondaries = {ReplicaManager::Replica(5, 1, 2)};
+    auto actions = ReplicaManager::plan(topology, secondaries, {{5, 0.5}}, workers, policy, true);
+    ASSERT_EQ(actions.size(), 1);
+    ASSERT_EQ(actions[0].partitionId, 1);
+    ASSERT_EQ(actions[0].source, -1);
+    ASSERT_EQ(actions[0].worker, 2);
+
+    // Not while a task runs on the worker, nor before heats are known
+    workers[2].tasks = 1;
+    ASSERT_TRUE(ReplicaManager::plan(topology, secondaries, {{5, 0.5}}, workers, policy, true).empty());
+    workers[2].tasks = 0;
+    ASSERT_TRUE(ReplicaManager::plan(topology, secondaries, {{5, 0.5}}, workers, policy, false).empty());
+    // Primaries are kept
+    ASSERT_TRUE(ReplicaManager::plan(topology, {}, {{5, 0.5}}, workers, policy, true).empty());
+}
+
+// Leases are checked against the current topology, so these tests load their own
+class ReplicaLeaseTest : public ::testing::Test {
+ protected:
+    SQLiteDBInterface *metadb = NULL;
+
+    void SetUp() override {
+        metadb = new SQLiteDBInterface(TEST_RESOURCE_DIR "temp/jasminegraph_meta.db");
+        metadb->init();
+        metadb->runInsert(
+            "INSERT INTO worker (idworker, host_idhost, name, ip, server_port, server_data_port) VALUES "
+            "(1, 1, 'worker-1', '10.0.0.1', '7780', '7781'), (2, 1, 'worker-2', '10.0.0.2', '7782', '7783')");
+        metadb->runInsert(
+            "INSERT INTO graph (idgraph, name, upload_path, upload_start_time, upload_end_time, "
+            "graph_status_idgraph_status) VALUES (5, 'g', '', '', '', 2)");
+        metadb->runInsert(
+            "INSERT INTO worker_has_partition (partition_idpartition, partition_graph_idgraph, worker_idworker) VALUES "
+            "('0', '5', 1), ('1', '5', 1), ('1', '5', 2)");
+        ASSERT_TRUE(ClusterTopology::reload(metadb));
+    }
+
+    void TearDown() override {
+        delete metadb;
+        remove(TEST_RESOURCE_DIR "temp/jasminegraph_meta.db");
+    }
+};
+
+TEST_F(ReplicaLeaseTest, TestRouteLeasesPickedReplicas) {
+    std::map<int, int> loads = {{1, 2}};
+    {
+        ReplicaLease lease;
+        auto routed = ReplicaManager::route(*ClusterTopology::get(), 5, loads, &lease);
+        ASSERT_EQ(routed[2], std::vector<int>({1}));
+        ASSERT_EQ(ReplicaManager::getLeaseCount(ReplicaManager::Replica(5, 0, 1)), 1);
+        ASSERT_EQ(ReplicaManager::getLeaseCount(ReplicaManager::Replica(5, 1, 2)), 1);
+        ASSERT_EQ(ReplicaManager::getLeaseCount(ReplicaManager::Replica(5, 1, 1)), 0);
+    }
+    ASSERT_EQ(ReplicaManager::getLeaseCount(ReplicaManager::Replica(5, 0, 1)), 0);
+    ASSERT_EQ(ReplicaManager::getLeaseCount(ReplicaManager::Replica(5, 1, 2)), 0);
+}
+
+TEST_F(ReplicaLeaseTest, TestReclaimedReplicasAreNotLeased) {
+    // A job that took its snapshot before the replica on worker 2 was reclaimed
+    auto snapshot = ClusterTopology::get();
+    ClusterTopology::removeReplica(5, 1, 2);
+    std::map<int, int> loads = {{1, 5}};
+    ReplicaLease lease;
+    auto routed = ReplicaManager::route(*snapshot, 5, loads, &lease);
+    ASSERT_EQ(routed.size(), 1);
+    ASSERT_EQ(routed[1], std::vector<int>({0, 1}));
+
+    ReplicaLease planned;
+    ASSERT_FALSE(planned.acquire(5, {{1, {0}}, {2, {1}}}));
+    ASSERT_EQ(ReplicaManager::getLeaseCount(ReplicaManager::Replica(5, 0, 1)), 1);
+    ASSERT_TRUE(planned.acquire(5, {{1, {0, 1}}}));
+    ASSERT_EQ(ReplicaManager::getLeaseCount(ReplicaManager::Replica(5, 0, 1)), 2);
+}
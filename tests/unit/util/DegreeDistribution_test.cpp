@@ -0,0 +1,65 @@
+/**
+Copyright 2024 JasmineGraph Team
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#include "../../../src/util/DegreeDistribution.h"
+
+#include "gtest/gtest.h"
+
+TEST(DegreeDistributionTest, TestWriteAndRead) {
+    std::map<long, long> distribution = {{0, 1}, {3, 0}, {4, 12}, {1L << 40, 300}};
+    ASSERT_TRUE(DegreeDistribution::write(TEST_RESOURCE_DIR "temp/degree_run", distribution));
+
+    DegreeDistributionReader reader(TEST_RESOURCE_DIR "temp/degree_run");
+    std::map<long, long> actual;
+    long vertex, degree;
+    while (reader.next(vertex, degree)) {
+        actual[vertex] = degree;
+    }
+    ASSERT_TRUE(reader.good());
+    ASSERT_EQ(actual, distribution);
+}
+
+TEST(DegreeDistributionTest, TestMergeRuns) {
+    ASSERT_TRUE(DegreeDistribution::write(TEST_RESOURCE_DIR "temp/degree_run_1", {{1, 3}, {5, 2}, {9, 7}}));
+    ASSERT_TRUE(DegreeDistribution::write(TEST_RESOURCE_DIR "temp/degree_run_2", {{2, 1}, {5, 4}}));
+
+    DegreeDistributionReader first(TEST_RESOURCE_DIR "temp/degree_run_1");
+    DegreeDistributionReader second(TEST_RESOURCE_DIR "temp/degree_run_2");
+    std::vector<DegreeDistributionReader *> runs = {&first, &second};
+    std::vector<std::pair<long, long>> merged;
+    ASSERT_TRUE(DegreeDistribution::merge(runs, DegreeDistribution::SUM,
+                                          [&merged](long vertex, long degree) { merged.push_back({vertex, degree}); }));
+
+    std::vector<std::pair<long, long>> expected = {{1, 3}, {2, 1}, {5, 6}, {9, 7}};
+    ASSERT_EQ(merged, expected);
+}
+
+TEST(DegreeDistributionTest, TestSummary) {
+    DegreeDistributionSummary summary(2);
+    summary.add(1, 0);
+    summary.add(2, 5);
+    summary.add(3, 1);
+    summary.add(4, 9);
+
+    ASSERT_EQ(summary.vertexCount, 4);
+    ASSERT_EQ(summary.degreeSum, 15);
+    ASSERT_EQ(summary.maxDegree, 9);
+    ASSERT_EQ(summary.histogram[0], 1);
+    ASSERT_EQ(summary.histogram[1], 1);
+    ASSERT_EQ(summary.histogram[3], 1);
+    ASSERT_EQ(summary.histogram[4], 1);
+    ASSERT_EQ(summary.toJson(),
+              R"({"degreeSum":15,"histogram":[{"count":1,"max":0,"min":0},{"count":1,"max":1,"min":1},)"
+              R"({"count":1,"max":7,"min":4},{"count":1,"max":15,"min":8}],"maxDegree":9,)"
+              R"("top":[{"degree":9,"vertex":4},{"degree":5,"vertex":2}],"vertices":4})");
+}
@@ -13,6 +13,12 @@ limitations under the License.
 
 #include "../../../src/util/Utils.h"
 
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <thread>
+
+#include "../../../src/server/JasmineGraphInstanceProtocol.h"
 #include "gtest/gtest.h"
 
 std::string sample =
@@ -60,3 +66,66 @@ TEST(UtilsTest, TestGetJsonStringFromYamlFile) {
     std::string actual = Utils::getJsonStringFromYamlFile(TEST_RESOURCE_DIR "sample.yaml");
     ASSERT_EQ(actual, expected);
 }
+
+TEST(UtilsTest, TestCompressAndUnzipFile) {
+    std::string filePath = TEST_RESOURCE_DIR "temp/sample_compress.yaml";
+    Utils::writeFileContent(filePath, sample);
+    long fileSize = Utils::getFileSize(filePath);
+    unsigned long checksum = Utils::getFileChecksum(filePath);
+    ASSERT_EQ(fileSize, sample.length());
+
+    ASSERT_EQ(Utils::compressFile(filePath), 0);
+    ASSERT_FALSE(Utils::fileExists(filePath));
+    ASSERT_TRUE(Utils::fileExists(filePath + ".gz"));
+
+    ASSERT_EQ(Utils::unzipFile(filePath + ".gz"), 0);
+    ASSERT_EQ(Utils::getFileSize(filePath), fileSize);
+    ASSERT_EQ(Utils::getFileChecksum(filePath), checksum);
+    ASSERT_EQ(Utils::getFileContentAsString(filePath), sample);
+}
+
+TEST(UtilsTest, TestParseWorkerHeartbeat) {
+    Utils::WorkerHeartbeat heartbeat = {};
+    ASSERT_TRUE(Utils::parseWorkerHeartbeat("2|1|0.75|1024|4096", &heartbeat));
+    ASSERT_EQ(heartbeat.runningTasks, 2);
+    ASSERT_EQ(heartbeat.highPriorityTasks, 1);
+    ASSERT_DOUBLE_EQ(heartbeat.cpuUsage, 0.75);
+    ASSERT_EQ(heartbeat.usedMemory, 1024);
+    ASSERT_EQ(heartbeat.totalMemory, 4096);
+}
+
+TEST(UtilsTest, TestParseWorkerHeartbeatRejectsBadReplies) {
+    Utils::WorkerHeartbeat heartbeat = {3, 0, 0.5, 10, 20};
+    ASSERT_FALSE(Utils::parseWorkerHeartbeat("", &heartbeat));
+    ASSERT_FALSE(Utils::parseWorkerHeartbeat("2|1|0.75", &heartbeat));
+    ASSERT_FALSE(Utils::parseWorkerHeartbeat("2|1|0.75|1024|", &heartbeat));
+    ASSERT_FALSE(Utils::parseWorkerHeartbeat("two|1|0.75|1024|4096", &heartbeat));
+    ASSERT_FALSE(Utils::parseWorkerHeartbeat("2|1|busy|1024|4096", &heartbeat));
+    ASSERT_FALSE(Utils::parseWorkerHeartbeat("-1|1|0.75|1024|4096", &heartbeat));
+    ASSERT_FALSE(Utils::parseWorkerHeartbeat("2|1|0.75|1024|4096|8", &heartbeat));
+    ASSERT_EQ(heartbeat.runningTasks, 3);
+    ASSERT_DOUBLE_EQ(heartbeat.cpuUsage, 0.5);
+}
+
+TEST(UtilsTest, TestChunkedStringIsReadWhole) {
+    int sockets[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sockets), 0);
+    std::string workers;
+    for (int i = 0; i < 100; i++) {
+        workers += (i > 0 ? "," : "") + std::string("jasminegraph-worker") + std::to_string(i) + "-service:7778";
+    }
+
+    for (const std::string &sent : {workers, std::string("1|0|worker:7778"), std::string("")}) {
+        std::thread sender([&sockets, &sent]() {
+            char buffer[INSTANCE_DATA_LENGTH + 1];
+            ASSERT_TRUE(Utils::sendChunkedString(sockets[0], buffer, INSTANCE_DATA_LENGTH, sent));
+        });
+        char buffer[INSTANCE_DATA_LENGTH + 1];
+        std::string received;
+        ASSERT_TRUE(Utils::readChunkedString(sockets[1], buffer, INSTANCE_DATA_LENGTH, received));
+        sender.join();
+        ASSERT_EQ(received, sent);
+    }
+    close(sockets[0]);
+    close(sockets[1]);
+}